@@ -48,6 +48,10 @@
 
 #if defined(_WIN32)
 # include <windows.h>
+#elif defined(OPENSSL_SYS_VXWORKS)
+# include <time.h>
+#else
+# include <sys/time.h>
 #endif
 
 #include <openssl/bn.h>
@@ -98,6 +102,8 @@ typedef struct openssl_speed_sec_st {
 static volatile int run = 0;
 
 static int mr = 0;  /* machine-readeable output format to merge fork results */
+static int eddsa_batch = 0; /* verify EdDSA signatures in batches this size */
+static int rsa_keygen = 0; /* number of RSA keys to time the generation of */
 static int usertime = 1;
 
 static double Time_F(int s);
@@ -210,7 +216,8 @@ typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP,
     OPT_ELAPSED, OPT_EVP, OPT_HMAC, OPT_DECRYPT, OPT_ENGINE, OPT_MULTI,
     OPT_MR, OPT_MB, OPT_MISALIGN, OPT_ASYNCJOBS, OPT_R_ENUM, OPT_PROV_ENUM,
-    OPT_PRIMES, OPT_SECONDS, OPT_BYTES, OPT_AEAD, OPT_CMAC
+    OPT_PRIMES, OPT_SECONDS, OPT_BYTES, OPT_AEAD, OPT_CMAC, OPT_EDDSA_BATCH,
+    OPT_RSA_KEYGEN, OPT_THREADS
 } OPTION_CHOICE;
 
 const OPTIONS speed_options[] = {
@@ -232,6 +239,12 @@ const OPTIONS speed_options[] = {
     {"engine", OPT_ENGINE, 's', "Use engine, possibly a hardware device"},
 #endif
     {"primes", OPT_PRIMES, 'p', "Specify number of primes (for RSA only)"},
+    {"eddsa_batch", OPT_EDDSA_BATCH, 'p',
+     "Verify EdDSA signatures in batches of the specified size"},
+    {"rsa_keygen", OPT_RSA_KEYGEN, 'p',
+     "Time generating the specified number of keys of each RSA size"},
+    {"threads", OPT_THREADS, 'p',
+     "Allow the library to use up to the specified number of worker threads"},
 
     OPT_SECTION("Selection"),
     {"evp", OPT_EVP, 's', "Use EVP-named cipher or digest"},
@@ -472,6 +485,7 @@ typedef struct loopargs_st {
     EVP_PKEY_CTX *ecdh_ctx[EC_NUM];
     EVP_MD_CTX *eddsa_ctx[EdDSA_NUM];
     EVP_MD_CTX *eddsa_ctx2[EdDSA_NUM];
+    EVP_PKEY *eddsa_pkey[EdDSA_NUM];
 #ifndef OPENSSL_NO_SM2
     EVP_MD_CTX *sm2_ctx[SM2_NUM];
     EVP_MD_CTX *sm2_vfy_ctx[SM2_NUM];
@@ -900,6 +914,83 @@ static int RSA_verify_loop(void *args)
     return count;
 }
 
+/* Milliseconds of wall clock time, app_tminterval() may only count ticks */
+static double keygen_clock(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER count, freq;
+
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (double)count.QuadPart * 1e3 / freq.QuadPart;
+#elif defined(OPENSSL_SYS_VXWORKS)
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return now.tv_sec * 1e3 + now.tv_nsec * 1e-6;
+#else
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return now.tv_sec * 1e3 + now.tv_usec * 1e-3;
+#endif
+}
+
+static int keygen_time_cmp(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Generate |rsa_keygen| keys of |bits| bits and report how the wall clock
+ * time taken by each is spread, as that varies far more than its mean.
+ */
+static int RSA_keygen_latency(unsigned int bits, int primes)
+{
+    EVP_PKEY_CTX *genctx = NULL;
+    EVP_PKEY *pkey = NULL;
+    double *times, start, total = 0;
+    int i, ret = 0;
+
+    times = app_malloc(rsa_keygen * sizeof(*times), "RSA keygen times");
+    if (!init_gen_str(&genctx, "RSA", NULL, 0, app_get0_libctx(),
+                      app_get0_propq())
+            || EVP_PKEY_CTX_set_rsa_keygen_bits(genctx, bits) <= 0
+            || EVP_PKEY_CTX_set_rsa_keygen_primes(genctx, primes) <= 0)
+        goto end;
+
+    BIO_printf(bio_err, mr ? "+DRK:%d:%u\n"
+               : "Doing %d %u bits RSA keygens: ", rsa_keygen, bits);
+    (void)BIO_flush(bio_err);
+    for (i = 0; i < rsa_keygen; i++) {
+        start = keygen_clock();
+        if (EVP_PKEY_keygen(genctx, &pkey) <= 0)
+            goto end;
+        times[i] = keygen_clock() - start;
+        total += times[i];
+        EVP_PKEY_free(pkey);
+        pkey = NULL;
+    }
+
+    qsort(times, rsa_keygen, sizeof(*times), keygen_time_cmp);
+    if (mr)
+        BIO_printf(bio_err, "+RK:%d:%u:%.2f:%.2f:%.2f:%.2f\n",
+                   rsa_keygen, bits, total / rsa_keygen, times[rsa_keygen / 2],
+                   times[(rsa_keygen * 99 - 1) / 100], times[rsa_keygen - 1]);
+    else
+        BIO_printf(bio_err, "mean %.1fms, p50 %.1fms, p99 %.1fms, max %.1fms\n",
+                   total / rsa_keygen, times[rsa_keygen / 2],
+                   times[(rsa_keygen * 99 - 1) / 100], times[rsa_keygen - 1]);
+    ret = 1;
+ end:
+    EVP_PKEY_free(pkey);
+    EVP_PKEY_CTX_free(genctx);
+    OPENSSL_free(times);
+    return ret;
+}
+
 #ifndef OPENSSL_NO_DH
 static long ffdh_c[FFDH_NUM][1];
 
@@ -1043,6 +1134,54 @@ static int EdDSA_sign_loop(void *args)
     return count;
 }
 
+/*
+ * Verify the same signature |eddsa_batch| times per EVP_DigestVerify_batch(),
+ * allowing the faster cofactored batch equation
+ */
+static int EdDSA_verify_batch_loop(void *args)
+{
+    loopargs_t *tempargs = *(loopargs_t **) args;
+    EVP_PKEY **pkeys;
+    const unsigned char **sigs, **tbs;
+    size_t *siglens, *tbslens;
+    int i, count, cofactored = 1;
+    OSSL_PARAM params[2];
+
+    pkeys = app_malloc(eddsa_batch * sizeof(*pkeys), "EdDSA batch keys");
+    sigs = app_malloc(eddsa_batch * sizeof(*sigs), "EdDSA batch signatures");
+    tbs = app_malloc(eddsa_batch * sizeof(*tbs), "EdDSA batch messages");
+    siglens = app_malloc(eddsa_batch * sizeof(*siglens), "EdDSA batch lengths");
+    tbslens = app_malloc(eddsa_batch * sizeof(*tbslens), "EdDSA batch lengths");
+    for (i = 0; i < eddsa_batch; i++) {
+        pkeys[i] = tempargs->eddsa_pkey[testnum];
+        sigs[i] = tempargs->buf2;
+        siglens[i] = tempargs->sigsize;
+        tbs[i] = tempargs->buf;
+        tbslens[i] = 20;
+    }
+    params[0] = OSSL_PARAM_construct_int(OSSL_SIGNATURE_PARAM_COFACTORED,
+                                         &cofactored);
+    params[1] = OSSL_PARAM_construct_end();
+
+    for (count = 0; COND(eddsa_c[testnum][1]); count += eddsa_batch) {
+        if (!EVP_DigestVerify_batch(pkeys, sigs, siglens, tbs, tbslens,
+                                    eddsa_batch, app_get0_libctx(),
+                                    app_get0_propq(), params)) {
+            BIO_printf(bio_err, "EdDSA batch verify failure\n");
+            ERR_print_errors(bio_err);
+            count = -1;
+            break;
+        }
+    }
+
+    OPENSSL_free(pkeys);
+    OPENSSL_free(sigs);
+    OPENSSL_free(tbs);
+    OPENSSL_free(siglens);
+    OPENSSL_free(tbslens);
+    return count;
+}
+
 static int EdDSA_verify_loop(void *args)
 {
     loopargs_t *tempargs = *(loopargs_t **) args;
@@ -1052,6 +1191,9 @@ static int EdDSA_verify_loop(void *args)
     size_t eddsasigsize = tempargs->sigsize;
     int ret, count;
 
+    if (eddsa_batch > 0)
+        return EdDSA_verify_batch_loop(args);
+
     for (count = 0; COND(eddsa_c[testnum][1]); count++) {
         ret = EVP_DigestVerify(edctx[testnum], eddsasig, eddsasigsize, buf, 20);
         if (ret != 1) {
@@ -1422,6 +1564,7 @@ int speed_main(int argc, char **argv)
     };
     uint8_t rsa_doit[RSA_NUM] = { 0 };
     int primes = RSA_DEFAULT_PRIME_NUM;
+    int threads = 0;
 #ifndef OPENSSL_NO_DH
     typedef struct ffdh_params_st {
         const char *name;
@@ -1624,6 +1767,18 @@ int speed_main(int argc, char **argv)
             if (!opt_int(opt_arg(), &primes))
                 goto end;
             break;
+        case OPT_EDDSA_BATCH:
+            if (!opt_int(opt_arg(), &eddsa_batch))
+                goto end;
+            break;
+        case OPT_RSA_KEYGEN:
+            if (!opt_int(opt_arg(), &rsa_keygen))
+                goto end;
+            break;
+        case OPT_THREADS:
+            if (!opt_int(opt_arg(), &threads))
+                goto end;
+            break;
         case OPT_SECONDS:
             seconds.sym = seconds.rsa = seconds.dsa = seconds.ecdsa
                         = seconds.ecdh = seconds.eddsa
@@ -1774,6 +1929,12 @@ int speed_main(int argc, char **argv)
         }
     }
 
+    if (threads > 0 && !OSSL_set_max_threads(app_get0_libctx(), threads)) {
+        BIO_printf(bio_err, "%s: cannot use %d worker threads\n", prog,
+                   threads);
+        goto end;
+    }
+
     /* Initialize the job pool if async mode is enabled */
     if (async_jobs > 0) {
         async_init = ASYNC_init_thread(async_jobs, async_jobs);
@@ -2351,6 +2512,14 @@ int speed_main(int argc, char **argv)
         if (!rsa_doit[testnum])
             continue;
 
+        if (rsa_keygen > 0
+                && !RSA_keygen_latency(rsa_keys[testnum].bits, primes)) {
+            BIO_printf(bio_err,
+                       "RSA keygen failure.  No RSA keygen will be timed.\n");
+            ERR_print_errors(bio_err);
+            rsa_keygen = 0;
+        }
+
         if (primes > RSA_DEFAULT_PRIME_NUM) {
             /* we haven't set keys yet,  generate multi-prime RSA keys */
             bn = BN_new();
@@ -2726,7 +2895,8 @@ int speed_main(int argc, char **argv)
                 break;
             }
 
-            EVP_PKEY_free(ed_pkey);
+            /* Kept for -eddsa_batch, freed with the contexts */
+            loopargs[i].eddsa_pkey[testnum] = ed_pkey;
             ed_pkey = NULL;
         }
         if (st == 0) {
@@ -3321,6 +3491,7 @@ int speed_main(int argc, char **argv)
         for (k = 0; k < EdDSA_NUM; k++) {
             EVP_MD_CTX_free(loopargs[i].eddsa_ctx[k]);
             EVP_MD_CTX_free(loopargs[i].eddsa_ctx2[k]);
+            EVP_PKEY_free(loopargs[i].eddsa_pkey[k]);
         }
 #ifndef OPENSSL_NO_SM2
         for (k = 0; k < SM2_NUM; k++) {
@@ -1,5 +1,5 @@
 /*
- * Copyright 2011-2018 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2011-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -125,4 +125,14 @@ extern unsigned int OPENSSL_arm_midr;
 
 # define MIDR_IS_CPU_MODEL(midr, imp, partnum) \
            (((midr) & MIDR_CPU_MODEL_MASK) == MIDR_CPU_MODEL(imp, partnum))
+
+/*
+ * Landing pad for assembler functions that can be reached by indirect calls,
+ * needed when the code is built for Armv8.5-A Branch Target Identification.
+ */
+# if defined(__ARM_FEATURE_BTI_DEFAULT) && __ARM_FEATURE_BTI_DEFAULT == 1
+#  define AARCH64_VALID_CALL_TARGET hint #34     /* BTI 'c' */
+# else
+#  define AARCH64_VALID_CALL_TARGET
+# endif
 #endif
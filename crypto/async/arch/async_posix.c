@@ -1,5 +1,5 @@
 /*
- * Copyright 2015-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2015-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -13,12 +13,21 @@
 #ifdef ASYNC_POSIX
 
 # include <stddef.h>
+# include <string.h>
 # include <unistd.h>
+# include <sys/mman.h>
 
 #define STACKSIZE       32768
 
+#if !defined(MAP_ANON) && defined(MAP_ANONYMOUS)
+# define MAP_ANON MAP_ANONYMOUS
+#endif
+
 int ASYNC_is_capable(void)
 {
+#ifdef USE_ASM_SWITCH
+    return 1;
+#else
     ucontext_t ctx;
 
     /*
@@ -26,35 +35,105 @@ int ASYNC_is_capable(void)
      * MacOSX PPC64). Check for a working getcontext();
      */
     return getcontext(&ctx) == 0;
+#endif
 }
 
 void async_local_cleanup(void)
 {
 }
 
-int async_fibre_makecontext(async_fibre *fibre)
+#ifdef MAP_ANON
+static size_t async_page_size(void)
 {
-#ifndef USE_SWAPCONTEXT
-    fibre->env_init = 0;
+# if defined(_SC_PAGE_SIZE) || defined(_SC_PAGESIZE)
+#  if defined(_SC_PAGE_SIZE)
+    long pgsize = sysconf(_SC_PAGE_SIZE);
+#  else
+    long pgsize = sysconf(_SC_PAGESIZE);
+#  endif
+
+    if (pgsize > 0)
+        return (size_t)pgsize;
+# endif
+    return 4096;
+}
+
+/*
+ * Map the stack with an inaccessible page below it, so that an overflow
+ * faults instead of silently corrupting whatever lies next to it on the heap.
+ */
+static unsigned char *async_stack_map(async_fibre *fibre, size_t *stacksize)
+{
+    size_t pgsize = async_page_size();
+    size_t size = (*stacksize + pgsize - 1) & ~(pgsize - 1);
+    unsigned char *map;
+
+    map = mmap(NULL, size + pgsize, PROT_READ | PROT_WRITE,
+               MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (map == MAP_FAILED)
+        return NULL;
+    if (mprotect(map, pgsize, PROT_NONE) != 0) {
+        munmap(map, size + pgsize);
+        return NULL;
+    }
+    fibre->map_size = size + pgsize;
+    *stacksize = size;
+    return map + pgsize;
+}
 #endif
-    if (getcontext(&fibre->fibre) == 0) {
-        fibre->fibre.uc_stack.ss_sp = OPENSSL_malloc(STACKSIZE);
-        if (fibre->fibre.uc_stack.ss_sp != NULL) {
-            fibre->fibre.uc_stack.ss_size = STACKSIZE;
-            fibre->fibre.uc_link = NULL;
-            makecontext(&fibre->fibre, async_start_func, 0);
-            return 1;
-        }
-    } else {
-        fibre->fibre.uc_stack.ss_sp = NULL;
+
+int async_fibre_makecontext(async_fibre *fibre, size_t stacksize,
+                            unsigned int flags)
+{
+    unsigned char *stack = NULL;
+
+    fibre->stack = NULL;
+    fibre->map_size = 0;
+    if (stacksize == 0)
+        stacksize = STACKSIZE;
+#ifdef MAP_ANON
+    if ((flags & ASYNC_STACK_GUARD) != 0)
+        stack = async_stack_map(fibre, &stacksize);
+    else
+#endif
+        stack = OPENSSL_malloc(stacksize);
+    if (stack == NULL)
+        return 0;
+    fibre->stack = stack;
+    fibre->stack_size = stacksize;
+
+    /* Fault the stack in now rather than on the job's first run */
+    if ((flags & ASYNC_STACK_PREFAULT) != 0)
+        memset(stack, 0, stacksize);
+
+#ifdef USE_ASM_SWITCH
+    fibre->sp = async_fibre_prepare(stack + stacksize, async_start_func);
+#else
+# ifndef USE_SWAPCONTEXT
+    fibre->env_init = 0;
+# endif
+    if (getcontext(&fibre->fibre) != 0) {
+        async_fibre_free(fibre);
+        return 0;
     }
-    return 0;
+    fibre->fibre.uc_stack.ss_sp = stack;
+    fibre->fibre.uc_stack.ss_size = stacksize;
+    fibre->fibre.uc_link = NULL;
+    makecontext(&fibre->fibre, async_start_func, 0);
+#endif
+    return 1;
 }
 
 void async_fibre_free(async_fibre *fibre)
 {
-    OPENSSL_free(fibre->fibre.uc_stack.ss_sp);
-    fibre->fibre.uc_stack.ss_sp = NULL;
+    if (fibre->map_size != 0) {
+        munmap(fibre->stack - (fibre->map_size - fibre->stack_size),
+               fibre->map_size);
+        fibre->map_size = 0;
+    } else {
+        OPENSSL_free(fibre->stack);
+    }
+    fibre->stack = NULL;
 }
 
 #endif
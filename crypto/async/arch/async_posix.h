@@ -1,5 +1,5 @@
 /*
- * Copyright 2015-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2015-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -34,24 +34,54 @@
  */
 #   define USE_SWAPCONTEXT
 #  endif
-#  include <ucontext.h>
-#  ifndef USE_SWAPCONTEXT
-#   include <setjmp.h>
+#  if defined(ASYNC_FIBRE_ASM) && !defined(USE_SWAPCONTEXT) \
+      && !defined(__SANITIZE_ADDRESS__)
+/*
+ * Switch fibres with a few instructions that save the callee-saved
+ * registers and change stacks, see crypto/async/asm.  This avoids the
+ * extra work done by _setjmp/_longjmp and the signal mask system call
+ * that setcontext makes the first time each fibre is entered.
+ */
+#   define USE_ASM_SWITCH
+#  else
+#   include <ucontext.h>
+#   ifndef USE_SWAPCONTEXT
+#    include <setjmp.h>
+#   endif
 #  endif
 
 typedef struct async_fibre_st {
+#  ifdef USE_ASM_SWITCH
+    void *sp;
+#  else
     ucontext_t fibre;
-#  ifndef USE_SWAPCONTEXT
+#   ifndef USE_SWAPCONTEXT
     jmp_buf env;
     int env_init;
+#   endif
 #  endif
+    unsigned char *stack;
+    size_t stack_size;
+    /* Size of the mapping holding the stack and its guard page, if mapped */
+    size_t map_size;
 } async_fibre;
 
+#  ifdef USE_ASM_SWITCH
+void async_fibre_swap(void **save_sp, void *sp);
+void *async_fibre_prepare(void *stack_top, void (*func)(void));
+
 static ossl_inline int async_fibre_swapcontext(async_fibre *o, async_fibre *n, int r)
 {
-#  ifdef USE_SWAPCONTEXT
-    swapcontext(&o->fibre, &n->fibre);
+    async_fibre_swap(&o->sp, n->sp);
+
+    return 1;
+}
 #  else
+static ossl_inline int async_fibre_swapcontext(async_fibre *o, async_fibre *n, int r)
+{
+#   ifdef USE_SWAPCONTEXT
+    swapcontext(&o->fibre, &n->fibre);
+#   else
     o->env_init = 1;
 
     if (!r || !_setjmp(o->env)) {
@@ -60,14 +90,16 @@ static ossl_inline int async_fibre_swapcontext(async_fibre *o, async_fibre *n, i
         else
             setcontext(&n->fibre);
     }
-#  endif
+#   endif
 
     return 1;
 }
+#  endif
 
 #  define async_fibre_init_dispatcher(d)
 
-int async_fibre_makecontext(async_fibre *fibre);
+int async_fibre_makecontext(async_fibre *fibre, size_t stacksize,
+                            unsigned int flags);
 void async_fibre_free(async_fibre *fibre);
 
 # endif
@@ -28,12 +28,12 @@ typedef struct async_fibre_st {
         (SwitchToFiber((n)->fibre), 1)
 
 # if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x600
-#   define async_fibre_makecontext(c) \
-        ((c)->fibre = CreateFiberEx(0, 0, FIBER_FLAG_FLOAT_SWITCH, \
+#   define async_fibre_makecontext(c, s, f) \
+        ((c)->fibre = CreateFiberEx(0, (s), FIBER_FLAG_FLOAT_SWITCH, \
                                     async_start_func_win, 0))
 # else
-#   define async_fibre_makecontext(c) \
-        ((c)->fibre = CreateFiber(0, async_start_func_win, 0))
+#   define async_fibre_makecontext(c, s, f) \
+        ((c)->fibre = CreateFiber((s), async_start_func_win, 0))
 # endif
 
 # define async_fibre_free(f)             (DeleteFiber((f)->fibre))
@@ -0,0 +1,163 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# Fibre switching for the POSIX ASYNC_JOB implementation, see
+# async-x86_64.pl for the interface.
+#
+# Saved frame, from the saved stack pointer upwards:
+#
+#	x19-x28 x29 x30 d8-d15 fpcr pad
+#
+# FPCR holds the rounding mode and other floating-point controls, which
+# the ABI requires a callee to preserve like the registers.  It is only
+# written back when it differs, as writing it can be slow.
+#
+# async_fibre_prepare leaves the function to run in the x19 slot and
+# async_fibre_entry in the x30 slot of a fresh stack, and the FPCR of the
+# thread that prepared it in the fpcr slot.
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}arm-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/arm-xlate.pl" and -f $xlate) or
+die "can't locate arm-xlate.pl";
+
+open OUT,"| \"$^X\" $xlate $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+$code.=<<___;
+#include "arm_arch.h"
+
+.text
+
+.globl	async_fibre_swap
+.type	async_fibre_swap,%function
+.align	5
+async_fibre_swap:
+.cfi_startproc
+	AARCH64_VALID_CALL_TARGET
+	sub	sp,sp,#176
+.cfi_def_cfa_offset	176
+	stp	x19,x20,[sp,#0]
+	stp	x21,x22,[sp,#16]
+	stp	x23,x24,[sp,#32]
+	stp	x25,x26,[sp,#48]
+	stp	x27,x28,[sp,#64]
+	stp	x29,x30,[sp,#80]
+	stp	d8,d9,[sp,#96]
+	stp	d10,d11,[sp,#112]
+	stp	d12,d13,[sp,#128]
+	stp	d14,d15,[sp,#144]
+.cfi_offset	x19,-176
+.cfi_offset	x20,-168
+.cfi_offset	x21,-160
+.cfi_offset	x22,-152
+.cfi_offset	x23,-144
+.cfi_offset	x24,-136
+.cfi_offset	x25,-128
+.cfi_offset	x26,-120
+.cfi_offset	x27,-112
+.cfi_offset	x28,-104
+.cfi_offset	x29,-96
+.cfi_offset	x30,-88
+.cfi_offset	d8,-80
+.cfi_offset	d9,-72
+.cfi_offset	d10,-64
+.cfi_offset	d11,-56
+.cfi_offset	d12,-48
+.cfi_offset	d13,-40
+.cfi_offset	d14,-32
+.cfi_offset	d15,-24
+	mrs	x3,fpcr
+	str	x3,[sp,#160]
+	mov	x2,sp
+	str	x2,[x0]
+	mov	sp,x1			// the other fibre's frame has the same
+					// layout, so the CFI above holds for it
+	ldr	x2,[sp,#160]
+	cmp	x2,x3
+	b.eq	.Lfpcr_same
+	msr	fpcr,x2
+.Lfpcr_same:
+	ldp	x19,x20,[sp,#0]
+	ldp	x21,x22,[sp,#16]
+	ldp	x23,x24,[sp,#32]
+	ldp	x25,x26,[sp,#48]
+	ldp	x27,x28,[sp,#64]
+	ldp	x29,x30,[sp,#80]
+	ldp	d8,d9,[sp,#96]
+	ldp	d10,d11,[sp,#112]
+	ldp	d12,d13,[sp,#128]
+	ldp	d14,d15,[sp,#144]
+	add	sp,sp,#176
+.cfi_def_cfa_offset	0
+.cfi_restore	x19
+.cfi_restore	x20
+.cfi_restore	x21
+.cfi_restore	x22
+.cfi_restore	x23
+.cfi_restore	x24
+.cfi_restore	x25
+.cfi_restore	x26
+.cfi_restore	x27
+.cfi_restore	x28
+.cfi_restore	x29
+.cfi_restore	x30
+.cfi_restore	d8
+.cfi_restore	d9
+.cfi_restore	d10
+.cfi_restore	d11
+.cfi_restore	d12
+.cfi_restore	d13
+.cfi_restore	d14
+.cfi_restore	d15
+	ret
+.cfi_endproc
+.size	async_fibre_swap,.-async_fibre_swap
+
+.globl	async_fibre_prepare
+.type	async_fibre_prepare,%function
+.align	5
+async_fibre_prepare:
+.cfi_startproc
+	AARCH64_VALID_CALL_TARGET
+	and	x0,x0,#-16
+	sub	x0,x0,#176
+	adr	x2,async_fibre_entry
+	mrs	x3,fpcr
+	stp	x1,xzr,[x0,#0]		// x19 is the function to run
+	stp	xzr,xzr,[x0,#16]
+	stp	xzr,xzr,[x0,#32]
+	stp	xzr,xzr,[x0,#48]
+	stp	xzr,xzr,[x0,#64]
+	stp	xzr,x2,[x0,#80]		// x29 ends frame chains, x30 is entry
+	str	x3,[x0,#160]		// FPCR of this thread
+	ret
+.cfi_endproc
+.size	async_fibre_prepare,.-async_fibre_prepare
+
+// Reached by the ret in async_fibre_swap, which BTI does not check
+.type	async_fibre_entry,%function
+.align	5
+async_fibre_entry:
+.cfi_startproc
+.cfi_undefined	x30			// outermost frame of the fibre
+	blr	x19
+	brk	#0			// the fibre function never returns
+.cfi_endproc
+.size	async_fibre_entry,.-async_fibre_entry
+___
+
+print $code;
+close STDOUT or die "error closing STDOUT: $!";
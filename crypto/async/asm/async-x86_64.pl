@@ -0,0 +1,149 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# Fibre switching for the POSIX ASYNC_JOB implementation.
+#
+# async_fibre_swap saves the callee-saved registers, as well as the MXCSR
+# and x87 control words that the ABI also requires a callee to preserve, on
+# the current stack, stores the stack pointer through its first argument,
+# and resumes the fibre whose saved stack pointer is its second argument.
+# This replaces _setjmp/_longjmp and setcontext, which do a good deal more
+# work (and in the latter case a sigprocmask system call) than is needed
+# here.
+#
+# Saved frame, from the saved stack pointer upwards:
+#
+#	mxcsr(4) x87cw(2) pad(2) %r15 %r14 %r13 %r12 %rbx %rbp return-address
+#
+# async_fibre_prepare builds such a frame at the top of a fresh stack, so
+# that the first switch "returns" to async_fibre_entry, which calls the
+# function left in the %rbx slot.  The new fibre starts with the control
+# words of the thread that prepared it.
+#
+# Round trip between two fibres, in nanoseconds:
+#
+#			this module	_setjmp/_longjmp	swapcontext
+# Xeon (VM)		13		31			700
+#
+# Saving and restoring the control words accounts for about 6ns of this.
+#
+# The functions start with endbr64 landing pads, but returning through
+# jmp is not compatible with indirect branch tracking, so CET builds keep
+# using swapcontext, see async_posix.h.
+#
+# The code uses the SysV calling convention; the Windows build uses
+# native fibres instead, so nothing is emitted for Win64.
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+$code=<<___ if (!$win64);
+.text
+
+.globl	async_fibre_swap
+.type	async_fibre_swap,\@abi-omnipotent
+.align	16
+async_fibre_swap:
+.cfi_startproc
+	endbranch
+	push	%rbp
+.cfi_push	%rbp
+	push	%rbx
+.cfi_push	%rbx
+	push	%r12
+.cfi_push	%r12
+	push	%r13
+.cfi_push	%r13
+	push	%r14
+.cfi_push	%r14
+	push	%r15
+.cfi_push	%r15
+	sub	\$8,%rsp
+.cfi_adjust_cfa_offset	8
+	stmxcsr	0(%rsp)
+	fnstcw	4(%rsp)
+	mov	%rsp,(%rdi)
+	mov	%rsi,%rsp		# the other fibre's frame has the same
+					# layout, so the CFI above holds for it
+	ldmxcsr	0(%rsp)
+	fldcw	4(%rsp)
+	add	\$8,%rsp
+.cfi_adjust_cfa_offset	-8
+	pop	%r15
+.cfi_pop	%r15
+	pop	%r14
+.cfi_pop	%r14
+	pop	%r13
+.cfi_pop	%r13
+	pop	%r12
+.cfi_pop	%r12
+	pop	%rbx
+.cfi_pop	%rbx
+	pop	%rbp
+.cfi_pop	%rbp
+	pop	%rcx			# not ret, which would mispredict every
+.cfi_adjust_cfa_offset	-8
+.cfi_register	%rip,%rcx
+	jmp	*%rcx			# time as the return stack buffer
+					# still holds the other fibre's caller
+.cfi_endproc
+.size	async_fibre_swap,.-async_fibre_swap
+
+.globl	async_fibre_prepare
+.type	async_fibre_prepare,\@abi-omnipotent
+.align	16
+async_fibre_prepare:
+.cfi_startproc
+	endbranch
+	mov	%rdi,%rax
+	and	\$-16,%rax
+	sub	\$80,%rax		# leaves %rsp 16-byte aligned after ret
+	lea	async_fibre_entry(%rip),%rcx
+	xor	%edx,%edx
+	mov	%rdx,0(%rax)
+	stmxcsr	0(%rax)			# control words of this thread
+	fnstcw	4(%rax)
+	mov	%rdx,8(%rax)		# %r15
+	mov	%rdx,16(%rax)		# %r14
+	mov	%rdx,24(%rax)		# %r13
+	mov	%rdx,32(%rax)		# %r12
+	mov	%rsi,40(%rax)		# %rbx, the function to run
+	mov	%rdx,48(%rax)		# %rbp, ends frame pointer chains
+	mov	%rcx,56(%rax)		# return address
+	ret
+.cfi_endproc
+.size	async_fibre_prepare,.-async_fibre_prepare
+
+.type	async_fibre_entry,\@abi-omnipotent
+.align	16
+async_fibre_entry:
+.cfi_startproc
+.cfi_undefined	%rip			# outermost frame of the fibre
+	endbranch			# reached by the jmp in async_fibre_swap
+	call	*%rbx
+	ud2				# the fibre function never returns
+.cfi_endproc
+.size	async_fibre_entry,.-async_fibre_entry
+___
+
+print $code;
+close STDOUT or die "error closing STDOUT: $!";
@@ -1,5 +1,5 @@
 /*
- * Copyright 2015-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2015-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -27,6 +27,9 @@
 #define ASYNC_JOB_PAUSED    2
 #define ASYNC_JOB_STOPPING  3
 
+/* Smallest non-default stack size accepted by ASYNC_init_thread_ex() */
+#define ASYNC_MIN_STACK_SIZE    8192
+
 static CRYPTO_THREAD_LOCAL ctxkey;
 static CRYPTO_THREAD_LOCAL poolkey;
 
@@ -77,7 +80,9 @@ static int async_ctx_free(void)
     return 1;
 }
 
-static ASYNC_JOB *async_job_new(void)
+static void async_job_free(ASYNC_JOB *job);
+
+static ASYNC_JOB *async_job_new(async_pool *pool)
 {
     ASYNC_JOB *job = NULL;
 
@@ -88,6 +93,12 @@ static ASYNC_JOB *async_job_new(void)
     }
 
     job->status = ASYNC_JOB_RUNNING;
+    job->pool = pool;
+    if (!async_fibre_makecontext(&job->fibrectx, pool->stack_size,
+                                 pool->flags)) {
+        async_job_free(job);
+        return NULL;
+    }
 
     return job;
 }
@@ -101,6 +112,49 @@ static void async_job_free(ASYNC_JOB *job)
     }
 }
 
+/*
+ * Drop a reference to |pool|. The thread that created the pool holds one and
+ * every job accounted for in it holds another, so a job still running on
+ * another thread keeps the pool alive after its thread has gone.
+ */
+static void async_pool_free(async_pool *pool)
+{
+    int i;
+
+    CRYPTO_DOWN_REF(&pool->references, &i, pool->lock);
+    if (i > 0)
+        return;
+    sk_ASYNC_JOB_free(pool->jobs);
+    CRYPTO_THREAD_lock_free(pool->lock);
+    OPENSSL_free(pool);
+}
+
+/* Account for a new job in |pool|, if that does not exceed its maximum size */
+static int async_pool_add(async_pool *pool)
+{
+    int ret = 0, i;
+
+    if (!CRYPTO_THREAD_write_lock(pool->lock))
+        return 0;
+    if (pool->max_size == 0 || pool->curr_size < pool->max_size) {
+        pool->curr_size++;
+        ret = 1;
+    }
+    CRYPTO_THREAD_unlock(pool->lock);
+    if (ret)
+        CRYPTO_UP_REF(&pool->references, &i, pool->lock);
+    return ret;
+}
+
+static void async_pool_remove(async_pool *pool)
+{
+    if (!CRYPTO_THREAD_write_lock(pool->lock))
+        return;
+    pool->curr_size--;
+    CRYPTO_THREAD_unlock(pool->lock);
+    async_pool_free(pool);
+}
+
 static ASYNC_JOB *async_get_pool_job(void) {
     ASYNC_JOB *job;
     async_pool *pool;
@@ -119,17 +173,12 @@ static ASYNC_JOB *async_get_pool_job(void) {
     job = sk_ASYNC_JOB_pop(pool->jobs);
     if (job == NULL) {
         /* Pool is empty */
-        if ((pool->max_size != 0) && (pool->curr_size >= pool->max_size))
+        if (!async_pool_add(pool))
             return NULL;
 
-        job = async_job_new();
-        if (job != NULL) {
-            if (! async_fibre_makecontext(&job->fibrectx)) {
-                async_job_free(job);
-                return NULL;
-            }
-            pool->curr_size++;
-        }
+        job = async_job_new(pool);
+        if (job == NULL)
+            async_pool_remove(pool);
     }
     return job;
 }
@@ -140,20 +189,44 @@ static void async_release_job(ASYNC_JOB *job) {
     pool = (async_pool *)CRYPTO_THREAD_get_local(&poolkey);
     OPENSSL_free(job->funcargs);
     job->funcargs = NULL;
-    sk_ASYNC_JOB_push(pool->jobs, job);
+    if (job->pool != pool) {
+        /*
+         * The job was resumed on a thread other than the one that created it.
+         * Hand it over to this thread's pool if it has room, so that the
+         * creating thread may go on to create a replacement.
+         */
+        async_pool_remove(job->pool);
+        job->pool = NULL;
+        if (pool == NULL || !async_pool_add(pool)) {
+            async_job_free(job);
+            return;
+        }
+        job->pool = pool;
+    }
+    if (!sk_ASYNC_JOB_push(pool->jobs, job)) {
+        async_pool_remove(pool);
+        async_job_free(job);
+    }
 }
 
 void async_start_func(void)
 {
     ASYNC_JOB *job;
-    async_ctx *ctx = async_get_ctx();
+    async_ctx *ctx;
 
     while (1) {
+        /*
+         * Fetch the context afresh every time: a paused job may have been
+         * resumed by a different thread.
+         */
+        ctx = async_get_ctx();
+
         /* Run the job */
         job = ctx->currjob;
         job->ret = job->func(job->funcargs);
 
         /* Stop the job */
+        ctx = async_get_ctx();
         job->status = ASYNC_JOB_STOPPING;
         if (!async_fibre_swapcontext(&job->fibrectx,
                                      &ctx->dispatcher, 1)) {
@@ -307,10 +380,10 @@ static void async_empty_pool(async_pool *pool)
     if (pool == NULL || pool->jobs == NULL)
         return;
 
-    do {
-        job = sk_ASYNC_JOB_pop(pool->jobs);
+    while ((job = sk_ASYNC_JOB_pop(pool->jobs)) != NULL) {
         async_job_free(job);
-    } while (job);
+        async_pool_remove(pool);
+    }
 }
 
 int async_init(void)
@@ -333,6 +406,12 @@ void async_deinit(void)
 }
 
 int ASYNC_init_thread(size_t max_size, size_t init_size)
+{
+    return ASYNC_init_thread_ex(max_size, init_size, 0, 0);
+}
+
+int ASYNC_init_thread_ex(size_t max_size, size_t init_size,
+                         size_t stack_size, unsigned int flags)
 {
     async_pool *pool;
     size_t curr_size = 0;
@@ -341,6 +420,14 @@ int ASYNC_init_thread(size_t max_size, size_t init_size)
         ERR_raise(ERR_LIB_ASYNC, ASYNC_R_INVALID_POOL_SIZE);
         return 0;
     }
+    if (stack_size != 0 && stack_size < ASYNC_MIN_STACK_SIZE) {
+        ERR_raise(ERR_LIB_ASYNC, ASYNC_R_INVALID_STACK_SIZE);
+        return 0;
+    }
+    if ((flags & ~(ASYNC_STACK_GUARD | ASYNC_STACK_PREFAULT)) != 0) {
+        ERR_raise(ERR_LIB_ASYNC, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
 
     if (!OPENSSL_init_crypto(OPENSSL_INIT_ASYNC, NULL))
         return 0;
@@ -355,24 +442,29 @@ int ASYNC_init_thread(size_t max_size, size_t init_size)
     }
 
     pool->jobs = sk_ASYNC_JOB_new_reserve(NULL, init_size);
-    if (pool->jobs == NULL) {
+    pool->lock = CRYPTO_THREAD_lock_new();
+    if (pool->jobs == NULL || pool->lock == NULL) {
         ERR_raise(ERR_LIB_ASYNC, ERR_R_MALLOC_FAILURE);
+        sk_ASYNC_JOB_free(pool->jobs);
+        CRYPTO_THREAD_lock_free(pool->lock);
         OPENSSL_free(pool);
         return 0;
     }
 
+    pool->references = 1;
     pool->max_size = max_size;
+    pool->stack_size = stack_size;
+    pool->flags = flags;
 
     /* Pre-create jobs as required */
     while (init_size--) {
         ASYNC_JOB *job;
-        job = async_job_new();
-        if (job == NULL || !async_fibre_makecontext(&job->fibrectx)) {
+        job = async_job_new(pool);
+        if (job == NULL) {
             /*
              * Not actually fatal because we already created the pool, just
              * skip creation of any more jobs
              */
-            async_job_free(job);
             break;
         }
         job->funcargs = NULL;
@@ -380,6 +472,7 @@ int ASYNC_init_thread(size_t max_size, size_t init_size)
         curr_size++;
     }
     pool->curr_size = curr_size;
+    pool->references += (int)curr_size;
     if (!CRYPTO_THREAD_set_local(&poolkey, pool)) {
         ERR_raise(ERR_LIB_ASYNC, ASYNC_R_FAILED_TO_SET_POOL);
         goto err;
@@ -388,8 +481,7 @@ int ASYNC_init_thread(size_t max_size, size_t init_size)
     return 1;
 err:
     async_empty_pool(pool);
-    sk_ASYNC_JOB_free(pool->jobs);
-    OPENSSL_free(pool);
+    async_pool_free(pool);
     return 0;
 }
 
@@ -400,9 +492,8 @@ static void async_delete_thread_state(void *arg)
 
     if (pool != NULL) {
         async_empty_pool(pool);
-        sk_ASYNC_JOB_free(pool->jobs);
-        OPENSSL_free(pool);
         CRYPTO_THREAD_set_local(&poolkey, NULL);
+        async_pool_free(pool);
     }
     async_local_cleanup();
     async_ctx_free();
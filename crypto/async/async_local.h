@@ -1,5 +1,5 @@
 /*
- * Copyright 2015-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2015-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -21,6 +21,7 @@
 #endif
 
 #include "crypto/async.h"
+#include "internal/refcount.h"
 #include <openssl/crypto.h>
 
 typedef struct async_ctx_st async_ctx;
@@ -44,6 +45,8 @@ struct async_job_st {
     int status;
     ASYNC_WAIT_CTX *waitctx;
     OSSL_LIB_CTX *libctx;
+    /* The pool of the thread that created the job and accounts for it */
+    async_pool *pool;
 };
 
 struct fd_lookup_st {
@@ -69,8 +72,17 @@ DEFINE_STACK_OF(ASYNC_JOB)
 
 struct async_pool_st {
     STACK_OF(ASYNC_JOB) *jobs;
+    /*
+     * Other threads finishing jobs created here decrement curr_size, so it
+     * is only changed with |lock| held.
+     */
+    CRYPTO_RWLOCK *lock;
+    /* The creating thread and each job in curr_size hold a reference */
+    CRYPTO_REF_COUNT references;
     size_t curr_size;
     size_t max_size;
+    size_t stack_size;
+    unsigned int flags;
 };
 
 void async_local_cleanup(void);
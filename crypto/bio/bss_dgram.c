@@ -7,6 +7,15 @@
  * https://www.openssl.org/source/license.html
  */
 
+/*
+ * We need to do this early, because stdio.h includes the header files that
+ * handle _GNU_SOURCE and other similar macros.  Defining it later is simply
+ * too late, because those headers are protected from re- inclusion.
+ */
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE            /* make sure recvmmsg() and sendmmsg() are declared */
+#endif
+
 #include <stdio.h>
 #include <errno.h>
 
@@ -24,6 +33,15 @@
 #  define IP_MTU      14        /* linux is lame */
 # endif
 
+/* sendmmsg() was only added in glibc 2.14 */
+# if defined(OPENSSL_SYS_LINUX) && defined(MSG_WAITFORONE) \
+    && (!defined(__GLIBC__) || __GLIBC__ > 2 \
+        || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 14))
+#  define DGRAM_HAVE_MMSG
+# endif
+/* The most datagrams passed to the kernel in one recvmmsg() or sendmmsg() */
+# define DGRAM_MMSG_MAX 64
+
 # if OPENSSL_USE_IPV6 && !defined(IPPROTO_IPV6)
 #  define IPPROTO_IPV6 41       /* windows is lame */
 # endif
@@ -40,6 +58,8 @@
 
 static int dgram_write(BIO *h, const char *buf, int num);
 static int dgram_read(BIO *h, char *buf, int size);
+static long dgram_sendmmsg(BIO *b, BIO_DGRAM_MSG *msg, size_t num);
+static long dgram_recvmmsg(BIO *b, BIO_DGRAM_MSG *msg, size_t num);
 static int dgram_puts(BIO *h, const char *str);
 static long dgram_ctrl(BIO *h, int cmd, long arg1, void *arg2);
 static int dgram_new(BIO *h);
@@ -355,6 +375,143 @@ static int dgram_write(BIO *b, const char *in, int inl)
     return ret;
 }
 
+/*
+ * Send up to |num| datagrams, each to its own peer if one is given. Returns
+ * the number of datagrams sent, or <= 0 with the retry flags set as by
+ * dgram_write() if none could be sent.
+ */
+static long dgram_sendmmsg(BIO *b, BIO_DGRAM_MSG *msg, size_t num)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    BIO_ADDR *peer;
+    size_t i;
+    long ret;
+# ifdef DGRAM_HAVE_MMSG
+    struct mmsghdr mh[DGRAM_MMSG_MAX];
+    struct iovec iov[DGRAM_MMSG_MAX];
+
+    if (num > DGRAM_MMSG_MAX)
+        num = DGRAM_MMSG_MAX;
+    memset(mh, 0, sizeof(mh[0]) * num);
+    for (i = 0; i < num; i++) {
+        iov[i].iov_base = msg[i].data;
+        iov[i].iov_len = msg[i].data_len;
+        mh[i].msg_hdr.msg_iov = &iov[i];
+        mh[i].msg_hdr.msg_iovlen = 1;
+        peer = msg[i].peer != NULL ? msg[i].peer
+               : data->connected ? NULL : &data->peer;
+        if (peer != NULL) {
+            mh[i].msg_hdr.msg_name = BIO_ADDR_sockaddr_noconst(peer);
+            mh[i].msg_hdr.msg_namelen = BIO_ADDR_sockaddr_size(peer);
+        }
+    }
+
+    clear_socket_error();
+    ret = sendmmsg(b->num, mh, (unsigned int)num, 0);
+    for (i = 0; ret > 0 && i < (size_t)ret; i++)
+        b->num_write += mh[i].msg_len;
+# else
+    int n = 0;
+
+    clear_socket_error();
+    for (ret = 0, i = 0; i < num; i++, ret++) {
+        if (msg[i].peer == NULL) {
+            n = dgram_write(b, msg[i].data, (int)msg[i].data_len);
+        } else {
+            peer = msg[i].peer;
+            n = sendto(b->num, msg[i].data, (int)msg[i].data_len, 0,
+                       BIO_ADDR_sockaddr(peer), BIO_ADDR_sockaddr_size(peer));
+        }
+        if (n < 0)
+            break;
+        b->num_write += n;
+    }
+    /* Report the failure of the first datagram, the others are retried */
+    if (ret == 0)
+        ret = n;
+# endif
+
+    BIO_clear_retry_flags(b);
+    if (ret <= 0) {
+        if (BIO_dgram_should_retry(ret)) {
+            BIO_set_retry_write(b);
+            data->_errno = get_last_socket_error();
+        }
+    }
+    return ret;
+}
+
+/*
+ * Receive up to |num| datagrams, waiting only for the first one if the
+ * socket is blocking. The length of each datagram received is stored in its
+ * data_len. Returns the number of datagrams received, or <= 0 with the retry
+ * flags set as by dgram_read() if there were none.
+ */
+static long dgram_recvmmsg(BIO *b, BIO_DGRAM_MSG *msg, size_t num)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    long ret;
+# ifdef DGRAM_HAVE_MMSG
+    struct mmsghdr mh[DGRAM_MMSG_MAX];
+    struct iovec iov[DGRAM_MMSG_MAX];
+    BIO_ADDR peer[DGRAM_MMSG_MAX];
+    size_t i;
+    int flags = MSG_WAITFORONE;
+
+    /* Peeking at several datagrams would only ever see the first one */
+    if (data->peekmode) {
+        num = 1;
+        flags |= MSG_PEEK;
+    }
+    if (num > DGRAM_MMSG_MAX)
+        num = DGRAM_MMSG_MAX;
+    memset(mh, 0, sizeof(mh[0]) * num);
+    memset(peer, 0, sizeof(peer[0]) * num);
+    for (i = 0; i < num; i++) {
+        iov[i].iov_base = msg[i].data;
+        iov[i].iov_len = msg[i].data_len;
+        mh[i].msg_hdr.msg_iov = &iov[i];
+        mh[i].msg_hdr.msg_iovlen = 1;
+        mh[i].msg_hdr.msg_name = BIO_ADDR_sockaddr_noconst(&peer[i]);
+        mh[i].msg_hdr.msg_namelen = sizeof(peer[i]);
+    }
+
+    clear_socket_error();
+    dgram_adjust_rcv_timeout(b);
+    ret = recvmmsg(b->num, mh, (unsigned int)num, flags, NULL);
+
+    for (i = 0; ret > 0 && i < (size_t)ret; i++) {
+        msg[i].data_len = mh[i].msg_len;
+        if (msg[i].peer != NULL)
+            *msg[i].peer = peer[i];
+        b->num_read += mh[i].msg_len;
+    }
+    /* Leave the peer as a sequence of dgram_read() calls would */
+    if (!data->connected && ret > 0)
+        BIO_ctrl(b, BIO_CTRL_DGRAM_SET_PEER, 0, &peer[ret - 1]);
+
+    BIO_clear_retry_flags(b);
+    if (ret < 0) {
+        if (BIO_dgram_should_retry(ret)) {
+            BIO_set_retry_read(b);
+            data->_errno = get_last_socket_error();
+        }
+    }
+
+    dgram_reset_rcv_timeout(b);
+# else
+    ret = dgram_read(b, msg[0].data, (int)msg[0].data_len);
+    if (ret >= 0) {
+        msg[0].data_len = (size_t)ret;
+        if (msg[0].peer != NULL)
+            *msg[0].peer = data->peer;
+        b->num_read += (uint64_t)ret;
+        ret = 1;
+    }
+# endif
+    return ret;
+}
+
 static long dgram_get_mtu_overhead(bio_dgram_data *data)
 {
     long ret;
@@ -585,6 +742,12 @@ static long dgram_ctrl(BIO *b, int cmd, long num, void *ptr)
     case BIO_CTRL_DGRAM_SET_NEXT_TIMEOUT:
         memcpy(&(data->next_timeout), ptr, sizeof(struct timeval));
         break;
+    case BIO_CTRL_DGRAM_SENDMMSG:
+        ret = num > 0 ? dgram_sendmmsg(b, ptr, (size_t)num) : 0;
+        break;
+    case BIO_CTRL_DGRAM_RECVMMSG:
+        ret = num > 0 ? dgram_recvmmsg(b, ptr, (size_t)num) : 0;
+        break;
 # if defined(SO_RCVTIMEO)
     case BIO_CTRL_DGRAM_SET_RECV_TIMEOUT:
 #  ifdef OPENSSL_SYS_WINDOWS
@@ -1384,6 +1547,11 @@ static long dgram_sctp_ctrl(BIO *b, int cmd, long num, void *ptr)
          */
         ret = 0;
         break;
+    case BIO_CTRL_DGRAM_SENDMMSG:
+    case BIO_CTRL_DGRAM_RECVMMSG:
+        /* Messages carry SCTP specific information, not supported */
+        ret = 0;
+        break;
     case BIO_CTRL_DGRAM_SCTP_SET_IN_HANDSHAKE:
         if (num > 0)
             data->in_handshake = 1;
@@ -1866,6 +2034,41 @@ static int BIO_dgram_should_retry(int i)
     return 0;
 }
 
+/*
+ * Send or receive up to |num_msg| datagrams at once. On Linux this takes a
+ * single sendmmsg() or recvmmsg() call, elsewhere the datagrams are sent
+ * one after the other and at most one datagram is received.
+ */
+int BIO_dgram_sendmmsg(BIO *b, BIO_DGRAM_MSG *msg, size_t num_msg,
+                       size_t *msgs_processed)
+{
+    long ret;
+
+    *msgs_processed = 0;
+    if (num_msg > LONG_MAX)
+        num_msg = LONG_MAX;
+    ret = BIO_ctrl(b, BIO_CTRL_DGRAM_SENDMMSG, (long)num_msg, msg);
+    if (ret <= 0)
+        return 0;
+    *msgs_processed = (size_t)ret;
+    return 1;
+}
+
+int BIO_dgram_recvmmsg(BIO *b, BIO_DGRAM_MSG *msg, size_t num_msg,
+                       size_t *msgs_processed)
+{
+    long ret;
+
+    *msgs_processed = 0;
+    if (num_msg > LONG_MAX)
+        num_msg = LONG_MAX;
+    ret = BIO_ctrl(b, BIO_CTRL_DGRAM_RECVMMSG, (long)num_msg, msg);
+    if (ret <= 0)
+        return 0;
+    *msgs_processed = (size_t)ret;
+    return 1;
+}
+
 int BIO_dgram_non_fatal_error(int err)
 {
     switch (err) {
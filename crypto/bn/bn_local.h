@@ -669,4 +669,10 @@ static ossl_inline BIGNUM *bn_expand(BIGNUM *a, int bits)
 int bn_check_prime_int(const BIGNUM *w, int checks, BN_CTX *ctx,
                       int do_trial_division, BN_GENCB *cb);
 
+/* Number of candidates handled by one call to ossl_bn_sieve_progression() */
+# define BN_SIEVE_SIZE 1024
+
+int ossl_bn_sieve_progression(const BIGNUM *w, const BIGNUM *step,
+                              unsigned char *sieve, int num);
+
 #endif
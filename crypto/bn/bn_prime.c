@@ -605,3 +605,65 @@ static int probable_prime_dh(BIGNUM *rnd, int bits, int safe, prime_t *mods,
     bn_check_top(rnd);
     return ret;
 }
+
+/* Returns a^-1 mod p for a prime p that does not divide a */
+static BN_ULONG mod_inverse_word(BN_ULONG a, BN_ULONG p)
+{
+    long t = 0, newt = 1, r = (long)p, newr = (long)a, q, tmp;
+
+    while (newr != 0) {
+        q = r / newr;
+        tmp = t - q * newt;
+        t = newt;
+        newt = tmp;
+        tmp = r - q * newr;
+        r = newr;
+        newr = tmp;
+    }
+    return (BN_ULONG)(t < 0 ? t + (long)p : t);
+}
+
+/*
+ * Sieve the arithmetic progression w + k * step for 0 <= k < |num| with all
+ * the odd primes in the table. Afterwards sieve[k] is 1 if w + k * step has
+ * a small prime factor and 0 if it has to be tested further.
+ *
+ * Unlike the trial division in bn_is_prime_int() which costs a division of
+ * the whole candidate by every prime, this takes a single reduction of |w|
+ * and |step| per prime for the whole batch, so the complete table is used
+ * regardless of the size of the candidates.
+ *
+ * |w| must be larger than the largest prime in the table and |num| must not
+ * exceed BN_SIEVE_SIZE.
+ *
+ * Returns 1 on success and 0 on error.
+ */
+int ossl_bn_sieve_progression(const BIGNUM *w, const BIGNUM *step,
+                              unsigned char *sieve, int num)
+{
+    int i, k;
+    BN_ULONG p, r, s;
+
+    if (num < 0 || num > BN_SIEVE_SIZE
+            || BN_num_bits(w) <= BN_num_bits_word(primes[NUMPRIMES - 1]))
+        return 0;
+
+    memset(sieve, 0, num);
+    for (i = 1; i < NUMPRIMES; i++) {
+        p = primes[i];
+        if ((r = BN_mod_word(w, p)) == (BN_ULONG)-1
+                || (s = BN_mod_word(step, p)) == (BN_ULONG)-1)
+            return 0;
+        if (s == 0) {
+            /* Every candidate has the same residue as w */
+            if (r == 0)
+                memset(sieve, 1, num);
+            continue;
+        }
+        /* The first k for which w + k * step == 0 mod p */
+        k = (int)(((p - r) % p) * mod_inverse_word(s, p) % p);
+        for (; k < num; k += (int)p)
+            sieve[k] = 1;
+    }
+    return 1;
+}
@@ -105,19 +105,37 @@ static int bn_rsa_fips186_4_find_aux_prob_prime(const BIGNUM *Xp1,
                                                 BN_GENCB *cb)
 {
     int ret = 0;
-    int i = 0;
+    int i = 0, j = BN_SIEVE_SIZE, res;
+    BIGNUM *two;
+    unsigned char sieve[BN_SIEVE_SIZE];
 
     if (BN_copy(p1, Xp1) == NULL)
         return 0;
     BN_set_flags(p1, BN_FLG_CONSTTIME);
 
+    BN_CTX_start(ctx);
+    two = BN_CTX_get(ctx);
+    if (two == NULL || !BN_set_word(two, 2))
+        goto err;
+
     /* Find the first odd number >= Xp1 that is probably prime */
     for(;;) {
+        /* Weed out the odd numbers with small factors a batch at a time */
+        if (j == BN_SIEVE_SIZE) {
+            if (!ossl_bn_sieve_progression(p1, two, sieve, BN_SIEVE_SIZE))
+                goto err;
+            j = 0;
+        }
         i++;
         BN_GENCB_call(cb, 0, i);
-        /* MR test with trial division */
-        if (BN_check_prime(p1, ctx, cb))
-            break;
+        /* MR test, the sieve has taken care of the trial division */
+        if (!sieve[j++]) {
+            res = bn_check_prime_int(p1, 0, ctx, 0, cb);
+            if (res < 0)
+                goto err;
+            if (res > 0)
+                break;
+        }
         /* Get next odd number */
         if (!BN_add_word(p1, 2))
             goto err;
@@ -125,6 +143,7 @@ static int bn_rsa_fips186_4_find_aux_prob_prime(const BIGNUM *Xp1,
     BN_GENCB_call(cb, 2, i);
     ret = 1;
 err:
+    BN_CTX_end(ctx);
     return ret;
 }
 
@@ -243,10 +262,11 @@ int ossl_bn_rsa_fips186_4_derive_prime(BIGNUM *Y, BIGNUM *X, const BIGNUM *Xin,
                                        BN_GENCB *cb)
 {
     int ret = 0;
-    int i, imax;
+    int i, imax, j, n, res;
     int bits = nlen >> 1;
     BIGNUM *tmp, *R, *r1r2x2, *y1, *r1x2;
     BIGNUM *base, *range;
+    unsigned char sieve[BN_SIEVE_SIZE];
 
     BN_CTX_start(ctx);
 
@@ -314,6 +334,7 @@ int ossl_bn_rsa_fips186_4_derive_prime(BIGNUM *Y, BIGNUM *X, const BIGNUM *Xin,
             goto err;
         /* (Step 5) */
         i = 0;
+        j = n = 0;
         for (;;) {
             /* (Step 6) */
             if (BN_num_bits(Y) > bits) {
@@ -322,15 +343,34 @@ int ossl_bn_rsa_fips186_4_derive_prime(BIGNUM *Y, BIGNUM *X, const BIGNUM *Xin,
                 else
                     goto err; /* X is not random so it will always fail */
             }
+            /*
+             * Rule out the upcoming candidates Y + k * 2r1r2 that have small
+             * factors in one go. This only skips candidates that would fail
+             * the trial division in the primality test, so the same Y is
+             * found as when testing each candidate in full.
+             */
+            if (j == n) {
+                n = imax - i < BN_SIEVE_SIZE ? imax - i : BN_SIEVE_SIZE;
+                if (!ossl_bn_sieve_progression(Y, r1r2x2, sieve, n))
+                    goto err;
+                j = 0;
+            }
             BN_GENCB_call(cb, 0, 2);
 
             /* (Step 7) If GCD(Y-1) == 1 & Y is probably prime then return Y */
-            if (BN_copy(y1, Y) == NULL
-                    || !BN_sub_word(y1, 1)
-                    || !BN_gcd(tmp, y1, e, ctx))
-                goto err;
-            if (BN_is_one(tmp) && BN_check_prime(Y, ctx, cb))
-                goto end;
+            if (!sieve[j++]) {
+                if (BN_copy(y1, Y) == NULL
+                        || !BN_sub_word(y1, 1)
+                        || !BN_gcd(tmp, y1, e, ctx))
+                    goto err;
+                if (BN_is_one(tmp)) {
+                    res = bn_check_prime_int(Y, 0, ctx, 0, cb);
+                    if (res < 0)
+                        goto err;
+                    if (res > 0)
+                        goto end;
+                }
+            }
             /* (Step 8-10) */
             if (++i >= imax || !BN_add(Y, Y, r1r2x2))
                 goto err;
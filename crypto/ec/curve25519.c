@@ -1,5 +1,5 @@
 /*
- * Copyright 2016-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2016-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -18,6 +18,7 @@
 #include "ec_local.h"
 #include <openssl/evp.h>
 #include <openssl/sha.h>
+#include <openssl/rand.h>
 
 #if defined(X25519_ASM) && (defined(__x86_64) || defined(__x86_64__) || \
                             defined(_M_AMD64) || defined(_M_X64))
@@ -4203,21 +4204,22 @@ static uint8_t negative(signed char b)
     return x;
 }
 
-static void table_select(ge_precomp *t, int pos, signed char b)
+static void table_select(ge_precomp *t, const ge_precomp (*table)[8], int pos,
+                         signed char b)
 {
     ge_precomp minust;
     uint8_t bnegative = negative(b);
     uint8_t babs = b - ((uint8_t)((-bnegative) & b) << 1);
 
     ge_precomp_0(t);
-    cmov(t, &k25519Precomp[pos][0], equal(babs, 1));
-    cmov(t, &k25519Precomp[pos][1], equal(babs, 2));
-    cmov(t, &k25519Precomp[pos][2], equal(babs, 3));
-    cmov(t, &k25519Precomp[pos][3], equal(babs, 4));
-    cmov(t, &k25519Precomp[pos][4], equal(babs, 5));
-    cmov(t, &k25519Precomp[pos][5], equal(babs, 6));
-    cmov(t, &k25519Precomp[pos][6], equal(babs, 7));
-    cmov(t, &k25519Precomp[pos][7], equal(babs, 8));
+    cmov(t, &table[pos][0], equal(babs, 1));
+    cmov(t, &table[pos][1], equal(babs, 2));
+    cmov(t, &table[pos][2], equal(babs, 3));
+    cmov(t, &table[pos][3], equal(babs, 4));
+    cmov(t, &table[pos][4], equal(babs, 5));
+    cmov(t, &table[pos][5], equal(babs, 6));
+    cmov(t, &table[pos][6], equal(babs, 7));
+    cmov(t, &table[pos][7], equal(babs, 8));
     fe_copy(minust.yplusx, t->yminusx);
     fe_copy(minust.yminusx, t->yplusx);
     fe_neg(minust.xy2d, t->xy2d);
@@ -4225,15 +4227,16 @@ static void table_select(ge_precomp *t, int pos, signed char b)
 }
 
 /*
- * h = a * B
+ * h = a * P
  *
  * where a = a[0]+256*a[1]+...+256^31 a[31]
- * B is the Ed25519 base point (x,4/5) with x positive.
+ * and table[i][j] = (j+1) * 256^i * P for a fixed point P, in affine form.
  *
  * Preconditions:
  *   a[31] <= 127
  */
-static void ge_scalarmult_base(ge_p3 *h, const uint8_t *a)
+static void ge_scalarmult_table(ge_p3 *h, const uint8_t *a,
+                                const ge_precomp (*table)[8])
 {
     signed char e[64];
     signed char carry;
@@ -4261,7 +4264,7 @@ static void ge_scalarmult_base(ge_p3 *h, const uint8_t *a)
 
     ge_p3_0(h);
     for (i = 1; i < 64; i += 2) {
-        table_select(&t, i / 2, e[i]);
+        table_select(&t, table, i / 2, e[i]);
         ge_madd(&r, h, &t);
         ge_p1p1_to_p3(h, &r);
     }
@@ -4276,7 +4279,7 @@ static void ge_scalarmult_base(ge_p3 *h, const uint8_t *a)
     ge_p1p1_to_p3(h, &r);
 
     for (i = 0; i < 64; i += 2) {
-        table_select(&t, i / 2, e[i]);
+        table_select(&t, table, i / 2, e[i]);
         ge_madd(&r, h, &t);
         ge_p1p1_to_p3(h, &r);
     }
@@ -4284,6 +4287,20 @@ static void ge_scalarmult_base(ge_p3 *h, const uint8_t *a)
     OPENSSL_cleanse(e, sizeof(e));
 }
 
+/*
+ * h = a * B
+ *
+ * where a = a[0]+256*a[1]+...+256^31 a[31]
+ * B is the Ed25519 base point (x,4/5) with x positive.
+ *
+ * Preconditions:
+ *   a[31] <= 127
+ */
+static void ge_scalarmult_base(ge_p3 *h, const uint8_t *a)
+{
+    ge_scalarmult_table(h, a, k25519Precomp);
+}
+
 #if !defined(BASE_2_51_IMPLEMENTED)
 /*
  * Replace (f,g) with (g,f) if b == 1;
@@ -4531,6 +4548,27 @@ static const ge_precomp Bi[8] = {
     },
 };
 
+/*
+ * Fill Ai with the odd multiples A,3A,5A,...,15A of A as used with the
+ * sliding window representation computed by slide().
+ */
+static void ge_precompute_odd(ge_cached Ai[8], const ge_p3 *A)
+{
+    ge_p1p1 t;
+    ge_p3 u;
+    ge_p3 A2;
+    int i;
+
+    ge_p3_to_cached(&Ai[0], A);
+    ge_p3_dbl(&t, A);
+    ge_p1p1_to_p3(&A2, &t);
+    for (i = 1; i < 8; i++) {
+        ge_add(&t, &A2, &Ai[i - 1]);
+        ge_p1p1_to_p3(&u, &t);
+        ge_p3_to_cached(&Ai[i], &u);
+    }
+}
+
 /*
  * r = a * A + b * B
  *
@@ -4546,36 +4584,12 @@ static void ge_double_scalarmult_vartime(ge_p2 *r, const uint8_t *a,
     ge_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
     ge_p1p1 t;
     ge_p3 u;
-    ge_p3 A2;
     int i;
 
     slide(aslide, a);
     slide(bslide, b);
 
-    ge_p3_to_cached(&Ai[0], A);
-    ge_p3_dbl(&t, A);
-    ge_p1p1_to_p3(&A2, &t);
-    ge_add(&t, &A2, &Ai[0]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[1], &u);
-    ge_add(&t, &A2, &Ai[1]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[2], &u);
-    ge_add(&t, &A2, &Ai[2]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[3], &u);
-    ge_add(&t, &A2, &Ai[3]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[4], &u);
-    ge_add(&t, &A2, &Ai[4]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[5], &u);
-    ge_add(&t, &A2, &Ai[5]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[6], &u);
-    ge_add(&t, &A2, &Ai[6]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[7], &u);
+    ge_precompute_odd(Ai, A);
 
     ge_p2_0(r);
 
@@ -4608,6 +4622,61 @@ static void ge_double_scalarmult_vartime(ge_p2 *r, const uint8_t *a,
     }
 }
 
+/*
+ * r = b * B + sum(a_i * A_i) for i = 0 ... num-1
+ *
+ * bslide is the sliding window representation of b as computed by slide(),
+ * aslide[i] that of a_i and Ai[i] the odd multiples of A_i as computed by
+ * ge_precompute_odd(). All points share a single chain of doublings which is
+ * where the saving over num separate calls of ge_double_scalarmult_vartime()
+ * comes from.
+ */
+static void ge_multi_scalarmult_vartime(ge_p2 *r, const signed char *bslide,
+                                        const signed char (*aslide)[256],
+                                        const ge_cached (*Ai)[8], size_t num)
+{
+    ge_p1p1 t;
+    ge_p3 u;
+    size_t j;
+    int i;
+
+    ge_p2_0(r);
+
+    for (i = 255; i >= 0; --i) {
+        if (bslide[i])
+            break;
+        for (j = 0; j < num; j++)
+            if (aslide[j][i])
+                break;
+        if (j < num)
+            break;
+    }
+
+    for (; i >= 0; --i) {
+        ge_p2_dbl(&t, r);
+
+        for (j = 0; j < num; j++) {
+            if (aslide[j][i] > 0) {
+                ge_p1p1_to_p3(&u, &t);
+                ge_add(&t, &u, &Ai[j][aslide[j][i] / 2]);
+            } else if (aslide[j][i] < 0) {
+                ge_p1p1_to_p3(&u, &t);
+                ge_sub(&t, &u, &Ai[j][(-aslide[j][i]) / 2]);
+            }
+        }
+
+        if (bslide[i] > 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_madd(&t, &u, &Bi[bslide[i] / 2]);
+        } else if (bslide[i] < 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_msub(&t, &u, &Bi[(-bslide[i]) / 2]);
+        }
+
+        ge_p1p1_to_p2(r, &t);
+    }
+}
+
 /*
  * The set of scalars is \Z/l
  * where l = 2^252 + 27742317777372353535851937790883648493.
@@ -5493,37 +5562,22 @@ err:
 
 static const char allzeroes[15];
 
-int ED25519_verify(const uint8_t *message, size_t message_len,
-                   const uint8_t signature[64], const uint8_t public_key[32],
-                   OSSL_LIB_CTX *libctx, const char *propq)
+/*
+ * Check 0 <= s < L where L = 2^252 + 27742317777372353535851937790883648493
+ *
+ * If not the signature is publicly invalid. Since it's public we can do the
+ * check in variable time.
+ */
+static int sc_is_canonical(const uint8_t *s)
 {
     int i;
-    ge_p3 A;
-    const uint8_t *r, *s;
-    EVP_MD *sha512;
-    EVP_MD_CTX *hash_ctx = NULL;
-    unsigned int sz;
-    int res = 0;
-    ge_p2 R;
-    uint8_t rcheck[32];
-    uint8_t h[SHA512_DIGEST_LENGTH];
     /* 27742317777372353535851937790883648493 in little endian format */
     const uint8_t l_low[16] = {
         0xED, 0xD3, 0xF5, 0x5C, 0x1A, 0x63, 0x12, 0x58, 0xD6, 0x9C, 0xF7, 0xA2,
         0xDE, 0xF9, 0xDE, 0x14
     };
 
-    r = signature;
-    s = signature + 32;
-
-    /*
-     * Check 0 <= s < L where L = 2^252 + 27742317777372353535851937790883648493
-     *
-     * If not the signature is publicly invalid. Since it's public we can do the
-     * check in variable time.
-     *
-     * First check the most significant byte
-     */
+    /* First check the most significant byte */
     if (s[31] > 0x10)
         return 0;
     if (s[31] == 0x10) {
@@ -5542,13 +5596,48 @@ int ED25519_verify(const uint8_t *message, size_t message_len,
         if (i < 0)
             return 0;
     }
+    return 1;
+}
+
+#ifndef FIPS_MODULE
+static void ge_double_scalarmult_precomp_vartime(ge_p2 *r, const uint8_t *a,
+                                                 const uint8_t *b,
+                                                 const ED25519_PRECOMP *pre);
+#endif
+
+/*
+ * Verify with the public key decoded from |public_key| or, if |pre| is not
+ * NULL, with the tables precomputed from it by ossl_ed25519_precomp_new().
+ */
+static int ed25519_verify_int(const uint8_t *message, size_t message_len,
+                              const uint8_t signature[64],
+                              const uint8_t public_key[32],
+                              const ED25519_PRECOMP *pre,
+                              OSSL_LIB_CTX *libctx, const char *propq)
+{
+    ge_p3 A;
+    const uint8_t *r, *s;
+    EVP_MD *sha512;
+    EVP_MD_CTX *hash_ctx = NULL;
+    unsigned int sz;
+    int res = 0;
+    ge_p2 R;
+    uint8_t rcheck[32];
+    uint8_t h[SHA512_DIGEST_LENGTH];
+
+    r = signature;
+    s = signature + 32;
 
-    if (ge_frombytes_vartime(&A, public_key) != 0) {
+    if (!sc_is_canonical(s))
         return 0;
-    }
 
-    fe_neg(A.X, A.X);
-    fe_neg(A.T, A.T);
+    if (pre == NULL) {
+        if (ge_frombytes_vartime(&A, public_key) != 0)
+            return 0;
+
+        fe_neg(A.X, A.X);
+        fe_neg(A.T, A.T);
+    }
 
     sha512 = EVP_MD_fetch(libctx, SN_sha512, propq);
     if (sha512 == NULL)
@@ -5566,7 +5655,12 @@ int ED25519_verify(const uint8_t *message, size_t message_len,
 
     x25519_sc_reduce(h);
 
-    ge_double_scalarmult_vartime(&R, h, &A, s);
+#ifndef FIPS_MODULE
+    if (pre != NULL)
+        ge_double_scalarmult_precomp_vartime(&R, h, s, pre);
+    else
+#endif
+        ge_double_scalarmult_vartime(&R, h, &A, s);
 
     ge_tobytes(rcheck, &R);
 
@@ -5577,6 +5671,195 @@ err:
     return res;
 }
 
+int ED25519_verify(const uint8_t *message, size_t message_len,
+                   const uint8_t signature[64], const uint8_t public_key[32],
+                   OSSL_LIB_CTX *libctx, const char *propq)
+{
+    return ed25519_verify_int(message, message_len, signature, public_key,
+                              NULL, libctx, propq);
+}
+
+/*
+ * The number of signatures that are combined into a single multi-scalar
+ * multiplication by ED25519_verify_batch(). Larger batches amortise the
+ * doublings better but need more working memory (about 3kB per signature).
+ */
+#define ED25519_BATCH_MAX 64
+
+/*
+ * Check that the 32 byte point encoding |s| is canonical, i.e. that the y
+ * coordinate is less than p = 2^255 - 19. The x == 0 case is checked by the
+ * caller after decoding.
+ */
+static int ge_bytes_y_is_canonical(const uint8_t *s)
+{
+    int i;
+
+    if ((s[31] & 0x7f) != 0x7f)
+        return 1;
+    for (i = 30; i > 0; i--)
+        if (s[i] != 0xff)
+            return 1;
+    return s[0] < 0xed;
+}
+
+static int ed25519_verify_batch_chunk(const uint8_t *const *messages,
+                                      const size_t *message_lens,
+                                      const uint8_t *const *signatures,
+                                      const uint8_t *const *public_keys,
+                                      size_t num, EVP_MD *sha512,
+                                      EVP_MD_CTX *hash_ctx,
+                                      signed char (*aslide)[256],
+                                      ge_cached (*Ai)[8],
+                                      OSSL_LIB_CTX *libctx)
+{
+    signed char bslide[256];
+    uint8_t b[32];
+    uint8_t z[32];
+    uint8_t c[32];
+    uint8_t h[SHA512_DIGEST_LENGTH];
+    static const uint8_t zero[32];
+    ge_p3 A, R;
+    ge_p2 sum;
+    ge_p1p1 t;
+    fe check;
+    unsigned int sz;
+    size_t i;
+
+    memset(b, 0, sizeof(b));
+    memset(z, 0, sizeof(z));
+
+    for (i = 0; i < num; i++) {
+        const uint8_t *r = signatures[i];
+        const uint8_t *s = signatures[i] + 32;
+
+        if (!sc_is_canonical(s))
+            return 0;
+
+        /*
+         * ED25519_verify() compares the encoding of the computed R with the
+         * one in the signature, so a non-canonical encoding of R can never
+         * verify. We decode R instead and so have to reject those explicitly.
+         */
+        if (!ge_bytes_y_is_canonical(r)
+            || ge_frombytes_vartime(&R, r) != 0
+            || (!fe_isnonzero(R.X) && (r[31] >> 7) != 0))
+            return 0;
+        if (ge_frombytes_vartime(&A, public_keys[i]) != 0)
+            return 0;
+
+        fe_neg(R.X, R.X);
+        fe_neg(R.T, R.T);
+        fe_neg(A.X, A.X);
+        fe_neg(A.T, A.T);
+
+        if (!EVP_DigestInit_ex(hash_ctx, sha512, NULL)
+            || !EVP_DigestUpdate(hash_ctx, r, 32)
+            || !EVP_DigestUpdate(hash_ctx, public_keys[i], 32)
+            || !EVP_DigestUpdate(hash_ctx, messages[i], message_lens[i])
+            || !EVP_DigestFinal_ex(hash_ctx, h, &sz))
+            return 0;
+
+        x25519_sc_reduce(h);
+
+        /*
+         * A random 128 bit z_i is enough to make the probability that an
+         * invalid signature passes as part of the batch negligible.
+         */
+        if (RAND_bytes_ex(libctx, z, 16) <= 0)
+            return 0;
+
+        /* b += z_i * s_i, c_i = z_i * h_i */
+        sc_muladd(b, z, s, b);
+        sc_muladd(c, z, h, zero);
+
+        slide(aslide[2 * i], z);
+        slide(aslide[2 * i + 1], c);
+        ge_precompute_odd(Ai[2 * i], &R);
+        ge_precompute_odd(Ai[2 * i + 1], &A);
+    }
+
+    /* sum = b * B + sum(z_i * -R_i) + sum(c_i * -A_i) */
+    slide(bslide, b);
+    ge_multi_scalarmult_vartime(&sum, bslide,
+                                (const signed char (*)[256])aslide,
+                                (const ge_cached (*)[8])Ai, 2 * num);
+
+    /* Multiply by the cofactor and check for the neutral element (0, 1) */
+    ge_p2_dbl(&t, &sum);
+    ge_p1p1_to_p2(&sum, &t);
+    ge_p2_dbl(&t, &sum);
+    ge_p1p1_to_p2(&sum, &t);
+    ge_p2_dbl(&t, &sum);
+    ge_p1p1_to_p2(&sum, &t);
+
+    fe_sub(check, sum.Y, sum.Z);
+    return !fe_isnonzero(sum.X) && !fe_isnonzero(check);
+}
+
+/*
+ * Verify |num| signatures at once. Returns 1 if all of them are valid and 0
+ * if at least one of them is invalid or an error occurred; it does not tell
+ * which one failed. Callers that need to know should fall back to
+ * ED25519_verify() on failure.
+ *
+ * This checks the cofactored verification equation
+ * [8][S]B = [8]R + [8][k]A' of RFC 8032 5.1.7 with random linear
+ * combinations of the signatures, whereas ED25519_verify() checks the
+ * cofactorless one. The two agree on all honestly generated signatures, but
+ * signatures with a small order component in R or A may be accepted here and
+ * rejected by ED25519_verify().
+ */
+int ED25519_verify_batch(const uint8_t *const *messages,
+                         const size_t *message_lens,
+                         const uint8_t *const *signatures,
+                         const uint8_t *const *public_keys, size_t num,
+                         OSSL_LIB_CTX *libctx, const char *propq)
+{
+    EVP_MD *sha512 = NULL;
+    EVP_MD_CTX *hash_ctx = NULL;
+    signed char (*aslide)[256] = NULL;
+    ge_cached (*Ai)[8] = NULL;
+    size_t n, chunk;
+    int res = 0;
+
+    if (num == 0)
+        return 1;
+    if (num == 1)
+        return ED25519_verify(messages[0], message_lens[0], signatures[0],
+                              public_keys[0], libctx, propq);
+
+    chunk = num < ED25519_BATCH_MAX ? num : ED25519_BATCH_MAX;
+
+    /* Each signature contributes two scalars, z_i and c_i, and two points */
+    aslide = OPENSSL_malloc(2 * chunk * sizeof(*aslide));
+    Ai = OPENSSL_malloc(2 * chunk * sizeof(*Ai));
+    sha512 = EVP_MD_fetch(libctx, SN_sha512, propq);
+    hash_ctx = EVP_MD_CTX_new();
+    if (aslide == NULL || Ai == NULL || sha512 == NULL || hash_ctx == NULL)
+        goto err;
+
+    for (; num > 0; num -= n) {
+        n = num < chunk ? num : chunk;
+        if (!ed25519_verify_batch_chunk(messages, message_lens, signatures,
+                                        public_keys, n, sha512, hash_ctx,
+                                        aslide, Ai, libctx))
+            goto err;
+        messages += n;
+        message_lens += n;
+        signatures += n;
+        public_keys += n;
+    }
+
+    res = 1;
+err:
+    OPENSSL_free(aslide);
+    OPENSSL_free(Ai);
+    EVP_MD_free(sha512);
+    EVP_MD_CTX_free(hash_ctx);
+    return res;
+}
+
 int ED25519_public_from_private(OSSL_LIB_CTX *ctx, uint8_t out_public_key[32],
                                 const uint8_t private_key[32], const char *propq)
 {
@@ -5606,6 +5889,223 @@ int ED25519_public_from_private(OSSL_LIB_CTX *ctx, uint8_t out_public_key[32],
     return 1;
 }
 
+#ifndef FIPS_MODULE
+/*
+ * Tables precomputed from a public key that is used many times.  They are
+ * built from public data only, so the variable time code used to construct
+ * them is fine.
+ */
+
+/* Odd multiples of -A, -2^128 A and 2^128 B */
+struct ed25519_precomp_st {
+    ge_cached table[3][8];
+};
+
+/*
+ * table[i][j] = (j+1) * 256^i * P in affine form, where P is a point on the
+ * Edwards curve with the same u-coordinate as the key.
+ */
+struct x25519_precomp_st {
+    ge_precomp table[32][8];
+};
+
+void ossl_ed25519_precomp_free(ED25519_PRECOMP *pre)
+{
+    OPENSSL_free(pre);
+}
+
+void ossl_x25519_precomp_free(X25519_PRECOMP *pre)
+{
+    OPENSSL_free(pre);
+}
+
+/*
+ * r = a * A + b * B
+ *
+ * as ge_double_scalarmult_vartime() with the tables from |pre|.  Both scalars
+ * are split into 128 bit halves, which need half as many doublings.
+ */
+static void ge_double_scalarmult_precomp_vartime(ge_p2 *r, const uint8_t *a,
+                                                 const uint8_t *b,
+                                                 const ED25519_PRECOMP *pre)
+{
+    signed char aslide[3][256];
+    signed char bslide[256];
+    uint8_t half[32];
+
+    memset(half, 0, sizeof(half));
+    memcpy(half, a, 16);
+    slide(aslide[0], half);
+    memcpy(half, a + 16, 16);
+    slide(aslide[1], half);
+    memcpy(half, b + 16, 16);
+    slide(aslide[2], half);
+    memcpy(half, b, 16);
+    slide(bslide, half);
+
+    ge_multi_scalarmult_vartime(r, bslide, (const signed char (*)[256])aslide,
+                                pre->table, 3);
+}
+
+ED25519_PRECOMP *ossl_ed25519_precomp_new(const uint8_t public_key[32])
+{
+    static const uint8_t two128[32] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1
+    };
+    ED25519_PRECOMP *pre;
+    ge_p3 A;
+    ge_p1p1 t;
+    int i;
+
+    if (ge_frombytes_vartime(&A, public_key) != 0)
+        return NULL;
+    fe_neg(A.X, A.X);
+    fe_neg(A.T, A.T);
+
+    if ((pre = OPENSSL_malloc(sizeof(*pre))) == NULL)
+        return NULL;
+
+    ge_precompute_odd(pre->table[0], &A);
+    for (i = 0; i < 128; i++) {
+        ge_p3_dbl(&t, &A);
+        ge_p1p1_to_p3(&A, &t);
+    }
+    ge_precompute_odd(pre->table[1], &A);
+    ge_scalarmult_base(&A, two128);
+    ge_precompute_odd(pre->table[2], &A);
+    return pre;
+}
+
+int ossl_ed25519_verify_precomp(const uint8_t *message, size_t message_len,
+                                const uint8_t signature[64],
+                                const uint8_t public_key[32],
+                                const ED25519_PRECOMP *pre,
+                                OSSL_LIB_CTX *libctx, const char *propq)
+{
+    return ed25519_verify_int(message, message_len, signature, public_key,
+                              pre, libctx, propq);
+}
+#endif
+
+/*
+ * We only need the u-coordinate of the curve25519 point.
+ * The map is u=(y+1)/(1-y). Since y=Y/Z, this gives
+ * u=(Z+Y)/(Z-Y).
+ */
+static void ge_p3_to_montgomery_u(uint8_t out[32], const ge_p3 *A)
+{
+    fe zplusy, zminusy, zminusy_inv;
+
+    fe_add(zplusy, A->Z, A->Y);
+    fe_sub(zminusy, A->Z, A->Y);
+    fe_invert(zminusy_inv, zminusy);
+    fe_mul(zplusy, zplusy, zminusy_inv);
+    fe_tobytes(out, zplusy);
+}
+
+#ifndef FIPS_MODULE
+X25519_PRECOMP *ossl_x25519_precomp_new(const uint8_t public_key[32])
+{
+    X25519_PRECOMP *pre = NULL;
+    ge_p3 *pts = NULL;
+    fe *acc = NULL;
+    ge_p3 base;
+    ge_cached c;
+    ge_p1p1 t;
+    ge_precomp *dst;
+    fe u, one, y, x, inv, zinv;
+    uint8_t ybytes[32];
+    int i, j;
+
+    /*
+     * The Edwards point with y = (u-1)/(u+1) and either sign of x has the
+     * same u-coordinate as the key, as does every multiple of it.  There is
+     * no such point if u = -1 or the key is on the twist, in which case the
+     * ladder has to be used.
+     */
+    fe_frombytes(u, public_key);
+    fe_1(one);
+    fe_add(x, u, one);
+    if (!fe_isnonzero(x))
+        return NULL;
+    fe_invert(inv, x);
+    fe_sub(y, u, one);
+    fe_mul(y, y, inv);
+    fe_tobytes(ybytes, y);
+    if (ge_frombytes_vartime(&base, ybytes) != 0)
+        return NULL;
+
+    pre = OPENSSL_malloc(sizeof(*pre));
+    pts = OPENSSL_malloc(256 * sizeof(*pts));
+    acc = OPENSSL_malloc(256 * sizeof(*acc));
+    if (pre == NULL || pts == NULL || acc == NULL) {
+        OPENSSL_free(pre);
+        pre = NULL;
+        goto err;
+    }
+
+    for (i = 0; i < 32; i++) {
+        ge_p3_to_cached(&c, &base);
+        pts[8 * i] = base;
+        for (j = 1; j < 8; j++) {
+            ge_add(&t, &pts[8 * i + j - 1], &c);
+            ge_p1p1_to_p3(&pts[8 * i + j], &t);
+        }
+        for (j = 0; j < 8; j++) {
+            ge_p3_dbl(&t, &base);
+            ge_p1p1_to_p3(&base, &t);
+        }
+    }
+
+    /* Convert to affine coordinates with a single inversion */
+    fe_copy(acc[0], pts[0].Z);
+    for (i = 1; i < 256; i++)
+        fe_mul(acc[i], acc[i - 1], pts[i].Z);
+    fe_invert(inv, acc[255]);
+    for (i = 255; i >= 0; i--) {
+        if (i > 0) {
+            fe_mul(zinv, inv, acc[i - 1]);
+            fe_mul(inv, inv, pts[i].Z);
+        } else {
+            fe_copy(zinv, inv);
+        }
+        fe_mul(x, pts[i].X, zinv);
+        fe_mul(y, pts[i].Y, zinv);
+        dst = &pre->table[i / 8][i % 8];
+        fe_add(dst->yplusx, y, x);
+        fe_sub(dst->yminusx, y, x);
+        fe_mul(dst->xy2d, x, y);
+        fe_mul(dst->xy2d, dst->xy2d, d2);
+    }
+
+ err:
+    OPENSSL_free(pts);
+    OPENSSL_free(acc);
+    return pre;
+}
+
+int ossl_x25519_precomp(uint8_t out_shared_key[32],
+                        const uint8_t private_key[32],
+                        const X25519_PRECOMP *peer)
+{
+    static const uint8_t kZeros[32] = {0};
+    uint8_t e[32];
+    ge_p3 A;
+
+    memcpy(e, private_key, 32);
+    e[0] &= 248;
+    e[31] &= 127;
+    e[31] |= 64;
+
+    ge_scalarmult_table(&A, e, peer->table);
+    ge_p3_to_montgomery_u(out_shared_key, &A);
+
+    OPENSSL_cleanse(e, sizeof(e));
+    /* The all-zero output results when the input is a point of small order. */
+    return CRYPTO_memcmp(kZeros, out_shared_key, 32) != 0;
+}
+#endif
+
 int X25519(uint8_t out_shared_key[32], const uint8_t private_key[32],
            const uint8_t peer_public_value[32])
 {
@@ -5620,7 +6120,6 @@ void X25519_public_from_private(uint8_t out_public_value[32],
 {
     uint8_t e[32];
     ge_p3 A;
-    fe zplusy, zminusy, zminusy_inv;
 
     memcpy(e, private_key, 32);
     e[0] &= 248;
@@ -5628,17 +6127,7 @@ void X25519_public_from_private(uint8_t out_public_value[32],
     e[31] |= 64;
 
     ge_scalarmult_base(&A, e);
-
-    /*
-     * We only need the u-coordinate of the curve25519 point.
-     * The map is u=(y+1)/(1-y). Since y=Y/Z, this gives
-     * u=(Z+Y)/(Z-Y).
-     */
-    fe_add(zplusy, A.Z, A.Y);
-    fe_sub(zminusy, A.Z, A.Y);
-    fe_invert(zminusy_inv, zminusy);
-    fe_mul(zplusy, zplusy, zminusy_inv);
-    fe_tobytes(out_public_value, zplusy);
+    ge_p3_to_montgomery_u(out_public_value, &A);
 
     OPENSSL_cleanse(e, sizeof(e));
 }
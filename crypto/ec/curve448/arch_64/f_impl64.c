@@ -0,0 +1,163 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2014 Cryptography Research, Inc.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ *
+ * Originally written by Mike Hamburg
+ */
+
+#include "field.h"
+
+#if ARCH_WORD_BITS == 64
+
+/*
+ * Elements are held as eight 56-bit limbs, split into a low half and a high
+ * half of four limbs each.  With phi = 2^224 we have p = phi^2 - phi - 1, so
+ * phi^2 = phi + 1 and the product of two elements needs only three 4x4 limb
+ * products (Karatsuba), with the wrap-around folded into the accumulation.
+ */
+void gf_mul(gf_s * RESTRICT cs, const gf as, const gf bs)
+{
+    const uint64_t *a = as->limb, *b = bs->limb;
+    uint64_t *c = cs->limb;
+    __uint128_t accum0 = 0, accum1 = 0, accum2;
+    uint64_t mask = (1ULL << 56) - 1;
+    uint64_t aa[4], bb[4], bbb[4];
+    unsigned int i, j;
+
+    for (i = 0; i < 4; i++) {
+        aa[i] = a[i] + a[i + 4];
+        bb[i] = b[i] + b[i + 4];
+        bbb[i] = bb[i] + b[i + 4];
+    }
+
+    for (i = 0; i < 4; i++) {
+        accum2 = 0;
+
+        for (j = 0; j <= i; j++) {
+            accum2 += widemul(a[j], b[i - j]);
+            accum1 += widemul(aa[j], bb[i - j]);
+            accum0 += widemul(a[j + 4], b[i - j + 4]);
+        }
+        for (; j < 4; j++) {
+            accum2 += widemul(a[j], b[i - j + 8]);
+            accum1 += widemul(aa[j], bbb[i - j + 4]);
+            accum0 += widemul(a[j + 4], bb[i - j + 4]);
+        }
+
+        accum1 -= accum2;
+        accum0 += accum2;
+
+        c[i] = ((uint64_t)(accum0)) & mask;
+        c[i + 4] = ((uint64_t)(accum1)) & mask;
+
+        accum0 >>= 56;
+        accum1 >>= 56;
+    }
+
+    accum0 += accum1;
+    accum0 += c[4];
+    accum1 += c[0];
+    c[4] = ((uint64_t)(accum0)) & mask;
+    c[0] = ((uint64_t)(accum1)) & mask;
+
+    accum0 >>= 56;
+    accum1 >>= 56;
+
+    c[5] += ((uint64_t)(accum0));
+    c[1] += ((uint64_t)(accum1));
+}
+
+void gf_mulw_unsigned(gf_s * RESTRICT cs, const gf as, uint32_t b)
+{
+    const uint64_t *a = as->limb;
+    uint64_t *c = cs->limb;
+    __uint128_t accum0 = 0, accum4 = 0;
+    uint64_t mask = (1ULL << 56) - 1;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        accum0 += widemul(b, a[i]);
+        accum4 += widemul(b, a[i + 4]);
+        c[i] = accum0 & mask;
+        accum0 >>= 56;
+        c[i + 4] = accum4 & mask;
+        accum4 >>= 56;
+    }
+
+    accum0 += accum4 + c[4];
+    c[4] = accum0 & mask;
+    c[5] += accum0 >> 56;
+
+    accum4 += c[0];
+    c[0] = accum4 & mask;
+    c[1] += accum4 >> 56;
+}
+
+/* r = x^2 for a four limb x, as seven unreduced coefficients */
+static ossl_inline void sqr4(__uint128_t r[7], const uint64_t x[4])
+{
+    uint64_t x0x2 = x[0] << 1, x1x2 = x[1] << 1, x2x2 = x[2] << 1;
+
+    r[0] = widemul(x[0], x[0]);
+    r[1] = widemul(x0x2, x[1]);
+    r[2] = widemul(x0x2, x[2]) + widemul(x[1], x[1]);
+    r[3] = widemul(x0x2, x[3]) + widemul(x1x2, x[2]);
+    r[4] = widemul(x1x2, x[3]) + widemul(x[2], x[2]);
+    r[5] = widemul(x2x2, x[3]);
+    r[6] = widemul(x[3], x[3]);
+}
+
+/*
+ * Squaring uses the same decomposition as gf_mul() but computes each of the
+ * three half-size squares with 10 rather than 16 multiplications.
+ */
+void gf_sqr(gf_s * RESTRICT cs, const gf as)
+{
+    const uint64_t *a = as->limb;
+    uint64_t *c = cs->limb;
+    __uint128_t lo[7], hi[7], mid[7], accum0 = 0, accum1 = 0;
+    uint64_t mask = (1ULL << 56) - 1;
+    uint64_t aa[4];
+    unsigned int i;
+
+    for (i = 0; i < 4; i++)
+        aa[i] = a[i] + a[i + 4];
+
+    sqr4(lo, a);
+    sqr4(hi, a + 4);
+    sqr4(mid, aa);
+
+    for (i = 0; i < 4; i++) {
+        accum0 += lo[i] + hi[i];
+        accum1 += mid[i] - lo[i];
+        if (i < 3) {
+            accum0 += mid[i + 4] - lo[i + 4];
+            accum1 += hi[i + 4] + mid[i + 4];
+        }
+
+        c[i] = ((uint64_t)(accum0)) & mask;
+        c[i + 4] = ((uint64_t)(accum1)) & mask;
+
+        accum0 >>= 56;
+        accum1 >>= 56;
+    }
+
+    accum0 += accum1;
+    accum0 += c[4];
+    accum1 += c[0];
+    c[4] = ((uint64_t)(accum0)) & mask;
+    c[0] = ((uint64_t)(accum1)) & mask;
+
+    accum0 >>= 56;
+    accum1 >>= 56;
+
+    c[5] += ((uint64_t)(accum0));
+    c[1] += ((uint64_t)(accum1));
+}
+
+#endif
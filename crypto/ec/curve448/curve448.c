@@ -1,5 +1,5 @@
 /*
- * Copyright 2017-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2017-2021 The OpenSSL Project Authors. All Rights Reserved.
  * Copyright 2015-2016 Cryptography Research, Inc.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
@@ -222,7 +222,25 @@ static ossl_inline void constant_time_lookup_niels(niels_s * RESTRICT ni,
                                                    const niels_t * table,
                                                    int nelts, int idx)
 {
+#ifdef FIPS_MODULE
     constant_time_lookup(ni, table, sizeof(niels_s), nelts, idx);
+#else
+    int i;
+
+    /*
+     * Select whole limbs rather than going through constant_time_lookup(),
+     * which masks one byte at a time and dominates fixed-base scalar
+     * multiplication otherwise.
+     */
+    *ni = *table[0];
+    for (i = 1; i < nelts; i++) {
+        mask_t m = word_is_zero((word_t)(i ^ idx));
+
+        gf_cond_sel(ni->a, ni->a, table[i]->a, m);
+        gf_cond_sel(ni->b, ni->b, table[i]->b, m);
+        gf_cond_sel(ni->c, ni->c, table[i]->c, m);
+    }
+#endif
 }
 
 void curve448_precomputed_scalarmul(curve448_point_t out,
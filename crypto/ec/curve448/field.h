@@ -1,5 +1,5 @@
 /*
- * Copyright 2017-2018 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2017-2021 The OpenSSL Project Authors. All Rights Reserved.
  * Copyright 2014 Cryptography Research, Inc.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
@@ -66,10 +66,15 @@ void gf_serialize(uint8_t *serial, const gf x, int with_highbit);
 mask_t gf_deserialize(gf x, const uint8_t serial[SER_BYTES], int with_hibit,
                       uint8_t hi_nmask);
 
-# include "f_impl.h"            /* Bring in the inline implementations */
+/* Bring in the inline implementations */
+# if ARCH_WORD_BITS == 64
+#  include "arch_64/f_impl.h"
+# else
+#  include "arch_32/f_impl.h"
+# endif
 
 # define LIMBPERM(i) (i)
-# define LIMB_MASK(i) (((1)<<LIMB_PLACE_VALUE(i))-1)
+# define LIMB_MASK(i) (((word_t)1 << LIMB_PLACE_VALUE(i)) - 1)
 
 static const gf ZERO = {{{0}}}, ONE = {{{1}}};
 
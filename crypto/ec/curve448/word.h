@@ -1,5 +1,5 @@
 /*
- * Copyright 2017-2018 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2017-2021 The OpenSSL Project Authors. All Rights Reserved.
  * Copyright 2014 Cryptography Research, Inc.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
@@ -17,8 +17,16 @@
 # include <assert.h>
 # include <stdlib.h>
 # include <openssl/e_os2.h>
-# include "arch_intrinsics.h"
 # include "curve448utils.h"
+/*
+ * The FIPS provider keeps the 32-bit field implementation, arch_64 is only
+ * built into libcrypto.
+ */
+# if C448_WORD_BITS == 64 && !defined(FIPS_MODULE)
+#  include "arch_64/arch_intrinsics.h"
+# else
+#  include "arch_32/arch_intrinsics.h"
+# endif
 
 # if (ARCH_WORD_BITS == 64)
 typedef uint64_t word_t, mask_t;
@@ -1,5 +1,5 @@
 /*
- * Copyright 2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2020-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -7,9 +7,18 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <string.h>
 #include <openssl/err.h>
 #include "crypto/ecx.h"
 
+/*
+ * Number of times a public key is used for verification or key exchange
+ * before tables are precomputed for it.  Building them costs about as much as
+ * two uses and they take about 4kB for Ed25519 and 30kB for X25519, so they are not
+ * built for ephemeral keys.
+ */
+#define ECX_PRECOMP_THRESHOLD   2
+
 ECX_KEY *ossl_ecx_key_new(OSSL_LIB_CTX *libctx, ECX_KEY_TYPE type, int haspubkey,
                           const char *propq)
 {
@@ -69,6 +78,7 @@ void ossl_ecx_key_free(ECX_KEY *key)
 
     OPENSSL_free(key->propq);
     OPENSSL_secure_clear_free(key->privkey, key->keylen);
+    ossl_ecx_key_clear_precomp(key);
     CRYPTO_THREAD_lock_free(key->lock);
     OPENSSL_free(key);
 }
@@ -96,3 +106,116 @@ unsigned char *ossl_ecx_key_allocate_privkey(ECX_KEY *key)
 
     return key->privkey;
 }
+
+/* Free the precomputed tables of |key|, after its public key changed */
+void ossl_ecx_key_clear_precomp(ECX_KEY *key)
+{
+#ifndef FIPS_MODULE
+    if (key->type == ECX_KEY_TYPE_X25519)
+        ossl_x25519_precomp_free(key->precomp.x25519);
+    else if (key->type == ECX_KEY_TYPE_ED25519)
+        ossl_ed25519_precomp_free(key->precomp.ed25519);
+#endif
+    memset(&key->precomp, 0, sizeof(key->precomp));
+    key->pubkey_uses = 0;
+}
+
+#ifndef FIPS_MODULE
+/*
+ * Count a use of the public key of |key| and return 1 if the caller is the one
+ * that should build the tables for it. Counting stops once that point has
+ * passed, whether or not the tables could be built, so the count stays small.
+ */
+static int ecx_key_precomp_due(ECX_KEY *key)
+{
+    int uses;
+
+    return key->haspubkey
+           && CRYPTO_atomic_add(&key->pubkey_uses, 0, &uses, key->lock)
+           && uses <= ECX_PRECOMP_THRESHOLD
+           && CRYPTO_atomic_add(&key->pubkey_uses, 1, &uses, key->lock)
+           && uses == ECX_PRECOMP_THRESHOLD + 1;
+}
+
+/*
+ * Return the tables precomputed for the public key of the X25519 |key|, or
+ * NULL if the caller should use the plain public key.
+ */
+static const X25519_PRECOMP *ecx_key_get0_x25519_precomp(ECX_KEY *key)
+{
+    X25519_PRECOMP *pre;
+
+    if (!CRYPTO_THREAD_read_lock(key->lock))
+        return NULL;
+    pre = key->precomp.x25519;
+    CRYPTO_THREAD_unlock(key->lock);
+    if (pre != NULL || !ecx_key_precomp_due(key)
+            || (pre = ossl_x25519_precomp_new(key->pubkey)) == NULL)
+        return pre;
+
+    if (!CRYPTO_THREAD_write_lock(key->lock)) {
+        ossl_x25519_precomp_free(pre);
+        return NULL;
+    }
+    key->precomp.x25519 = pre;
+    CRYPTO_THREAD_unlock(key->lock);
+    return pre;
+}
+
+/* As ecx_key_get0_x25519_precomp(), for an Ed25519 |key| */
+static const ED25519_PRECOMP *ecx_key_get0_ed25519_precomp(ECX_KEY *key)
+{
+    ED25519_PRECOMP *pre;
+
+    if (!CRYPTO_THREAD_read_lock(key->lock))
+        return NULL;
+    pre = key->precomp.ed25519;
+    CRYPTO_THREAD_unlock(key->lock);
+    if (pre != NULL || !ecx_key_precomp_due(key)
+            || (pre = ossl_ed25519_precomp_new(key->pubkey)) == NULL)
+        return pre;
+
+    if (!CRYPTO_THREAD_write_lock(key->lock)) {
+        ossl_ed25519_precomp_free(pre);
+        return NULL;
+    }
+    key->precomp.ed25519 = pre;
+    CRYPTO_THREAD_unlock(key->lock);
+    return pre;
+}
+#endif
+
+/*
+ * X25519 with the public key of |peer|, using precomputed tables once the key
+ * has been used often enough.
+ */
+int ossl_ecx_key_x25519(uint8_t out_shared_key[32],
+                        const uint8_t private_key[32], ECX_KEY *peer)
+{
+#ifndef FIPS_MODULE
+    const X25519_PRECOMP *pre;
+
+    if (peer->type == ECX_KEY_TYPE_X25519
+            && (pre = ecx_key_get0_x25519_precomp(peer)) != NULL)
+        return ossl_x25519_precomp(out_shared_key, private_key, pre);
+#endif
+    return X25519(out_shared_key, private_key, peer->pubkey);
+}
+
+/* As ossl_ecx_key_x25519(), for Ed25519 verification with |key| */
+int ossl_ecx_key_ed25519_verify(const uint8_t *message, size_t message_len,
+                                const uint8_t signature[64], ECX_KEY *key,
+                                OSSL_LIB_CTX *libctx)
+{
+#ifndef FIPS_MODULE
+    const ED25519_PRECOMP *pre;
+
+    if (key->type == ECX_KEY_TYPE_ED25519
+            && (pre = ecx_key_get0_ed25519_precomp(key)) != NULL)
+        return ossl_ed25519_verify_precomp(message, message_len, signature,
+                                           key->pubkey, pre, libctx,
+                                           key->propq);
+#endif
+    return ED25519_verify(message, message_len, signature, key->pubkey,
+                          libctx, key->propq);
+}
@@ -620,6 +620,45 @@ int EVP_Digest(const void *data, size_t count,
     return ret;
 }
 
+int EVP_Digest_many(const void *const *data, const size_t *count, size_t num,
+                    unsigned char *md, unsigned int *size, const EVP_MD *type,
+                    ENGINE *impl)
+{
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    int mdsize;
+    size_t i;
+    int ret = 0;
+
+    if (ctx == NULL)
+        return 0;
+    EVP_MD_CTX_set_flags(ctx, EVP_MD_CTX_FLAG_ONESHOT);
+    /* Let the init resolve engines and implicit fetches as usual */
+    if (!EVP_DigestInit_ex(ctx, type, impl))
+        goto err;
+    if ((mdsize = EVP_MD_size(ctx->digest)) <= 0) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_INVALID_DIGEST);
+        goto err;
+    }
+
+    if (ctx->engine == NULL && ctx->digest->prov != NULL
+            && ctx->digest->digest_many != NULL) {
+        ret = ctx->digest->digest_many(
+                  ossl_provider_ctx(ctx->digest->prov),
+                  (const unsigned char *const *)data, count, num, md,
+                  num * (size_t)mdsize);
+    } else {
+        for (ret = 1, i = 0; ret && i < num; i++)
+            ret = (i == 0 || EVP_DigestInit_ex(ctx, type, impl))
+                  && EVP_DigestUpdate(ctx, data[i], count[i])
+                  && EVP_DigestFinal_ex(ctx, md + i * mdsize, NULL);
+    }
+    if (ret && size != NULL)
+        *size = (unsigned int)mdsize;
+ err:
+    EVP_MD_CTX_free(ctx);
+    return ret;
+}
+
 int EVP_MD_get_params(const EVP_MD *digest, OSSL_PARAM params[])
 {
     if (digest != NULL && digest->get_params != NULL)
@@ -932,6 +971,10 @@ static void *evp_md_from_dispatch(int name_id,
                 md->digest = OSSL_FUNC_digest_digest(fns);
             /* We don't increment fnct for this as it is stand alone */
             break;
+        case OSSL_FUNC_DIGEST_DIGEST_MANY:
+            if (md->digest_many == NULL)
+                md->digest_many = OSSL_FUNC_digest_digest_many(fns);
+            break;
         case OSSL_FUNC_DIGEST_FREECTX:
             if (md->freectx == NULL) {
                 md->freectx = OSSL_FUNC_digest_freectx(fns);
@@ -20,6 +20,7 @@
 #include <openssl/crypto.h>
 #include "crypto/asn1.h"
 #include "crypto/evp.h"
+#include "crypto/rand.h"
 #include "internal/cryptlib.h"
 #include "internal/numbers.h"
 #include "internal/provider.h"
@@ -400,6 +401,28 @@ int EVP_RAND_get_ctx_params(EVP_RAND_CTX *ctx, OSSL_PARAM params[])
     return res;
 }
 
+#ifndef FIPS_MODULE
+unsigned int evp_rand_reseed_counter(EVP_RAND_CTX *ctx)
+{
+    OSSL_PARAM params[2];
+    unsigned int count = 0;
+
+    /*
+     * The DRBGs of the built-in default provider share its lock function,
+     * and keep their reseed counter where it can be read without the lock.
+     */
+    if (ctx->meth->lock == ossl_drbg_lock)
+        return ossl_drbg_reseed_counter(ctx->data);
+
+    params[0] = OSSL_PARAM_construct_uint(OSSL_DRBG_PARAM_RESEED_COUNTER,
+                                          &count);
+    params[1] = OSSL_PARAM_construct_end();
+    if (!EVP_RAND_get_ctx_params(ctx, params))
+        return 0;
+    return count;
+}
+#endif
+
 static int evp_rand_set_ctx_params_locked(EVP_RAND_CTX *ctx,
                                           const OSSL_PARAM params[])
 {
@@ -582,4 +582,79 @@ int EVP_DigestVerify(EVP_MD_CTX *ctx, const unsigned char *sigret,
         return -1;
     return EVP_DigestVerifyFinal(ctx, sigret, siglen);
 }
+
+/*
+ * The signature implementation that verifies for |ctx|, if it is a provider
+ * one that can verify a batch of signatures at once.
+ */
+static EVP_SIGNATURE *batch_signature(const EVP_MD_CTX *ctx)
+{
+    EVP_PKEY_CTX *pctx = ctx->pctx;
+
+    if (pctx == NULL
+            || pctx->operation != EVP_PKEY_OP_VERIFYCTX
+            || pctx->op.sig.sigprovctx == NULL
+            || pctx->op.sig.signature == NULL
+            || pctx->op.sig.signature->digest_verify_batch == NULL)
+        return NULL;
+    return pctx->op.sig.signature;
+}
+
+int EVP_DigestVerify_batch(EVP_PKEY *const *pkeys,
+                           const unsigned char *const *sigs,
+                           const size_t *siglens,
+                           const unsigned char *const *tbs,
+                           const size_t *tbslens, size_t num,
+                           OSSL_LIB_CTX *libctx, const char *propq,
+                           const OSSL_PARAM params[])
+{
+    EVP_MD_CTX **ctxs;
+    void **provctxs = NULL;
+    EVP_SIGNATURE *signature;
+    size_t i, j;
+    int ret = 0;
+
+    if (num == 0)
+        return 1;
+
+    ctxs = OPENSSL_zalloc(num * sizeof(*ctxs));
+    provctxs = OPENSSL_malloc(num * sizeof(*provctxs));
+    if (ctxs == NULL || provctxs == NULL) {
+        ERR_raise(ERR_LIB_EVP, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    for (i = 0; i < num; i++) {
+        if ((ctxs[i] = EVP_MD_CTX_new()) == NULL
+                || EVP_DigestVerifyInit_ex(ctxs[i], NULL, NULL, libctx, propq,
+                                           pkeys[i]) <= 0)
+            goto err;
+    }
+
+    /*
+     * Consecutive signatures verified by the same implementation are passed to
+     * it together if it can verify a batch, all others are verified one by one.
+     */
+    for (i = 0; i < num; i = j) {
+        if ((signature = batch_signature(ctxs[i])) == NULL) {
+            if (EVP_DigestVerify(ctxs[i], sigs[i], siglens[i], tbs[i],
+                                 tbslens[i]) != 1)
+                goto err;
+            j = i + 1;
+            continue;
+        }
+        for (j = i; j < num && batch_signature(ctxs[j]) == signature; j++)
+            provctxs[j - i] = ctxs[j]->pctx->op.sig.sigprovctx;
+        if (!signature->digest_verify_batch(provctxs, sigs + i, siglens + i,
+                                            tbs + i, tbslens + i, j - i,
+                                            params))
+            goto err;
+    }
+    ret = 1;
+ err:
+    for (i = 0; ctxs != NULL && i < num; i++)
+        EVP_MD_CTX_free(ctxs[i]);
+    OPENSSL_free(ctxs);
+    OPENSSL_free(provctxs);
+    return ret;
+}
 #endif /* FIPS_MODULE */
@@ -219,6 +219,12 @@ static void *evp_signature_from_dispatch(int name_id,
                 = OSSL_FUNC_signature_settable_ctx_md_params(fns);
             smdparamfncnt++;
             break;
+        case OSSL_FUNC_SIGNATURE_DIGEST_VERIFY_BATCH:
+            if (signature->digest_verify_batch != NULL)
+                break;
+            signature->digest_verify_batch
+                = OSSL_FUNC_signature_digest_verify_batch(fns);
+            break;
         }
     }
     if (ctxfncnt != 2
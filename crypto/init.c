@@ -30,6 +30,7 @@
 #include "crypto/dso_conf.h"
 #include "internal/dso.h"
 #include "crypto/store.h"
+#include "internal/property.h"
 #include <openssl/cmp_util.h> /* for OSSL_CMP_log_close() */
 #include <openssl/trace.h>
 
@@ -432,6 +433,9 @@ void OPENSSL_cleanup(void)
 
     ossl_cleanup_thread();
 
+    OSSL_TRACE(INIT, "OPENSSL_cleanup: ossl_method_store_cleanup_int()\n");
+    ossl_method_store_cleanup_int();
+
     OSSL_TRACE(INIT, "OPENSSL_cleanup: bio_cleanup()\n");
     bio_cleanup();
 
@@ -24,11 +24,20 @@ static unsigned int real_shift(void)
     return sizeof(double) == 4 ? 24 : 53;
 }
 
+/*
+ * A key that is the very same string as |key| matches without a comparison.
+ * That only happens when both come from the same string literal in the same
+ * binary, e.g. libcrypto or a built-in provider looking up a parameter that
+ * libcrypto built.  Literals are not merged across shared libraries, so with
+ * a shared libcrypto an application's keys are always compared by name.
+ * Checking the first byte settles most mismatches without calling strcmp().
+ */
 OSSL_PARAM *OSSL_PARAM_locate(OSSL_PARAM *p, const char *key)
 {
     if (p != NULL && key != NULL)
         for (; p->key != NULL; p++)
-            if (strcmp(key, p->key) == 0)
+            if (p->key == key
+                || (p->key[0] == key[0] && strcmp(key, p->key) == 0))
                 return p;
     return NULL;
 }
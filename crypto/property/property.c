@@ -17,6 +17,7 @@
 #include <openssl/lhash.h>
 #include <openssl/rand.h>
 #include "internal/thread_once.h"
+#include "crypto/cryptlib.h"
 #include "crypto/lhash.h"
 #include "crypto/sparse_array.h"
 #include "property_local.h"
@@ -28,6 +29,12 @@
  */
 #define IMPL_CACHE_FLUSH_THRESHOLD  500
 
+/*
+ * The number of slots in each thread's private query cache.  The per thread
+ * cache is direct mapped, so this must be a power of two.
+ */
+#define THREAD_CACHE_SIZE           16
+
 typedef struct {
     void *method;
     int (*up_ref)(void *);
@@ -56,12 +63,53 @@ typedef struct {
     LHASH_OF(QUERY) *cache;
 } ALGORITHM;
 
+#ifndef FIPS_MODULE
+typedef struct {
+    int nid;
+    QUERY *query;
+} THREAD_QUERY;
+
+/*
+ * One thread's query cache for one store.  The slots are only looked at by
+ * whoever has claimed the cache: the owning thread during a lookup, or the
+ * thread that changes the store, which releases the outdated entries of the
+ * caches it can claim.  When the store is freed, which must not happen while
+ * the store is still in use, the slots are released without a claim.  The
+ * cache itself is always freed by its thread, once it has been removed from
+ * the store or the store has marked it dead.
+ */
+typedef struct {
+    OSSL_METHOD_STORE *store;
+    /* The store generation the slots are valid for */
+    int generation;
+    /* Non-zero while claimed, only accessed with CRYPTO_atomic_add() */
+    int busy;
+    /* Set once the store is gone, only accessed with CRYPTO_atomic_add() */
+    int dead;
+    THREAD_QUERY slots[THREAD_CACHE_SIZE];
+} THREAD_CACHE;
+
+DEFINE_STACK_OF(THREAD_CACHE)
+#endif
+
 struct ossl_method_store_st {
     OSSL_LIB_CTX *ctx;
     size_t nelem;
     SPARSE_ARRAY_OF(ALGORITHM) *algs;
     int need_flush;
     CRYPTO_RWLOCK *lock;
+
+    /*
+     * The generation is bumped every time the store or its query cache
+     * is altered.  Entries in the per thread caches are tagged with the
+     * generation they were created in and are ignored once it changes.
+     * It is only ever accessed with CRYPTO_atomic_add().
+     */
+    int generation;
+#ifndef FIPS_MODULE
+    /* The per thread caches for this store, guarded by |lock| */
+    STACK_OF(THREAD_CACHE) *thread_caches;
+#endif
 };
 
 typedef struct {
@@ -168,6 +216,418 @@ static void alg_cleanup(ossl_uintmax_t idx, ALGORITHM *a)
     }
 }
 
+static QUERY *query_new(const char *prop_query, void *method,
+                        int (*method_up_ref)(void *),
+                        void (*method_destruct)(void *))
+{
+    size_t len = strlen(prop_query);
+    QUERY *p = OPENSSL_malloc(sizeof(*p) + len);
+
+    if (p != NULL) {
+        p->query = p->body;
+        p->method.method = method;
+        p->method.up_ref = method_up_ref;
+        p->method.free = method_destruct;
+        if (!ossl_method_up_ref(&p->method)) {
+            OPENSSL_free(p);
+            return NULL;
+        }
+        memcpy((char *)p->query, prop_query, len + 1);
+    }
+    return p;
+}
+
+/*
+ * The store generation is read and modified atomically so that the per thread
+ * caches can be validated without taking the store lock.  No fallback lock is
+ * supplied: on platforms lacking lock free atomics these calls fail and the
+ * per thread caches are simply never used.
+ */
+static int store_generation(OSSL_METHOD_STORE *store, int *gen)
+{
+    return CRYPTO_atomic_add(&store->generation, 0, gen, NULL);
+}
+
+static void thread_caches_flush(OSSL_METHOD_STORE *store, int gen);
+
+/*
+ * Must be called with the store write lock held.  The entries of the per
+ * thread caches are outdated from now on and are released here, so that idle
+ * threads don't keep methods, and with them their providers, alive.  A cache
+ * that its thread is using at this very moment is left to that thread.
+ */
+static void store_bump_generation(OSSL_METHOD_STORE *store)
+{
+    int gen;
+
+    if (CRYPTO_atomic_add(&store->generation, 1, &gen, NULL))
+        thread_caches_flush(store, gen);
+}
+
+#ifndef FIPS_MODULE
+/*
+ * A single thread local key for all stores, whose value is the stack of the
+ * calling thread's caches.  Having a key per store would run out of keys in
+ * applications that create many library contexts.
+ */
+static CRYPTO_THREAD_LOCAL thread_caches_key;
+static CRYPTO_ONCE thread_caches_once = CRYPTO_ONCE_STATIC_INIT;
+static int thread_caches_inited = 0;
+
+DEFINE_RUN_ONCE_STATIC(do_thread_caches_init)
+{
+    if (!CRYPTO_THREAD_init_local(&thread_caches_key, NULL))
+        return 0;
+    thread_caches_inited = 1;
+    return 1;
+}
+
+static STACK_OF(THREAD_CACHE) *thread_caches_get(void)
+{
+    if (!RUN_ONCE(&thread_caches_once, do_thread_caches_init))
+        return NULL;
+    return CRYPTO_THREAD_get_local(&thread_caches_key);
+}
+
+static void thread_cache_clear(THREAD_CACHE *tc)
+{
+    size_t i;
+
+    for (i = 0; i < OSSL_NELEM(tc->slots); i++) {
+        impl_cache_free(tc->slots[i].query);
+        tc->slots[i].query = NULL;
+    }
+}
+
+/*
+ * Only one thread at a time may look at a cache's slots.  Neither side ever
+ * waits for the other: if the cache is already claimed, the caller does
+ * without it.
+ */
+static int thread_cache_claim(THREAD_CACHE *tc)
+{
+    int busy;
+
+    if (!CRYPTO_atomic_add(&tc->busy, 1, &busy, NULL))
+        return 0;
+    if (busy == 1)
+        return 1;
+    CRYPTO_atomic_add(&tc->busy, -1, &busy, NULL);
+    return 0;
+}
+
+static void thread_cache_unclaim(THREAD_CACHE *tc)
+{
+    int busy;
+
+    CRYPTO_atomic_add(&tc->busy, -1, &busy, NULL);
+}
+
+/*
+ * Called by the owning thread once it has let go of its cache, which was
+ * valid for generation |gen|.  If the store changed while the cache was
+ * claimed, the thread that changed it had to skip this cache, so its outdated
+ * entries are released here instead.
+ */
+static void thread_cache_done(OSSL_METHOD_STORE *store, THREAD_CACHE *tc,
+                              int gen)
+{
+    int cur;
+
+    thread_cache_unclaim(tc);
+    if (!store_generation(store, &cur) || cur == gen
+            || !thread_cache_claim(tc))
+        return;
+    if (tc->generation != cur) {
+        thread_cache_clear(tc);
+        tc->generation = cur;
+    }
+    thread_cache_unclaim(tc);
+}
+
+static int thread_cache_is_dead(THREAD_CACHE *tc)
+{
+    int dead;
+
+    return !CRYPTO_atomic_add(&tc->dead, 0, &dead, NULL) || dead;
+}
+
+/* The calling thread's cache for |store|, if it has one */
+static THREAD_CACHE *thread_cache_find(STACK_OF(THREAD_CACHE) *caches,
+                                       OSSL_METHOD_STORE *store)
+{
+    THREAD_CACHE *tc;
+    int i;
+
+    for (i = 0; i < sk_THREAD_CACHE_num(caches); i++) {
+        tc = sk_THREAD_CACHE_value(caches, i);
+        /* A freed store's address can be reused, so check it's alive */
+        if (tc->store == store && !thread_cache_is_dead(tc))
+            return tc;
+    }
+    return NULL;
+}
+
+/* Free the calling thread's caches of stores that have since been freed */
+static void thread_caches_purge(STACK_OF(THREAD_CACHE) *caches)
+{
+    THREAD_CACHE *tc;
+    int i;
+
+    for (i = sk_THREAD_CACHE_num(caches) - 1; i >= 0; i--) {
+        tc = sk_THREAD_CACHE_value(caches, i);
+        if (thread_cache_is_dead(tc)) {
+            (void)sk_THREAD_CACHE_delete(caches, i);
+            OPENSSL_free(tc);
+        }
+    }
+}
+
+/* Called when a thread stops, once for all stores */
+static void thread_caches_stop(void *arg)
+{
+    STACK_OF(THREAD_CACHE) *caches = thread_caches_get();
+
+    if (caches == NULL)
+        return;
+    /* The stores' own handlers have already removed their live caches */
+    thread_caches_purge(caches);
+    if (sk_THREAD_CACHE_num(caches) == 0) {
+        CRYPTO_THREAD_set_local(&thread_caches_key, NULL);
+        sk_THREAD_CACHE_free(caches);
+    }
+}
+
+/* Called when a thread stops, for each store the thread has a cache for */
+static void thread_cache_stop(void *arg)
+{
+    OSSL_METHOD_STORE *store = arg;
+    STACK_OF(THREAD_CACHE) *caches = thread_caches_get();
+    THREAD_CACHE *tc;
+
+    if (caches == NULL || (tc = thread_cache_find(caches, store)) == NULL)
+        return;
+    ossl_property_write_lock(store);
+    (void)sk_THREAD_CACHE_delete_ptr(store->thread_caches, tc);
+    ossl_property_unlock(store);
+    (void)sk_THREAD_CACHE_delete_ptr(caches, tc);
+    thread_cache_clear(tc);
+    OPENSSL_free(tc);
+}
+
+/*
+ * Create the calling thread's query cache for |store|.  The store remembers
+ * it as well, so that it can release the cached methods when it is freed,
+ * even if the thread is still running.
+ */
+static THREAD_CACHE *thread_cache_new(OSSL_METHOD_STORE *store)
+{
+    STACK_OF(THREAD_CACHE) *caches = thread_caches_get();
+    THREAD_CACHE *tc;
+
+    if (caches == NULL) {
+        if (!RUN_ONCE(&thread_caches_once, do_thread_caches_init)
+                || (caches = sk_THREAD_CACHE_new_null()) == NULL)
+            return NULL;
+        if (!CRYPTO_THREAD_set_local(&thread_caches_key, caches)
+                || !ossl_init_thread_start(&thread_caches_key, NULL,
+                                           &thread_caches_stop)) {
+            CRYPTO_THREAD_set_local(&thread_caches_key, NULL);
+            sk_THREAD_CACHE_free(caches);
+            return NULL;
+        }
+    }
+    thread_caches_purge(caches);
+
+    if ((tc = OPENSSL_zalloc(sizeof(*tc))) == NULL)
+        return NULL;
+    tc->store = store;
+    if (!sk_THREAD_CACHE_push(caches, tc)) {
+        OPENSSL_free(tc);
+        return NULL;
+    }
+
+    ossl_property_write_lock(store);
+    if (store->thread_caches == NULL)
+        store->thread_caches = sk_THREAD_CACHE_new_null();
+    if (store->thread_caches == NULL
+            || !sk_THREAD_CACHE_push(store->thread_caches, tc)) {
+        ossl_property_unlock(store);
+        (void)sk_THREAD_CACHE_pop(caches);
+        OPENSSL_free(tc);
+        return NULL;
+    }
+    ossl_property_unlock(store);
+
+    if (!ossl_init_thread_start(store, store, &thread_cache_stop)) {
+        ossl_property_write_lock(store);
+        (void)sk_THREAD_CACHE_delete_ptr(store->thread_caches, tc);
+        ossl_property_unlock(store);
+        (void)sk_THREAD_CACHE_pop(caches);
+        OPENSSL_free(tc);
+        return NULL;
+    }
+    return tc;
+}
+
+/*
+ * Release the methods cached by all threads for |store| and hand the caches
+ * back to their threads to be freed.  The store is being freed, so none of
+ * these threads can be using the caches.
+ */
+static void thread_caches_release(OSSL_METHOD_STORE *store)
+{
+    THREAD_CACHE *tc;
+    int dead;
+
+    if (store->thread_caches == NULL)
+        return;
+    ossl_init_thread_deregister(store);
+    while ((tc = sk_THREAD_CACHE_pop(store->thread_caches)) != NULL) {
+        thread_cache_clear(tc);
+        /* The thread may free |tc| from now on */
+        CRYPTO_atomic_add(&tc->dead, 1, &dead, NULL);
+    }
+    sk_THREAD_CACHE_free(store->thread_caches);
+    store->thread_caches = NULL;
+}
+
+/*
+ * Release the outdated entries of all threads' caches for |store|, which has
+ * just moved on to generation |gen|.  Must be called with the store write lock
+ * held, which keeps the list of caches stable.
+ */
+static void thread_caches_flush(OSSL_METHOD_STORE *store, int gen)
+{
+    THREAD_CACHE *tc;
+    int i;
+
+    for (i = 0; i < sk_THREAD_CACHE_num(store->thread_caches); i++) {
+        tc = sk_THREAD_CACHE_value(store->thread_caches, i);
+        if (!thread_cache_claim(tc))
+            continue;
+        thread_cache_clear(tc);
+        tc->generation = gen;
+        thread_cache_unclaim(tc);
+    }
+}
+
+static THREAD_QUERY *thread_cache_slot(THREAD_CACHE *tc, int nid,
+                                       const char *prop_query)
+{
+    unsigned long h = OPENSSL_LH_strhash(prop_query) ^ (unsigned long)nid;
+
+    return tc->slots + (h & (THREAD_CACHE_SIZE - 1));
+}
+
+/*
+ * Lookup in the calling thread's query cache, which takes no lock at all.
+ * If the store has changed since the cache was filled, its entries are
+ * dropped instead.
+ */
+static int thread_cache_get(OSSL_METHOD_STORE *store, int nid,
+                            const char *prop_query, void **method)
+{
+    STACK_OF(THREAD_CACHE) *caches;
+    THREAD_CACHE *tc;
+    THREAD_QUERY *slot;
+    int gen, ret = 0;
+
+    if ((caches = thread_caches_get()) == NULL
+            || (tc = thread_cache_find(caches, store)) == NULL
+            || !thread_cache_claim(tc))
+        return 0;
+    if (!store_generation(store, &gen)) {
+        thread_cache_unclaim(tc);
+        return 0;
+    }
+
+    if (tc->generation != gen) {
+        /* Don't keep outdated methods alive any longer than needed */
+        thread_cache_clear(tc);
+        tc->generation = gen;
+    } else {
+        slot = thread_cache_slot(tc, nid, prop_query);
+        if (slot->query != NULL
+                && slot->nid == nid
+                && strcmp(slot->query->query, prop_query) == 0
+                && ossl_method_up_ref(&slot->query->method)) {
+            *method = slot->query->method.method;
+            ret = 1;
+        }
+    }
+    thread_cache_done(store, tc, gen);
+    return ret;
+}
+
+/*
+ * Remember a query result in the calling thread's cache.  The generation must
+ * have been read while the store lock was held and the lock must since have
+ * been released.
+ */
+static void thread_cache_set(OSSL_METHOD_STORE *store, int gen, int nid,
+                             const char *prop_query, METHOD *method)
+{
+    STACK_OF(THREAD_CACHE) *caches = thread_caches_get();
+    THREAD_CACHE *tc = NULL;
+    THREAD_QUERY *slot;
+    QUERY *p;
+    int cur;
+
+    /* If the store changed meanwhile, the result is already outdated */
+    if (!store_generation(store, &cur) || cur != gen)
+        return;
+    if (caches != NULL)
+        tc = thread_cache_find(caches, store);
+    if (tc == NULL && (tc = thread_cache_new(store)) == NULL)
+        return;
+    if ((p = query_new(prop_query, method->method, method->up_ref,
+                       method->free)) == NULL)
+        return;
+    if (!thread_cache_claim(tc)) {
+        impl_cache_free(p);
+        return;
+    }
+    if (tc->generation != gen) {
+        thread_cache_clear(tc);
+        tc->generation = gen;
+    }
+
+    slot = thread_cache_slot(tc, nid, prop_query);
+    impl_cache_free(slot->query);
+    slot->nid = nid;
+    slot->query = p;
+    thread_cache_done(store, tc, gen);
+}
+
+void ossl_method_store_cleanup_int(void)
+{
+    if (thread_caches_inited) {
+        CRYPTO_THREAD_cleanup_local(&thread_caches_key);
+        thread_caches_inited = 0;
+    }
+}
+#else
+/*
+ * The FIPS provider learns about thread stop events per library context, not
+ * per store, so it goes without the per thread caches.
+ */
+static int thread_cache_get(OSSL_METHOD_STORE *store, int nid,
+                            const char *prop_query, void **method)
+{
+    return 0;
+}
+
+static void thread_cache_set(OSSL_METHOD_STORE *store, int gen, int nid,
+                             const char *prop_query, METHOD *method)
+{
+}
+
+static void thread_caches_flush(OSSL_METHOD_STORE *store, int gen)
+{
+}
+#endif
+
 /*
  * The OSSL_LIB_CTX param here allows access to underlying property data needed
  * for computation
@@ -195,6 +655,9 @@ OSSL_METHOD_STORE *ossl_method_store_new(OSSL_LIB_CTX *ctx)
 void ossl_method_store_free(OSSL_METHOD_STORE *store)
 {
     if (store != NULL) {
+#ifndef FIPS_MODULE
+        thread_caches_release(store);
+#endif
         ossl_sa_ALGORITHM_doall(store->algs, &alg_cleanup);
         ossl_sa_ALGORITHM_free(store->algs);
         CRYPTO_THREAD_lock_free(store->lock);
@@ -419,6 +882,7 @@ static void ossl_method_cache_flush(OSSL_METHOD_STORE *store, int nid)
 {
     ALGORITHM *alg = ossl_method_store_retrieve(store, nid);
 
+    store_bump_generation(store);
     if (alg != NULL) {
         store->nelem -= lh_QUERY_num_items(alg->cache);
         impl_cache_flush_alg(0, alg, NULL);
@@ -430,6 +894,7 @@ void ossl_method_store_flush_cache(OSSL_METHOD_STORE *store, int all)
     void *arg = (all != 0 ? store->algs : NULL);
 
     ossl_property_write_lock(store);
+    store_bump_generation(store);
     ossl_sa_ALGORITHM_doall_arg(store->algs, &impl_cache_flush_alg, arg);
     store->nelem = 0;
     ossl_property_unlock(store);
@@ -494,6 +959,7 @@ static void ossl_method_cache_flush_some(OSSL_METHOD_STORE *store)
     if ((state.seed = OPENSSL_rdtsc()) == 0)
         state.seed = 1;
     store->need_flush = 0;
+    store_bump_generation(store);
     ossl_sa_ALGORITHM_doall_arg(store->algs, &impl_cache_flush_one_alg, &state);
     store->nelem = state.nelem;
 }
@@ -503,26 +969,36 @@ int ossl_method_store_cache_get(OSSL_METHOD_STORE *store, int nid,
 {
     ALGORITHM *alg;
     QUERY elem, *r;
-    int res = 0;
+    METHOD found;
+    int res = 0, gen = 0, have_gen = 0;
 
     if (nid <= 0 || store == NULL)
         return 0;
+    if (prop_query == NULL)
+        prop_query = "";
+
+    if (thread_cache_get(store, nid, prop_query, method))
+        return 1;
 
     ossl_property_read_lock(store);
     alg = ossl_method_store_retrieve(store, nid);
     if (alg == NULL)
         goto err;
 
-    elem.query = prop_query != NULL ? prop_query : "";
+    elem.query = prop_query;
     r = lh_QUERY_retrieve(alg->cache, &elem);
     if (r == NULL)
         goto err;
     if (ossl_method_up_ref(&r->method)) {
         *method = r->method.method;
+        found = r->method;
+        have_gen = store_generation(store, &gen);
         res = 1;
     }
 err:
     ossl_property_unlock(store);
+    if (res && have_gen)
+        thread_cache_set(store, gen, nid, prop_query, &found);
     return res;
 }
 
@@ -533,8 +1009,8 @@ int ossl_method_store_cache_set(OSSL_METHOD_STORE *store, int nid,
 {
     QUERY elem, *old, *p = NULL;
     ALGORITHM *alg;
-    size_t len;
-    int res = 1;
+    METHOD added;
+    int res = 1, gen = 0, have_gen = 0;
 
     if (nid <= 0 || store == NULL)
         return 0;
@@ -551,27 +1027,25 @@ int ossl_method_store_cache_set(OSSL_METHOD_STORE *store, int nid,
     if (method == NULL) {
         elem.query = prop_query;
         if ((old = lh_QUERY_delete(alg->cache, &elem)) != NULL) {
+            store_bump_generation(store);
             impl_cache_free(old);
             store->nelem--;
         }
         goto end;
     }
-    p = OPENSSL_malloc(sizeof(*p) + (len = strlen(prop_query)));
+    p = query_new(prop_query, method, method_up_ref, method_destruct);
     if (p != NULL) {
-        p->query = p->body;
-        p->method.method = method;
-        p->method.up_ref = method_up_ref;
-        p->method.free = method_destruct;
-        if (!ossl_method_up_ref(&p->method))
-            goto err;
-        memcpy((char *)p->query, prop_query, len + 1);
+        added = p->method;
         if ((old = lh_QUERY_insert(alg->cache, p)) != NULL) {
+            store_bump_generation(store);
             impl_cache_free(old);
+            have_gen = store_generation(store, &gen);
             goto end;
         }
         if (!lh_QUERY_error(alg->cache)) {
             if (++store->nelem >= IMPL_CACHE_FLUSH_THRESHOLD)
                 store->need_flush = 1;
+            have_gen = store_generation(store, &gen);
             goto end;
         }
         ossl_method_free(&p->method);
@@ -581,5 +1055,7 @@ err:
     OPENSSL_free(p);
 end:
     ossl_property_unlock(store);
+    if (have_gen)
+        thread_cache_set(store, gen, nid, prop_query, &added);
     return res;
 }
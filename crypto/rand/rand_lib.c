@@ -41,6 +41,17 @@ static const RAND_METHOD *default_RAND_meth;
 # endif
 static CRYPTO_ONCE rand_init = CRYPTO_ONCE_STATIC_INIT;
 
+/*
+ * Public requests of up to RAND_CACHE_MAX_REQUEST bytes are served from a
+ * per-thread buffer holding RAND_CACHE_SIZE bytes of DRBG output.
+ */
+# define RAND_CACHE_MAX_REQUEST     32
+# define RAND_CACHE_SIZE            512
+
+static int rand_public_bytes_cached(OSSL_LIB_CTX *ctx, unsigned char *buf,
+                                    int num);
+static void rand_discard_cache(OSSL_LIB_CTX *ctx);
+
 static int rand_inited = 0;
 
 DEFINE_RUN_ONCE_STATIC(do_rand_init)
@@ -180,6 +191,16 @@ const RAND_METHOD *RAND_get_rand_method(void)
     if (!RUN_ONCE(&rand_init, do_rand_init))
         return NULL;
 
+    /*
+     * This is called for every RAND_bytes(), so avoid serialising all
+     * callers on the write lock once the method has been chosen.
+     */
+    CRYPTO_THREAD_read_lock(rand_meth_lock);
+    tmp_meth = default_RAND_meth;
+    CRYPTO_THREAD_unlock(rand_meth_lock);
+    if (tmp_meth != NULL)
+        return tmp_meth;
+
     CRYPTO_THREAD_write_lock(rand_meth_lock);
     if (default_RAND_meth == NULL) {
 #  ifndef OPENSSL_NO_ENGINE
@@ -235,7 +256,10 @@ void RAND_seed(const void *buf, int num)
     EVP_RAND_CTX *drbg;
 # ifndef OPENSSL_NO_DEPRECATED_3_0
     const RAND_METHOD *meth = RAND_get_rand_method();
+# endif
 
+    rand_discard_cache(NULL);
+# ifndef OPENSSL_NO_DEPRECATED_3_0
     if (meth != NULL && meth->seed != NULL) {
         meth->seed(buf, num);
         return;
@@ -252,7 +276,10 @@ void RAND_add(const void *buf, int num, double randomness)
     EVP_RAND_CTX *drbg;
 # ifndef OPENSSL_NO_DEPRECATED_3_0
     const RAND_METHOD *meth = RAND_get_rand_method();
+# endif
 
+    rand_discard_cache(NULL);
+# ifndef OPENSSL_NO_DEPRECATED_3_0
     if (meth != NULL && meth->add != NULL) {
         meth->add(buf, num, randomness);
         return;
@@ -344,6 +371,11 @@ int RAND_bytes_ex(OSSL_LIB_CTX *ctx, unsigned char *buf, int num)
     }
 #endif
 
+#ifndef FIPS_MODULE
+    if (num > 0 && num <= RAND_CACHE_MAX_REQUEST)
+        return rand_public_bytes_cached(ctx, buf, num);
+#endif
+
     rand = RAND_get0_public(ctx);
     if (rand != NULL)
         return EVP_RAND_generate(rand, buf, num, 0, 0, NULL, 0);
@@ -356,6 +388,23 @@ int RAND_bytes(unsigned char *buf, int num)
     return RAND_bytes_ex(NULL, buf, num);
 }
 
+/* Per-thread state of the <public> DRBG */
+typedef struct rand_public_st {
+    EVP_RAND_CTX *drbg;
+#ifndef FIPS_MODULE
+    /*
+     * Buffered output, see rand_public_bytes_cached().  |reseed_count|,
+     * |primary_reseed_count| and |fork_id| are those of |drbg| and of the
+     * <primary> DRBG when the buffer was filled.
+     */
+    unsigned int reseed_count;
+    unsigned int primary_reseed_count;
+    int fork_id;
+    size_t avail;
+    unsigned char buf[RAND_CACHE_SIZE];
+#endif
+} RAND_PUBLIC;
+
 typedef struct rand_global_st {
     /*
      * The three shared DRBG instances
@@ -388,7 +437,7 @@ typedef struct rand_global_st {
      * Used by default for generating random bytes using RAND_bytes().
      *
      * The <public> secondary DRBG is thread-local, i.e., there is one instance
-     * per thread.
+     * per thread.  The thread-local value is a RAND_PUBLIC.
      */
     CRYPTO_THREAD_LOCAL public;
 
@@ -490,13 +539,17 @@ static void rand_delete_thread_state(void *arg)
     OSSL_LIB_CTX *ctx = arg;
     RAND_GLOBAL *dgbl = rand_get_global(ctx);
     EVP_RAND_CTX *rand;
+    RAND_PUBLIC *pub;
 
     if (dgbl == NULL)
         return;
 
-    rand = CRYPTO_THREAD_get_local(&dgbl->public);
+    pub = CRYPTO_THREAD_get_local(&dgbl->public);
     CRYPTO_THREAD_set_local(&dgbl->public, NULL);
-    EVP_RAND_CTX_free(rand);
+    if (pub != NULL) {
+        EVP_RAND_CTX_free(pub->drbg);
+        OPENSSL_clear_free(pub, sizeof(*pub));
+    }
 
     rand = CRYPTO_THREAD_get_local(&dgbl->private);
     CRYPTO_THREAD_set_local(&dgbl->private, NULL);
@@ -645,13 +698,14 @@ EVP_RAND_CTX *RAND_get0_primary(OSSL_LIB_CTX *ctx)
 EVP_RAND_CTX *RAND_get0_public(OSSL_LIB_CTX *ctx)
 {
     RAND_GLOBAL *dgbl = rand_get_global(ctx);
-    EVP_RAND_CTX *rand, *primary;
+    EVP_RAND_CTX *primary;
+    RAND_PUBLIC *pub;
 
     if (dgbl == NULL)
         return NULL;
 
-    rand = CRYPTO_THREAD_get_local(&dgbl->public);
-    if (rand == NULL) {
+    pub = CRYPTO_THREAD_get_local(&dgbl->public);
+    if (pub == NULL) {
         primary = RAND_get0_primary(ctx);
         if (primary == NULL)
             return NULL;
@@ -664,11 +718,19 @@ EVP_RAND_CTX *RAND_get0_public(OSSL_LIB_CTX *ctx)
         if (CRYPTO_THREAD_get_local(&dgbl->private) == NULL
                 && !ossl_init_thread_start(NULL, ctx, rand_delete_thread_state))
             return NULL;
-        rand = rand_new_drbg(ctx, primary, SECONDARY_RESEED_INTERVAL,
-                             SECONDARY_RESEED_TIME_INTERVAL);
-        CRYPTO_THREAD_set_local(&dgbl->public, rand);
+        pub = OPENSSL_zalloc(sizeof(*pub));
+        if (pub == NULL)
+            return NULL;
+        pub->drbg = rand_new_drbg(ctx, primary, SECONDARY_RESEED_INTERVAL,
+                                  SECONDARY_RESEED_TIME_INTERVAL);
+        if (pub->drbg == NULL
+                || !CRYPTO_THREAD_set_local(&dgbl->public, pub)) {
+            EVP_RAND_CTX_free(pub->drbg);
+            OPENSSL_free(pub);
+            return NULL;
+        }
     }
-    return rand;
+    return pub->drbg;
 }
 
 /*
@@ -704,6 +766,89 @@ EVP_RAND_CTX *RAND_get0_private(OSSL_LIB_CTX *ctx)
     return rand;
 }
 
+#ifndef FIPS_MODULE
+/*
+ * Serve a short request from the calling thread's buffer of <public> DRBG
+ * output, refilling it with a single generate call when it runs dry.  This
+ * spreads the cost of a DRBG generate (and of the reseed checks that go with
+ * it) over many nonces and IVs.  Bytes are wiped from the buffer as they are
+ * handed out.
+ *
+ * The buffer is dropped when the process has forked and once the reseed
+ * counter of the <public> DRBG or of the <primary> DRBG moves on.  The
+ * <public> DRBG only notices that the <primary> reseeded, e.g. after a
+ * RAND_add() on another thread, when it generates, so that counter is
+ * checked here as well.
+ *
+ * The <public> DRBG has no lock of its own, and the counters of the built-in
+ * DRBGs are read without taking the <primary>'s lock, so none of this takes a
+ * lock.
+ */
+static int rand_public_bytes_cached(OSSL_LIB_CTX *ctx, unsigned char *buf,
+                                    int num)
+{
+    RAND_GLOBAL *dgbl = rand_get_global(ctx);
+    RAND_PUBLIC *pub;
+    EVP_RAND_CTX *primary;
+    unsigned char *p;
+    unsigned int reseed_count, primary_reseed_count;
+    int fork_id;
+
+    if (dgbl == NULL)
+        return 0;
+
+    pub = CRYPTO_THREAD_get_local(&dgbl->public);
+    if (pub == NULL) {
+        if (RAND_get0_public(ctx) == NULL)
+            return 0;
+        pub = CRYPTO_THREAD_get_local(&dgbl->public);
+    }
+
+    /* Set before |pub| was, and only changed once the library is freed */
+    primary = dgbl->primary;
+
+    fork_id = openssl_get_fork_id();
+    reseed_count = evp_rand_reseed_counter(pub->drbg);
+    primary_reseed_count = evp_rand_reseed_counter(primary);
+    if (pub->fork_id != fork_id || pub->reseed_count != reseed_count
+            || pub->primary_reseed_count != primary_reseed_count)
+        rand_discard_cache(ctx);
+
+    if (pub->avail < (size_t)num) {
+        if (!EVP_RAND_generate(pub->drbg, pub->buf, sizeof(pub->buf),
+                               0, 0, NULL, 0)) {
+            OPENSSL_cleanse(pub->buf, sizeof(pub->buf));
+            pub->avail = 0;
+            return 0;
+        }
+        /* The generate may itself have reseeded, and the <primary> too */
+        pub->reseed_count = evp_rand_reseed_counter(pub->drbg);
+        pub->primary_reseed_count = evp_rand_reseed_counter(primary);
+        pub->fork_id = fork_id;
+        pub->avail = sizeof(pub->buf);
+    }
+
+    p = pub->buf + sizeof(pub->buf) - pub->avail;
+    memcpy(buf, p, num);
+    OPENSSL_cleanse(p, num);
+    pub->avail -= num;
+    return 1;
+}
+
+/* Wipe whatever is left in the calling thread's <public> output buffer */
+static void rand_discard_cache(OSSL_LIB_CTX *ctx)
+{
+    RAND_GLOBAL *dgbl = rand_get_global(ctx);
+    RAND_PUBLIC *pub;
+
+    if (dgbl == NULL
+            || (pub = CRYPTO_THREAD_get_local(&dgbl->public)) == NULL)
+        return;
+    OPENSSL_cleanse(pub->buf, sizeof(pub->buf));
+    pub->avail = 0;
+}
+#endif
+
 #ifndef FIPS_MODULE
 static int random_set_string(char **p, const char *s)
 {
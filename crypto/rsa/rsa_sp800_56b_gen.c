@@ -13,12 +13,38 @@
 #include <openssl/core.h>
 #include "crypto/bn.h"
 #include "crypto/security_bits.h"
+#include "internal/thread.h"
 #include "rsa_local.h"
 
 #define RSA_FIPS1864_MIN_KEYGEN_KEYSIZE 2048
 #define RSA_FIPS1864_MIN_KEYGEN_STRENGTH 112
 #define RSA_FIPS1864_MAX_KEYGEN_STRENGTH 256
 
+#ifndef FIPS_MODULE
+/* A search for q that runs on a worker thread while p is being searched for */
+typedef struct {
+    OSSL_LIB_CTX *libctx;
+    BIGNUM *q, *Xq;
+    const BIGNUM *e;
+    int nbits;
+    int ret;
+} RSA_PRIME_JOB;
+
+static void rsa_prime_job(void *data)
+{
+    RSA_PRIME_JOB *job = data;
+    BN_CTX *ctx = BN_CTX_new_ex(job->libctx);
+
+    /* The caller's BN_GENCB is not called from other threads */
+    job->ret = ctx != NULL
+               && ossl_bn_rsa_fips186_4_gen_prob_primes(job->q, job->Xq,
+                                                        NULL, NULL, NULL, NULL,
+                                                        NULL, job->nbits,
+                                                        job->e, ctx, NULL);
+    BN_CTX_free(ctx);
+}
+#endif
+
 /*
  * Generate probable primes 'p' & 'q'. See FIPS 186-4 Section B.3.6
  * "Generation of Probable Primes with Conditions Based on Auxiliary Probable
@@ -67,6 +93,11 @@ int ossl_rsa_fips186_4_gen_prob_primes(RSA *rsa, RSA_ACVP_TEST *test,
     BIGNUM *Xpout = NULL, *Xqout = NULL;
     BIGNUM *Xp = NULL, *Xp1 = NULL, *Xp2 = NULL;
     BIGNUM *Xq = NULL, *Xq1 = NULL, *Xq2 = NULL;
+    int have_q = 0;
+#ifndef FIPS_MODULE
+    RSA_PRIME_JOB job;
+    OSSL_CRYPTO_THREAD *thread = NULL;
+#endif
 
 #if defined(FIPS_MODULE) && !defined(OPENSSL_NO_ACVP_TESTS)
     if (test != NULL) {
@@ -120,15 +151,41 @@ int ossl_rsa_fips186_4_gen_prob_primes(RSA *rsa, RSA_ACVP_TEST *test,
     BN_set_flags(rsa->p, BN_FLG_CONSTTIME);
     BN_set_flags(rsa->q, BN_FLG_CONSTTIME);
 
+#ifndef FIPS_MODULE
+    /*
+     * p and q are independent of each other, so if the library context has
+     * a worker thread to spare the first q is searched for on it while this
+     * thread looks for p. Known answer tests pass in their own X values and
+     * always run in sequence.
+     */
+    if (test == NULL) {
+        job.libctx = rsa->libctx;
+        job.q = rsa->q;
+        job.Xq = Xqo;
+        job.e = e;
+        job.nbits = nbits;
+        job.ret = 0;
+        thread = ossl_crypto_thread_start(rsa->libctx, rsa_prime_job, &job);
+    }
+#endif
+
     /* (Step 4) Generate p, Xp */
-    if (!ossl_bn_rsa_fips186_4_gen_prob_primes(rsa->p, Xpo, p1, p2, Xp, Xp1, Xp2,
-                                               nbits, e, ctx, cb))
+    ok = ossl_bn_rsa_fips186_4_gen_prob_primes(rsa->p, Xpo, p1, p2, Xp, Xp1,
+                                               Xp2, nbits, e, ctx, cb);
+#ifndef FIPS_MODULE
+    if (thread != NULL)
+        have_q = ossl_crypto_thread_join(thread) && job.ret;
+#endif
+    if (!ok)
         goto err;
     for(;;) {
         /* (Step 5) Generate q, Xq*/
-        if (!ossl_bn_rsa_fips186_4_gen_prob_primes(rsa->q, Xqo, q1, q2, Xq, Xq1,
-                                                   Xq2, nbits, e, ctx, cb))
+        if (!have_q
+                && !ossl_bn_rsa_fips186_4_gen_prob_primes(rsa->q, Xqo, q1, q2,
+                                                          Xq, Xq1, Xq2, nbits,
+                                                          e, ctx, cb))
             goto err;
+        have_q = 0;
 
         /* (Step 6) |Xp - Xq| > 2^(nbitlen/2 - 100) */
         ok = ossl_rsa_check_pminusq_diff(tmp, Xpo, Xqo, nbits);
@@ -1,5 +1,5 @@
 #!/usr/bin/env perl
-# Copyright 2017-2020 The OpenSSL Project Authors. All Rights Reserved.
+# Copyright 2017-2021 The OpenSSL Project Authors. All Rights Reserved.
 #
 # Licensed under the Apache License 2.0 (the "License").  You may not use
 # this file except in compliance with the License.  You can obtain a copy
@@ -125,6 +125,33 @@ my @A_jagged = ([0,0], [1,0], [1,1], [1,2], [1,3],	# [0][0..4]
 my @T = map("%ymm$_",(7..15));
 my ($C14,$C00,$D00,$D14) = @T[5..8];
 
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+# Same assembler check as in keccak1600-x86_64.pl, which only dispatches
+# to this module if it was assembled.
+$avx=0;
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx = ($1>=2.19) + ($1>=2.22) + ($1>=2.25);
+}
+if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$avx = ($2>=3.0) + ($2>3.0);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
 $code.=<<___;
 .text
 
@@ -281,11 +308,65 @@ ___
 my ($A_flat,$inp,$len,$bsz) = ("%rdi","%rsi","%rdx","%rcx");
 my  $out = $inp;	# in squeeze
 
+# Callers keep the state in canonical A[5][5] order, the same as in the
+# scalar code, so that the code path can be chosen per call. It's moved
+# to and from the register layout through the transfer area on stack.
+
+sub load_state {
+my $code=<<___;
+	vpbroadcastq	0-96($A_flat),$A00	# load A[5][5]
+	vmovdqu		8-96($A_flat),$A01
+___
+for(my $i=5; $i<25; $i++) {
+$code.=<<___;
+	mov	8*$i-96($A_flat),%rax
+	mov	%rax,$A_jagged[$i]-96(%r10)
+___
+}
+$code.=<<___;
+	vmovdqa		32*2-96(%r10),$A20
+	vmovdqa		32*3-96(%r10),$A31
+	vmovdqa		32*4-96(%r10),$A21
+	vmovdqa		32*5-96(%r10),$A41
+	vmovdqa		32*6-96(%r10),$A11
+___
+}
+
+sub store_state {
+my $code=<<___;
+	vmovq		%xmm0,0-96($A_flat)	# store A[5][5]
+	vmovdqu		$A01,8-96($A_flat)
+	vmovdqa		$A20,32*2-96(%r10)
+	vmovdqa		$A31,32*3-96(%r10)
+	vmovdqa		$A21,32*4-96(%r10)
+	vmovdqa		$A41,32*5-96(%r10)
+	vmovdqa		$A11,32*6-96(%r10)
+___
+for(my $i=5; $i<25; $i++) {
 $code.=<<___;
-.globl	SHA3_absorb
-.type	SHA3_absorb,\@function
+	mov	$A_jagged[$i]-96(%r10),%rax
+	mov	%rax,8*$i-96($A_flat)
+___
+}
+$code;
+}
+
+sub zero_transfer_area {
+<<___;
+	vpxor		@T[0],@T[0],@T[0]
+	vmovdqa		@T[0],32*2-96(%r10)
+	vmovdqa		@T[0],32*3-96(%r10)
+	vmovdqa		@T[0],32*4-96(%r10)
+	vmovdqa		@T[0],32*5-96(%r10)
+	vmovdqa		@T[0],32*6-96(%r10)
+___
+}
+
+$code.=<<___;
+.globl	SHA3_absorb_avx2
+.type	SHA3_absorb_avx2,\@function
 .align	32
-SHA3_absorb:
+SHA3_absorb_avx2:
 	mov	%rsp,%r11
 
 	lea	-240(%rsp),%rsp
@@ -294,24 +375,10 @@ SHA3_absorb:
 	lea	96($A_flat),$A_flat
 	lea	96($inp),$inp
 	lea	96(%rsp),%r10
-
 	vzeroupper
 
-	vpbroadcastq	-96($A_flat),$A00	# load A[5][5]
-	vmovdqu		8+32*0-96($A_flat),$A01
-	vmovdqu		8+32*1-96($A_flat),$A20
-	vmovdqu		8+32*2-96($A_flat),$A31
-	vmovdqu		8+32*3-96($A_flat),$A21
-	vmovdqu		8+32*4-96($A_flat),$A41
-	vmovdqu		8+32*5-96($A_flat),$A11
-
-	vpxor		@T[0],@T[0],@T[0]
-	vmovdqa		@T[0],32*2-96(%r10)	# zero transfer area on stack
-	vmovdqa		@T[0],32*3-96(%r10)
-	vmovdqa		@T[0],32*4-96(%r10)
-	vmovdqa		@T[0],32*5-96(%r10)
-	vmovdqa		@T[0],32*6-96(%r10)
-
+@{[&load_state()]}
+@{[&zero_transfer_area()]}
 .Loop_absorb_avx2:
 	mov		$bsz,%rax
 	sub		$bsz,$len
@@ -348,45 +415,36 @@ $code.=<<___;
 	jmp	.Loop_absorb_avx2
 
 .Ldone_absorb_avx2:
-	vmovq	%xmm0,-96($A_flat)
-	vmovdqu	$A01,8+32*0-96($A_flat)
-	vmovdqu	$A20,8+32*1-96($A_flat)
-	vmovdqu	$A31,8+32*2-96($A_flat)
-	vmovdqu	$A21,8+32*3-96($A_flat)
-	vmovdqu	$A41,8+32*4-96($A_flat)
-	vmovdqu	$A11,8+32*5-96($A_flat)
-
+@{[&store_state()]}
+@{[&zero_transfer_area()]}
 	vzeroupper
 
 	lea	(%r11),%rsp
 	lea	($len,$bsz),%rax		# return value
 	ret
-.size	SHA3_absorb,.-SHA3_absorb
+.size	SHA3_absorb_avx2,.-SHA3_absorb_avx2
 
-.globl	SHA3_squeeze
-.type	SHA3_squeeze,\@function
+.globl	SHA3_squeeze_avx2
+.type	SHA3_squeeze_avx2,\@function
 .align	32
-SHA3_squeeze:
+SHA3_squeeze_avx2:
 	mov	%rsp,%r11
 
+	lea	-240(%rsp),%rsp
+	and	\$-32,%rsp
+
 	lea	96($A_flat),$A_flat
+	lea	96(%rsp),%r10
 	shr	\$3,$bsz
 
 	vzeroupper
 
-	vpbroadcastq	-96($A_flat),$A00
-	vpxor		@T[0],@T[0],@T[0]
-	vmovdqu		8+32*0-96($A_flat),$A01
-	vmovdqu		8+32*1-96($A_flat),$A20
-	vmovdqu		8+32*2-96($A_flat),$A31
-	vmovdqu		8+32*3-96($A_flat),$A21
-	vmovdqu		8+32*4-96($A_flat),$A41
-	vmovdqu		8+32*5-96($A_flat),$A11
-
 	mov	$bsz,%rax
+	test	$len,$len
+	jz	.Ldone_squeeze_avx2
 
 .Loop_squeeze_avx2:
-	mov	@A_jagged[$i]-96($A_flat),%r8
+	mov	0-96($A_flat),%r8
 ___
 for (my $i=0; $i<25; $i++) {
 $code.=<<___;
@@ -397,21 +455,18 @@ $code.=<<___;
 	je	.Ldone_squeeze_avx2
 	dec	%eax
 	je	.Lextend_output_avx2
-	mov	@A_jagged[$i+1]-120($A_flat),%r8
+___
+$code.=<<___	if ($i<24);
+	mov	8*($i+1)-96($A_flat),%r8
 ___
 }
 $code.=<<___;
 .Lextend_output_avx2:
+@{[&load_state()]}
 	call	__KeccakF1600
 
-	vmovq	%xmm0,-96($A_flat)
-	vmovdqu	$A01,8+32*0-96($A_flat)
-	vmovdqu	$A20,8+32*1-96($A_flat)
-	vmovdqu	$A31,8+32*2-96($A_flat)
-	vmovdqu	$A21,8+32*3-96($A_flat)
-	vmovdqu	$A41,8+32*4-96($A_flat)
-	vmovdqu	$A11,8+32*5-96($A_flat)
-
+	lea	96(%rsp),%r10
+@{[&store_state()]}
 	mov	$bsz,%rax
 	jmp	.Loop_squeeze_avx2
 
@@ -426,11 +481,12 @@ $code.=<<___;
 	jnz	.Loop_tail_avx2
 
 .Ldone_squeeze_avx2:
+@{[&zero_transfer_area()]}
 	vzeroupper
 
 	lea	(%r11),%rsp
 	ret
-.size	SHA3_squeeze,.-SHA3_squeeze
+.size	SHA3_squeeze_avx2,.-SHA3_squeeze_avx2
 
 .align	64
 rhotates_left:
@@ -476,6 +532,9 @@ iotas:
 .asciz	"Keccak-1600 absorb and squeeze for AVX2, CRYPTOGAMS by <appro\@openssl.org>"
 ___
 
-$output=pop and open STDOUT,">$output";
+# Nothing is emitted for Win64, where %xmm6-%xmm15 are callee-saved and
+# this module doesn't preserve them, nor if the assembler is too old.
+$code=".text\n" if ($win64 || $avx<2);
+
 print $code;
 close STDOUT or die "error closing STDOUT: $!";
@@ -1,5 +1,5 @@
 #!/usr/bin/env perl
-# Copyright 2017-2020 The OpenSSL Project Authors. All Rights Reserved.
+# Copyright 2017-2021 The OpenSSL Project Authors. All Rights Reserved.
 #
 # Licensed under the Apache License 2.0 (the "License").  You may not use
 # this file except in compliance with the License.  You can obtain a copy
@@ -49,10 +49,18 @@
 # (**)	Sandy Bridge has broken rotate instruction. Performance can be
 #	improved by 14% by replacing rotates with double-precision
 #	shift with same register as source and destination.
+#
+# When generated with the "dispatch" argument, SHA3_absorb and SHA3_squeeze
+# hand over to keccak1600-avx512.pl on processors with AVX-512F, and to
+# keccak1600-avx2.pl on Intel processors with AVX2. The AVX2 code is not
+# used elsewhere, because it is slower than this module on Ryzen. Without
+# the argument this module is self-contained, which is what the FIPS
+# provider uses.
 
 # $output is the last argument if it looks like a file (it has an extension)
 # $flavour is the first argument if it doesn't look like a file
 $output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$dispatch = $#ARGV >= 0 && $ARGV[0] eq "dispatch" ? shift : undef;
 $flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
 
 $win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
@@ -62,6 +70,17 @@ $0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
 ( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
 die "can't locate x86_64-xlate.pl";
 
+# Keep in sync with keccak1600-avx2.pl and keccak1600-avx512.pl
+$avx=0;
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx = ($1>=2.19) + ($1>=2.22) + ($1>=2.25);
+}
+if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$avx = ($2>=3.0) + ($2>3.0);
+}
+$avx=0 if ($win64 || !$dispatch);
+
 open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
     or die "can't call $xlate: $!";
 *STDOUT=*OUT;
@@ -417,6 +436,23 @@ $code.=<<___;
 .align	32
 SHA3_absorb:
 .cfi_startproc
+___
+$code.=<<___	if ($avx>1);
+	mov	OPENSSL_ia32cap_P+8(%rip),%r10d
+___
+$code.=<<___	if ($avx>2);
+	bt	\$16,%r10d		# check for AVX512F
+	jc	SHA3_absorb_avx512
+___
+$code.=<<___	if ($avx>1);
+	bt	\$5,%r10d		# check for AVX2
+	jnc	.Labsorb_scalar
+	mov	OPENSSL_ia32cap_P(%rip),%r10d
+	bt	\$30,%r10d		# check for Intel CPU
+	jc	SHA3_absorb_avx2
+.Labsorb_scalar:
+___
+$code.=<<___;
 	push	%rbx
 .cfi_push	%rbx
 	push	%rbp
@@ -512,6 +548,23 @@ $code.=<<___;
 .align	32
 SHA3_squeeze:
 .cfi_startproc
+___
+$code.=<<___	if ($avx>1);
+	mov	OPENSSL_ia32cap_P+8(%rip),%r10d
+___
+$code.=<<___	if ($avx>2);
+	bt	\$16,%r10d		# check for AVX512F
+	jc	SHA3_squeeze_avx512
+___
+$code.=<<___	if ($avx>1);
+	bt	\$5,%r10d		# check for AVX2
+	jnc	.Lsqueeze_scalar
+	mov	OPENSSL_ia32cap_P(%rip),%r10d
+	bt	\$30,%r10d		# check for Intel CPU
+	jc	SHA3_squeeze_avx2
+.Lsqueeze_scalar:
+___
+$code.=<<___;
 	push	%r12
 .cfi_push	%r12
 	push	%r13
@@ -564,6 +617,15 @@ SHA3_squeeze:
 .size	SHA3_squeeze,.-SHA3_squeeze
 ___
 }
+$code.=<<___	if ($avx>1);
+.extern	OPENSSL_ia32cap_P
+.extern	SHA3_absorb_avx2
+.extern	SHA3_squeeze_avx2
+___
+$code.=<<___	if ($avx>2);
+.extern	SHA3_absorb_avx512
+.extern	SHA3_squeeze_avx512
+___
 $code.=<<___;
 .align	256
 	.quad	0,0,0,0,0,0,0,0
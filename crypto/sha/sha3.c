@@ -1,5 +1,5 @@
 /*
- * Copyright 2017-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2017-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -8,10 +8,19 @@
  */
 
 #include <string.h>
+#include <openssl/crypto.h>
 #include "internal/sha3.h"
 
 void SHA3_squeeze(uint64_t A[5][5], unsigned char *out, size_t len, size_t r);
 
+/* The FIPS provider only uses the single state code */
+#if defined(KECCAK1600_ASM) && !defined(FIPS_MODULE) \
+    && (defined(__x86_64) || defined(_M_AMD64) || defined(_M_X64))
+# define KECCAK_MULTI_BLOCK
+int KeccakF1600_x4_eligible(void);
+void KeccakF1600_x4(uint64_t A[25][4]);
+#endif
+
 void ossl_sha3_reset(KECCAK1600_CTX *ctx)
 {
     memset(ctx->A, 0, sizeof(ctx->A));
@@ -107,3 +116,101 @@ int ossl_sha3_final(unsigned char *md, KECCAK1600_CTX *ctx)
 
     return 1;
 }
+
+#ifdef KECCAK_MULTI_BLOCK
+/*
+ * Hash groups of four messages with the 4-way permutation. The lanes are
+ * interleaved, A[w][i] being word w of the state of message i. A lane that
+ * runs out of blocks before the others is still permuted along with them,
+ * but its digest has already been taken by then.
+ */
+static void keccak_x4_digest(unsigned char pad, size_t bsz, size_t mdlen,
+                             const unsigned char *const *in,
+                             const size_t *inl, size_t num,
+                             unsigned char *out)
+{
+    unsigned char storage[sizeof(uint64_t) * 25 * 4 + 32];
+    unsigned char tail[4][KECCAK1600_WIDTH / 8];
+    uint64_t (*A)[4], w;
+    size_t blocks[4], maxblocks, n, i, j, k, b, rem;
+    const unsigned char *p;
+
+    A = (uint64_t (*)[4])(storage + 32 - ((size_t)storage % 32)); /* align */
+
+    for (; num > 0; num -= n, in += n, inl += n, out += n * mdlen) {
+        n = num < 4 ? num : 4;
+
+        memset(A, 0, sizeof(uint64_t) * 25 * 4);
+        for (maxblocks = 0, i = 0; i < n; i++) {
+            rem = inl[i] % bsz;
+            blocks[i] = inl[i] / bsz + 1;
+            if (blocks[i] > maxblocks)
+                maxblocks = blocks[i];
+
+            /* The last block with the padding */
+            memset(tail[i], 0, bsz);
+            if (rem > 0)
+                memcpy(tail[i], in[i] + inl[i] - rem, rem);
+            tail[i][rem] = pad;
+            tail[i][bsz - 1] |= 0x80;
+        }
+
+        for (b = 0; b < maxblocks; b++) {
+            for (i = 0; i < n; i++) {
+                if (b >= blocks[i])
+                    continue;
+                p = b + 1 < blocks[i] ? in[i] + b * bsz : tail[i];
+                /* x86_64 is little endian, so the bytes can be used as is */
+                for (j = 0; j < bsz / 8; j++) {
+                    memcpy(&w, p + 8 * j, 8);
+                    A[j][i] ^= w;
+                }
+            }
+            KeccakF1600_x4(A);
+            for (i = 0; i < n; i++) {
+                if (b + 1 != blocks[i])
+                    continue;
+                for (k = 0; k < mdlen; k++)
+                    out[i * mdlen + k] =
+                        (unsigned char)(A[k / 8][i] >> (8 * (k % 8)));
+            }
+        }
+    }
+
+    OPENSSL_cleanse(tail, sizeof(tail));
+    OPENSSL_cleanse(storage, sizeof(storage));
+}
+#endif
+
+/*
+ * Hash the |num| messages in[i] of inl[i] bytes each with the Keccak
+ * parameters |pad| and |bitlen| as for ossl_sha3_init(), and store the
+ * |mdlen| byte digests one after the other in |out|. |mdlen| may not exceed
+ * the block size.
+ */
+int ossl_sha3_digest_many(unsigned char pad, size_t bitlen, size_t mdlen,
+                          const unsigned char *const *in, const size_t *inl,
+                          size_t num, unsigned char *out)
+{
+    KECCAK1600_CTX c;
+    size_t i = 0;
+    int ret;
+
+    if (!ossl_sha3_init(&c, pad, bitlen) || mdlen > c.block_size)
+        return 0;
+    c.md_size = mdlen;
+
+#ifdef KECCAK_MULTI_BLOCK
+    if (num > 1 && KeccakF1600_x4_eligible()) {
+        keccak_x4_digest(pad, c.block_size, mdlen, in, inl, num, out);
+        return 1;
+    }
+#endif
+    for (ret = 1; ret && i < num; i++) {
+        ossl_sha3_reset(&c);
+        ret = ossl_sha3_update(&c, in[i], inl[i])
+              && ossl_sha3_final(out + i * mdlen, &c);
+    }
+    OPENSSL_cleanse(&c, sizeof(c));
+    return ret;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * SHA low level APIs are deprecated for public use, but still ok for
+ * internal use.
+ */
+#include "internal/deprecated.h"
+
+#include <string.h>
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+#include "internal/cryptlib.h"
+#include "crypto/sha.h"
+
+/*
+ * Hashing of many independent messages at once. On x86_64 this uses the
+ * multi-block routines from sha1-mb-x86_64.pl and sha256-mb-x86_64.pl that
+ * hash 4 (SSE, AVX) or 8 (AVX2) messages in the lanes of a vector register.
+ * Even their most basic code path needs SSSE3. Elsewhere, and always in the
+ * FIPS provider, the messages are simply hashed one after the other.
+ */
+
+#if defined(SHA1_ASM) && defined(SHA256_ASM) && !defined(FIPS_MODULE) \
+    && (defined(__x86_64) || defined(_M_AMD64) || defined(_M_X64))
+# define SHA_MULTI_BLOCK
+#endif
+
+#ifdef SHA_MULTI_BLOCK
+
+# define SHA_MB_LANES           8
+/* HASH_DESC counts blocks in an int, so feed long messages in pieces */
+# define SHA_MB_MAX_BLOCKS      (1 << 20)
+
+typedef struct {
+    const unsigned char *ptr;
+    int blocks;
+} HASH_DESC;
+
+/*
+ * The chaining values are kept transposed: h[i][lane] is word i of the
+ * state of the given lane. SHA-1 only uses the first five rows.
+ */
+typedef struct {
+    unsigned int h[8][SHA_MB_LANES];
+} SHA_MB_CTX;
+
+void sha1_multi_block(SHA_MB_CTX *, const HASH_DESC *, int);
+void sha256_multi_block(SHA_MB_CTX *, const HASH_DESC *, int);
+
+typedef void (*sha_mb_block_fn)(SHA_MB_CTX *, const HASH_DESC *, int);
+
+# define SHA_MB_CAPABLE (OPENSSL_ia32cap_P[1] & (1 << (41 - 32))) /* SSSE3 */
+
+/*
+ * The assembly processes the lanes in groups (of 2 or 4 depending on the
+ * code path) and stops at the first group in which no lane has any blocks
+ * left. The lanes are therefore filled in order of descending length, which
+ * guarantees that empty groups only ever appear at the end.
+ */
+static void sha_mb_digest(sha_mb_block_fn block, const unsigned int *iv,
+                          size_t words, const unsigned char *const *in,
+                          const size_t *inl, size_t num, unsigned char *out)
+{
+    unsigned char storage[sizeof(SHA_MB_CTX) + 32];
+    unsigned char tail[SHA_MB_LANES][2 * 64];
+    SHA_MB_CTX *mctx;
+    HASH_DESC desc[SHA_MB_LANES];
+    size_t idx[SHA_MB_LANES], left[SHA_MB_LANES];
+    size_t mdlen = words * 4;
+    size_t n, i, j, k, len, rem, blocks;
+    uint64_t bits;
+    unsigned char *md;
+
+    mctx = (SHA_MB_CTX *)(storage + 32 - ((size_t)storage % 32)); /* align */
+
+    for (; num > 0; num -= n, in += n, inl += n, out += n * mdlen) {
+        n = num < SHA_MB_LANES ? num : SHA_MB_LANES;
+
+        for (i = 0; i < n; i++) {
+            for (j = i; j > 0 && inl[idx[j - 1]] < inl[i]; j--)
+                idx[j] = idx[j - 1];
+            idx[j] = i;
+        }
+        for (i = 0; i < SHA_MB_LANES; i++) {
+            for (k = 0; k < words; k++)
+                mctx->h[k][i] = iv[k];
+            desc[i].ptr = i < n ? in[idx[i]] : NULL;
+            desc[i].blocks = 0;
+            left[i] = i < n ? inl[idx[i]] / 64 : 0;
+        }
+
+        /* All complete blocks, lane 0 always has the most of them */
+        while (left[0] > 0) {
+            for (i = 0; i < n; i++) {
+                blocks = left[i] < SHA_MB_MAX_BLOCKS ? left[i]
+                                                     : SHA_MB_MAX_BLOCKS;
+                desc[i].blocks = (int)blocks;
+            }
+            block(mctx, desc, (int)(n + 3) / 4);
+            for (i = 0; i < n; i++) {
+                desc[i].ptr += (size_t)desc[i].blocks * 64;
+                left[i] -= desc[i].blocks;
+            }
+        }
+
+        /* The remaining bytes and the padding, one or two blocks per lane */
+        for (i = 0; i < n; i++) {
+            len = inl[idx[i]];
+            rem = len % 64;
+            blocks = rem < 56 ? 1 : 2;
+            memset(tail[i], 0, blocks * 64);
+            if (rem > 0)
+                memcpy(tail[i], desc[i].ptr, rem);
+            tail[i][rem] = 0x80;
+            bits = (uint64_t)len << 3;
+            for (k = 0; k < 8; k++)
+                tail[i][blocks * 64 - 1 - k] = (unsigned char)(bits >> (8 * k));
+            desc[i].ptr = tail[i];
+            desc[i].blocks = (int)blocks;
+        }
+        block(mctx, desc, (int)(n + 3) / 4);
+
+        for (i = 0; i < n; i++) {
+            md = out + idx[i] * mdlen;
+            for (k = 0; k < words; k++) {
+                md[4 * k] = (unsigned char)(mctx->h[k][i] >> 24);
+                md[4 * k + 1] = (unsigned char)(mctx->h[k][i] >> 16);
+                md[4 * k + 2] = (unsigned char)(mctx->h[k][i] >> 8);
+                md[4 * k + 3] = (unsigned char)mctx->h[k][i];
+            }
+        }
+    }
+
+    OPENSSL_cleanse(tail, sizeof(tail));
+    OPENSSL_cleanse(storage, sizeof(storage));
+}
+
+static const unsigned int sha1_iv[5] = {
+    0x67452301U, 0xefcdab89U, 0x98badcfeU, 0x10325476U, 0xc3d2e1f0U
+};
+
+static const unsigned int sha256_iv[8] = {
+    0x6a09e667U, 0xbb67ae85U, 0x3c6ef372U, 0xa54ff53aU,
+    0x510e527fU, 0x9b05688cU, 0x1f83d9abU, 0x5be0cd19U
+};
+
+#endif /* SHA_MULTI_BLOCK */
+
+/*
+ * Hash the |num| messages in[i] of inl[i] bytes each and store the digests
+ * one after the other in |out|, which must hold num * SHA_DIGEST_LENGTH
+ * bytes.
+ */
+int ossl_sha1_digest_many(const unsigned char *const *in, const size_t *inl,
+                          size_t num, unsigned char *out)
+{
+    SHA_CTX c;
+    size_t i = 0;
+    int ret = 1;
+
+#ifdef SHA_MULTI_BLOCK
+    /* A single message is faster with the one lane code */
+    if (num > 1 && SHA_MB_CAPABLE) {
+        sha_mb_digest(sha1_multi_block, sha1_iv, 5, in, inl, num, out);
+        return 1;
+    }
+#endif
+    for (; ret && i < num; i++)
+        ret = SHA1_Init(&c)
+              && SHA1_Update(&c, in[i], inl[i])
+              && SHA1_Final(out + i * SHA_DIGEST_LENGTH, &c);
+    OPENSSL_cleanse(&c, sizeof(c));
+    return ret;
+}
+
+/* As ossl_sha1_digest_many() with SHA256_DIGEST_LENGTH bytes per digest */
+int ossl_sha256_digest_many(const unsigned char *const *in, const size_t *inl,
+                            size_t num, unsigned char *out)
+{
+    SHA256_CTX c;
+    size_t i = 0;
+    int ret = 1;
+
+#ifdef SHA_MULTI_BLOCK
+    if (num > 1 && SHA_MB_CAPABLE) {
+        sha_mb_digest(sha256_multi_block, sha256_iv, 8, in, inl, num, out);
+        return 1;
+    }
+#endif
+    for (; ret && i < num; i++)
+        ret = SHA256_Init(&c)
+              && SHA256_Update(&c, in[i], inl[i])
+              && SHA256_Final(out + i * SHA256_DIGEST_LENGTH, &c);
+    OPENSSL_cleanse(&c, sizeof(c));
+    return ret;
+}
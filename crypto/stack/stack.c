@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include "internal/cryptlib.h"
 #include "internal/numbers.h"
+#include "crypto/cryptlib.h"
 #include <openssl/stack.h>
 #include <errno.h>
 #include <openssl/e_os2.h>      /* For ossl_inline */
@@ -28,6 +29,7 @@ struct stack_st {
     int sorted;
     int num_alloc;
     OPENSSL_sk_compfunc comp;
+    uint64_t generation;        /* Bumped by every change to the elements */
 };
 
 OPENSSL_sk_compfunc OPENSSL_sk_set_cmp_func(OPENSSL_STACK *sk, OPENSSL_sk_compfunc c)
@@ -52,6 +54,7 @@ OPENSSL_STACK *OPENSSL_sk_dup(const OPENSSL_STACK *sk)
         ret->num = 0;
         ret->sorted = 0;
         ret->comp = NULL;
+        ret->generation = 0;
     } else {
         /* direct structure assignment */
         *ret = *sk;
@@ -90,6 +93,7 @@ OPENSSL_STACK *OPENSSL_sk_deep_copy(const OPENSSL_STACK *sk,
         ret->num = 0;
         ret->sorted = 0;
         ret->comp = NULL;
+        ret->generation = 0;
     } else {
         /* direct structure assignment */
         *ret = *sk;
@@ -263,6 +267,7 @@ int OPENSSL_sk_insert(OPENSSL_STACK *st, const void *data, int loc)
     }
     st->num++;
     st->sorted = 0;
+    st->generation++;
     return st->num;
 }
 
@@ -274,6 +279,7 @@ static ossl_inline void *internal_delete(OPENSSL_STACK *st, int loc)
          memmove(&st->data[loc], &st->data[loc + 1],
                  sizeof(st->data[0]) * (st->num - loc - 1));
     st->num--;
+    st->generation++;
 
     return (void *)ret;
 }
@@ -367,6 +373,7 @@ void OPENSSL_sk_zero(OPENSSL_STACK *st)
         return;
     memset(st->data, 0, sizeof(*st->data) * st->num);
     st->num = 0;
+    st->generation++;
 }
 
 void OPENSSL_sk_pop_free(OPENSSL_STACK *st, OPENSSL_sk_freefunc func)
@@ -407,6 +414,7 @@ void *OPENSSL_sk_set(OPENSSL_STACK *st, int i, const void *data)
         return NULL;
     st->data[i] = data;
     st->sorted = 0;
+    st->generation++;
     return (void *)st->data[i];
 }
 
@@ -423,3 +431,12 @@ int OPENSSL_sk_is_sorted(const OPENSSL_STACK *st)
 {
     return st == NULL ? 1 : st->sorted;
 }
+
+/*
+ * A value that changes whenever an element is added to, removed from or
+ * replaced in |st|. Sorting leaves it alone.
+ */
+uint64_t ossl_sk_generation(const OPENSSL_STACK *st)
+{
+    return st == NULL ? 0 : st->generation;
+}
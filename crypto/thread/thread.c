@@ -0,0 +1,514 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#if defined(_WIN32)
+# include <windows.h>
+#endif
+
+#include <openssl/crypto.h>
+#include "internal/cryptlib.h"
+#include "internal/thread.h"
+
+#if defined(OPENSSL_THREADS) && !defined(CRYPTO_TDEBUG)
+# if defined(OPENSSL_SYS_WINDOWS)
+/* Condition variables need Windows Vista or later */
+#  if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0600
+#   define THREAD_WINDOWS
+#  endif
+# else
+#  include <pthread.h>
+#  define THREAD_POSIX
+# endif
+#endif
+
+/*
+ * A piece of work handed to the pool, returned to the caller as a handle to
+ * wait for.
+ */
+struct ossl_crypto_thread_st {
+    struct thread_pool_st *pool;
+    OSSL_CRYPTO_THREAD_ROUTINE *routine;
+    void *data;
+    int done;
+    struct ossl_crypto_thread_st *next;     /* on the queue */
+};
+
+typedef struct worker_st WORKER;
+
+#if defined(THREAD_POSIX)
+typedef pthread_mutex_t POOL_MUTEX;
+typedef pthread_cond_t POOL_COND;
+typedef pthread_t WORKER_HANDLE;
+#elif defined(THREAD_WINDOWS)
+typedef CRITICAL_SECTION POOL_MUTEX;
+typedef CONDITION_VARIABLE POOL_COND;
+typedef HANDLE WORKER_HANDLE;
+#else
+typedef int POOL_MUTEX;
+typedef int POOL_COND;
+typedef int WORKER_HANDLE;
+#endif
+
+struct worker_st {
+    WORKER_HANDLE handle;
+    struct thread_pool_st *pool;
+    int exited;                     /* only needs joining */
+    WORKER *next;
+};
+
+/*
+ * Worker threads are started when work is handed to the pool and no idle
+ * worker is waiting for it. They then stay around for further work until
+ * there are more of them than max_threads, or the library context is freed.
+ *
+ * |active| counts the work that has been started and not yet waited for. It
+ * never exceeds max_threads, so all queued work is picked up without waiting
+ * for other queued work to finish.
+ */
+typedef struct thread_pool_st {
+    POOL_MUTEX mutex;
+    POOL_COND work_cond;            /* signalled when work is queued */
+    POOL_COND done_cond;            /* broadcast when work is done */
+    int fork_id;
+    int shutdown;
+    uint64_t max_threads;
+    uint64_t active;
+    size_t workers_num;             /* workers that have not exited */
+    size_t idle;                    /* workers waiting for work */
+    size_t queued;
+    OSSL_CRYPTO_THREAD *queue_head, *queue_tail;
+    WORKER *workers;
+} THREAD_POOL;
+
+#if defined(THREAD_POSIX)
+static int pool_mutex_init(THREAD_POOL *pool)
+{
+    if (pthread_mutex_init(&pool->mutex, NULL) != 0)
+        return 0;
+    if (pthread_cond_init(&pool->work_cond, NULL) != 0) {
+        pthread_mutex_destroy(&pool->mutex);
+        return 0;
+    }
+    if (pthread_cond_init(&pool->done_cond, NULL) != 0) {
+        pthread_cond_destroy(&pool->work_cond);
+        pthread_mutex_destroy(&pool->mutex);
+        return 0;
+    }
+    return 1;
+}
+
+static void pool_mutex_destroy(THREAD_POOL *pool)
+{
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+}
+
+static void pool_lock(THREAD_POOL *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+}
+
+static void pool_unlock(THREAD_POOL *pool)
+{
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void pool_wait(THREAD_POOL *pool, POOL_COND *cond)
+{
+    pthread_cond_wait(cond, &pool->mutex);
+}
+
+static void pool_signal(POOL_COND *cond)
+{
+    pthread_cond_signal(cond);
+}
+
+static void pool_broadcast(POOL_COND *cond)
+{
+    pthread_cond_broadcast(cond);
+}
+#elif defined(THREAD_WINDOWS)
+static int pool_mutex_init(THREAD_POOL *pool)
+{
+    InitializeCriticalSection(&pool->mutex);
+    InitializeConditionVariable(&pool->work_cond);
+    InitializeConditionVariable(&pool->done_cond);
+    return 1;
+}
+
+static void pool_mutex_destroy(THREAD_POOL *pool)
+{
+    DeleteCriticalSection(&pool->mutex);
+}
+
+static void pool_lock(THREAD_POOL *pool)
+{
+    EnterCriticalSection(&pool->mutex);
+}
+
+static void pool_unlock(THREAD_POOL *pool)
+{
+    LeaveCriticalSection(&pool->mutex);
+}
+
+static void pool_wait(THREAD_POOL *pool, POOL_COND *cond)
+{
+    SleepConditionVariableCS(cond, &pool->mutex, INFINITE);
+}
+
+static void pool_signal(POOL_COND *cond)
+{
+    WakeConditionVariable(cond);
+}
+
+static void pool_broadcast(POOL_COND *cond)
+{
+    WakeAllConditionVariable(cond);
+}
+#else
+static int pool_mutex_init(THREAD_POOL *pool)
+{
+    return 1;
+}
+
+static void pool_mutex_destroy(THREAD_POOL *pool)
+{
+}
+
+static void pool_lock(THREAD_POOL *pool)
+{
+}
+
+static void pool_unlock(THREAD_POOL *pool)
+{
+}
+
+static void pool_wait(THREAD_POOL *pool, POOL_COND *cond)
+{
+}
+
+static void pool_signal(POOL_COND *cond)
+{
+}
+
+static void pool_broadcast(POOL_COND *cond)
+{
+}
+#endif
+
+/* The main loop of a worker thread */
+static void worker_run(WORKER *worker)
+{
+    THREAD_POOL *pool = worker->pool;
+    OSSL_CRYPTO_THREAD *thread;
+
+    pool_lock(pool);
+    for (;;) {
+        while (pool->queue_head == NULL) {
+            if (pool->shutdown || pool->workers_num > pool->max_threads) {
+                pool->workers_num--;
+                worker->exited = 1;
+                pool_unlock(pool);
+                return;
+            }
+            pool->idle++;
+            pool_wait(pool, &pool->work_cond);
+            pool->idle--;
+        }
+
+        thread = pool->queue_head;
+        pool->queue_head = thread->next;
+        if (pool->queue_head == NULL)
+            pool->queue_tail = NULL;
+        pool->queued--;
+        pool_unlock(pool);
+
+        thread->routine(thread->data);
+
+        pool_lock(pool);
+        thread->done = 1;
+        pool_broadcast(&pool->done_cond);
+    }
+}
+
+#if defined(THREAD_POSIX)
+static void *worker_start_posix(void *arg)
+{
+    worker_run(arg);
+    return NULL;
+}
+
+static int worker_create(WORKER *worker)
+{
+    return pthread_create(&worker->handle, NULL, worker_start_posix,
+                          worker) == 0;
+}
+
+static void worker_join(WORKER *worker)
+{
+    pthread_join(worker->handle, NULL);
+}
+#elif defined(THREAD_WINDOWS)
+static DWORD WINAPI worker_start_win(LPVOID arg)
+{
+    worker_run(arg);
+    return 0;
+}
+
+static int worker_create(WORKER *worker)
+{
+    worker->handle = CreateThread(NULL, 0, worker_start_win, worker, 0, NULL);
+    return worker->handle != NULL;
+}
+
+static void worker_join(WORKER *worker)
+{
+    WaitForSingleObject(worker->handle, INFINITE);
+    CloseHandle(worker->handle);
+}
+#else
+static int worker_create(WORKER *worker)
+{
+    return 0;
+}
+
+static void worker_join(WORKER *worker)
+{
+}
+#endif
+
+/*
+ * Unlink the workers that have exited, or all of them if |all| is set, from
+ * |pool| so that they can be joined with the pool unlocked.
+ */
+static WORKER *pool_take_workers(THREAD_POOL *pool, int all)
+{
+    WORKER **pw = &pool->workers, *w, *ret = NULL;
+
+    while ((w = *pw) != NULL) {
+        if (all || w->exited) {
+            *pw = w->next;
+            w->next = ret;
+            ret = w;
+        } else {
+            pw = &w->next;
+        }
+    }
+    return ret;
+}
+
+static void workers_join(WORKER *w)
+{
+    WORKER *next;
+
+    for (; w != NULL; w = next) {
+        next = w->next;
+        worker_join(w);
+        OPENSSL_free(w);
+    }
+}
+
+/*
+ * The workers of the parent process do not exist in a forked child, forget
+ * about them and any work they had. Called with the pool locked.
+ */
+static void pool_check_fork(THREAD_POOL *pool)
+{
+    WORKER *w, *next;
+    int fork_id = openssl_get_fork_id();
+
+    if (pool->fork_id == fork_id)
+        return;
+    for (w = pool->workers; w != NULL; w = next) {
+        next = w->next;
+        OPENSSL_free(w);
+    }
+    pool->workers = NULL;
+    pool->workers_num = pool->idle = pool->queued = 0;
+    pool->queue_head = pool->queue_tail = NULL;
+    pool->active = 0;
+    pool->fork_id = fork_id;
+}
+
+static void *thread_pool_new(OSSL_LIB_CTX *ctx)
+{
+    THREAD_POOL *pool = OPENSSL_zalloc(sizeof(*pool));
+
+    if (pool == NULL)
+        return NULL;
+    if (!pool_mutex_init(pool)) {
+        OPENSSL_free(pool);
+        return NULL;
+    }
+    pool->fork_id = openssl_get_fork_id();
+    return pool;
+}
+
+static void thread_pool_free(void *vpool)
+{
+    THREAD_POOL *pool = vpool;
+    WORKER *workers;
+
+    if (pool == NULL)
+        return;
+    pool_lock(pool);
+    pool_check_fork(pool);
+    pool->shutdown = 1;
+    pool_broadcast(&pool->work_cond);
+    workers = pool_take_workers(pool, 1);
+    pool_unlock(pool);
+    workers_join(workers);
+    pool_mutex_destroy(pool);
+    OPENSSL_free(pool);
+}
+
+static const OSSL_LIB_CTX_METHOD thread_pool_method = {
+    thread_pool_new,
+    thread_pool_free,
+};
+
+static THREAD_POOL *get_thread_pool(OSSL_LIB_CTX *ctx)
+{
+    return ossl_lib_ctx_get_data(ctx, OSSL_LIB_CTX_THREAD_INDEX,
+                                 &thread_pool_method);
+}
+
+int OSSL_set_max_threads(OSSL_LIB_CTX *ctx, uint64_t max_threads)
+{
+    THREAD_POOL *pool;
+    WORKER *exited;
+
+#if !defined(THREAD_POSIX) && !defined(THREAD_WINDOWS)
+    if (max_threads != 0)
+        return 0;
+#endif
+    if ((pool = get_thread_pool(ctx)) == NULL)
+        return 0;
+    pool_lock(pool);
+    pool_check_fork(pool);
+    pool->max_threads = max_threads;
+    /* Let surplus idle workers exit */
+    if (pool->workers_num > max_threads)
+        pool_broadcast(&pool->work_cond);
+    exited = pool_take_workers(pool, 0);
+    pool_unlock(pool);
+    workers_join(exited);
+    return 1;
+}
+
+uint64_t OSSL_get_max_threads(OSSL_LIB_CTX *ctx)
+{
+    THREAD_POOL *pool;
+    uint64_t ret;
+
+    if ((pool = get_thread_pool(ctx)) == NULL)
+        return 0;
+    pool_lock(pool);
+    ret = pool->max_threads;
+    pool_unlock(pool);
+    return ret;
+}
+
+/*
+ * The number of pieces of work that could be started right now. This is only
+ * a hint for how to split up work, ossl_crypto_thread_start() may still fail.
+ */
+uint64_t ossl_get_avail_threads(OSSL_LIB_CTX *ctx)
+{
+    THREAD_POOL *pool;
+    uint64_t ret = 0;
+
+    if ((pool = get_thread_pool(ctx)) == NULL)
+        return 0;
+    pool_lock(pool);
+    pool_check_fork(pool);
+    if (pool->active < pool->max_threads)
+        ret = pool->max_threads - pool->active;
+    pool_unlock(pool);
+    return ret;
+}
+
+/*
+ * Run |routine| with |data| on a worker thread of the pool of |ctx| if its
+ * limit allows it. Returns NULL if no thread is available, the caller should
+ * then call |routine| itself. Every piece of work started must be waited for
+ * with ossl_crypto_thread_join() before |ctx| is freed.
+ */
+OSSL_CRYPTO_THREAD *ossl_crypto_thread_start(OSSL_LIB_CTX *ctx,
+                                             OSSL_CRYPTO_THREAD_ROUTINE *routine,
+                                             void *data)
+{
+    THREAD_POOL *pool;
+    OSSL_CRYPTO_THREAD *thread;
+    WORKER *worker = NULL, *exited;
+
+    if ((pool = get_thread_pool(ctx)) == NULL)
+        return NULL;
+    if ((thread = OPENSSL_zalloc(sizeof(*thread))) == NULL)
+        return NULL;
+    thread->pool = pool;
+    thread->routine = routine;
+    thread->data = data;
+
+    pool_lock(pool);
+    pool_check_fork(pool);
+    if (pool->active >= pool->max_threads)
+        goto err;
+
+    if (pool->queued >= pool->idle) {
+        /* Every idle worker already has work waiting, start another one */
+        if ((worker = OPENSSL_zalloc(sizeof(*worker))) == NULL)
+            goto err;
+        worker->pool = pool;
+        if (!worker_create(worker))
+            goto err;
+        worker->next = pool->workers;
+        pool->workers = worker;
+        pool->workers_num++;
+    } else {
+        pool_signal(&pool->work_cond);
+    }
+
+    if (pool->queue_tail != NULL)
+        pool->queue_tail->next = thread;
+    else
+        pool->queue_head = thread;
+    pool->queue_tail = thread;
+    pool->queued++;
+    pool->active++;
+    exited = pool_take_workers(pool, 0);
+    pool_unlock(pool);
+    workers_join(exited);
+    return thread;
+
+ err:
+    pool_unlock(pool);
+    OPENSSL_free(worker);
+    OPENSSL_free(thread);
+    return NULL;
+}
+
+/* Wait for the work |thread| was started with to finish and free it */
+int ossl_crypto_thread_join(OSSL_CRYPTO_THREAD *thread)
+{
+    THREAD_POOL *pool;
+
+    if (thread == NULL)
+        return 0;
+    pool = thread->pool;
+    pool_lock(pool);
+    while (!thread->done)
+        pool_wait(pool, &pool->done_cond);
+    if (pool->active > 0)
+        pool->active--;
+    pool_unlock(pool);
+    OPENSSL_free(thread);
+    return 1;
+}
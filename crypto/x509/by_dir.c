@@ -219,29 +219,19 @@ static int get_cert_by_subject_ex(X509_LOOKUP *xl, X509_LOOKUP_TYPE type,
                                   OSSL_LIB_CTX *libctx, const char *propq)
 {
     BY_DIR *ctx;
-    union {
-        X509 st_x509;
-        X509_CRL crl;
-    } data;
     int ok = 0;
     int i, j, k;
     unsigned long h;
     BUF_MEM *b = NULL;
-    X509_OBJECT stmp, *tmp;
+    X509_OBJECT *tmp;
     const char *postfix = "";
 
     if (name == NULL)
         return 0;
 
-    stmp.type = type;
-    if (type == X509_LU_X509) {
-        data.st_x509.cert_info.subject = (X509_NAME *)name; /* won't modify it */
-        stmp.data.x509 = &data.st_x509;
-    } else if (type == X509_LU_CRL) {
-        data.crl.crl.issuer = (X509_NAME *)name; /* won't modify it */
-        stmp.data.crl = &data.crl;
+    if (type == X509_LU_CRL) {
         postfix = "r";
-    } else {
+    } else if (type != X509_LU_X509) {
         ERR_raise(ERR_LIB_X509, X509_R_WRONG_LOOKUP_TYPE);
         goto finish;
     }
@@ -338,10 +328,7 @@ static int get_cert_by_subject_ex(X509_LOOKUP *xl, X509_LOOKUP_TYPE type,
         /*
          * we have added it to the cache so now pull it out again
          */
-        X509_STORE_lock(xl->store_ctx);
-        j = sk_X509_OBJECT_find(xl->store_ctx->objs, &stmp);
-        tmp = sk_X509_OBJECT_value(xl->store_ctx->objs, j);
-        X509_STORE_unlock(xl->store_ctx);
+        tmp = x509_store_get0_object(xl->store_ctx, type, name);
 
         /* If a CRL, update the last file suffix added for this */
 
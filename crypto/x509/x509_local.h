@@ -8,6 +8,7 @@
  */
 
 #include "internal/refcount.h"
+#include "internal/tsan_assist.h"
 
 #define X509V3_conf_add_error_name_value(val) \
     ERR_add_error_data(4, "name=", (val)->name, ", value=", (val)->value)
@@ -106,6 +107,23 @@ struct x509_lookup_st {
     X509_STORE *store_ctx;      /* who owns us */
 };
 
+/*
+ * All the objects in a store of one type that share a name: the subject name
+ * of certificates or the issuer name of CRLs.
+ */
+typedef struct x509_object_pile_st X509_OBJECT_PILE;
+
+DEFINE_LHASH_OF(X509_OBJECT_PILE);
+
+/*
+ * A certificate signature that has been verified successfully, identified by
+ * a digest of the certificate and of the public key it was verified with.
+ */
+typedef struct x509_sig_cache_entry_st {
+    unsigned char key[SHA256_DIGEST_LENGTH];
+    time_t added;               /* 0 if the entry is unused */
+} X509_SIG_CACHE_ENTRY;
+
 /*
  * This is used to hold everything.  It is used for all certificate
  * validation.  Once we have a certificate chain, the 'verify' function is
@@ -115,6 +133,9 @@ struct x509_store_st {
     /* The following is a cache of trusted certs */
     int cache;                  /* if true, stash any hits */
     STACK_OF(X509_OBJECT) *objs; /* Cache of all objects */
+    LHASH_OF(X509_OBJECT_PILE) *piles; /* |objs| indexed by name */
+    uint64_t objs_gen;          /* Generation of |objs| indexed in |piles| */
+    int objs_indexed;           /* Set once |piles| matches |objs_gen| */
     /* These are external lookup methods */
     STACK_OF(X509_LOOKUP) *get_cert_methods;
     X509_VERIFY_PARAM *param;
@@ -146,6 +167,12 @@ struct x509_store_st {
     CRYPTO_EX_DATA ex_data;
     CRYPTO_REF_COUNT references;
     CRYPTO_RWLOCK *lock;
+    /* Direct mapped cache of verified signatures, disabled by default */
+    X509_SIG_CACHE_ENTRY *sig_cache;
+    size_t sig_cache_size;
+    long sig_cache_timeout;
+    /* Read without the lock to skip the cache quickly when it is off */
+    TSAN_QUALIFIER int sig_cache_on;
 };
 
 typedef struct lookup_dir_hashes_st BY_DIR_HASH;
@@ -157,5 +184,10 @@ DEFINE_STACK_OF(STACK_OF_X509_NAME_ENTRY)
 
 void x509_set_signature_info(X509_SIG_INFO *siginf, const X509_ALGOR *alg,
                              const ASN1_STRING *sig);
+X509_OBJECT *x509_store_get0_object(X509_STORE *store, X509_LOOKUP_TYPE type,
+                                    const X509_NAME *name);
+int x509_store_has_sig_cache(X509_STORE *store);
+int x509_store_sig_cached(X509_STORE *store, const unsigned char *key);
+void x509_store_sig_cache_add(X509_STORE *store, const unsigned char *key);
 int x509_likely_issued(X509 *issuer, X509 *subject);
 int x509_signing_allowed(const X509 *issuer, const X509 *subject);
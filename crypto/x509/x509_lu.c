@@ -11,6 +11,7 @@
 #include "internal/cryptlib.h"
 #include "internal/refcount.h"
 #include <openssl/x509.h>
+#include "crypto/cryptlib.h"
 #include "crypto/x509.h"
 #include <openssl/x509v3.h>
 #include "x509_local.h"
@@ -177,6 +178,231 @@ static int x509_object_cmp(const X509_OBJECT *const *a,
     return ret;
 }
 
+struct x509_object_pile_st {
+    X509_LOOKUP_TYPE type;
+    /*
+     * Only set in lookup templates, a pile in the index uses the name of
+     * its first object, which cannot go away while the object is there.
+     */
+    const X509_NAME *name;
+    unsigned long hash;
+    STACK_OF(X509_OBJECT) *objs; /* Not owned, |objs| of the store is */
+};
+
+/*
+ * Make sure that the canonical encoding of |name| is up to date, after which
+ * X509_NAME_cmp() and x509_name_canon_hash() only read |name|. The names of
+ * the objects in a store are brought up to date when the objects are indexed,
+ * under the write lock, so that lookups can compare them under the read lock.
+ */
+static int x509_name_canon_update(const X509_NAME *name)
+{
+    if (name->canon_enc == NULL || name->modified)
+        return i2d_X509_NAME((X509_NAME *)name, NULL) >= 0;
+    return 1;
+}
+
+/*
+ * Hash of the canonical encoding of |name|, which is what X509_NAME_cmp()
+ * compares, so equal names end up in the same bucket. The encoding must be
+ * up to date.
+ */
+static unsigned long x509_name_canon_hash(const X509_NAME *name)
+{
+    unsigned long h = 0;
+    int i;
+
+    for (i = 0; i < name->canon_enclen; i++)
+        h = (h * 31) ^ name->canon_enc[i];
+    return h;
+}
+
+static const X509_NAME *x509_object_get0_name(const X509_OBJECT *obj)
+{
+    switch (obj->type) {
+    case X509_LU_X509:
+        return X509_get_subject_name(obj->data.x509);
+    case X509_LU_CRL:
+        return X509_CRL_get_issuer(obj->data.crl);
+    default:
+        return NULL;
+    }
+}
+
+/* Bring the canonical encodings of all the names in |obj| up to date */
+static int x509_object_canon_update(const X509_OBJECT *obj)
+{
+    const X509_NAME *name = x509_object_get0_name(obj);
+
+    if (name == NULL || !x509_name_canon_update(name))
+        return 0;
+    /* The issuer name of a certificate is used to look up its issuer */
+    return obj->type != X509_LU_X509
+           || x509_name_canon_update(X509_get_issuer_name(obj->data.x509));
+}
+
+static const X509_NAME *x509_object_pile_name(const X509_OBJECT_PILE *a)
+{
+    if (a->name != NULL)
+        return a->name;
+    return x509_object_get0_name(sk_X509_OBJECT_value(a->objs, 0));
+}
+
+static unsigned long x509_object_pile_hash(const X509_OBJECT_PILE *a)
+{
+    return a->hash ^ (unsigned long)a->type;
+}
+
+static int x509_object_pile_cmp(const X509_OBJECT_PILE *a,
+                                const X509_OBJECT_PILE *b)
+{
+    if (a->type != b->type)
+        return a->type - b->type;
+    return X509_NAME_cmp(x509_object_pile_name(a), x509_object_pile_name(b));
+}
+
+static void x509_object_pile_free(X509_OBJECT_PILE *pile)
+{
+    sk_X509_OBJECT_free(pile->objs);
+    OPENSSL_free(pile);
+}
+
+/*
+ * The caller must hold at least a read lock on |store|, and the canonical
+ * encoding of |name| must be up to date.
+ */
+static X509_OBJECT_PILE *x509_store_get_pile(X509_STORE *store,
+                                             X509_LOOKUP_TYPE type,
+                                             const X509_NAME *name)
+{
+    X509_OBJECT_PILE tmpl;
+
+    if (name == NULL)
+        return NULL;
+    tmpl.type = type;
+    tmpl.name = name;
+    tmpl.objs = NULL;
+    tmpl.hash = x509_name_canon_hash(name);
+    return lh_X509_OBJECT_PILE_retrieve(store->piles, &tmpl);
+}
+
+/*
+ * Add |obj| to the pile of objects with its name, without checking whether
+ * it is there already. The caller must hold the write lock on |store|.
+ */
+static int x509_store_index_object(X509_STORE *store, X509_OBJECT *obj)
+{
+    X509_OBJECT_PILE *pile;
+    const X509_NAME *name = x509_object_get0_name(obj);
+
+    if (!x509_object_canon_update(obj))
+        return 0;
+    pile = x509_store_get_pile(store, obj->type, name);
+    if (pile != NULL)
+        return sk_X509_OBJECT_push(pile->objs, obj) != 0;
+
+    if ((pile = OPENSSL_zalloc(sizeof(*pile))) == NULL
+            || (pile->objs = sk_X509_OBJECT_new_null()) == NULL) {
+        OPENSSL_free(pile);
+        return 0;
+    }
+    pile->type = obj->type;
+    pile->hash = x509_name_canon_hash(name);
+    if (!sk_X509_OBJECT_push(pile->objs, obj)) {
+        x509_object_pile_free(pile);
+        return 0;
+    }
+    (void)lh_X509_OBJECT_PILE_insert(store->piles, pile);
+    if (lh_X509_OBJECT_PILE_error(store->piles)) {
+        x509_object_pile_free(pile);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Applications can change the stack returned by X509_STORE_get0_objects()
+ * without the name index noticing. Every change to the stack changes its
+ * generation, so the index is only trusted while the stack still has the
+ * generation it had when the index was last updated. Lookups also need the
+ * stack sorted, x509_store_add() leaves that to the next lookup so that
+ * adding many objects in a row stays cheap. The caller must hold at least a
+ * read lock on |store|.
+ */
+static int x509_store_index_is_current(const X509_STORE *store, int lookup)
+{
+    if (!store->objs_indexed
+            || ossl_sk_generation((const OPENSSL_STACK *)store->objs)
+               != store->objs_gen)
+        return 0;
+    return !lookup || sk_X509_OBJECT_is_sorted(store->objs);
+}
+
+/*
+ * Rebuild the name index from the object stack if it may have been changed
+ * behind the store's back. The caller must hold the write lock on |store|.
+ */
+static int x509_store_index_update(X509_STORE *store, int lookup)
+{
+    int i;
+
+    if (x509_store_index_is_current(store, lookup))
+        return 1;
+
+    store->objs_indexed = 0;
+    lh_X509_OBJECT_PILE_doall(store->piles, x509_object_pile_free);
+    lh_X509_OBJECT_PILE_flush(store->piles);
+    for (i = 0; i < sk_X509_OBJECT_num(store->objs); i++)
+        if (!x509_store_index_object(store, sk_X509_OBJECT_value(store->objs,
+                                                                 i)))
+            return 0;
+    sk_X509_OBJECT_sort(store->objs);
+    store->objs_gen = ossl_sk_generation((const OPENSSL_STACK *)store->objs);
+    store->objs_indexed = 1;
+    return 1;
+}
+
+/* Take the read lock on |store| with its name index up to date */
+static int x509_store_read_lock(X509_STORE *store)
+{
+    int ok;
+
+    for (;;) {
+        if (!CRYPTO_THREAD_read_lock(store->lock))
+            return 0;
+        if (x509_store_index_is_current(store, 1))
+            return 1;
+        CRYPTO_THREAD_unlock(store->lock);
+
+        if (!X509_STORE_lock(store))
+            return 0;
+        ok = x509_store_index_update(store, 1);
+        X509_STORE_unlock(store);
+        if (!ok)
+            return 0;
+    }
+}
+
+/*
+ * Return the first object of |type| named |name| in |store| or NULL if there
+ * is none. The object stays valid as long as it is in the store.
+ */
+X509_OBJECT *x509_store_get0_object(X509_STORE *store, X509_LOOKUP_TYPE type,
+                                    const X509_NAME *name)
+{
+    X509_OBJECT_PILE *pile;
+    X509_OBJECT *ret = NULL;
+
+    if (name == NULL || !x509_name_canon_update(name)
+            || !x509_store_read_lock(store))
+        return NULL;
+    pile = x509_store_get_pile(store, type, name);
+    if (pile != NULL)
+        ret = sk_X509_OBJECT_value(pile->objs, 0);
+    CRYPTO_THREAD_unlock(store->lock);
+    return ret;
+}
+
 X509_STORE *X509_STORE_new(void)
 {
     X509_STORE *ret = OPENSSL_zalloc(sizeof(*ret));
@@ -189,6 +415,13 @@ X509_STORE *X509_STORE_new(void)
         ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
         goto err;
     }
+    ret->piles = lh_X509_OBJECT_PILE_new(x509_object_pile_hash,
+                                         x509_object_pile_cmp);
+    if (ret->piles == NULL) {
+        ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    ret->objs_indexed = 1;
     ret->cache = 1;
     if ((ret->get_cert_methods = sk_X509_LOOKUP_new_null()) == NULL) {
         ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
@@ -214,6 +447,7 @@ X509_STORE *X509_STORE_new(void)
 
 err:
     X509_VERIFY_PARAM_free(ret->param);
+    lh_X509_OBJECT_PILE_free(ret->piles);
     sk_X509_OBJECT_free(ret->objs);
     sk_X509_LOOKUP_free(ret->get_cert_methods);
     OPENSSL_free(ret);
@@ -241,10 +475,13 @@ void X509_STORE_free(X509_STORE *vfy)
         X509_LOOKUP_free(lu);
     }
     sk_X509_LOOKUP_free(sk);
+    lh_X509_OBJECT_PILE_doall(vfy->piles, x509_object_pile_free);
+    lh_X509_OBJECT_PILE_free(vfy->piles);
     sk_X509_OBJECT_pop_free(vfy->objs, X509_OBJECT_free);
 
     CRYPTO_free_ex_data(CRYPTO_EX_INDEX_X509_STORE, vfy, &vfy->ex_data);
     X509_VERIFY_PARAM_free(vfy->param);
+    OPENSSL_free(vfy->sig_cache);
     CRYPTO_THREAD_lock_free(vfy->lock);
     OPENSSL_free(vfy);
 }
@@ -322,9 +559,7 @@ int X509_STORE_CTX_get_by_subject(const X509_STORE_CTX *vs,
     stmp.data.ptr = NULL;
 
 
-    X509_STORE_lock(store);
-    tmp = X509_OBJECT_retrieve_by_subject(store->objs, type, name);
-    X509_STORE_unlock(store);
+    tmp = x509_store_get0_object(store, type, name);
 
     if (tmp == NULL || type == X509_LU_CRL) {
         for (i = 0; i < sk_X509_LOOKUP_num(store->get_cert_methods); i++) {
@@ -349,6 +584,41 @@ int X509_STORE_CTX_get_by_subject(const X509_STORE_CTX *vs,
     return 1;
 }
 
+/*
+ * Add |obj| to both the object stack and the name index of |store| unless an
+ * identical object is already there, |*added| tells which it was. The caller
+ * must hold the write lock on |store|.
+ */
+static int x509_store_add_object(X509_STORE *store, X509_OBJECT *obj,
+                                 int *added)
+{
+    X509_OBJECT_PILE *pile;
+    X509_OBJECT *tmp;
+    int i;
+
+    *added = 0;
+    if (!x509_store_index_update(store, 0) || !x509_object_canon_update(obj))
+        return 0;
+    pile = x509_store_get_pile(store, obj->type, x509_object_get0_name(obj));
+    for (i = 0; pile != NULL && i < sk_X509_OBJECT_num(pile->objs); i++) {
+        tmp = sk_X509_OBJECT_value(pile->objs, i);
+        if (obj->type == X509_LU_X509
+                ? X509_cmp(tmp->data.x509, obj->data.x509) == 0
+                : X509_CRL_match(tmp->data.crl, obj->data.crl) == 0)
+            return 1;
+    }
+
+    if (!sk_X509_OBJECT_push(store->objs, obj))
+        return 0;
+    if (!x509_store_index_object(store, obj)) {
+        (void)sk_X509_OBJECT_pop(store->objs);
+        return 0;
+    }
+    store->objs_gen = ossl_sk_generation((const OPENSSL_STACK *)store->objs);
+    *added = 1;
+    return 1;
+}
+
 static int x509_store_add(X509_STORE *store, void *x, int crl) {
     X509_OBJECT *obj;
     int ret = 0, added = 0;
@@ -373,12 +643,7 @@ static int x509_store_add(X509_STORE *store, void *x, int crl) {
     }
 
     X509_STORE_lock(store);
-    if (X509_OBJECT_retrieve_match(store->objs, obj)) {
-        ret = 1;
-    } else {
-        added = sk_X509_OBJECT_push(store->objs, obj);
-        ret = added != 0;
-    }
+    ret = x509_store_add_object(store, obj, &added);
     X509_STORE_unlock(store);
 
     if (added == 0)             /* obj not pushed */
@@ -588,25 +853,27 @@ STACK_OF(X509) *X509_STORE_get1_all_certs(X509_STORE *store)
 STACK_OF(X509) *X509_STORE_CTX_get1_certs(X509_STORE_CTX *ctx,
                                           const X509_NAME *nm)
 {
-    int i, idx, cnt;
+    int i;
     STACK_OF(X509) *sk = NULL;
     X509 *x;
     X509_OBJECT *obj;
+    X509_OBJECT_PILE *pile;
     X509_STORE *store = ctx->store;
 
-    if (store == NULL)
+    if (store == NULL || nm == NULL || !x509_name_canon_update(nm))
         return NULL;
 
-    X509_STORE_lock(store);
-    idx = x509_object_idx_cnt(store->objs, X509_LU_X509, nm, &cnt);
-    if (idx < 0) {
+    if (!x509_store_read_lock(store))
+        return NULL;
+    pile = x509_store_get_pile(store, X509_LU_X509, nm);
+    if (pile == NULL) {
         /*
          * Nothing found in cache: do lookup to possibly add new objects to
          * cache
          */
         X509_OBJECT *xobj = X509_OBJECT_new();
 
-        X509_STORE_unlock(store);
+        CRYPTO_THREAD_unlock(store->lock);
 
         if (xobj == NULL)
             return NULL;
@@ -615,35 +882,37 @@ STACK_OF(X509) *X509_STORE_CTX_get1_certs(X509_STORE_CTX *ctx,
             return NULL;
         }
         X509_OBJECT_free(xobj);
-        X509_STORE_lock(store);
-        idx = x509_object_idx_cnt(store->objs, X509_LU_X509, nm, &cnt);
-        if (idx < 0) {
-            X509_STORE_unlock(store);
+        if (!x509_store_read_lock(store))
+            return NULL;
+        pile = x509_store_get_pile(store, X509_LU_X509, nm);
+        if (pile == NULL) {
+            CRYPTO_THREAD_unlock(store->lock);
             return NULL;
         }
     }
 
     sk = sk_X509_new_null();
-    for (i = 0; i < cnt; i++, idx++) {
-        obj = sk_X509_OBJECT_value(store->objs, idx);
+    for (i = 0; i < sk_X509_OBJECT_num(pile->objs); i++) {
+        obj = sk_X509_OBJECT_value(pile->objs, i);
         x = obj->data.x509;
         if (!X509_add_cert(sk, x, X509_ADD_FLAG_UP_REF)) {
-            X509_STORE_unlock(store);
+            CRYPTO_THREAD_unlock(store->lock);
             sk_X509_pop_free(sk, X509_free);
             return NULL;
         }
     }
-    X509_STORE_unlock(store);
+    CRYPTO_THREAD_unlock(store->lock);
     return sk;
 }
 
 STACK_OF(X509_CRL) *X509_STORE_CTX_get1_crls(const X509_STORE_CTX *ctx,
                                              const X509_NAME *nm)
 {
-    int i, idx, cnt;
+    int i;
     STACK_OF(X509_CRL) *sk = sk_X509_CRL_new_null();
     X509_CRL *x;
     X509_OBJECT *obj, *xobj = X509_OBJECT_new();
+    X509_OBJECT_PILE *pile;
     X509_STORE *store = ctx->store;
 
     /* Always do lookup to possibly add new CRLs to cache */
@@ -656,30 +925,33 @@ STACK_OF(X509_CRL) *X509_STORE_CTX_get1_crls(const X509_STORE_CTX *ctx,
         return NULL;
     }
     X509_OBJECT_free(xobj);
-    X509_STORE_lock(store);
-    idx = x509_object_idx_cnt(store->objs, X509_LU_CRL, nm, &cnt);
-    if (idx < 0) {
-        X509_STORE_unlock(store);
+    if (!x509_name_canon_update(nm) || !x509_store_read_lock(store)) {
+        sk_X509_CRL_free(sk);
+        return NULL;
+    }
+    pile = x509_store_get_pile(store, X509_LU_CRL, nm);
+    if (pile == NULL) {
+        CRYPTO_THREAD_unlock(store->lock);
         sk_X509_CRL_free(sk);
         return NULL;
     }
 
-    for (i = 0; i < cnt; i++, idx++) {
-        obj = sk_X509_OBJECT_value(store->objs, idx);
+    for (i = 0; i < sk_X509_OBJECT_num(pile->objs); i++) {
+        obj = sk_X509_OBJECT_value(pile->objs, i);
         x = obj->data.crl;
         if (!X509_CRL_up_ref(x)) {
-            X509_STORE_unlock(store);
+            CRYPTO_THREAD_unlock(store->lock);
             sk_X509_CRL_pop_free(sk, X509_CRL_free);
             return NULL;
         }
         if (!sk_X509_CRL_push(sk, x)) {
-            X509_STORE_unlock(store);
+            CRYPTO_THREAD_unlock(store->lock);
             X509_CRL_free(x);
             sk_X509_CRL_pop_free(sk, X509_CRL_free);
             return NULL;
         }
     }
-    X509_STORE_unlock(store);
+    CRYPTO_THREAD_unlock(store->lock);
     return sk;
 }
 
@@ -724,8 +996,9 @@ int X509_STORE_CTX_get1_issuer(X509 **issuer, X509_STORE_CTX *ctx, X509 *x)
 {
     const X509_NAME *xn;
     X509_OBJECT *obj = X509_OBJECT_new(), *pobj = NULL;
+    X509_OBJECT_PILE *pile;
     X509_STORE *store = ctx->store;
-    int i, ok, idx, ret;
+    int i, ok, ret;
 
     if (obj == NULL)
         return -1;
@@ -758,42 +1031,36 @@ int X509_STORE_CTX_get1_issuer(X509 **issuer, X509_STORE_CTX *ctx, X509 *x)
     if (store == NULL)
         return 0;
 
-    /* Find index of first currently valid cert accepted by 'check_issued' */
+    /* Find first currently valid cert accepted by 'check_issued' */
     ret = 0;
-    X509_STORE_lock(store);
-    idx = X509_OBJECT_idx_by_subject(store->objs, X509_LU_X509, xn);
-    if (idx != -1) { /* should be true as we've had at least one match */
-        /* Look through all matching certs for suitable issuer */
-        for (i = idx; i < sk_X509_OBJECT_num(store->objs); i++) {
-            pobj = sk_X509_OBJECT_value(store->objs, i);
-            /* See if we've run past the matches */
-            if (pobj->type != X509_LU_X509)
+    if (!x509_name_canon_update(xn) || !x509_store_read_lock(store))
+        return -1;
+    pile = x509_store_get_pile(store, X509_LU_X509, xn);
+    /* Look through all matching certs for suitable issuer */
+    for (i = 0; pile != NULL && i < sk_X509_OBJECT_num(pile->objs); i++) {
+        pobj = sk_X509_OBJECT_value(pile->objs, i);
+        if (ctx->check_issued(ctx, x, pobj->data.x509)) {
+            ret = 1;
+            /* If times check fine, exit with match, else keep looking. */
+            if (x509_check_cert_time(ctx, pobj->data.x509, -1)) {
+                *issuer = pobj->data.x509;
                 break;
-            if (X509_NAME_cmp(X509_get_subject_name(pobj->data.x509), xn) != 0)
-                break; /* Not more cert matches xn */
-            if (ctx->check_issued(ctx, x, pobj->data.x509)) {
-                ret = 1;
-                /* If times check fine, exit with match, else keep looking. */
-                if (x509_check_cert_time(ctx, pobj->data.x509, -1)) {
-                    *issuer = pobj->data.x509;
-                    break;
-                }
-                /*
-                 * Leave the so far most recently expired match in *issuer
-                 * so we return nearest match if no certificate time is OK.
-                 */
-                if (*issuer == NULL
-                    || ASN1_TIME_compare(X509_get0_notAfter(pobj->data.x509),
-                                         X509_get0_notAfter(*issuer)) > 0)
-                    *issuer = pobj->data.x509;
             }
+            /*
+             * Leave the so far most recently expired match in *issuer
+             * so we return nearest match if no certificate time is OK.
+             */
+            if (*issuer == NULL
+                || ASN1_TIME_compare(X509_get0_notAfter(pobj->data.x509),
+                                     X509_get0_notAfter(*issuer)) > 0)
+                *issuer = pobj->data.x509;
         }
     }
     if (*issuer != NULL && !X509_up_ref(*issuer)) {
         *issuer = NULL;
         ret = -1;
     }
-    X509_STORE_unlock(store);
+    CRYPTO_THREAD_unlock(store->lock);
     return ret;
 }
 
@@ -823,6 +1090,84 @@ int X509_STORE_set1_param(X509_STORE *ctx, const X509_VERIFY_PARAM *param)
     return X509_VERIFY_PARAM_set1(ctx->param, param);
 }
 
+int X509_STORE_set_sig_cache(X509_STORE *ctx, size_t size, long timeout)
+{
+    X509_SIG_CACHE_ENTRY *cache = NULL;
+
+    if (timeout < 0 || size > SIZE_MAX / sizeof(*cache)) {
+        ERR_raise(ERR_LIB_X509, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+    if (size > 0 && (cache = OPENSSL_zalloc(sizeof(*cache) * size)) == NULL) {
+        ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    if (!X509_STORE_lock(ctx)) {
+        OPENSSL_free(cache);
+        return 0;
+    }
+    OPENSSL_free(ctx->sig_cache);
+    ctx->sig_cache = cache;
+    ctx->sig_cache_size = size;
+    ctx->sig_cache_timeout = timeout;
+    tsan_store(&ctx->sig_cache_on, size > 0);
+    X509_STORE_unlock(ctx);
+    return 1;
+}
+
+int x509_store_has_sig_cache(X509_STORE *store)
+{
+    return tsan_load(&store->sig_cache_on);
+}
+
+/* Keys are digests, so any bits of them make a good enough slot index */
+static X509_SIG_CACHE_ENTRY *sig_cache_slot(X509_STORE *store,
+                                            const unsigned char *key)
+{
+    size_t idx = 0;
+    int i;
+
+    for (i = 0; i < (int)sizeof(idx); i++)
+        idx = (idx << 8) | key[i];
+    return &store->sig_cache[idx % store->sig_cache_size];
+}
+
+/* Return 1 if the signature identified by |key| has been verified recently */
+int x509_store_sig_cached(X509_STORE *store, const unsigned char *key)
+{
+    X509_SIG_CACHE_ENTRY *ent;
+    time_t now = time(NULL);
+    int ret = 0;
+
+    if (!CRYPTO_THREAD_read_lock(store->lock))
+        return 0;
+    if (store->sig_cache_size > 0) {
+        ent = sig_cache_slot(store, key);
+        ret = ent->added != 0
+            && memcmp(ent->key, key, sizeof(ent->key)) == 0
+            && (store->sig_cache_timeout == 0
+                || (now >= ent->added
+                    && now - ent->added < store->sig_cache_timeout));
+    }
+    CRYPTO_THREAD_unlock(store->lock);
+    return ret;
+}
+
+/* Record a successful signature check, evicting whatever was in its slot */
+void x509_store_sig_cache_add(X509_STORE *store, const unsigned char *key)
+{
+    X509_SIG_CACHE_ENTRY *ent;
+
+    if (!X509_STORE_lock(store))
+        return;
+    if (store->sig_cache_size > 0) {
+        ent = sig_cache_slot(store, key);
+        memcpy(ent->key, key, sizeof(ent->key));
+        ent->added = time(NULL);
+    }
+    X509_STORE_unlock(store);
+}
+
 X509_VERIFY_PARAM *X509_STORE_get0_param(const X509_STORE *ctx)
 {
     return ctx->param;
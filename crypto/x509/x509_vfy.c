@@ -1727,6 +1727,100 @@ int x509_check_cert_time(X509_STORE_CTX *ctx, X509 *x, int depth)
     return 1;
 }
 
+/*
+ * Hash |len| bytes at |data| preceded by their length, so that the fields
+ * hashed one after the other cannot run into each other. An absent field,
+ * with |data| NULL, hashes differently from an empty one.
+ */
+static int sig_cache_key_update(EVP_MD_CTX *mctx, const void *data,
+                                size_t len)
+{
+    uint64_t n = data == NULL ? UINT64_MAX : (uint64_t)len;
+    unsigned char enc[8];
+    int i;
+
+    for (i = 7; i >= 0; i--, n >>= 8)
+        enc[i] = (unsigned char)n;
+    return EVP_DigestUpdate(mctx, enc, sizeof(enc))
+        && (data == NULL || EVP_DigestUpdate(mctx, data, len));
+}
+
+/*
+ * Compute the key under which the signature on |x| as checked with the public
+ * key of |issuer| is kept in the signature cache of the store. The cached DER
+ * encodings of both certificates are hashed together with the outer signature
+ * algorithm and the signature on |x|, any distinguishing ID used for the
+ * verification and what determines the implementation used for it: the
+ * library context, the property query and the security level. Certificates
+ * modified since they were decoded are not cached. The digest is fetched once
+ * per |ctx|.
+ */
+static int sig_cache_key(X509_STORE_CTX *ctx, X509 *x, X509 *issuer,
+                         unsigned char *key)
+{
+    const ASN1_ENCODING *tbs = &x->cert_info.enc;
+    const ASN1_ENCODING *itbs = &issuer->cert_info.enc;
+    ASN1_OCTET_STRING *id = X509_get0_distinguishing_id(x);
+    int level = X509_VERIFY_PARAM_get_auth_level(ctx->param);
+    unsigned char unused_bits = (unsigned char)(x->signature.flags & 0x07);
+    unsigned char *alg = NULL;
+    int alglen;
+    EVP_MD_CTX *mctx = NULL;
+    int ret = 0;
+
+    if (tbs->enc == NULL || tbs->modified
+            || itbs->enc == NULL || itbs->modified)
+        return 0;
+    if (ctx->sig_cache_md == NULL
+            && (ctx->sig_cache_md = EVP_MD_fetch(ctx->libctx, SN_sha256,
+                                                 ctx->propq)) == NULL)
+        return 0;
+    /* X509_verify() rejects an outer algorithm that differs from the inner */
+    if ((alglen = i2d_X509_ALGOR(&x->sig_alg, &alg)) <= 0
+            || (mctx = EVP_MD_CTX_new()) == NULL)
+        goto end;
+    ret = EVP_DigestInit_ex(mctx, ctx->sig_cache_md, NULL)
+        && EVP_DigestUpdate(mctx, &ctx->libctx, sizeof(ctx->libctx))
+        && sig_cache_key_update(mctx, ctx->propq,
+                                ctx->propq == NULL ? 0 : strlen(ctx->propq))
+        && EVP_DigestUpdate(mctx, &level, sizeof(level))
+        && sig_cache_key_update(mctx, tbs->enc, tbs->len)
+        && sig_cache_key_update(mctx, alg, alglen)
+        && EVP_DigestUpdate(mctx, &unused_bits, 1)
+        && sig_cache_key_update(mctx, x->signature.data, x->signature.length)
+        && sig_cache_key_update(mctx, itbs->enc, itbs->len)
+        && (id == NULL
+            ? sig_cache_key_update(mctx, NULL, 0)
+            : sig_cache_key_update(mctx, id->data, id->length))
+        && EVP_DigestFinal_ex(mctx, key, NULL);
+ end:
+    EVP_MD_CTX_free(mctx);
+    OPENSSL_free(alg);
+    return ret;
+}
+
+/*
+ * Check the signature on |xs| with the key |pkey| of |xi|. If the store has a
+ * signature cache, a signature that verified before is not checked again.
+ * Only the outcome of the public key operation is cached, everything else
+ * (validity periods, revocation, flags) is still evaluated by the caller.
+ */
+static int verify_cert_signature(X509_STORE_CTX *ctx, X509 *xs, X509 *xi,
+                                 EVP_PKEY *pkey)
+{
+    unsigned char key[SHA256_DIGEST_LENGTH];
+    int cache, ret;
+
+    cache = ctx->store != NULL && x509_store_has_sig_cache(ctx->store)
+        && sig_cache_key(ctx, xs, xi, key);
+    if (cache && x509_store_sig_cached(ctx->store, key))
+        return 1;
+    ret = X509_verify(xs, pkey);
+    if (ret > 0 && cache)
+        x509_store_sig_cache_add(ctx->store, key);
+    return ret;
+}
+
 /*
  * Verify the issuer signatures and cert times of ctx->chain.
  * Sadly, returns 0 also on internal error.
@@ -1811,7 +1905,7 @@ static int internal_verify(X509_STORE_CTX *ctx)
                 CB_FAIL_IF(1, ctx, xi, issuer_depth,
                            X509_V_ERR_UNABLE_TO_DECODE_ISSUER_PUBLIC_KEY);
             } else {
-                CB_FAIL_IF(X509_verify(xs, pkey) <= 0,
+                CB_FAIL_IF(verify_cert_signature(ctx, xs, xi, pkey) <= 0,
                            ctx, xs, n, X509_V_ERR_CERT_SIGNATURE_FAILURE);
             }
         }
@@ -2305,6 +2399,7 @@ void X509_STORE_CTX_free(X509_STORE_CTX *ctx)
 
     /* libctx and propq survive X509_STORE_CTX_cleanup() */
     OPENSSL_free(ctx->propq);
+    EVP_MD_free(ctx->sig_cache_md);
     OPENSSL_free(ctx);
 }
 
@@ -36,8 +36,6 @@ static void x509_name_ex_free(ASN1_VALUE **val, const ASN1_ITEM *it);
 static int x509_name_encode(X509_NAME *a);
 static int x509_name_canon(X509_NAME *a);
 static int asn1_string_canon(ASN1_STRING *out, const ASN1_STRING *in);
-static int i2d_name_canon(const STACK_OF(STACK_OF_X509_NAME_ENTRY) * intname,
-                          unsigned char **in);
 
 static int x509_name_ex_print(BIO *out, const ASN1_VALUE **pval,
                               int indent,
@@ -153,7 +151,7 @@ static int x509_name_ex_d2i(ASN1_VALUE **val,
     } nm = {
         NULL
     };
-    int i, j, ret;
+    int i, j, ret, num = 0;
     STACK_OF(X509_NAME_ENTRY) *entries;
     X509_NAME_ENTRY *entry;
 
@@ -179,6 +177,12 @@ static int x509_name_ex_d2i(ASN1_VALUE **val,
     memcpy(nm.x->bytes->data, q, p - q);
 
     /* Convert internal representation to X509_NAME structure */
+    for (i = 0; i < sk_STACK_OF_X509_NAME_ENTRY_num(intname.s); i++) {
+        entries = sk_STACK_OF_X509_NAME_ENTRY_value(intname.s, i);
+        num += sk_X509_NAME_ENTRY_num(entries);
+    }
+    if (!sk_X509_NAME_ENTRY_reserve(nm.x->entries, num))
+        goto err;
     for (i = 0; i < sk_STACK_OF_X509_NAME_ENTRY_num(intname.s); i++) {
         entries = sk_STACK_OF_X509_NAME_ENTRY_value(intname.s, i);
         for (j = 0; j < sk_X509_NAME_ENTRY_num(entries); j++) {
@@ -300,60 +304,52 @@ static int x509_name_ex_print(BIO *out, const ASN1_VALUE **pval,
  * constraints of type dirName can also be checked with a simple memcmp().
  */
 
+/*
+ * The canonical entries only live until the encoding has been generated and
+ * merely borrow the attribute type from the real entry, so they are carved
+ * from a single block rather than allocated one by one.
+ */
+typedef struct {
+    X509_NAME_ENTRY entry;
+    ASN1_STRING value;
+} NAME_CANON_ENTRY;
+
+static int i2d_name_canon(NAME_CANON_ENTRY *tmp, int num,
+                          STACK_OF(X509_NAME_ENTRY) *rdn, unsigned char **in);
+
 static int x509_name_canon(X509_NAME *a)
 {
     unsigned char *p;
-    STACK_OF(STACK_OF_X509_NAME_ENTRY) *intname;
-    STACK_OF(X509_NAME_ENTRY) *entries = NULL;
-    X509_NAME_ENTRY *entry, *tmpentry = NULL;
-    int i, set = -1, ret = 0, len;
+    STACK_OF(X509_NAME_ENTRY) *rdn = NULL;
+    NAME_CANON_ENTRY *tmp = NULL;
+    X509_NAME_ENTRY *entry;
+    int i, num, ret = 0, len;
 
     OPENSSL_free(a->canon_enc);
     a->canon_enc = NULL;
+    num = sk_X509_NAME_ENTRY_num(a->entries);
     /* Special case: empty X509_NAME => null encoding */
-    if (sk_X509_NAME_ENTRY_num(a->entries) == 0) {
+    if (num == 0) {
         a->canon_enclen = 0;
         return 1;
     }
-    intname = sk_STACK_OF_X509_NAME_ENTRY_new_null();
-    if (intname == NULL) {
+    tmp = OPENSSL_zalloc(sizeof(*tmp) * num);
+    rdn = sk_X509_NAME_ENTRY_new_reserve(NULL, num);
+    if (tmp == NULL || rdn == NULL) {
         ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
         goto err;
     }
-    for (i = 0; i < sk_X509_NAME_ENTRY_num(a->entries); i++) {
+    for (i = 0; i < num; i++) {
         entry = sk_X509_NAME_ENTRY_value(a->entries, i);
-        if (entry->set != set) {
-            entries = sk_X509_NAME_ENTRY_new_null();
-            if (entries == NULL)
-                goto err;
-            if (!sk_STACK_OF_X509_NAME_ENTRY_push(intname, entries)) {
-                sk_X509_NAME_ENTRY_free(entries);
-                ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
-                goto err;
-            }
-            set = entry->set;
-        }
-        tmpentry = X509_NAME_ENTRY_new();
-        if (tmpentry == NULL) {
-            ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
-            goto err;
-        }
-        tmpentry->object = OBJ_dup(entry->object);
-        if (tmpentry->object == NULL) {
-            ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
+        tmp[i].entry.object = entry->object;
+        tmp[i].entry.value = &tmp[i].value;
+        tmp[i].entry.set = entry->set;
+        if (!asn1_string_canon(&tmp[i].value, entry->value))
             goto err;
-        }
-        if (!asn1_string_canon(tmpentry->value, entry->value))
-            goto err;
-        if (!sk_X509_NAME_ENTRY_push(entries, tmpentry)) {
-            ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
-            goto err;
-        }
-        tmpentry = NULL;
     }
 
     /* Finally generate encoding */
-    len = i2d_name_canon(intname, NULL);
+    len = i2d_name_canon(tmp, num, rdn, NULL);
     if (len < 0)
         goto err;
     a->canon_enclen = len;
@@ -366,14 +362,16 @@ static int x509_name_canon(X509_NAME *a)
 
     a->canon_enc = p;
 
-    i2d_name_canon(intname, &p);
+    i2d_name_canon(tmp, num, rdn, &p);
 
     ret = 1;
 
  err:
-    X509_NAME_ENTRY_free(tmpentry);
-    sk_STACK_OF_X509_NAME_ENTRY_pop_free(intname,
-                                         local_sk_X509_NAME_ENTRY_pop_free);
+    if (tmp != NULL)
+        for (i = 0; i < num; i++)
+            OPENSSL_free(tmp[i].value.data);
+    OPENSSL_free(tmp);
+    sk_X509_NAME_ENTRY_free(rdn);
     return ret;
 }
 
@@ -463,16 +461,21 @@ static int asn1_string_canon(ASN1_STRING *out, const ASN1_STRING *in)
 
 }
 
-static int i2d_name_canon(const STACK_OF(STACK_OF_X509_NAME_ENTRY) * _intname,
-                          unsigned char **in)
+/*
+ * Encode each run of entries belonging to the same RDN as a SET OF, |rdn|
+ * must have room for all |num| entries.
+ */
+static int i2d_name_canon(NAME_CANON_ENTRY *tmp, int num,
+                          STACK_OF(X509_NAME_ENTRY) *rdn, unsigned char **in)
 {
-    int i, len, ltmp;
-    const ASN1_VALUE *v;
-    STACK_OF(ASN1_VALUE) *intname = (STACK_OF(ASN1_VALUE) *)_intname;
+    int i, j, len, ltmp;
+    const ASN1_VALUE *v = (const ASN1_VALUE *)rdn;
 
     len = 0;
-    for (i = 0; i < sk_ASN1_VALUE_num(intname); i++) {
-        v = sk_ASN1_VALUE_value(intname, i);
+    for (i = 0; i < num; i = j) {
+        sk_X509_NAME_ENTRY_zero(rdn);
+        for (j = i; j < num && tmp[j].entry.set == tmp[i].entry.set; j++)
+            (void)sk_X509_NAME_ENTRY_push(rdn, &tmp[j].entry);
         ltmp = ASN1_item_ex_i2d(&v, in,
                                 ASN1_ITEM_rptr(X509_NAME_ENTRIES), -1, -1);
         if (ltmp < 0)
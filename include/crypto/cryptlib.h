@@ -37,4 +37,6 @@ void ossl_malloc_setup_failures(void);
 int ossl_crypto_alloc_ex_data_intern(int class_index, void *obj,
                                      CRYPTO_EX_DATA *ad, int idx);
 
+uint64_t ossl_sk_generation(const OPENSSL_STACK *st);
+
 #endif  /* OSSL_CRYPTO_CRYPTLIB_H */
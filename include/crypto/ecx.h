@@ -62,6 +62,9 @@ typedef enum {
            ? EVP_PKEY_ED25519 \
            : EVP_PKEY_ED448)))
 
+typedef struct x25519_precomp_st X25519_PRECOMP;
+typedef struct ed25519_precomp_st ED25519_PRECOMP;
+
 struct ecx_key_st {
     OSSL_LIB_CTX *libctx;
     char *propq;
@@ -72,6 +75,15 @@ struct ecx_key_st {
     ECX_KEY_TYPE type;
     CRYPTO_REF_COUNT references;
     CRYPTO_RWLOCK *lock;
+    /*
+     * Tables for a public key in frequent use, the member for |type| if any,
+     * see ecx_key.c.  They are never built in the FIPS provider.
+     */
+    union {
+        X25519_PRECOMP *x25519;
+        ED25519_PRECOMP *ed25519;
+    } precomp;
+    int pubkey_uses;
 };
 
 typedef struct ecx_key_st ECX_KEY;
@@ -82,6 +94,12 @@ void ossl_ecx_key_set0_libctx(ECX_KEY *key, OSSL_LIB_CTX *libctx);
 unsigned char *ossl_ecx_key_allocate_privkey(ECX_KEY *key);
 void ossl_ecx_key_free(ECX_KEY *key);
 int ossl_ecx_key_up_ref(ECX_KEY *key);
+void ossl_ecx_key_clear_precomp(ECX_KEY *key);
+int ossl_ecx_key_x25519(uint8_t out_shared_key[32],
+                        const uint8_t private_key[32], ECX_KEY *peer);
+int ossl_ecx_key_ed25519_verify(const uint8_t *message, size_t message_len,
+                                const uint8_t signature[64], ECX_KEY *key,
+                                OSSL_LIB_CTX *libctx);
 
 int X25519(uint8_t out_shared_key[32], const uint8_t private_key[32],
            const uint8_t peer_public_value[32]);
@@ -96,6 +114,26 @@ int ED25519_sign(uint8_t *out_sig, const uint8_t *message, size_t message_len,
 int ED25519_verify(const uint8_t *message, size_t message_len,
                    const uint8_t signature[64], const uint8_t public_key[32],
                    OSSL_LIB_CTX *libctx, const char *propq);
+int ED25519_verify_batch(const uint8_t *const *messages,
+                         const size_t *message_lens,
+                         const uint8_t *const *signatures,
+                         const uint8_t *const *public_keys, size_t num,
+                         OSSL_LIB_CTX *libctx, const char *propq);
+
+#  ifndef FIPS_MODULE
+X25519_PRECOMP *ossl_x25519_precomp_new(const uint8_t public_key[32]);
+void ossl_x25519_precomp_free(X25519_PRECOMP *pre);
+int ossl_x25519_precomp(uint8_t out_shared_key[32],
+                        const uint8_t private_key[32],
+                        const X25519_PRECOMP *peer);
+ED25519_PRECOMP *ossl_ed25519_precomp_new(const uint8_t public_key[32]);
+void ossl_ed25519_precomp_free(ED25519_PRECOMP *pre);
+int ossl_ed25519_verify_precomp(const uint8_t *message, size_t message_len,
+                                const uint8_t signature[64],
+                                const uint8_t public_key[32],
+                                const ED25519_PRECOMP *pre,
+                                OSSL_LIB_CTX *libctx, const char *propq);
+#  endif
 
 int ED448_public_from_private(OSSL_LIB_CTX *ctx, uint8_t out_public_key[57],
                               const uint8_t private_key[57], const char *propq);
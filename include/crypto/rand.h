@@ -20,6 +20,7 @@
 # pragma once
 
 # include <openssl/rand.h>
+# include <openssl/core_dispatch.h>
 # include "crypto/rand_pool.h"
 
 /*
@@ -115,4 +116,14 @@ void ossl_rand_cleanup_nonce(ossl_unused OSSL_CORE_HANDLE *handle,
 size_t ossl_pool_acquire_entropy(RAND_POOL *pool);
 int ossl_pool_add_nonce_data(RAND_POOL *pool);
 
+# ifndef FIPS_MODULE
+/*
+ * Read the reseed counter of a DRBG, directly for those of the built-in
+ * default provider.
+ */
+unsigned int evp_rand_reseed_counter(EVP_RAND_CTX *ctx);
+OSSL_FUNC_rand_lock_fn ossl_drbg_lock;
+unsigned int ossl_drbg_reseed_counter(void *vdrbg);
+# endif
+
 #endif
@@ -17,5 +17,9 @@
 int sha512_224_init(SHA512_CTX *);
 int sha512_256_init(SHA512_CTX *);
 int ossl_sha1_ctrl(SHA_CTX *ctx, int cmd, int mslen, void *ms);
+int ossl_sha1_digest_many(const unsigned char *const *in, const size_t *inl,
+                          size_t num, unsigned char *out);
+int ossl_sha256_digest_many(const unsigned char *const *in, const size_t *inl,
+                            size_t num, unsigned char *out);
 
 #endif
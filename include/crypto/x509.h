@@ -277,6 +277,8 @@ struct x509_store_ctx_st {      /* X509_STORE_CTX */
 
     OSSL_LIB_CTX *libctx;
     char *propq;
+    /* Digest for the signature cache keys, fetched with |libctx| and |propq| */
+    EVP_MD *sig_cache_md;
 };
 
 /* PKCS#8 private key info structure */
@@ -58,6 +58,8 @@ static ossl_inline unsigned int constant_time_is_zero(unsigned int a);
 static ossl_inline unsigned char constant_time_is_zero_8(unsigned int a);
 /* Convenience method for getting a 32-bit mask. */
 static ossl_inline uint32_t constant_time_is_zero_32(uint32_t a);
+/* Convenience method for getting a 64-bit mask. */
+static ossl_inline uint64_t constant_time_is_zero_64(uint64_t a);
 
 /* Returns 0xff..f if a == b and 0 otherwise. */
 static ossl_inline unsigned int constant_time_eq(unsigned int a,
@@ -182,6 +184,11 @@ static ossl_inline uint32_t constant_time_is_zero_32(uint32_t a)
     return constant_time_msb_32(~a & (a - 1));
 }
 
+static ossl_inline uint64_t constant_time_is_zero_64(uint64_t a)
+{
+    return constant_time_msb_64(~a & (a - 1));
+}
+
 static ossl_inline unsigned int constant_time_eq(unsigned int a,
                                                  unsigned int b)
 {
@@ -58,6 +58,7 @@ int ossl_method_store_cache_set(OSSL_METHOD_STORE *store, int nid,
                                 void (*method_destruct)(void *));
 
 void ossl_method_store_flush_cache(OSSL_METHOD_STORE *store, int all);
+void ossl_method_store_cleanup_int(void);
 
 /* Merge two property queries together */
 OSSL_PROPERTY_LIST *ossl_property_merge(const OSSL_PROPERTY_LIST *a,
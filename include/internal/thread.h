@@ -0,0 +1,35 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_INTERNAL_THREAD_H
+# define OSSL_INTERNAL_THREAD_H
+# pragma once
+
+# include <openssl/e_os2.h>
+# include <openssl/types.h>
+
+/*
+ * A pool of worker threads for internal parallel work, one per library
+ * context and limited by OSSL_set_max_threads(). By default no threads are
+ * available and ossl_crypto_thread_start() always returns NULL, in which case
+ * the caller is expected to do the work itself.
+ *
+ * Errors raised on a worker thread end up on that thread's error queue and
+ * are lost, so routines should only report failures through |data|.
+ */
+typedef struct ossl_crypto_thread_st OSSL_CRYPTO_THREAD;
+typedef void OSSL_CRYPTO_THREAD_ROUTINE(void *data);
+
+uint64_t ossl_get_avail_threads(OSSL_LIB_CTX *ctx);
+OSSL_CRYPTO_THREAD *ossl_crypto_thread_start(OSSL_LIB_CTX *ctx,
+                                             OSSL_CRYPTO_THREAD_ROUTINE *routine,
+                                             void *data);
+int ossl_crypto_thread_join(OSSL_CRYPTO_THREAD *thread);
+
+#endif
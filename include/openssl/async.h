@@ -49,7 +49,13 @@ typedef int (*ASYNC_callback_fn)(void *arg);
 #define ASYNC_STATUS_OK             2
 #define ASYNC_STATUS_EAGAIN         3
 
+/* Flags for ASYNC_init_thread_ex() */
+#define ASYNC_STACK_GUARD           0x1
+#define ASYNC_STACK_PREFAULT        0x2
+
 int ASYNC_init_thread(size_t max_size, size_t init_size);
+int ASYNC_init_thread_ex(size_t max_size, size_t init_size,
+                         size_t stack_size, unsigned int flags);
 void ASYNC_cleanup_thread(void);
 
 #ifdef OSSL_ASYNC_FD
@@ -25,5 +25,6 @@
 # define ASYNC_R_FAILED_TO_SWAP_CONTEXT                   102
 # define ASYNC_R_INIT_FAILED                              105
 # define ASYNC_R_INVALID_POOL_SIZE                        103
+# define ASYNC_R_INVALID_STACK_SIZE                       106
 
 #endif
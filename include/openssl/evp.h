@@ -347,6 +347,8 @@ OSSL_DEPRECATEDIN_3_0 int
 /* For supplementary wrap cipher support */
 # define         EVP_CIPH_FLAG_GET_WRAP_CIPHER   0x4000000
 # define         EVP_CIPH_FLAG_INVERSE_CIPHER    0x8000000
+/* Cipher can encrypt several independent AEAD records in one call */
+# define         EVP_CIPH_FLAG_AEAD_MULTIREC     0x10000000
 
 /*
  * Cipher context flag to indicate we can handle wrap mode: if allowed in
@@ -448,6 +450,21 @@ typedef struct {
     unsigned int interleave;
 } EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM;
 
+/*
+ * One record of a multi-record AEAD encryption, see the "aead-multirec-enc"
+ * cipher parameter.  |len| bytes of ciphertext followed by a |taglen| byte
+ * tag are written to |out|.
+ */
+typedef struct {
+    unsigned char *out;
+    const unsigned char *inp;
+    size_t len;
+    const unsigned char *iv;
+    const unsigned char *aad;
+    size_t aadlen;
+    size_t taglen;
+} EVP_AEAD_MULTIREC_PARAM;
+
 /* GCM TLS constants */
 /* Length of fixed part of IV derived from PRF */
 # define EVP_GCM_TLS_FIXED_IV_LEN                        4
@@ -663,6 +680,9 @@ __owur int EVP_DigestFinal_ex(EVP_MD_CTX *ctx, unsigned char *md,
 __owur int EVP_Digest(const void *data, size_t count,
                           unsigned char *md, unsigned int *size,
                           const EVP_MD *type, ENGINE *impl);
+__owur int EVP_Digest_many(const void *const *data, const size_t *count,
+                           size_t num, unsigned char *md, unsigned int *size,
+                           const EVP_MD *type, ENGINE *impl);
 
 __owur int EVP_MD_CTX_copy(EVP_MD_CTX *out, const EVP_MD_CTX *in);
 __owur int EVP_DigestInit(EVP_MD_CTX *ctx, const EVP_MD *type);
@@ -751,6 +771,13 @@ __owur int EVP_VerifyFinal_ex(EVP_MD_CTX *ctx, const unsigned char *sigbuf,
 __owur int EVP_DigestVerify(EVP_MD_CTX *ctx, const unsigned char *sigret,
                             size_t siglen, const unsigned char *tbs,
                             size_t tbslen);
+__owur int EVP_DigestVerify_batch(EVP_PKEY *const *pkeys,
+                                  const unsigned char *const *sigs,
+                                  const size_t *siglens,
+                                  const unsigned char *const *tbs,
+                                  const size_t *tbslens, size_t num,
+                                  OSSL_LIB_CTX *libctx, const char *propq,
+                                  const OSSL_PARAM params[]);
 
 int EVP_DigestSignInit_ex(EVP_MD_CTX *ctx, EVP_PKEY_CTX **pctx,
                           const char *mdname, OSSL_LIB_CTX *libctx,
@@ -41,6 +41,27 @@ static void aes_ccm_freectx(void *vctx)
     OPENSSL_clear_free(ctx,  sizeof(*ctx));
 }
 
+static OSSL_FUNC_cipher_dupctx_fn aes_ccm_dupctx;
+static void *aes_ccm_dupctx(void *provctx)
+{
+    PROV_AES_CCM_CTX *ctx = provctx;
+    PROV_AES_CCM_CTX *dctx;
+
+    if (!ossl_prov_is_running())
+        return NULL;
+
+    dctx = OPENSSL_memdup(ctx, sizeof(*ctx));
+    if (dctx == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    /* The key schedule is referred to by pointer, point it at the copy */
+    if (dctx->base.ccm_ctx.key != NULL)
+        dctx->base.ccm_ctx.key = &dctx->ccm.ks.ks;
+
+    return dctx;
+}
+
 /* ossl_aes128ccm_functions */
 IMPLEMENT_aead_cipher(aes, ccm, CCM, AEAD_FLAGS, 128, 8, 96);
 /* ossl_aes192ccm_functions */
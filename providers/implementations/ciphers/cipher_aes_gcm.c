@@ -45,9 +45,32 @@ static void aes_gcm_freectx(void *vctx)
     OPENSSL_clear_free(ctx,  sizeof(*ctx));
 }
 
+static OSSL_FUNC_cipher_dupctx_fn aes_gcm_dupctx;
+static void *aes_gcm_dupctx(void *provctx)
+{
+    PROV_AES_GCM_CTX *ctx = provctx;
+    PROV_AES_GCM_CTX *dctx;
+
+    if (!ossl_prov_is_running())
+        return NULL;
+
+    dctx = OPENSSL_memdup(ctx, sizeof(*ctx));
+    if (dctx == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    /* The key schedule is referred to by pointer, point it at the copy */
+    if (dctx->base.ks != NULL)
+        dctx->base.ks = &dctx->ks.ks;
+    if (dctx->base.gcm.key != NULL)
+        dctx->base.gcm.key = &dctx->ks.ks;
+
+    return dctx;
+}
+
 /* ossl_aes128gcm_functions */
-IMPLEMENT_aead_cipher(aes, gcm, GCM, AEAD_FLAGS, 128, 8, 96);
+IMPLEMENT_aead_cipher(aes, gcm, GCM, GCM_FLAGS, 128, 8, 96);
 /* ossl_aes192gcm_functions */
-IMPLEMENT_aead_cipher(aes, gcm, GCM, AEAD_FLAGS, 192, 8, 96);
+IMPLEMENT_aead_cipher(aes, gcm, GCM, GCM_FLAGS, 192, 8, 96);
 /* ossl_aes256gcm_functions */
-IMPLEMENT_aead_cipher(aes, gcm, GCM, AEAD_FLAGS, 256, 8, 96);
+IMPLEMENT_aead_cipher(aes, gcm, GCM, GCM_FLAGS, 256, 8, 96);
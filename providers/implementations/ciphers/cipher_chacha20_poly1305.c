@@ -20,7 +20,8 @@
 #define CHACHA20_POLY1305_MAX_IVLEN 12
 #define CHACHA20_POLY1305_MODE 0
 #define CHACHA20_POLY1305_FLAGS (PROV_CIPHER_FLAG_AEAD                         \
-                                 | PROV_CIPHER_FLAG_CUSTOM_IV)
+                                 | PROV_CIPHER_FLAG_CUSTOM_IV                  \
+                                 | PROV_CIPHER_FLAG_AEAD_MULTIREC)
 
 static OSSL_FUNC_cipher_newctx_fn chacha20_poly1305_newctx;
 static OSSL_FUNC_cipher_freectx_fn chacha20_poly1305_freectx;
@@ -32,7 +33,7 @@ static OSSL_FUNC_cipher_set_ctx_params_fn chacha20_poly1305_set_ctx_params;
 static OSSL_FUNC_cipher_cipher_fn chacha20_poly1305_cipher;
 static OSSL_FUNC_cipher_final_fn chacha20_poly1305_final;
 static OSSL_FUNC_cipher_gettable_ctx_params_fn chacha20_poly1305_gettable_ctx_params;
-#define chacha20_poly1305_settable_ctx_params ossl_cipher_aead_settable_ctx_params
+static OSSL_FUNC_cipher_settable_ctx_params_fn chacha20_poly1305_settable_ctx_params;
 #define chacha20_poly1305_gettable_params ossl_cipher_generic_gettable_params
 #define chacha20_poly1305_update chacha20_poly1305_cipher
 
@@ -140,6 +141,63 @@ static const OSSL_PARAM *chacha20_poly1305_gettable_ctx_params
     return chacha20_poly1305_known_gettable_ctx_params;
 }
 
+static const OSSL_PARAM chacha20_poly1305_known_settable_ctx_params[] = {
+    OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_AEAD_IVLEN, NULL),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_AAD, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_SET_IV_INV, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_MULTIREC_ENC, NULL, 0),
+    OSSL_PARAM_END
+};
+static const OSSL_PARAM *chacha20_poly1305_settable_ctx_params
+    (ossl_unused void *cctx, ossl_unused void *provctx)
+{
+    return chacha20_poly1305_known_settable_ctx_params;
+}
+
+/*
+ * Encrypt |n| independent records, each with its own nonce and AAD, in a
+ * single call.  See the "aead-multirec-enc" parameter.
+ */
+static int chacha20_poly1305_multirec_enc(PROV_CHACHA20_POLY1305_CTX *ctx,
+                                          const EVP_AEAD_MULTIREC_PARAM *rec,
+                                          size_t n)
+{
+    PROV_CIPHER_HW_CHACHA20_POLY1305 *hw =
+        (PROV_CIPHER_HW_CHACHA20_POLY1305 *)ctx->base.hw;
+    size_t i, outl;
+
+    if (!ossl_prov_is_running())
+        return 0;
+    if (!ctx->base.enc) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_NOT_SUPPORTED);
+        return 0;
+    }
+
+    for (i = 0; i < n; i++, rec++) {
+        if (rec->taglen == 0 || rec->taglen > POLY1305_BLOCK_SIZE) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+            return 0;
+        }
+        memcpy(ctx->base.oiv, rec->iv, ctx->nonce_len);
+        /* A NULL input to aead_cipher() means final, so skip empty parts */
+        if (!hw->initiv(&ctx->base)
+            || (rec->aadlen > 0
+                && !hw->aead_cipher(&ctx->base, NULL, &outl, rec->aad,
+                                    rec->aadlen))
+            || (rec->len > 0
+                && !hw->aead_cipher(&ctx->base, rec->out, &outl, rec->inp,
+                                    rec->len))
+            || !hw->aead_cipher(&ctx->base, NULL, &outl, NULL, 0)) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_CIPHER_OPERATION_FAILED);
+            return 0;
+        }
+        memcpy(rec->out + rec->len, ctx->tag, rec->taglen);
+    }
+    return 1;
+}
+
 static int chacha20_poly1305_set_ctx_params(void *vctx,
                                             const OSSL_PARAM params[])
 {
@@ -218,6 +276,19 @@ static int chacha20_poly1305_set_ctx_params(void *vctx,
             return 0;
         }
     }
+    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_MULTIREC_ENC);
+    if (p != NULL) {
+        if (p->data == NULL
+            || p->data_type != OSSL_PARAM_OCTET_STRING
+            || p->data_size % sizeof(EVP_AEAD_MULTIREC_PARAM) != 0) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
+            return 0;
+        }
+        if (!chacha20_poly1305_multirec_enc(ctx, p->data,
+                                            p->data_size
+                                            / sizeof(EVP_AEAD_MULTIREC_PARAM)))
+            return 0;
+    }
     /* ignore OSSL_CIPHER_PARAM_AEAD_MAC_KEY */
     return 1;
 }
@@ -24,6 +24,8 @@ static int gcm_tls_cipher(PROV_GCM_CTX *ctx, unsigned char *out, size_t *padlen,
 static int gcm_cipher_internal(PROV_GCM_CTX *ctx, unsigned char *out,
                                size_t *padlen, const unsigned char *in,
                                size_t len);
+static int gcm_multirec_enc(PROV_GCM_CTX *ctx,
+                            const EVP_AEAD_MULTIREC_PARAM *rec, size_t n);
 
 void ossl_gcm_initctx(void *provctx, PROV_GCM_CTX *ctx, size_t keybits,
                       const PROV_GCM_HW *hw, size_t ivlen_min)
@@ -282,11 +284,37 @@ int ossl_gcm_set_ctx_params(void *vctx, const OSSL_PARAM params[])
             || !setivinv(ctx, p->data, p->data_size))
             return 0;
     }
-
+    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_MULTIREC_ENC);
+    if (p != NULL) {
+        if (p->data == NULL
+            || p->data_type != OSSL_PARAM_OCTET_STRING
+            || p->data_size % sizeof(EVP_AEAD_MULTIREC_PARAM) != 0) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
+            return 0;
+        }
+        if (!gcm_multirec_enc(ctx, p->data,
+                              p->data_size / sizeof(EVP_AEAD_MULTIREC_PARAM)))
+            return 0;
+    }
 
     return 1;
 }
 
+static const OSSL_PARAM gcm_known_settable_ctx_params[] = {
+    OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_AEAD_IVLEN, NULL),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_AAD, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_SET_IV_INV, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_MULTIREC_ENC, NULL, 0),
+    OSSL_PARAM_END
+};
+const OSSL_PARAM *ossl_gcm_settable_ctx_params(ossl_unused void *cctx,
+                                               ossl_unused void *provctx)
+{
+    return gcm_known_settable_ctx_params;
+}
+
 int ossl_gcm_stream_update(void *vctx, unsigned char *out, size_t *outl,
                            size_t outsize, const unsigned char *in, size_t inl)
 {
@@ -553,3 +581,45 @@ err:
     *padlen = plen;
     return rv;
 }
+
+/*
+ * Encrypt |n| independent records, each with its own IV and AAD, in a single
+ * call.  This is used by TLSv1.3 to encrypt pipelined records without a trip
+ * through the EVP layer for every record.  The records are processed one
+ * after the other by the same one shot routine gcm_tls_cipher() uses.
+ */
+static int gcm_multirec_enc(PROV_GCM_CTX *ctx,
+                            const EVP_AEAD_MULTIREC_PARAM *rec, size_t n)
+{
+    unsigned char tag[GCM_TAG_MAX_SIZE];
+    size_t i;
+
+    if (!ossl_prov_is_running())
+        return 0;
+    if (!ctx->key_set) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_NO_KEY_SET);
+        return 0;
+    }
+    if (!ctx->enc) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_NOT_SUPPORTED);
+        return 0;
+    }
+
+    for (i = 0; i < n; i++, rec++) {
+        if (rec->taglen == 0 || rec->taglen > GCM_TAG_MAX_SIZE) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+            return 0;
+        }
+        if (!ctx->hw->setiv(ctx, rec->iv, ctx->ivlen)
+            || !ctx->hw->oneshot(ctx, (unsigned char *)rec->aad, rec->aadlen,
+                                 rec->inp, rec->len, rec->out, tag,
+                                 GCM_TAG_MAX_SIZE)) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_CIPHER_OPERATION_FAILED);
+            ctx->iv_state = IV_STATE_FINISHED;
+            return 0;
+        }
+        memcpy(rec->out + rec->len, tag, rec->taglen);
+    }
+    ctx->iv_state = IV_STATE_FINISHED;
+    return 1;
+}
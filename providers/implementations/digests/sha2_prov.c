@@ -54,11 +54,37 @@ static int sha1_set_ctx_params(void *vctx, const OSSL_PARAM params[])
     return 0;
 }
 
+static OSSL_FUNC_digest_digest_many_fn sha1_digest_many;
+static OSSL_FUNC_digest_digest_many_fn sha256_digest_many;
+
+static int sha1_digest_many(ossl_unused void *provctx,
+                            const unsigned char *const *in, const size_t *inl,
+                            size_t num, unsigned char *out, size_t outsz)
+{
+    if (!ossl_prov_is_running() || outsz / SHA_DIGEST_LENGTH < num)
+        return 0;
+    return ossl_sha1_digest_many(in, inl, num, out);
+}
+
+static int sha256_digest_many(ossl_unused void *provctx,
+                              const unsigned char *const *in,
+                              const size_t *inl, size_t num,
+                              unsigned char *out, size_t outsz)
+{
+    if (!ossl_prov_is_running() || outsz / SHA256_DIGEST_LENGTH < num)
+        return 0;
+    return ossl_sha256_digest_many(in, inl, num, out);
+}
+
 /* ossl_sha1_functions */
-IMPLEMENT_digest_functions_with_settable_ctx(
+PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_START(
     sha1, SHA_CTX, SHA_CBLOCK, SHA_DIGEST_LENGTH, SHA2_FLAGS,
-    SHA1_Init, SHA1_Update, SHA1_Final,
-    sha1_settable_ctx_params, sha1_set_ctx_params)
+    SHA1_Init, SHA1_Update, SHA1_Final),
+{ OSSL_FUNC_DIGEST_SETTABLE_CTX_PARAMS,
+  (void (*)(void))sha1_settable_ctx_params },
+{ OSSL_FUNC_DIGEST_SET_CTX_PARAMS, (void (*)(void))sha1_set_ctx_params },
+{ OSSL_FUNC_DIGEST_DIGEST_MANY, (void (*)(void))sha1_digest_many },
+PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_END
 
 /* ossl_sha224_functions */
 IMPLEMENT_digest_functions(sha224, SHA256_CTX,
@@ -66,9 +92,11 @@ IMPLEMENT_digest_functions(sha224, SHA256_CTX,
                            SHA224_Init, SHA224_Update, SHA224_Final)
 
 /* ossl_sha256_functions */
-IMPLEMENT_digest_functions(sha256, SHA256_CTX,
-                           SHA256_CBLOCK, SHA256_DIGEST_LENGTH, SHA2_FLAGS,
-                           SHA256_Init, SHA256_Update, SHA256_Final)
+PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_START(
+    sha256, SHA256_CTX, SHA256_CBLOCK, SHA256_DIGEST_LENGTH, SHA2_FLAGS,
+    SHA256_Init, SHA256_Update, SHA256_Final),
+{ OSSL_FUNC_DIGEST_DIGEST_MANY, (void (*)(void))sha256_digest_many },
+PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_END
 
 /* ossl_sha384_functions */
 IMPLEMENT_digest_functions(sha384, SHA512_CTX,
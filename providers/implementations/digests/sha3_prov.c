@@ -221,10 +221,23 @@ static void *uname##_newctx(void *provctx)                                     \
     return ctx;                                                                \
 }
 
+#define KECCAK_digest_many(name, bitlen, pad, dgstsize)                        \
+static OSSL_FUNC_digest_digest_many_fn name##_digest_many;                     \
+static int name##_digest_many(ossl_unused void *provctx,                       \
+                              const unsigned char *const *in,                  \
+                              const size_t *inl, size_t num,                   \
+                              unsigned char *out, size_t outsz)                \
+{                                                                              \
+    if (!ossl_prov_is_running() || outsz / (dgstsize) < num)                   \
+        return 0;                                                              \
+    return ossl_sha3_digest_many(pad, bitlen, dgstsize, in, inl, num, out);    \
+}
+
 #define PROV_FUNC_SHA3_DIGEST_COMMON(name, bitlen, blksize, dgstsize, flags)   \
 PROV_FUNC_DIGEST_GET_PARAM(name, blksize, dgstsize, flags)                     \
 const OSSL_DISPATCH ossl_##name##_functions[] = {                              \
     { OSSL_FUNC_DIGEST_NEWCTX, (void (*)(void))name##_newctx },                \
+    { OSSL_FUNC_DIGEST_DIGEST_MANY, (void (*)(void))name##_digest_many },      \
     { OSSL_FUNC_DIGEST_INIT, (void (*)(void))keccak_init },                    \
     { OSSL_FUNC_DIGEST_UPDATE, (void (*)(void))keccak_update },                \
     { OSSL_FUNC_DIGEST_FINAL, (void (*)(void))keccak_final },                  \
@@ -289,17 +302,21 @@ static int shake_set_ctx_params(void *vctx, const OSSL_PARAM params[])
 
 #define IMPLEMENT_SHA3_functions(bitlen)                                       \
     SHA3_newctx(sha3, SHA3_##bitlen, sha3_##bitlen, bitlen, '\x06')            \
+    KECCAK_digest_many(sha3_##bitlen, bitlen, '\x06', SHA3_MDSIZE(bitlen))    \
     PROV_FUNC_SHA3_DIGEST(sha3_##bitlen, bitlen,                               \
                           SHA3_BLOCKSIZE(bitlen), SHA3_MDSIZE(bitlen),         \
                           SHA3_FLAGS)
 
 #define IMPLEMENT_SHAKE_functions(bitlen)                                      \
     SHA3_newctx(shake, SHAKE_##bitlen, shake_##bitlen, bitlen, '\x1f')         \
+    KECCAK_digest_many(shake_##bitlen, bitlen, '\x1f', SHA3_MDSIZE(bitlen))   \
     PROV_FUNC_SHAKE_DIGEST(shake_##bitlen, bitlen,                             \
                           SHA3_BLOCKSIZE(bitlen), SHA3_MDSIZE(bitlen),         \
                           SHAKE_FLAGS)
 #define IMPLEMENT_KMAC_functions(bitlen)                                       \
     KMAC_newctx(keccak_kmac_##bitlen, bitlen, '\x04')                          \
+    KECCAK_digest_many(keccak_kmac_##bitlen, bitlen, '\x04',                   \
+                       KMAC_MDSIZE(bitlen))                                    \
     PROV_FUNC_SHAKE_DIGEST(keccak_kmac_##bitlen, bitlen,                       \
                            SHA3_BLOCKSIZE(bitlen), KMAC_MDSIZE(bitlen),        \
                            KMAC_FLAGS)
@@ -17,6 +17,8 @@ typedef struct prov_gcm_hw_st PROV_GCM_HW;
 #define GCM_IV_MAX_SIZE     (1024 / 8)
 #define GCM_TAG_MAX_SIZE    16
 
+#define GCM_FLAGS (AEAD_FLAGS | PROV_CIPHER_FLAG_AEAD_MULTIREC)
+
 #if defined(OPENSSL_CPUID_OBJ) && defined(__s390__)
 /*-
  * KMA-GCM-AES parameter block - begin
@@ -106,6 +108,7 @@ OSSL_FUNC_cipher_encrypt_init_fn ossl_gcm_einit;
 OSSL_FUNC_cipher_decrypt_init_fn ossl_gcm_dinit;
 OSSL_FUNC_cipher_get_ctx_params_fn ossl_gcm_get_ctx_params;
 OSSL_FUNC_cipher_set_ctx_params_fn ossl_gcm_set_ctx_params;
+OSSL_FUNC_cipher_settable_ctx_params_fn ossl_gcm_settable_ctx_params;
 OSSL_FUNC_cipher_cipher_fn ossl_gcm_cipher;
 OSSL_FUNC_cipher_update_fn ossl_gcm_stream_update;
 OSSL_FUNC_cipher_final_fn ossl_gcm_stream_final;
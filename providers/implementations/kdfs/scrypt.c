@@ -17,6 +17,7 @@
 #include <openssl/proverr.h>
 #include "crypto/evp.h"
 #include "internal/numbers.h"
+#include "internal/thread.h"
 #include "prov/implementations.h"
 #include "prov/provider_ctx.h"
 #include "prov/providercommon.h"
@@ -402,16 +403,40 @@ static void scryptROMix(unsigned char *B, uint64_t r, uint64_t N,
 
 #define SCRYPT_PR_MAX   ((1 << 30) - 1)
 
+/*
+ * The p lanes of scrypt are independent. With worker threads available in
+ * the library context each thread mixes every |step|th lane starting at
+ * |first|, using its own X, T and V buffers.
+ */
+typedef struct {
+    unsigned char *B;
+    uint64_t r, N, p;
+    uint64_t first, step;
+    uint32_t *X;
+} SCRYPT_LANES;
+
+static void scrypt_lanes(void *arg)
+{
+    SCRYPT_LANES *l = arg;
+    uint32_t *T = l->X + 32 * l->r;
+    uint32_t *V = T + 32 * l->r;
+    uint64_t i;
+
+    for (i = l->first; i < l->p; i += l->step)
+        scryptROMix(l->B + 128 * l->r * i, l->r, l->N, l->X, T, V);
+}
+
 static int scrypt_alg(const char *pass, size_t passlen,
                       const unsigned char *salt, size_t saltlen,
                       uint64_t N, uint64_t r, uint64_t p, uint64_t maxmem,
                       unsigned char *key, size_t keylen, EVP_MD *sha256,
                       OSSL_LIB_CTX *libctx, const char *propq)
 {
-    int rv = 0;
+    int rv = 0, joined = 1;
     unsigned char *B;
-    uint32_t *X, *V, *T;
-    uint64_t i, Blen, Vlen;
+    uint64_t i, Blen, Vlen, nthreads = 1;
+    SCRYPT_LANES one, *lanes = &one;
+    OSSL_CRYPTO_THREAD **threads = NULL;
 
     /* Sanity check parameters */
     /* initial check, r,p must be non zero, N >= 2 and a power of 2 */
@@ -482,20 +507,57 @@ static int scrypt_alg(const char *pass, size_t passlen,
     if (key == NULL)
         return 1;
 
-    B = OPENSSL_malloc((size_t)(Blen + Vlen));
+    /*
+     * Use as many threads as there are lanes, if available, as long as the
+     * extra V buffers fit into the memory limit.
+     */
+    if (p > 1) {
+        nthreads = ossl_get_avail_threads(libctx) + 1;
+        if (nthreads > p || nthreads == 0)
+            nthreads = p;
+        if (nthreads > (maxmem - Blen) / Vlen)
+            nthreads = (maxmem - Blen) / Vlen;
+        if (nthreads > 1) {
+            lanes = OPENSSL_malloc(nthreads * sizeof(*lanes));
+            threads = OPENSSL_zalloc(nthreads * sizeof(*threads));
+            if (lanes == NULL || threads == NULL) {
+                OPENSSL_free(lanes);
+                lanes = &one;
+                nthreads = 1;
+            }
+        }
+    }
+
+    B = OPENSSL_malloc((size_t)(Blen + nthreads * Vlen));
     if (B == NULL) {
         ERR_raise(ERR_LIB_EVP, ERR_R_MALLOC_FAILURE);
-        return 0;
+        goto end;
     }
-    X = (uint32_t *)(B + Blen);
-    T = X + 32 * r;
-    V = T + 32 * r;
     if (pkcs5_pbkdf2_hmac_ex(pass, passlen, salt, saltlen, 1, sha256, (int)Blen,
                              B, libctx, propq) == 0)
         goto err;
 
-    for (i = 0; i < p; i++)
-        scryptROMix(B + 128 * r * i, r, N, X, T, V);
+    for (i = 0; i < nthreads; i++) {
+        lanes[i].B = B;
+        lanes[i].r = r;
+        lanes[i].N = N;
+        lanes[i].p = p;
+        lanes[i].first = i;
+        lanes[i].step = nthreads;
+        lanes[i].X = (uint32_t *)(B + Blen + i * Vlen);
+    }
+    for (i = 1; i < nthreads; i++)
+        threads[i] = ossl_crypto_thread_start(libctx, scrypt_lanes, &lanes[i]);
+    scrypt_lanes(&lanes[0]);
+    for (i = 1; i < nthreads; i++) {
+        /* Do the lanes of any thread that could not be started here */
+        if (threads[i] == NULL)
+            scrypt_lanes(&lanes[i]);
+        else if (!ossl_crypto_thread_join(threads[i]))
+            joined = 0;
+    }
+    if (!joined)
+        goto err;
 
     if (pkcs5_pbkdf2_hmac_ex(pass, passlen, B, (int)Blen, 1, sha256, keylen,
                              key, libctx, propq) == 0)
@@ -505,7 +567,11 @@ static int scrypt_alg(const char *pass, size_t passlen,
     if (rv == 0)
         ERR_raise(ERR_LIB_EVP, EVP_R_PBKDF2_ERROR);
 
-    OPENSSL_clear_free(B, (size_t)(Blen + Vlen));
+    OPENSSL_clear_free(B, (size_t)(Blen + nthreads * Vlen));
+ end:
+    if (lanes != &one)
+        OPENSSL_free(lanes);
+    OPENSSL_free(threads);
     return rv;
 }
 
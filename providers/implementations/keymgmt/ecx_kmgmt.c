@@ -384,6 +384,7 @@ static int ecx_set_params(void *key, const OSSL_PARAM params[])
         OPENSSL_clear_free(ecxkey->privkey, ecxkey->keylen);
         ecxkey->privkey = NULL;
         ecxkey->haspubkey = 1;
+        ossl_ecx_key_clear_precomp(ecxkey);
     }
     p = OSSL_PARAM_locate_const(params, OSSL_PKEY_PARAM_PROPERTIES);
     if (p != NULL) {
@@ -0,0 +1,366 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * HMAC low level APIs are deprecated for public use, but still ok for internal
+ * use.
+ */
+#include "internal/deprecated.h"
+
+#include <string.h>
+
+#include <openssl/crypto.h>
+#include <openssl/hmac.h>
+
+#include "internal/refcount.h"
+#include "crypto/hmac/hmac_local.h"
+#include "hmac_fips.h"
+
+#ifdef FIPS_MODULE
+
+/* The FIPS module uses the validated HMAC_CTX implementation as is */
+struct prov_hmac_st {
+    HMAC_CTX *ctx;
+    /* Copy of the raw key for TLS HMAC */
+    unsigned char *key;
+    size_t keylen;
+};
+
+PROV_HMAC *ossl_prov_hmac_new(void)
+{
+    PROV_HMAC *hmac = OPENSSL_zalloc(sizeof(*hmac));
+
+    if (hmac == NULL)
+        return NULL;
+    if ((hmac->ctx = HMAC_CTX_new()) == NULL) {
+        OPENSSL_free(hmac);
+        return NULL;
+    }
+    return hmac;
+}
+
+void ossl_prov_hmac_free(PROV_HMAC *hmac)
+{
+    if (hmac != NULL) {
+        HMAC_CTX_free(hmac->ctx);
+        OPENSSL_secure_clear_free(hmac->key, hmac->keylen);
+        OPENSSL_free(hmac);
+    }
+}
+
+PROV_HMAC *ossl_prov_hmac_dup(const PROV_HMAC *src)
+{
+    PROV_HMAC *dst = ossl_prov_hmac_new();
+
+    if (dst == NULL)
+        return NULL;
+    if (!HMAC_CTX_copy(dst->ctx, src->ctx)) {
+        ossl_prov_hmac_free(dst);
+        return NULL;
+    }
+    if (src->key != NULL) {
+        /* There is no "secure" OPENSSL_memdup */
+        dst->key = OPENSSL_secure_malloc(src->keylen > 0 ? src->keylen : 1);
+        if (dst->key == NULL) {
+            ossl_prov_hmac_free(dst);
+            return NULL;
+        }
+        memcpy(dst->key, src->key, src->keylen);
+        dst->keylen = src->keylen;
+    }
+    return dst;
+}
+
+int ossl_prov_hmac_set_key(PROV_HMAC *hmac, const unsigned char *key,
+                           size_t keylen, const EVP_MD *md, ENGINE *engine)
+{
+    if (hmac->key != NULL)
+        OPENSSL_secure_clear_free(hmac->key, hmac->keylen);
+    hmac->keylen = 0;
+    /* Keep a copy of the key in case we need it for TLS HMAC */
+    hmac->key = OPENSSL_secure_malloc(keylen > 0 ? keylen : 1);
+    if (hmac->key == NULL)
+        return 0;
+    if (keylen > 0)
+        memcpy(hmac->key, key, keylen);
+    hmac->keylen = keylen;
+
+    return HMAC_Init_ex(hmac->ctx, key, keylen, md, engine);
+}
+
+int ossl_prov_hmac_reinit(PROV_HMAC *hmac)
+{
+    return HMAC_Init_ex(hmac->ctx, NULL, 0, NULL, NULL);
+}
+
+const unsigned char *ossl_prov_hmac_get0_key(const PROV_HMAC *hmac,
+                                             size_t *keylen)
+{
+    *keylen = hmac->keylen;
+    return hmac->key;
+}
+
+void ossl_prov_hmac_set_flags(PROV_HMAC *hmac, unsigned long flags)
+{
+    HMAC_CTX_set_flags(hmac->ctx, flags);
+}
+
+size_t ossl_prov_hmac_size(const PROV_HMAC *hmac)
+{
+    return HMAC_size(hmac->ctx);
+}
+
+int ossl_prov_hmac_update(PROV_HMAC *hmac, const unsigned char *data,
+                          size_t datalen)
+{
+    return HMAC_Update(hmac->ctx, data, datalen);
+}
+
+int ossl_prov_hmac_final(PROV_HMAC *hmac, unsigned char *out,
+                         unsigned int *outl)
+{
+    return HMAC_Final(hmac->ctx, out, outl);
+}
+
+#else /* FIPS_MODULE */
+
+/*
+ * A prepared HMAC key: the digest states after absorbing the inner and the
+ * outer padded key, which are all that is needed to start a new MAC with the
+ * key.  They are never modified once set up, so states duplicated from one
+ * another share them and only need to copy their running digest state.
+ */
+typedef struct hmac_key_st {
+    CRYPTO_RWLOCK *lock;
+    CRYPTO_REF_COUNT refcnt;
+    EVP_MD_CTX *i_ctx;
+    EVP_MD_CTX *o_ctx;
+    /* Copy of the raw key for TLS HMAC */
+    unsigned char *key;
+    size_t keylen;
+} HMAC_KEY;
+
+struct prov_hmac_st {
+    HMAC_KEY *hkey;              /* Prepared key, shared with duplicates */
+    EVP_MD_CTX *md_ctx;          /* Running digest state */
+    unsigned long md_flags;      /* EVP_MD_CTX flags for |md_ctx| */
+};
+
+static void hmac_key_free(HMAC_KEY *hkey)
+{
+    int ref = 0;
+
+    if (hkey == NULL)
+        return;
+
+    CRYPTO_DOWN_REF(&hkey->refcnt, &ref, hkey->lock);
+    if (ref > 0)
+        return;
+
+    EVP_MD_CTX_free(hkey->i_ctx);
+    EVP_MD_CTX_free(hkey->o_ctx);
+    OPENSSL_secure_clear_free(hkey->key, hkey->keylen);
+    CRYPTO_THREAD_lock_free(hkey->lock);
+    OPENSSL_free(hkey);
+}
+
+static HMAC_KEY *hmac_key_new(const unsigned char *key, size_t keylen)
+{
+    HMAC_KEY *hkey = OPENSSL_zalloc(sizeof(*hkey));
+
+    if (hkey == NULL)
+        return NULL;
+    hkey->refcnt = 1;
+    if ((hkey->lock = CRYPTO_THREAD_lock_new()) == NULL
+        /* There is no "secure" OPENSSL_memdup */
+        || (hkey->key = OPENSSL_secure_malloc(keylen > 0 ? keylen : 1)) == NULL
+        || (hkey->i_ctx = EVP_MD_CTX_new()) == NULL
+        || (hkey->o_ctx = EVP_MD_CTX_new()) == NULL) {
+        hmac_key_free(hkey);
+        return NULL;
+    }
+    if (keylen > 0)
+        memcpy(hkey->key, key, keylen);
+    hkey->keylen = keylen;
+    return hkey;
+}
+
+/*
+ * Absorb the inner and outer padded key of |hkey| into its digest states,
+ * using |tmp| to hash keys that are longer than a block.
+ */
+static int hmac_key_prepare(HMAC_KEY *hkey, const EVP_MD *md, ENGINE *engine,
+                            EVP_MD_CTX *tmp)
+{
+    unsigned char pad[HMAC_MAX_MD_CBLOCK_SIZE];
+    unsigned char keytmp[HMAC_MAX_MD_CBLOCK_SIZE];
+    unsigned int keytmp_length;
+    int i, bs, rv = 0;
+
+    /*
+     * The HMAC construction is not allowed to be used with the
+     * extendable-output functions (XOF) shake128 and shake256.
+     */
+    if ((EVP_MD_flags(md) & EVP_MD_FLAG_XOF) != 0)
+        return 0;
+
+    bs = EVP_MD_block_size(md);
+    if (bs <= 0 || bs > (int)sizeof(keytmp))
+        return 0;
+    if (hkey->keylen > (size_t)bs) {
+        if (!EVP_DigestInit_ex(tmp, md, engine)
+                || !EVP_DigestUpdate(tmp, hkey->key, hkey->keylen)
+                || !EVP_DigestFinal_ex(tmp, keytmp, &keytmp_length))
+            goto err;
+    } else {
+        memcpy(keytmp, hkey->key, hkey->keylen);
+        keytmp_length = hkey->keylen;
+    }
+    memset(&keytmp[keytmp_length], 0, bs - keytmp_length);
+
+    for (i = 0; i < bs; i++)
+        pad[i] = 0x36 ^ keytmp[i];
+    if (!EVP_DigestInit_ex(hkey->i_ctx, md, engine)
+            || !EVP_DigestUpdate(hkey->i_ctx, pad, bs))
+        goto err;
+
+    for (i = 0; i < bs; i++)
+        pad[i] = 0x5c ^ keytmp[i];
+    if (!EVP_DigestInit_ex(hkey->o_ctx, md, engine)
+            || !EVP_DigestUpdate(hkey->o_ctx, pad, bs))
+        goto err;
+    rv = 1;
+ err:
+    OPENSSL_cleanse(keytmp, sizeof(keytmp));
+    OPENSSL_cleanse(pad, sizeof(pad));
+    return rv;
+}
+
+PROV_HMAC *ossl_prov_hmac_new(void)
+{
+    PROV_HMAC *hmac = OPENSSL_zalloc(sizeof(*hmac));
+
+    if (hmac == NULL)
+        return NULL;
+    if ((hmac->md_ctx = EVP_MD_CTX_new()) == NULL) {
+        OPENSSL_free(hmac);
+        return NULL;
+    }
+    return hmac;
+}
+
+void ossl_prov_hmac_free(PROV_HMAC *hmac)
+{
+    if (hmac != NULL) {
+        EVP_MD_CTX_free(hmac->md_ctx);
+        hmac_key_free(hmac->hkey);
+        OPENSSL_free(hmac);
+    }
+}
+
+PROV_HMAC *ossl_prov_hmac_dup(const PROV_HMAC *src)
+{
+    PROV_HMAC *dst = ossl_prov_hmac_new();
+    int ref = 0;
+
+    if (dst == NULL)
+        return NULL;
+    if (EVP_MD_CTX_md(src->md_ctx) != NULL
+            && !EVP_MD_CTX_copy_ex(dst->md_ctx, src->md_ctx)) {
+        ossl_prov_hmac_free(dst);
+        return NULL;
+    }
+    dst->md_flags = src->md_flags;
+    if (src->hkey != NULL) {
+        CRYPTO_UP_REF(&src->hkey->refcnt, &ref, src->hkey->lock);
+        dst->hkey = src->hkey;
+    }
+    return dst;
+}
+
+int ossl_prov_hmac_set_key(PROV_HMAC *hmac, const unsigned char *key,
+                           size_t keylen, const EVP_MD *md, ENGINE *engine)
+{
+    HMAC_KEY *hkey;
+
+    if (md == NULL)
+        return 0;
+    if ((hkey = hmac_key_new(key, keylen)) == NULL)
+        return 0;
+    if (!hmac_key_prepare(hkey, md, engine, hmac->md_ctx)) {
+        hmac_key_free(hkey);
+        return 0;
+    }
+    hmac_key_free(hmac->hkey);
+    hmac->hkey = hkey;
+    return ossl_prov_hmac_reinit(hmac);
+}
+
+/* Start a new MAC with the current key, a single digest state copy */
+int ossl_prov_hmac_reinit(PROV_HMAC *hmac)
+{
+    if (hmac->hkey == NULL
+            || !EVP_MD_CTX_copy_ex(hmac->md_ctx, hmac->hkey->i_ctx))
+        return 0;
+    if (hmac->md_flags != 0)
+        EVP_MD_CTX_set_flags(hmac->md_ctx, hmac->md_flags);
+    return 1;
+}
+
+const unsigned char *ossl_prov_hmac_get0_key(const PROV_HMAC *hmac,
+                                             size_t *keylen)
+{
+    if (hmac->hkey == NULL) {
+        *keylen = 0;
+        return NULL;
+    }
+    *keylen = hmac->hkey->keylen;
+    return hmac->hkey->key;
+}
+
+void ossl_prov_hmac_set_flags(PROV_HMAC *hmac, unsigned long flags)
+{
+    hmac->md_flags |= flags;
+    EVP_MD_CTX_set_flags(hmac->md_ctx, flags);
+}
+
+size_t ossl_prov_hmac_size(const PROV_HMAC *hmac)
+{
+    int size;
+
+    if (hmac->hkey == NULL)
+        return 0;
+    size = EVP_MD_size(EVP_MD_CTX_md(hmac->hkey->i_ctx));
+    return size < 0 ? 0 : size;
+}
+
+int ossl_prov_hmac_update(PROV_HMAC *hmac, const unsigned char *data,
+                          size_t datalen)
+{
+    if (hmac->hkey == NULL)
+        return 0;
+    return EVP_DigestUpdate(hmac->md_ctx, data, datalen);
+}
+
+int ossl_prov_hmac_final(PROV_HMAC *hmac, unsigned char *out,
+                         unsigned int *outl)
+{
+    unsigned int hlen;
+    unsigned char buf[EVP_MAX_MD_SIZE];
+
+    if (hmac->hkey == NULL
+            || !EVP_DigestFinal_ex(hmac->md_ctx, buf, &hlen)
+            || !EVP_MD_CTX_copy_ex(hmac->md_ctx, hmac->hkey->o_ctx)
+            || !EVP_DigestUpdate(hmac->md_ctx, buf, hlen)
+            || !EVP_DigestFinal_ex(hmac->md_ctx, out, outl))
+        return 0;
+    return 1;
+}
+
+#endif /* FIPS_MODULE */
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <openssl/evp.h>
+
+/*
+ * The HMAC computation used by hmac_prov.c.  Available in hmac_fips.c, which
+ * is compiled differently depending on whether we're in the FIPS module or
+ * not: the FIPS module uses HMAC_CTX, other providers a prepared key that is
+ * shared between duplicated states.
+ */
+typedef struct prov_hmac_st PROV_HMAC;
+
+PROV_HMAC *ossl_prov_hmac_new(void);
+PROV_HMAC *ossl_prov_hmac_dup(const PROV_HMAC *src);
+void ossl_prov_hmac_free(PROV_HMAC *hmac);
+int ossl_prov_hmac_set_key(PROV_HMAC *hmac, const unsigned char *key,
+                           size_t keylen, const EVP_MD *md, ENGINE *engine);
+int ossl_prov_hmac_reinit(PROV_HMAC *hmac);
+const unsigned char *ossl_prov_hmac_get0_key(const PROV_HMAC *hmac,
+                                             size_t *keylen);
+void ossl_prov_hmac_set_flags(PROV_HMAC *hmac, unsigned long flags);
+size_t ossl_prov_hmac_size(const PROV_HMAC *hmac);
+int ossl_prov_hmac_update(PROV_HMAC *hmac, const unsigned char *data,
+                          size_t datalen);
+int ossl_prov_hmac_final(PROV_HMAC *hmac, unsigned char *out,
+                         unsigned int *outl);
@@ -7,12 +7,6 @@
  * https://www.openssl.org/source/license.html
  */
 
-/*
- * HMAC low level APIs are deprecated for public use, but still ok for internal
- * use.
- */
-#include "internal/deprecated.h"
-
 #include <string.h>
 
 #include <openssl/core_dispatch.h>
@@ -20,12 +14,12 @@
 #include <openssl/params.h>
 #include <openssl/engine.h>
 #include <openssl/evp.h>
-#include <openssl/hmac.h>
 
 #include "prov/implementations.h"
 #include "prov/provider_ctx.h"
 #include "prov/provider_util.h"
 #include "prov/providercommon.h"
+#include "hmac_fips.h"
 
 /*
  * Forward declaration of everything implemented here.  This is not strictly
@@ -48,10 +42,8 @@ static OSSL_FUNC_mac_final_fn hmac_final;
 /* typedef EVP_MAC_IMPL */
 struct hmac_data_st {
     void *provctx;
-    HMAC_CTX *ctx;               /* HMAC context */
+    PROV_HMAC *hmac;             /* HMAC state, see hmac_fips.c */
     PROV_DIGEST digest;
-    unsigned char *key;
-    size_t keylen;
     /* Length of full TLS record including the MAC and any padding */
     size_t tls_data_size;
     unsigned char tls_header[13];
@@ -79,7 +71,7 @@ static void *hmac_new(void *provctx)
         return NULL;
 
     if ((macctx = OPENSSL_zalloc(sizeof(*macctx))) == NULL
-        || (macctx->ctx = HMAC_CTX_new()) == NULL) {
+        || (macctx->hmac = ossl_prov_hmac_new()) == NULL) {
         OPENSSL_free(macctx);
         return NULL;
     }
@@ -93,9 +85,8 @@ static void hmac_free(void *vmacctx)
     struct hmac_data_st *macctx = vmacctx;
 
     if (macctx != NULL) {
-        HMAC_CTX_free(macctx->ctx);
+        ossl_prov_hmac_free(macctx->hmac);
         ossl_prov_digest_reset(&macctx->digest);
-        OPENSSL_secure_clear_free(macctx->key, macctx->keylen);
         OPENSSL_free(macctx);
     }
 }
@@ -104,33 +95,21 @@ static void *hmac_dup(void *vsrc)
 {
     struct hmac_data_st *src = vsrc;
     struct hmac_data_st *dst;
-    HMAC_CTX *ctx;
 
     if (!ossl_prov_is_running())
         return NULL;
-    dst = hmac_new(src->provctx);
+    dst = OPENSSL_malloc(sizeof(*dst));
     if (dst == NULL)
         return NULL;
 
-    ctx = dst->ctx;
     *dst = *src;
-    dst->ctx = ctx;
-    dst->key = NULL;
+    memset(&dst->digest, 0, sizeof(dst->digest));
 
-    if (!HMAC_CTX_copy(dst->ctx, src->ctx)
+    if ((dst->hmac = ossl_prov_hmac_dup(src->hmac)) == NULL
         || !ossl_prov_digest_copy(&dst->digest, &src->digest)) {
         hmac_free(dst);
         return NULL;
     }
-    if (src->key != NULL) {
-        /* There is no "secure" OPENSSL_memdup */
-        dst->key = OPENSSL_secure_malloc(src->keylen > 0 ? src->keylen : 1);
-        if (dst->key == NULL) {
-            hmac_free(dst);
-            return 0;
-        }
-        memcpy(dst->key, src->key, src->keylen);
-    }
     return dst;
 }
 
@@ -138,41 +117,34 @@ static size_t hmac_size(void *vmacctx)
 {
     struct hmac_data_st *macctx = vmacctx;
 
-    return HMAC_size(macctx->ctx);
+    return ossl_prov_hmac_size(macctx->hmac);
 }
 
 static int hmac_setkey(struct hmac_data_st *macctx,
                        const unsigned char *key, size_t keylen)
 {
-    const EVP_MD *digest;
+    const EVP_MD *digest = ossl_prov_digest_md(&macctx->digest);
 
-    if (macctx->keylen > 0)
-        OPENSSL_secure_clear_free(macctx->key, macctx->keylen);
-    /* Keep a copy of the key in case we need it for TLS HMAC */
-    macctx->key = OPENSSL_secure_malloc(keylen > 0 ? keylen : 1);
-    if (macctx->key == NULL)
+    if (digest == NULL)
         return 0;
-    memcpy(macctx->key, key, keylen);
-    macctx->keylen = keylen;
-
-    digest = ossl_prov_digest_md(&macctx->digest);
-    /* HMAC_Init_ex doesn't tolerate all zero params, so we must be careful */
-    if (key != NULL || (macctx->tls_data_size == 0 && digest != NULL))
-        return HMAC_Init_ex(macctx->ctx, key, keylen, digest,
-                            ossl_prov_digest_engine(&macctx->digest));
-    return 1;
+    return ossl_prov_hmac_set_key(macctx->hmac, key, keylen, digest,
+                                  ossl_prov_digest_engine(&macctx->digest));
 }
 
 static int hmac_init(void *vmacctx, const unsigned char *key,
                      size_t keylen, const OSSL_PARAM params[])
 {
     struct hmac_data_st *macctx = vmacctx;
+    size_t oldkeylen;
 
     if (!ossl_prov_is_running() || !hmac_set_ctx_params(macctx, params))
         return 0;
 
-    if (key != NULL && !hmac_setkey(macctx, key, keylen))
-        return 0;
+    if (key != NULL)
+        return hmac_setkey(macctx, key, keylen);
+    /* Start again with the current key, if there is one yet */
+    if (ossl_prov_hmac_get0_key(macctx->hmac, &oldkeylen) != NULL)
+        return ossl_prov_hmac_reinit(macctx->hmac);
     return 1;
 }
 
@@ -182,6 +154,9 @@ static int hmac_update(void *vmacctx, const unsigned char *data,
     struct hmac_data_st *macctx = vmacctx;
 
     if (macctx->tls_data_size > 0) {
+        const unsigned char *key;
+        size_t keylen;
+
         /* We're doing a TLS HMAC */
         if (!macctx->tls_header_set) {
             /* We expect the first update call to contain the TLS header */
@@ -194,6 +169,8 @@ static int hmac_update(void *vmacctx, const unsigned char *data,
         /* macctx->tls_data_size is datalen plus the padding length */
         if (macctx->tls_data_size < datalen)
             return 0;
+        if ((key = ossl_prov_hmac_get0_key(macctx->hmac, &keylen)) == NULL)
+            return 0;
 
         return ssl3_cbc_digest_record(ossl_prov_digest_md(&macctx->digest),
                                       macctx->tls_mac_out,
@@ -202,12 +179,12 @@ static int hmac_update(void *vmacctx, const unsigned char *data,
                                       data,
                                       datalen,
                                       macctx->tls_data_size,
-                                      macctx->key,
-                                      macctx->keylen,
+                                      key,
+                                      keylen,
                                       0);
     }
 
-    return HMAC_Update(macctx->ctx, data, datalen);
+    return ossl_prov_hmac_update(macctx->hmac, data, datalen);
 }
 
 static int hmac_final(void *vmacctx, unsigned char *out, size_t *outl,
@@ -226,7 +203,7 @@ static int hmac_final(void *vmacctx, unsigned char *out, size_t *outl,
         memcpy(out, macctx->tls_mac_out, macctx->tls_mac_out_size);
         return 1;
     }
-    if (!HMAC_Final(macctx->ctx, out, &hlen))
+    if (!ossl_prov_hmac_final(macctx->hmac, out, &hlen))
         return 0;
     *outl = hlen;
     return 1;
@@ -304,26 +281,14 @@ static int hmac_set_ctx_params(void *vmacctx, const OSSL_PARAM params[])
                   &flags))
         return 0;
     if (flags)
-        HMAC_CTX_set_flags(macctx->ctx, flags);
+        ossl_prov_hmac_set_flags(macctx->hmac, flags);
 
     if ((p = OSSL_PARAM_locate_const(params, OSSL_MAC_PARAM_KEY)) != NULL) {
         if (p->data_type != OSSL_PARAM_OCTET_STRING)
             return 0;
 
-        if (macctx->keylen > 0)
-            OPENSSL_secure_clear_free(macctx->key, macctx->keylen);
-        /* Keep a copy of the key if we need it for TLS HMAC */
-        macctx->key = OPENSSL_secure_malloc(p->data_size > 0 ? p->data_size : 1);
-        if (macctx->key == NULL)
+        if (!hmac_setkey(macctx, p->data, p->data_size))
             return 0;
-        memcpy(macctx->key, p->data, p->data_size);
-        macctx->keylen = p->data_size;
-
-        if (!HMAC_Init_ex(macctx->ctx, p->data, p->data_size,
-                          ossl_prov_digest_md(&macctx->digest),
-                          NULL /* ENGINE */))
-            return 0;
-
     }
     if ((p = OSSL_PARAM_locate_const(params,
                                      OSSL_MAC_PARAM_TLS_DATA_SIZE)) != NULL) {
@@ -50,6 +50,7 @@ static OSSL_FUNC_signature_digest_sign_fn ed25519_digest_sign;
 static OSSL_FUNC_signature_digest_sign_fn ed448_digest_sign;
 static OSSL_FUNC_signature_digest_verify_fn ed25519_digest_verify;
 static OSSL_FUNC_signature_digest_verify_fn ed448_digest_verify;
+static OSSL_FUNC_signature_digest_verify_batch_fn ed25519_digest_verify_batch;
 static OSSL_FUNC_signature_freectx_fn eddsa_freectx;
 static OSSL_FUNC_signature_dupctx_fn eddsa_dupctx;
 static OSSL_FUNC_signature_get_ctx_params_fn eddsa_get_ctx_params;
@@ -203,7 +204,7 @@ int ed25519_digest_verify(void *vpeddsactx, const unsigned char *sig,
                           size_t tbslen)
 {
     PROV_EDDSA_CTX *peddsactx = (PROV_EDDSA_CTX *)vpeddsactx;
-    const ECX_KEY *edkey = peddsactx->key;
+    ECX_KEY *edkey = peddsactx->key;
 
     if (!ossl_prov_is_running() || siglen != ED25519_SIGSIZE)
         return 0;
@@ -213,8 +214,62 @@ int ed25519_digest_verify(void *vpeddsactx, const unsigned char *sig,
         return s390x_ed25519_digestverify(edkey, sig, tbs, tbslen);
 #endif /* S390X_EC_ASM */
 
-    return ED25519_verify(tbs, tbslen, sig, edkey->pubkey, peddsactx->libctx,
-                          edkey->propq);
+    return ossl_ecx_key_ed25519_verify(tbs, tbslen, sig, edkey,
+                                       peddsactx->libctx);
+}
+
+/*
+ * The batch is checked with the cofactored verification equation, which
+ * accepts some signatures with a small order component that the cofactorless
+ * one of ed25519_digest_verify() rejects. It is only used if the caller asks
+ * for it, otherwise the signatures are verified one by one so that the result
+ * is always the same as for single verification.
+ */
+static int ed25519_digest_verify_batch(void **vpeddsactxs,
+                                       const unsigned char *const *sigs,
+                                       const size_t *siglens,
+                                       const unsigned char *const *tbs,
+                                       const size_t *tbslens, size_t num,
+                                       const OSSL_PARAM params[])
+{
+    PROV_EDDSA_CTX *peddsactx;
+    const OSSL_PARAM *p;
+    const unsigned char **pubs;
+    int cofactored = 0, ret = 0;
+    size_t i;
+
+    if (!ossl_prov_is_running())
+        return 0;
+
+    p = OSSL_PARAM_locate_const(params, OSSL_SIGNATURE_PARAM_COFACTORED);
+    if (p != NULL && !OSSL_PARAM_get_int(p, &cofactored))
+        return 0;
+
+    if (!cofactored || num < 2) {
+        for (i = 0; i < num; i++)
+            if (!ed25519_digest_verify(vpeddsactxs[i], sigs[i], siglens[i],
+                                       tbs[i], tbslens[i]))
+                return 0;
+        return 1;
+    }
+
+    pubs = OPENSSL_malloc(num * sizeof(*pubs));
+    if (pubs == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    for (i = 0; i < num; i++) {
+        if (siglens[i] != ED25519_SIGSIZE)
+            goto end;
+        peddsactx = (PROV_EDDSA_CTX *)vpeddsactxs[i];
+        pubs[i] = peddsactx->key->pubkey;
+    }
+    peddsactx = (PROV_EDDSA_CTX *)vpeddsactxs[0];
+    ret = ED25519_verify_batch(tbs, tbslens, sigs, pubs, num,
+                               peddsactx->libctx, peddsactx->key->propq);
+ end:
+    OPENSSL_free(pubs);
+    return ret;
 }
 
 int ed448_digest_verify(void *vpeddsactx, const unsigned char *sig,
@@ -309,6 +364,8 @@ const OSSL_DISPATCH ossl_ed25519_signature_functions[] = {
       (void (*)(void))eddsa_digest_signverify_init },
     { OSSL_FUNC_SIGNATURE_DIGEST_VERIFY,
       (void (*)(void))ed25519_digest_verify },
+    { OSSL_FUNC_SIGNATURE_DIGEST_VERIFY_BATCH,
+      (void (*)(void))ed25519_digest_verify_batch },
     { OSSL_FUNC_SIGNATURE_FREECTX, (void (*)(void))eddsa_freectx },
     { OSSL_FUNC_SIGNATURE_DUPCTX, (void (*)(void))eddsa_dupctx },
     { OSSL_FUNC_SIGNATURE_GET_CTX_PARAMS, (void (*)(void))eddsa_get_ctx_params },
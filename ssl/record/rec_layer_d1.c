@@ -20,7 +20,7 @@ int DTLS_RECORD_LAYER_new(RECORD_LAYER *rl)
 {
     DTLS_RECORD_LAYER *d;
 
-    if ((d = OPENSSL_malloc(sizeof(*d))) == NULL) {
+    if ((d = OPENSSL_zalloc(sizeof(*d))) == NULL) {
         ERR_raise(ERR_LIB_SSL, ERR_R_MALLOC_FAILURE);
         return 0;
     }
@@ -65,6 +65,7 @@ void DTLS_RECORD_LAYER_clear(RECORD_LAYER *rl)
     pqueue *unprocessed_rcds;
     pqueue *processed_rcds;
     pqueue *buffered_app_data;
+    size_t i;
 
     d = rl->d;
 
@@ -93,6 +94,14 @@ void DTLS_RECORD_LAYER_clear(RECORD_LAYER *rl)
         pitem_free(item);
     }
 
+    if (d->rdgram_buf != NULL) {
+        if (rl->s->options & SSL_OP_CLEANSE_PLAINTEXT)
+            OPENSSL_cleanse(d->rdgram_buf, d->rdgram_slots * d->rdgram_size);
+        OPENSSL_free(d->rdgram_buf);
+    }
+    for (i = 0; i < OSSL_NELEM(d->rdgram_peer); i++)
+        BIO_ADDR_free(d->rdgram_peer[i]);
+
     unprocessed_rcds = d->unprocessed_rcds.q;
     processed_rcds = d->processed_rcds.q;
     buffered_app_data = d->buffered_app_data.q;
@@ -102,6 +111,89 @@ void DTLS_RECORD_LAYER_clear(RECORD_LAYER *rl)
     d->buffered_app_data.q = buffered_app_data;
 }
 
+/* Set up |slots| datagram slots of |size| bytes each, plus their peers */
+static int dtls1_setup_datagrams(DTLS_RECORD_LAYER *d, size_t slots,
+                                 size_t size)
+{
+    size_t i;
+
+    OPENSSL_free(d->rdgram_buf);
+    d->rdgram_slots = 0;
+    if ((d->rdgram_buf = OPENSSL_malloc(slots * size)) == NULL)
+        return 0;
+    for (i = 0; i <= slots; i++)
+        if (d->rdgram_peer[i] == NULL
+                && (d->rdgram_peer[i] = BIO_ADDR_new()) == NULL)
+            return 0;
+    d->rdgram_slots = slots;
+    d->rdgram_size = size;
+    return 1;
+}
+
+/*
+ * Read the next datagram into |buf|, just like BIO_read(s->rbio, buf, len).
+ * If the connection reads several datagrams at once, the ones received
+ * along with the first are handed out by the following calls without going
+ * back to the BIO, and the peer address of the BIO is kept in line with the
+ * datagram handed out.
+ */
+int dtls1_read_datagram(SSL *s, unsigned char *buf, size_t len)
+{
+    DTLS_RECORD_LAYER *d = s->rlayer.d;
+    BIO_DGRAM_MSG msg[SSL_MAX_DTLS_READ_BATCH];
+    size_t i, n = s->dtls_read_batch, size, count;
+
+    if (d->rdgram_next < d->rdgram_count) {
+        i = d->rdgram_next++;
+        /* Truncate the datagram just like the socket would */
+        n = d->rdgram_len[i] < len ? d->rdgram_len[i] : len;
+        memcpy(buf, d->rdgram_buf + (i - 1) * d->rdgram_size, n);
+        (void)BIO_dgram_set_peer(s->rbio, d->rdgram_peer[i]);
+        return (int)n;
+    }
+
+    /*
+     * Only the datagram socket BIO itself is asked for several datagrams,
+     * a filter in front of it would be bypassed
+     */
+    if (n <= 1 || s->rbio == NULL
+            || BIO_method_type(s->rbio) != BIO_TYPE_DGRAM)
+        return BIO_read(s->rbio, buf, (int)len);
+
+    /*
+     * The other datagrams get slots as big as the whole read buffer, so that
+     * they are never truncated more than the first one. The slots together
+     * never take more than DTLS_READ_BATCH_MAX_MEM bytes.
+     */
+    size = SSL3_BUFFER_get_len(&s->rlayer.rbuf);
+    if (n - 1 > DTLS_READ_BATCH_MAX_MEM / size)
+        n = DTLS_READ_BATCH_MAX_MEM / size + 1;
+    if (n <= 1)
+        return BIO_read(s->rbio, buf, (int)len);
+    if ((d->rdgram_slots < n - 1 || d->rdgram_size != size)
+            && !dtls1_setup_datagrams(d, n - 1, size))
+        return BIO_read(s->rbio, buf, (int)len);
+
+    msg[0].data = buf;
+    msg[0].data_len = len;
+    msg[0].peer = d->rdgram_peer[0];
+    for (i = 1; i < n; i++) {
+        msg[i].data = d->rdgram_buf + (i - 1) * size;
+        msg[i].data_len = size;
+        msg[i].peer = d->rdgram_peer[i];
+    }
+    if (!BIO_dgram_recvmmsg(s->rbio, msg, n, &count))
+        return -1;
+
+    for (i = 1; i < count; i++)
+        d->rdgram_len[i] = msg[i].data_len;
+    d->rdgram_next = 1;
+    d->rdgram_count = count;
+    if (count > 1)
+        (void)BIO_dgram_set_peer(s->rbio, d->rdgram_peer[0]);
+    return (int)msg[0].data_len;
+}
+
 void DTLS_RECORD_LAYER_set_saved_w_epoch(RECORD_LAYER *rl, unsigned short e)
 {
     if (e == rl->d->w_epoch - 1) {
@@ -17,6 +17,12 @@
 #include "record_local.h"
 #include "internal/packet.h"
 
+/*
+ * The multiblock write path is only compiled in where the stitched
+ * AES-CBC-HMAC-SHA1/SHA256 ciphers that support it can exist at all.  Whether
+ * it's actually used is decided at run time from the cipher flags, which for
+ * provided ciphers are derived from OSSL_CIPHER_PARAM_TLS1_MULTIBLOCK.
+ */
 #if     defined(OPENSSL_SMALL_FOOTPRINT) || \
         !(      defined(AES_ASM) &&     ( \
                 defined(__x86_64)       || defined(__x86_64__)  || \
@@ -77,7 +83,9 @@ void RECORD_LAYER_release(RECORD_LAYER *rl)
 /* Checks if we have unprocessed read ahead data pending */
 int RECORD_LAYER_read_pending(const RECORD_LAYER *rl)
 {
-    return SSL3_BUFFER_get_left(&rl->rbuf) != 0;
+    /* DTLS may also hold datagrams that were read ahead of the current one */
+    return SSL3_BUFFER_get_left(&rl->rbuf) != 0
+           || (rl->d != NULL && rl->d->rdgram_next < rl->d->rdgram_count);
 }
 
 /* Checks if we have decrypted unread record data pending */
@@ -296,7 +304,10 @@ int ssl3_read_n(SSL *s, size_t n, size_t max, int extend, int clearold,
         if (s->rbio != NULL) {
             s->rwstate = SSL_READING;
             /* TODO(size_t): Convert this function */
-            ret = BIO_read(s->rbio, pkt + len + left, max - left);
+            if (SSL_IS_DTLS(s))
+                ret = dtls1_read_datagram(s, pkt + len + left, max - left);
+            else
+                ret = BIO_read(s->rbio, pkt + len + left, max - left);
             if (ret >= 0)
                 bioread = ret;
             if (ret <= 0
@@ -573,7 +584,10 @@ int ssl3_write_bytes(SSL *s, int type, const void *buf_, size_t len,
      * If max_pipelines is 0 then this means "undefined" and we default to
      * 1 pipeline. Similarly if the cipher does not support pipelined
      * processing then we also only use 1 pipeline, or if we're not using
-     * explicit IVs
+     * explicit IVs.  In TLSv1.3 every record has its own nonce, so
+     * application data can be pipelined with any cipher that can encrypt
+     * several records in one call, see tls13_enc().  This isn't compatible
+     * with kernel TLS though.
      */
     maxpipes = s->max_pipelines;
     if (maxpipes > SSL_MAX_PIPELINES) {
@@ -584,11 +598,16 @@ int ssl3_write_bytes(SSL *s, int type, const void *buf_, size_t len,
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
         return -1;
     }
-    if (maxpipes == 0
-        || s->enc_write_ctx == NULL
-        || !(EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(s->enc_write_ctx))
-             & EVP_CIPH_FLAG_PIPELINE)
-        || !SSL_USE_EXPLICIT_IV(s))
+    if (maxpipes == 0 || s->enc_write_ctx == NULL)
+        maxpipes = 1;
+    else if (SSL_TREAT_AS_TLS13(s)
+             ? (type != SSL3_RT_APPLICATION_DATA
+                || BIO_get_ktls_send(s->wbio)
+                || !(EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(s->enc_write_ctx))
+                     & EVP_CIPH_FLAG_AEAD_MULTIREC))
+             : (!(EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(s->enc_write_ctx))
+                  & EVP_CIPH_FLAG_PIPELINE)
+                || !SSL_USE_EXPLICIT_IV(s)))
         maxpipes = 1;
     if (max_send_fragment == 0 || split_send_fragment == 0
         || split_send_fragment > max_send_fragment) {
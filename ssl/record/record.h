@@ -116,6 +116,19 @@ typedef struct dtls_record_layer_st {
     /* save last and current sequence numbers for retransmissions */
     unsigned char last_write_sequence[8];
     unsigned char curr_write_sequence[8];
+    /*
+     * Datagrams received by the same BIO_dgram_recvmmsg() call as the one being
+     * processed. Datagram i (for i > 0) is kept in the slot of |rdgram_size|
+     * bytes at rdgram_buf + (i - 1) * rdgram_size. Datagrams |rdgram_next|
+     * up to |rdgram_count| have not been handed to the record layer yet.
+     */
+    unsigned char *rdgram_buf;
+    size_t rdgram_size;
+    size_t rdgram_slots;
+    size_t rdgram_next;
+    size_t rdgram_count;
+    size_t rdgram_len[SSL_MAX_DTLS_READ_BATCH];
+    BIO_ADDR *rdgram_peer[SSL_MAX_DTLS_READ_BATCH];
 } DTLS_RECORD_LAYER;
 
 /*****************************************************************************
@@ -186,6 +199,9 @@ typedef struct ssl_mac_buf_st SSL_MAC_BUF;
 
 #define MIN_SSL2_RECORD_LEN     9
 
+/* The most memory a DTLS connection uses for datagrams read in a batch */
+#define DTLS_READ_BATCH_MAX_MEM (1024 * 1024)
+
 #define RECORD_LAYER_set_read_ahead(rl, ra)     ((rl)->read_ahead = (ra))
 #define RECORD_LAYER_get_read_ahead(rl)         ((rl)->read_ahead)
 #define RECORD_LAYER_get_packet(rl)             ((rl)->packet)
@@ -44,6 +44,7 @@ DTLS1_BITMAP *dtls1_get_bitmap(SSL *s, SSL3_RECORD *rr,
 int dtls1_process_buffered_records(SSL *s);
 int dtls1_retrieve_buffered_record(SSL *s, record_pqueue *queue);
 int dtls1_buffer_record(SSL *s, record_pqueue *q, unsigned char *priority);
+int dtls1_read_datagram(SSL *s, unsigned char *buf, size_t len);
 void ssl3_record_sequence_update(unsigned char *seq);
 
 /* Functions provided by the DTLS1_BITMAP component */
@@ -1,5 +1,5 @@
 /*
- * Copyright 1995-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 1995-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -34,6 +34,166 @@ void SSL3_BUFFER_release(SSL3_BUFFER *b)
     b->buf = NULL;
 }
 
+/*
+ * The SSL_CTX buffer pool. Idle record buffers are kept on per-length free
+ * lists, linked through the first bytes of the buffers themselves, so that
+ * connections which repeatedly release and reacquire their buffers (e.g. with
+ * SSL_MODE_RELEASE_BUFFERS) do not have to go back to the allocator each time.
+ */
+int ssl_buffer_pool_init(SSL_CTX *ctx)
+{
+    size_t i;
+
+    for (i = 0; i < SSL_BUFFER_POOL_SHARDS; i++) {
+        ctx->buffer_pool[i].lock = CRYPTO_THREAD_lock_new();
+        if (ctx->buffer_pool[i].lock == NULL)
+            return 0;
+    }
+    return 1;
+}
+
+/* Free buffers from |cls| until no more than |max| remain. */
+static void buffer_pool_class_trim(SSL_BUFFER_POOL_CLASS *cls, size_t max)
+{
+    void *buf;
+
+    while (cls->num > max) {
+        buf = cls->head;
+        cls->head = *(void **)buf;
+        cls->num--;
+        OPENSSL_free(buf);
+    }
+    if (cls->num == 0)
+        cls->len = 0;
+}
+
+void ssl_buffer_pool_cleanup(SSL_CTX *ctx)
+{
+    size_t i, j;
+
+    for (i = 0; i < SSL_BUFFER_POOL_SHARDS; i++) {
+        for (j = 0; j < SSL_BUFFER_POOL_CLASSES; j++)
+            buffer_pool_class_trim(&ctx->buffer_pool[i].classes[j], 0);
+        CRYPTO_THREAD_lock_free(ctx->buffer_pool[i].lock);
+        ctx->buffer_pool[i].lock = NULL;
+    }
+}
+
+/*
+ * Split |size| between the shards so that, for each buffer length, they never
+ * hold more than |size| idle buffers between them.
+ */
+void ssl_buffer_pool_set_size(SSL_CTX *ctx, size_t size)
+{
+    SSL_BUFFER_POOL_SHARD *shard;
+    size_t i, j;
+
+    tsan_store(&ctx->buffer_pool_size, (long)size);
+    for (i = 0; i < SSL_BUFFER_POOL_SHARDS; i++) {
+        shard = &ctx->buffer_pool[i];
+        if (!CRYPTO_THREAD_write_lock(shard->lock))
+            continue;
+        shard->max = size / SSL_BUFFER_POOL_SHARDS
+                     + (i < size % SSL_BUFFER_POOL_SHARDS ? 1 : 0);
+        for (j = 0; j < SSL_BUFFER_POOL_CLASSES; j++)
+            buffer_pool_class_trim(&shard->classes[j], shard->max);
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+}
+
+size_t ssl_buffer_pool_num(SSL_CTX *ctx)
+{
+    SSL_BUFFER_POOL_SHARD *shard;
+    size_t i, j, num = 0;
+
+    for (i = 0; i < SSL_BUFFER_POOL_SHARDS; i++) {
+        shard = &ctx->buffer_pool[i];
+        if (!CRYPTO_THREAD_read_lock(shard->lock))
+            continue;
+        for (j = 0; j < SSL_BUFFER_POOL_CLASSES; j++)
+            num += shard->classes[j].num;
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+    return num;
+}
+
+/* Get a buffer of |len| bytes, from the pool if possible */
+static unsigned char *buffer_pool_get(SSL *s, size_t len)
+{
+    SSL_CTX *ctx = s->ctx;
+    SSL_BUFFER_POOL_SHARD *shard;
+    SSL_BUFFER_POOL_CLASS *cls;
+    void *buf = NULL;
+    size_t i;
+
+    if (tsan_load(&ctx->buffer_pool_size) == 0)
+        return OPENSSL_malloc(len);
+
+    shard = &ctx->buffer_pool[s->buffer_pool_shard];
+    if (CRYPTO_THREAD_write_lock(shard->lock)) {
+        for (i = 0; i < SSL_BUFFER_POOL_CLASSES; i++) {
+            cls = &shard->classes[i];
+            if (cls->len == len && cls->num > 0) {
+                buf = cls->head;
+                cls->head = *(void **)buf;
+                if (--cls->num == 0)
+                    cls->len = 0;
+                break;
+            }
+        }
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+
+    if (buf != NULL) {
+        tsan_counter(&ctx->stats.buffer_pool_hit);
+        return buf;
+    }
+    tsan_counter(&ctx->stats.buffer_pool_miss);
+    return OPENSSL_malloc(len);
+}
+
+/* Return a buffer of |len| bytes to the pool, or free it if the pool is full */
+static void buffer_pool_put(SSL *s, unsigned char *buf, size_t len)
+{
+    SSL_CTX *ctx = s->ctx;
+    SSL_BUFFER_POOL_SHARD *shard;
+    SSL_BUFFER_POOL_CLASS *cls = NULL, *unused = NULL;
+    size_t i;
+
+    if (buf == NULL)
+        return;
+    if (tsan_load(&ctx->buffer_pool_size) == 0 || len < sizeof(void *)) {
+        OPENSSL_free(buf);
+        return;
+    }
+
+    shard = &ctx->buffer_pool[s->buffer_pool_shard];
+    if (!CRYPTO_THREAD_write_lock(shard->lock)) {
+        OPENSSL_free(buf);
+        return;
+    }
+    for (i = 0; i < SSL_BUFFER_POOL_CLASSES; i++) {
+        if (shard->classes[i].len == len) {
+            cls = &shard->classes[i];
+            break;
+        }
+        if (unused == NULL && shard->classes[i].num == 0)
+            unused = &shard->classes[i];
+    }
+    if (cls == NULL)
+        cls = unused;
+    if (cls != NULL && cls->num < shard->max) {
+        cls->len = len;
+        *(void **)buf = cls->head;
+        cls->head = buf;
+        cls->num++;
+        buf = NULL;
+    }
+    CRYPTO_THREAD_unlock(shard->lock);
+
+    OPENSSL_free(buf);
+}
+
 int ssl3_setup_read_buffer(SSL *s)
 {
     unsigned char *p;
@@ -60,7 +220,7 @@ int ssl3_setup_read_buffer(SSL *s)
 #endif
         if (b->default_len > len)
             len = b->default_len;
-        if ((p = OPENSSL_malloc(len)) == NULL) {
+        if ((p = buffer_pool_get(s, len)) == NULL) {
             /*
              * We've got a malloc failure, and we're still initialising buffers.
              * We assume we're so doomed that we won't even be able to send an
@@ -111,13 +271,14 @@ int ssl3_setup_write_buffer(SSL *s, size_t numwpipes, size_t len)
         SSL3_BUFFER *thiswb = &wb[currpipe];
 
         if (thiswb->len != len) {
-            OPENSSL_free(thiswb->buf);
+            if (!SSL3_BUFFER_is_app_buffer(thiswb))
+                buffer_pool_put(s, thiswb->buf, thiswb->len);
             thiswb->buf = NULL;         /* force reallocation */
         }
 
         if (thiswb->buf == NULL) {
             if (s->wbio == NULL || !BIO_get_ktls_send(s->wbio)) {
-                p = OPENSSL_malloc(len);
+                p = buffer_pool_get(s, len);
                 if (p == NULL) {
                     s->rlayer.numwpipes = currpipe;
                     /*
@@ -165,7 +326,7 @@ int ssl3_release_write_buffer(SSL *s)
         if (SSL3_BUFFER_is_app_buffer(wb))
             SSL3_BUFFER_set_app_buffer(wb, 0);
         else
-            OPENSSL_free(wb->buf);
+            buffer_pool_put(s, wb->buf, wb->len);
         wb->buf = NULL;
         pipes--;
     }
@@ -180,7 +341,7 @@ int ssl3_release_read_buffer(SSL *s)
     b = RECORD_LAYER_get_rbuf(&s->rlayer);
     if (s->options & SSL_OP_CLEANSE_PLAINTEXT)
         OPENSSL_cleanse(b->buf, b->len);
-    OPENSSL_free(b->buf);
+    buffer_pool_put(s, b->buf, b->len);
     b->buf = NULL;
     return 1;
 }
@@ -7,15 +7,175 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <openssl/core_names.h>
 #include "../ssl_local.h"
 #include "record_local.h"
 #include "internal/cryptlib.h"
 
+/*
+ * Sets |iv| to the nonce for the next record, computed from |staticiv| and the
+ * sequence number |seq|, and then increments |seq|.
+ */
+static int tls13_next_nonce(unsigned char *iv, const unsigned char *staticiv,
+                            size_t ivlen, unsigned char *seq)
+{
+    size_t offset = ivlen - SEQ_NUM_SIZE, loop;
+
+    memcpy(iv, staticiv, offset);
+    for (loop = 0; loop < SEQ_NUM_SIZE; loop++)
+        iv[offset + loop] = staticiv[offset + loop] ^ seq[loop];
+
+    /* Increment the sequence counter */
+    for (loop = SEQ_NUM_SIZE; loop > 0; loop--) {
+        ++seq[loop - 1];
+        if (seq[loop - 1] != 0)
+            break;
+    }
+    /* Fail if the sequence has wrapped */
+    return loop != 0;
+}
+
+/* Writes the record header of |rec|, which is used as the AAD, to |recheader| */
+static int tls13_record_header(unsigned char *recheader, const SSL3_RECORD *rec,
+                               size_t taglen)
+{
+    size_t hdrlen;
+    WPACKET wpkt;
+
+    if (!WPACKET_init_static_len(&wpkt, recheader, SSL3_RT_HEADER_LENGTH, 0)
+            || !WPACKET_put_bytes_u8(&wpkt, rec->type)
+            || !WPACKET_put_bytes_u16(&wpkt, rec->rec_version)
+            || !WPACKET_put_bytes_u16(&wpkt, rec->length + taglen)
+            || !WPACKET_get_total_written(&wpkt, &hdrlen)
+            || hdrlen != SSL3_RT_HEADER_LENGTH
+            || !WPACKET_finish(&wpkt)) {
+        WPACKET_cleanup(&wpkt);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Encrypts/decrypts the single record |rec| with |ctx|, using (and then
+ * incrementing) the sequence number |seq|.
+ */
+static int tls13_enc_record(SSL *s, EVP_CIPHER_CTX *ctx, SSL3_RECORD *rec,
+                            const unsigned char *staticiv, size_t ivlen,
+                            unsigned char *seq, uint32_t alg_enc,
+                            size_t taglen, int sending)
+{
+    unsigned char iv[EVP_MAX_IV_LENGTH], recheader[SSL3_RT_HEADER_LENGTH];
+    int lenu, lenf;
+
+    if (!sending) {
+        /*
+         * Take off tag. There must be at least one byte of content type as
+         * well as the tag
+         */
+        if (rec->length < taglen + 1)
+            return 0;
+        rec->length -= taglen;
+    }
+
+    if (!tls13_next_nonce(iv, staticiv, ivlen, seq))
+        return 0;
+
+    /* TODO(size_t): lenu/lenf should be a size_t but EVP doesn't support it */
+    if (EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, sending) <= 0
+            || (!sending && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
+                                             taglen,
+                                             rec->data + rec->length) <= 0)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+
+    /* Set up the AAD */
+    if (!tls13_record_header(recheader, rec, taglen)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+
+    /*
+     * For CCM we must explicitly set the total plaintext length before we add
+     * any AAD.
+     */
+    if (((alg_enc & SSL_AESCCM) != 0
+                 && EVP_CipherUpdate(ctx, NULL, &lenu, NULL,
+                                     (unsigned int)rec->length) <= 0)
+            || EVP_CipherUpdate(ctx, NULL, &lenu, recheader,
+                                sizeof(recheader)) <= 0
+            || EVP_CipherUpdate(ctx, rec->data, &lenu, rec->input,
+                                (unsigned int)rec->length) <= 0
+            || EVP_CipherFinal_ex(ctx, rec->data + lenu, &lenf) <= 0
+            || (size_t)(lenu + lenf) != rec->length) {
+        return 0;
+    }
+    if (sending) {
+        /* Add the tag */
+        if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, taglen,
+                                rec->data + rec->length) <= 0) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            return 0;
+        }
+        rec->length += taglen;
+    }
+
+    return 1;
+}
+
+/*
+ * Encrypts the |n_recs| records in |recs| with a single call into a cipher
+ * that supports EVP_CIPH_FLAG_AEAD_MULTIREC, using (and then incrementing) the
+ * sequence number |seq| once for each record.
+ */
+static int tls13_enc_multirec(SSL *s, EVP_CIPHER_CTX *ctx, SSL3_RECORD *recs,
+                              size_t n_recs, const unsigned char *staticiv,
+                              size_t ivlen, unsigned char *seq, size_t taglen)
+{
+    EVP_AEAD_MULTIREC_PARAM mr[SSL_MAX_PIPELINES];
+    unsigned char iv[SSL_MAX_PIPELINES][EVP_MAX_IV_LENGTH];
+    unsigned char recheader[SSL_MAX_PIPELINES][SSL3_RT_HEADER_LENGTH];
+    OSSL_PARAM params[2];
+    size_t ctr;
+
+    for (ctr = 0; ctr < n_recs; ctr++) {
+        if (!tls13_next_nonce(iv[ctr], staticiv, ivlen, seq))
+            return 0;
+        if (!tls13_record_header(recheader[ctr], &recs[ctr], taglen)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            return 0;
+        }
+        mr[ctr].out = recs[ctr].data;
+        mr[ctr].inp = recs[ctr].input;
+        mr[ctr].len = recs[ctr].length;
+        mr[ctr].iv = iv[ctr];
+        mr[ctr].aad = recheader[ctr];
+        mr[ctr].aadlen = SSL3_RT_HEADER_LENGTH;
+        mr[ctr].taglen = taglen;
+    }
+
+    params[0] = OSSL_PARAM_construct_octet_string(
+                    OSSL_CIPHER_PARAM_AEAD_MULTIREC_ENC, mr,
+                    n_recs * sizeof(mr[0]));
+    params[1] = OSSL_PARAM_construct_end();
+    if (!EVP_CIPHER_CTX_set_params(ctx, params))
+        return 0;
+
+    for (ctr = 0; ctr < n_recs; ctr++)
+        recs[ctr].length += taglen;
+
+    return 1;
+}
+
 /*-
  * tls13_enc encrypts/decrypts |n_recs| in |recs|. Calls SSLfatal on internal
  * error, but not otherwise. It is the responsibility of the caller to report
  * a bad_record_mac.
  *
+ * Every TLSv1.3 record has its own nonce, so multiple records (i.e. write
+ * pipelines) can be encrypted independently with consecutive sequence
+ * numbers.  If the cipher supports it they are all handed to it in one call.
+ *
  * Returns:
  *    0: On failure
  *    1: if the record encryption/decryption was successful.
@@ -24,18 +184,14 @@ int tls13_enc(SSL *s, SSL3_RECORD *recs, size_t n_recs, int sending,
               ossl_unused SSL_MAC_BUF *mac, ossl_unused size_t macsize)
 {
     EVP_CIPHER_CTX *ctx;
-    unsigned char iv[EVP_MAX_IV_LENGTH], recheader[SSL3_RT_HEADER_LENGTH];
-    size_t ivlen, taglen, offset, loop, hdrlen;
+    size_t ivlen, taglen, ctr;
     unsigned char *staticiv;
     unsigned char *seq;
-    int lenu, lenf;
     SSL3_RECORD *rec = &recs[0];
     uint32_t alg_enc;
-    WPACKET wpkt;
 
-    if (n_recs != 1) {
+    if (n_recs == 0 || n_recs > SSL_MAX_PIPELINES) {
         /* Should not happen */
-        /* TODO(TLS1.3): Support pipelining */
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
         return 0;
     }
@@ -55,8 +211,14 @@ int tls13_enc(SSL *s, SSL3_RECORD *recs, size_t n_recs, int sending,
      * plaintext alerts. If we're reading and ctx != NULL then we allow
      * plaintext alerts at certain points in the handshake. If we've got this
      * far then we have already validated that a plaintext alert is ok here.
+     * Alerts are always sent in a record of their own.
      */
     if (ctx == NULL || rec->type == SSL3_RT_ALERT) {
+        if (n_recs != 1) {
+            /* Should not happen */
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            return 0;
+        }
         memmove(rec->data, rec->input, rec->length);
         rec->input = rec->data;
         return 1;
@@ -107,83 +269,22 @@ int tls13_enc(SSL *s, SSL3_RECORD *recs, size_t n_recs, int sending,
         return 0;
     }
 
-    if (!sending) {
-        /*
-         * Take off tag. There must be at least one byte of content type as
-         * well as the tag
-         */
-        if (rec->length < taglen + 1)
-            return 0;
-        rec->length -= taglen;
-    }
-
-    /* Set up IV */
     if (ivlen < SEQ_NUM_SIZE) {
         /* Should not happen */
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
         return 0;
     }
-    offset = ivlen - SEQ_NUM_SIZE;
-    memcpy(iv, staticiv, offset);
-    for (loop = 0; loop < SEQ_NUM_SIZE; loop++)
-        iv[offset + loop] = staticiv[offset + loop] ^ seq[loop];
 
-    /* Increment the sequence counter */
-    for (loop = SEQ_NUM_SIZE; loop > 0; loop--) {
-        ++seq[loop - 1];
-        if (seq[loop - 1] != 0)
-            break;
-    }
-    if (loop == 0) {
-        /* Sequence has wrapped */
-        return 0;
-    }
-
-    /* TODO(size_t): lenu/lenf should be a size_t but EVP doesn't support it */
-    if (EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, sending) <= 0
-            || (!sending && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
-                                             taglen,
-                                             rec->data + rec->length) <= 0)) {
-        SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
-        return 0;
-    }
-
-    /* Set up the AAD */
-    if (!WPACKET_init_static_len(&wpkt, recheader, sizeof(recheader), 0)
-            || !WPACKET_put_bytes_u8(&wpkt, rec->type)
-            || !WPACKET_put_bytes_u16(&wpkt, rec->rec_version)
-            || !WPACKET_put_bytes_u16(&wpkt, rec->length + taglen)
-            || !WPACKET_get_total_written(&wpkt, &hdrlen)
-            || hdrlen != SSL3_RT_HEADER_LENGTH
-            || !WPACKET_finish(&wpkt)) {
-        SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
-        WPACKET_cleanup(&wpkt);
-        return 0;
-    }
+    if (sending
+            && (EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(ctx))
+                & EVP_CIPH_FLAG_AEAD_MULTIREC) != 0)
+        return tls13_enc_multirec(s, ctx, recs, n_recs, staticiv, ivlen, seq,
+                                  taglen);
 
-    /*
-     * For CCM we must explicitly set the total plaintext length before we add
-     * any AAD.
-     */
-    if (((alg_enc & SSL_AESCCM) != 0
-                 && EVP_CipherUpdate(ctx, NULL, &lenu, NULL,
-                                     (unsigned int)rec->length) <= 0)
-            || EVP_CipherUpdate(ctx, NULL, &lenu, recheader,
-                                sizeof(recheader)) <= 0
-            || EVP_CipherUpdate(ctx, rec->data, &lenu, rec->input,
-                                (unsigned int)rec->length) <= 0
-            || EVP_CipherFinal_ex(ctx, rec->data + lenu, &lenf) <= 0
-            || (size_t)(lenu + lenf) != rec->length) {
-        return 0;
-    }
-    if (sending) {
-        /* Add the tag */
-        if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, taglen,
-                                rec->data + rec->length) <= 0) {
-            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+    for (ctr = 0; ctr < n_recs; ctr++) {
+        if (!tls13_enc_record(s, ctx, &recs[ctr], staticiv, ivlen, seq,
+                              alg_enc, taglen, sending))
             return 0;
-        }
-        rec->length += taglen;
     }
 
     return 1;
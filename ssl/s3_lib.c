@@ -20,6 +20,9 @@
 #include <openssl/x509v3.h>
 #include <openssl/core_names.h>
 #include "internal/cryptlib.h"
+#ifdef OPENSSL_SYS_UNIX
+# include <unistd.h>
+#endif
 
 #define TLS13_NUM_CIPHERS       OSSL_NELEM(tls13_ciphers)
 #define SSL3_NUM_CIPHERS        OSSL_NELEM(ssl3_ciphers)
@@ -3804,6 +3807,19 @@ long ssl3_ctx_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
                 return 0;
             }
             if (cmd == SSL_CTRL_SET_TLSEXT_TICKET_KEYS) {
+                if (!CRYPTO_THREAD_write_lock(ctx->ext.tick_keys_lock))
+                    return 0;
+                /*
+                 * Tickets protected with the keys being replaced are still
+                 * accepted, and renewed, until the keys are set again. The
+                 * contexts for them are only set up on first use, so do that
+                 * now if they were never used.
+                 */
+                if (ctx->ext.tick_keys[0] == NULL)
+                    ctx->ext.tick_keys[0] = ssl_ticket_keys_new(ctx);
+                ssl_ticket_keys_free(ctx->ext.tick_keys[1]);
+                ctx->ext.tick_keys[1] = ctx->ext.tick_keys[0];
+                ctx->ext.tick_keys[0] = NULL;
                 memcpy(ctx->ext.tick_key_name, keys,
                        sizeof(ctx->ext.tick_key_name));
                 memcpy(ctx->ext.secure->tick_hmac_key,
@@ -3813,6 +3829,7 @@ long ssl3_ctx_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
                        keys + sizeof(ctx->ext.tick_key_name) +
                        sizeof(ctx->ext.secure->tick_hmac_key),
                        sizeof(ctx->ext.secure->tick_aes_key));
+                CRYPTO_THREAD_unlock(ctx->ext.tick_keys_lock);
             } else {
                 memcpy(keys, ctx->ext.tick_key_name,
                        sizeof(ctx->ext.tick_key_name));
@@ -4672,6 +4689,9 @@ EVP_PKEY *ssl_generate_pkey_group(SSL *s, uint16_t id)
         goto err;
     }
 
+    if ((pkey = ssl_keyshare_pool_get(s->ctx, id)) != NULL)
+        return pkey;
+
     pctx = EVP_PKEY_CTX_new_from_name(s->ctx->libctx, ginf->algorithm,
                                       s->ctx->propq);
 
@@ -4698,6 +4718,210 @@ EVP_PKEY *ssl_generate_pkey_group(SSL *s, uint16_t id)
     return pkey;
 }
 
+/*
+ * Identify the current process, like openssl_get_fork_id() does inside
+ * libcrypto, which does not export it.
+ */
+static int keyshare_pool_fork_id(void)
+{
+#ifdef OPENSSL_SYS_UNIX
+    return getpid();
+#else
+    return 0;
+#endif
+}
+
+int ssl_keyshare_pool_init(SSL_CTX *ctx)
+{
+    ctx->keyshare_pool_fork_id = keyshare_pool_fork_id();
+    ctx->keyshare_pool_lock = CRYPTO_THREAD_lock_new();
+    return ctx->keyshare_pool_lock != NULL;
+}
+
+/* Free keys from |grp| until no more than |max| remain */
+static void keyshare_pool_group_trim(SSL_KEYSHARE_POOL_GROUP *grp, size_t max)
+{
+    while (grp->num > max)
+        EVP_PKEY_free(grp->keys[--grp->num]);
+    if (max == 0) {
+        OPENSSL_free(grp->keys);
+        grp->keys = NULL;
+        grp->alloc = 0;
+        grp->group_id = 0;
+    }
+}
+
+/*
+ * Keys generated before a fork() are known to both processes, so the child
+ * throws its copies away the first time it touches the pool. Called with the
+ * write lock held.
+ */
+static void keyshare_pool_check_fork(SSL_CTX *ctx)
+{
+    SSL_KEYSHARE_POOL_GROUP *grp;
+    int fork_id = keyshare_pool_fork_id();
+    size_t i;
+
+    if (ctx->keyshare_pool_fork_id == fork_id)
+        return;
+    for (i = 0; i < SSL_KEYSHARE_POOL_GROUPS; i++) {
+        grp = &ctx->keyshare_pool[i];
+        while (grp->num > 0)
+            EVP_PKEY_free(grp->keys[--grp->num]);
+    }
+    ctx->keyshare_pool_fork_id = fork_id;
+}
+
+void ssl_keyshare_pool_cleanup(SSL_CTX *ctx)
+{
+    size_t i;
+
+    for (i = 0; i < SSL_KEYSHARE_POOL_GROUPS; i++)
+        keyshare_pool_group_trim(&ctx->keyshare_pool[i], 0);
+    CRYPTO_THREAD_lock_free(ctx->keyshare_pool_lock);
+    ctx->keyshare_pool_lock = NULL;
+}
+
+void ssl_keyshare_pool_set_size(SSL_CTX *ctx, size_t size)
+{
+    size_t i;
+
+    if (!CRYPTO_THREAD_write_lock(ctx->keyshare_pool_lock))
+        return;
+    tsan_store(&ctx->keyshare_pool_size, (long)size);
+    for (i = 0; i < SSL_KEYSHARE_POOL_GROUPS; i++)
+        keyshare_pool_group_trim(&ctx->keyshare_pool[i], size);
+    CRYPTO_THREAD_unlock(ctx->keyshare_pool_lock);
+}
+
+size_t ssl_keyshare_pool_num(SSL_CTX *ctx)
+{
+    size_t i, num = 0;
+
+    if (!CRYPTO_THREAD_read_lock(ctx->keyshare_pool_lock))
+        return 0;
+    for (i = 0; i < SSL_KEYSHARE_POOL_GROUPS; i++)
+        num += ctx->keyshare_pool[i].num;
+    CRYPTO_THREAD_unlock(ctx->keyshare_pool_lock);
+    return num;
+}
+
+/*
+ * Take a key for group |id| out of the pool of |ctx|. Returns NULL if there
+ * is none, in which case the group is added to the pool if there is room so
+ * that the next SSL_CTX_fill_keyshare_pool() generates keys for it.
+ */
+EVP_PKEY *ssl_keyshare_pool_get(SSL_CTX *ctx, uint16_t id)
+{
+    SSL_KEYSHARE_POOL_GROUP *grp, *unused = NULL;
+    EVP_PKEY *pkey = NULL;
+    size_t i;
+
+    if (tsan_load(&ctx->keyshare_pool_size) == 0
+            || !CRYPTO_THREAD_write_lock(ctx->keyshare_pool_lock))
+        return NULL;
+    keyshare_pool_check_fork(ctx);
+    for (i = 0; i < SSL_KEYSHARE_POOL_GROUPS; i++) {
+        grp = &ctx->keyshare_pool[i];
+        if (grp->group_id == id) {
+            if (grp->num > 0)
+                pkey = grp->keys[--grp->num];
+            break;
+        }
+        if (grp->group_id == 0 && unused == NULL)
+            unused = grp;
+    }
+    if (i == SSL_KEYSHARE_POOL_GROUPS && unused != NULL)
+        unused->group_id = id;
+    CRYPTO_THREAD_unlock(ctx->keyshare_pool_lock);
+
+    if (pkey != NULL)
+        tsan_counter(&ctx->stats.keyshare_pool_hit);
+    else
+        tsan_counter(&ctx->stats.keyshare_pool_miss);
+    return pkey;
+}
+
+static EVP_PKEY *keyshare_pool_generate(SSL_CTX *ctx, uint16_t id)
+{
+    const TLS_GROUP_INFO *ginf = tls1_group_id_lookup(ctx, id);
+    EVP_PKEY_CTX *pctx = NULL;
+    EVP_PKEY *pkey = NULL;
+
+    if (ginf == NULL) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_INTERNAL_ERROR);
+        return NULL;
+    }
+    pctx = EVP_PKEY_CTX_new_from_name(ctx->libctx, ginf->algorithm,
+                                      ctx->propq);
+    if (pctx == NULL
+            || EVP_PKEY_keygen_init(pctx) <= 0
+            || !EVP_PKEY_CTX_set_group_name(pctx, ginf->realname)
+            || EVP_PKEY_keygen(pctx, &pkey) <= 0) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_EVP_LIB);
+        EVP_PKEY_free(pkey);
+        pkey = NULL;
+    }
+    EVP_PKEY_CTX_free(pctx);
+    return pkey;
+}
+
+/*
+ * Top up the pool of |ctx| for every group in it. The lock is not held while
+ * generating keys, so that handshakes can keep taking keys in the meantime.
+ */
+int ssl_keyshare_pool_fill(SSL_CTX *ctx)
+{
+    SSL_KEYSHARE_POOL_GROUP *grp;
+    EVP_PKEY *pkey, **keys;
+    uint16_t id;
+    size_t i, max;
+    int full;
+
+    for (i = 0; i < SSL_KEYSHARE_POOL_GROUPS; i++) {
+        grp = &ctx->keyshare_pool[i];
+        for (;;) {
+            if (!CRYPTO_THREAD_read_lock(ctx->keyshare_pool_lock))
+                return 0;
+            id = grp->group_id;
+            full = grp->num >= (size_t)tsan_load(&ctx->keyshare_pool_size);
+            CRYPTO_THREAD_unlock(ctx->keyshare_pool_lock);
+            if (id == 0 || full)
+                break;
+
+            if ((pkey = keyshare_pool_generate(ctx, id)) == NULL)
+                return 0;
+
+            if (!CRYPTO_THREAD_write_lock(ctx->keyshare_pool_lock)) {
+                EVP_PKEY_free(pkey);
+                return 0;
+            }
+            keyshare_pool_check_fork(ctx);
+            max = (size_t)tsan_load(&ctx->keyshare_pool_size);
+            /* The pool may have been resized or emptied in the meantime */
+            if (grp->group_id != id || grp->num >= max) {
+                CRYPTO_THREAD_unlock(ctx->keyshare_pool_lock);
+                EVP_PKEY_free(pkey);
+                break;
+            }
+            if (grp->num == grp->alloc) {
+                keys = OPENSSL_realloc(grp->keys, max * sizeof(*keys));
+                if (keys == NULL) {
+                    CRYPTO_THREAD_unlock(ctx->keyshare_pool_lock);
+                    EVP_PKEY_free(pkey);
+                    ERR_raise(ERR_LIB_SSL, ERR_R_MALLOC_FAILURE);
+                    return 0;
+                }
+                grp->keys = keys;
+                grp->alloc = max;
+            }
+            grp->keys[grp->num++] = pkey;
+            CRYPTO_THREAD_unlock(ctx->keyshare_pool_lock);
+        }
+    }
+    return 1;
+}
+
 /*
  * Generate parameters from a group ID
  */
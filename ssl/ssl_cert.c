@@ -48,6 +48,39 @@ int SSL_get_ex_data_X509_STORE_CTX_idx(void)
     return ssl_x509_store_ctx_idx;
 }
 
+static SSL_CERT_ENC_CACHE *cert_enc_cache_new(void)
+{
+    SSL_CERT_ENC_CACHE *cache = OPENSSL_zalloc(sizeof(*cache));
+
+    if (cache == NULL)
+        return NULL;
+    cache->references = 1;
+    cache->lock = CRYPTO_THREAD_lock_new();
+    if (cache->lock == NULL) {
+        OPENSSL_free(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+static void cert_enc_cache_free(SSL_CERT_ENC_CACHE *cache)
+{
+    int i;
+
+    if (cache == NULL)
+        return;
+    CRYPTO_DOWN_REF(&cache->references, &i, cache->lock);
+    REF_PRINT_COUNT("SSL_CERT_ENC_CACHE", cache);
+    if (i > 0)
+        return;
+    REF_ASSERT_ISNT(i < 0);
+
+    for (i = 0; i < SSL_PKEY_NUM; i++)
+        ssl_cert_chain_enc_free(cache->chains[i]);
+    CRYPTO_THREAD_lock_free(cache->lock);
+    OPENSSL_free(cache);
+}
+
 CERT *ssl_cert_new(void)
 {
     CERT *ret = OPENSSL_zalloc(sizeof(*ret));
@@ -68,6 +101,13 @@ CERT *ssl_cert_new(void)
         OPENSSL_free(ret);
         return NULL;
     }
+    ret->enc_cache = cert_enc_cache_new();
+    if (ret->enc_cache == NULL) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_MALLOC_FAILURE);
+        CRYPTO_THREAD_lock_free(ret->lock);
+        OPENSSL_free(ret);
+        return NULL;
+    }
 
     return ret;
 }
@@ -91,6 +131,11 @@ CERT *ssl_cert_dup(CERT *cert)
         return NULL;
     }
 
+    if (cert->enc_cache != NULL) {
+        CRYPTO_UP_REF(&cert->enc_cache->references, &i, cert->enc_cache->lock);
+        ret->enc_cache = cert->enc_cache;
+    }
+
     if (cert->dh_tmp != NULL) {
         ret->dh_tmp = cert->dh_tmp;
         EVP_PKEY_up_ref(ret->dh_tmp);
@@ -244,10 +289,132 @@ void ssl_cert_free(CERT *c)
 #ifndef OPENSSL_NO_PSK
     OPENSSL_free(c->psk_identity_hint);
 #endif
+    cert_enc_cache_free(c->enc_cache);
     CRYPTO_THREAD_lock_free(c->lock);
     OPENSSL_free(c);
 }
 
+void ssl_cert_chain_enc_free(SSL_CERT_CHAIN_ENC *enc)
+{
+    int i;
+
+    if (enc == NULL)
+        return;
+    CRYPTO_DOWN_REF(&enc->references, &i, enc->lock);
+    REF_PRINT_COUNT("SSL_CERT_CHAIN_ENC", enc);
+    if (i > 0)
+        return;
+    REF_ASSERT_ISNT(i < 0);
+
+    sk_X509_pop_free(enc->certs, X509_free);
+    OPENSSL_free(enc->data);
+    CRYPTO_THREAD_lock_free(enc->lock);
+    OPENSSL_free(enc);
+}
+
+/* Check whether |enc| was made from |x| followed by |chain| */
+static int chain_enc_matches(const SSL_CERT_CHAIN_ENC *enc, X509 *x,
+                             STACK_OF(X509) *chain)
+{
+    int i, n = chain != NULL ? sk_X509_num(chain) : 0;
+
+    if (sk_X509_num(enc->certs) != n + 1 || sk_X509_value(enc->certs, 0) != x)
+        return 0;
+    for (i = 0; i < n; i++)
+        if (sk_X509_value(enc->certs, i + 1) != sk_X509_value(chain, i))
+            return 0;
+    return 1;
+}
+
+static SSL_CERT_CHAIN_ENC *chain_enc_new(X509 *x, STACK_OF(X509) *chain)
+{
+    SSL_CERT_CHAIN_ENC *enc = OPENSSL_zalloc(sizeof(*enc));
+    unsigned char *p;
+    int i, len;
+
+    if (enc == NULL)
+        goto merr;
+    enc->references = 1;
+    if ((enc->lock = CRYPTO_THREAD_lock_new()) == NULL)
+        goto merr;
+    enc->certs = chain != NULL ? X509_chain_up_ref(chain) : sk_X509_new_null();
+    if (enc->certs == NULL)
+        goto merr;
+    if (!sk_X509_insert(enc->certs, x, 0))
+        goto merr;
+    X509_up_ref(x);
+
+    for (i = 0; i < sk_X509_num(enc->certs); i++) {
+        len = i2d_X509(sk_X509_value(enc->certs, i), NULL);
+        if (len < 0 || len > 0xffffff) {
+            ERR_raise(ERR_LIB_SSL, ERR_R_BUF_LIB);
+            goto err;
+        }
+        enc->len += 3 + len;
+    }
+    if ((enc->data = OPENSSL_malloc(enc->len)) == NULL)
+        goto merr;
+    for (i = 0, p = enc->data; i < sk_X509_num(enc->certs); i++) {
+        X509 *c = sk_X509_value(enc->certs, i);
+
+        len = i2d_X509(c, NULL);
+        l2n3(len, p);
+        if (i2d_X509(c, &p) != len) {
+            ERR_raise(ERR_LIB_SSL, ERR_R_INTERNAL_ERROR);
+            goto err;
+        }
+    }
+    return enc;
+
+ merr:
+    ERR_raise(ERR_LIB_SSL, ERR_R_MALLOC_FAILURE);
+ err:
+    ssl_cert_chain_enc_free(enc);
+    return NULL;
+}
+
+/*
+ * Return the encoded certificate_list for the certificate of |cpk| followed
+ * by |chain|. The previous encoding for the same slot of |c| is reused if it
+ * was made from the very same certificates, so that a server presenting a
+ * fixed chain only has to encode it once. The result must be released with
+ * ssl_cert_chain_enc_free().
+ */
+SSL_CERT_CHAIN_ENC *ssl_cert_get1_chain_enc(CERT *c, CERT_PKEY *cpk,
+                                           STACK_OF(X509) *chain)
+{
+    SSL_CERT_ENC_CACHE *cache = c->enc_cache;
+    SSL_CERT_CHAIN_ENC *enc, *old;
+    size_t idx = cpk - c->pkeys;
+    int i;
+
+    if (cache == NULL || idx >= SSL_PKEY_NUM)
+        return chain_enc_new(cpk->x509, chain);
+
+    if (!CRYPTO_THREAD_read_lock(cache->lock))
+        return NULL;
+    enc = cache->chains[idx];
+    if (enc != NULL && chain_enc_matches(enc, cpk->x509, chain))
+        CRYPTO_UP_REF(&enc->references, &i, enc->lock);
+    else
+        enc = NULL;
+    CRYPTO_THREAD_unlock(cache->lock);
+    if (enc != NULL)
+        return enc;
+
+    if ((enc = chain_enc_new(cpk->x509, chain)) == NULL)
+        return NULL;
+    /* Failing to cache the new encoding doesn't stop us from using it */
+    if (!CRYPTO_THREAD_write_lock(cache->lock))
+        return enc;
+    old = cache->chains[idx];
+    CRYPTO_UP_REF(&enc->references, &i, enc->lock);
+    cache->chains[idx] = enc;
+    CRYPTO_THREAD_unlock(cache->lock);
+    ssl_cert_chain_enc_free(old);
+    return enc;
+}
+
 int ssl_cert_set0_chain(SSL *s, SSL_CTX *ctx, STACK_OF(X509) *chain)
 {
     int i, r;
@@ -750,10 +750,14 @@ SSL *SSL_new(SSL_CTX *ctx)
     s->max_send_fragment = ctx->max_send_fragment;
     s->split_send_fragment = ctx->split_send_fragment;
     s->max_pipelines = ctx->max_pipelines;
+    s->dtls_read_batch = ctx->dtls_read_batch;
     if (s->max_pipelines > 1)
         RECORD_LAYER_set_read_ahead(&s->rlayer, 1);
     if (ctx->default_read_buf_len > 0)
         SSL_set_default_read_buffer_len(s, ctx->default_read_buf_len);
+    /* Spread connections evenly over the shards of the buffer pool */
+    s->buffer_pool_shard = (size_t)tsan_counter(&ctx->buffer_pool_next)
+                           % SSL_BUFFER_POOL_SHARDS;
 
     SSL_CTX_up_ref(ctx);
     s->ctx = ctx;
@@ -918,6 +922,7 @@ int SSL_has_matching_session_id(const SSL *ssl, const unsigned char *id,
      * by this SSL.
      */
     SSL_SESSION r, *p;
+    SSL_SESSION_CACHE_SHARD *shard;
 
     if (id_len > sizeof(r.session_id))
         return 0;
@@ -926,9 +931,10 @@ int SSL_has_matching_session_id(const SSL *ssl, const unsigned char *id,
     r.session_id_length = id_len;
     memcpy(r.session_id, id, id_len);
 
-    CRYPTO_THREAD_read_lock(ssl->session_ctx->lock);
-    p = lh_SSL_SESSION_retrieve(ssl->session_ctx->sessions, &r);
-    CRYPTO_THREAD_unlock(ssl->session_ctx->lock);
+    shard = ssl_session_cache_shard(ssl->session_ctx, &r);
+    CRYPTO_THREAD_read_lock(shard->lock);
+    p = lh_SSL_SESSION_retrieve(shard->sessions, &r);
+    CRYPTO_THREAD_unlock(shard->lock);
     return (p != NULL);
 }
 
@@ -2373,6 +2379,11 @@ long SSL_ctrl(SSL *s, int cmd, long larg, void *parg)
         if (larg > 1)
             RECORD_LAYER_set_read_ahead(&s->rlayer, 1);
         return 1;
+    case SSL_CTRL_SET_DTLS_READ_BATCH:
+        if (larg < 1 || larg > SSL_MAX_DTLS_READ_BATCH)
+            return 0;
+        s->dtls_read_batch = larg;
+        return 1;
     case SSL_CTRL_GET_RI_SUPPORT:
         return s->s3.send_connection_binding;
     case SSL_CTRL_CERT_FLAGS:
@@ -2428,9 +2439,13 @@ long SSL_callback_ctrl(SSL *s, int cmd, void (*fp) (void))
     }
 }
 
+/*
+ * The session cache is split into shards, each with its own hash table, so
+ * only the sessions of the first shard can be reached through this.
+ */
 LHASH_OF(SSL_SESSION) *SSL_CTX_sessions(SSL_CTX *ctx)
 {
-    return ctx->sessions;
+    return ctx->session_cache[0].sessions;
 }
 
 long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
@@ -2486,7 +2501,7 @@ long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
         return ctx->session_cache_mode;
 
     case SSL_CTRL_SESS_NUMBER:
-        return lh_SSL_SESSION_num_items(ctx->sessions);
+        return tsan_load(&ctx->session_cache_num);
     case SSL_CTRL_SESS_CONNECT:
         return tsan_load(&ctx->stats.sess_connect);
     case SSL_CTRL_SESS_CONNECT_GOOD:
@@ -2509,6 +2524,36 @@ long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
         return tsan_load(&ctx->stats.sess_timeout);
     case SSL_CTRL_SESS_CACHE_FULL:
         return tsan_load(&ctx->stats.sess_cache_full);
+    case SSL_CTRL_SET_BUFFER_POOL_SIZE:
+        if (larg < 0)
+            return 0;
+        l = tsan_load(&ctx->buffer_pool_size);
+        ssl_buffer_pool_set_size(ctx, (size_t)larg);
+        return l;
+    case SSL_CTRL_GET_BUFFER_POOL_SIZE:
+        return tsan_load(&ctx->buffer_pool_size);
+    case SSL_CTRL_BUFFER_POOL_NUMBER:
+        return (long)ssl_buffer_pool_num(ctx);
+    case SSL_CTRL_BUFFER_POOL_HITS:
+        return tsan_load(&ctx->stats.buffer_pool_hit);
+    case SSL_CTRL_BUFFER_POOL_MISSES:
+        return tsan_load(&ctx->stats.buffer_pool_miss);
+    case SSL_CTRL_SET_KEYSHARE_POOL_SIZE:
+        if (larg < 0)
+            return 0;
+        l = tsan_load(&ctx->keyshare_pool_size);
+        ssl_keyshare_pool_set_size(ctx, (size_t)larg);
+        return l;
+    case SSL_CTRL_GET_KEYSHARE_POOL_SIZE:
+        return tsan_load(&ctx->keyshare_pool_size);
+    case SSL_CTRL_FILL_KEYSHARE_POOL:
+        return ssl_keyshare_pool_fill(ctx);
+    case SSL_CTRL_KEYSHARE_POOL_NUMBER:
+        return (long)ssl_keyshare_pool_num(ctx);
+    case SSL_CTRL_KEYSHARE_POOL_HITS:
+        return tsan_load(&ctx->stats.keyshare_pool_hit);
+    case SSL_CTRL_KEYSHARE_POOL_MISSES:
+        return tsan_load(&ctx->stats.keyshare_pool_miss);
     case SSL_CTRL_MODE:
         return (ctx->mode |= larg);
     case SSL_CTRL_CLEAR_MODE:
@@ -2530,6 +2575,11 @@ long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
             return 0;
         ctx->max_pipelines = larg;
         return 1;
+    case SSL_CTRL_SET_DTLS_READ_BATCH:
+        if (larg < 1 || larg > SSL_MAX_DTLS_READ_BATCH)
+            return 0;
+        ctx->dtls_read_batch = larg;
+        return 1;
     case SSL_CTRL_CERT_FLAGS:
         return (ctx->cert->cert_flags |= larg);
     case SSL_CTRL_CLEAR_CERT_FLAGS:
@@ -3116,6 +3166,7 @@ SSL_CTX *SSL_CTX_new_ex(OSSL_LIB_CTX *libctx, const char *propq,
                         const SSL_METHOD *meth)
 {
     SSL_CTX *ret = NULL;
+    size_t i;
 
     if (meth == NULL) {
         ERR_raise(ERR_LIB_SSL, SSL_R_NULL_SSL_METHOD_PASSED);
@@ -3160,8 +3211,18 @@ SSL_CTX *SSL_CTX_new_ex(OSSL_LIB_CTX *libctx, const char *propq,
     if ((ret->cert = ssl_cert_new()) == NULL)
         goto err;
 
-    ret->sessions = lh_SSL_SESSION_new(ssl_session_hash, ssl_session_cmp);
-    if (ret->sessions == NULL)
+    for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++) {
+        ret->session_cache[i].lock = CRYPTO_THREAD_lock_new();
+        if (ret->session_cache[i].lock == NULL)
+            goto err;
+        ret->session_cache[i].sessions =
+            lh_SSL_SESSION_new(ssl_session_hash, ssl_session_cmp);
+        if (ret->session_cache[i].sessions == NULL)
+            goto err;
+    }
+    if (!ssl_buffer_pool_init(ret))
+        goto err;
+    if (!ssl_keyshare_pool_init(ret))
         goto err;
     ret->cert_store = X509_STORE_new();
     if (ret->cert_store == NULL)
@@ -3217,6 +3278,8 @@ SSL_CTX *SSL_CTX_new_ex(OSSL_LIB_CTX *libctx, const char *propq,
 
     if ((ret->ext.secure = OPENSSL_secure_zalloc(sizeof(*ret->ext.secure))) == NULL)
         goto err;
+    if ((ret->ext.tick_keys_lock = CRYPTO_THREAD_lock_new()) == NULL)
+        goto err;
 
     /* No compression for DTLS */
     if (!(meth->ssl3_enc->enc_flags & SSL_ENC_FLAG_DTLS))
@@ -3361,11 +3424,13 @@ void SSL_CTX_free(SSL_CTX *a)
      * free ex_data, then finally free the cache.
      * (See ticket [openssl.org #212].)
      */
-    if (a->sessions != NULL)
-        SSL_CTX_flush_sessions(a, 0);
+    SSL_CTX_flush_sessions(a, 0);
 
     CRYPTO_free_ex_data(CRYPTO_EX_INDEX_SSL_CTX, a, &a->ex_data);
-    lh_SSL_SESSION_free(a->sessions);
+    for (j = 0; j < SSL_SESSION_CACHE_SHARDS; j++) {
+        lh_SSL_SESSION_free(a->session_cache[j].sessions);
+        CRYPTO_THREAD_lock_free(a->session_cache[j].lock);
+    }
     X509_STORE_free(a->cert_store);
 #ifndef OPENSSL_NO_CT
     CTLOG_STORE_free(a->ctlog_store);
@@ -3393,6 +3458,9 @@ void SSL_CTX_free(SSL_CTX *a)
     OPENSSL_free(a->ext.supported_groups_default);
     OPENSSL_free(a->ext.alpn);
     OPENSSL_secure_free(a->ext.secure);
+    ssl_ticket_keys_free(a->ext.tick_keys[0]);
+    ssl_ticket_keys_free(a->ext.tick_keys[1]);
+    CRYPTO_THREAD_lock_free(a->ext.tick_keys_lock);
 
     ssl_evp_md_free(a->md5);
     ssl_evp_md_free(a->sha1);
@@ -3410,6 +3478,9 @@ void SSL_CTX_free(SSL_CTX *a)
 
     OPENSSL_free(a->sigalg_lookup_cache);
 
+    ssl_buffer_pool_cleanup(a);
+    ssl_keyshare_pool_cleanup(a);
+
     CRYPTO_THREAD_lock_free(a->lock);
 
     OPENSSL_free(a->propq);
@@ -3676,15 +3747,18 @@ void ssl_update_cache(SSL *s, int mode)
         }
     }
 
-    /* auto flush every 255 connections */
+    /*
+     * auto flush one shard of the cache every 16 connections, so the whole
+     * cache every 256 connections
+     */
     if ((!(i & SSL_SESS_CACHE_NO_AUTO_CLEAR)) && ((i & mode) == mode)) {
         TSAN_QUALIFIER int *stat;
         if (mode & SSL_SESS_CACHE_CLIENT)
             stat = &s->session_ctx->stats.sess_connect_good;
         else
             stat = &s->session_ctx->stats.sess_accept_good;
-        if ((tsan_load(stat) & 0xff) == 0xff)
-            SSL_CTX_flush_sessions(s->session_ctx, (unsigned long)time(NULL));
+        if ((tsan_load(stat) & 0xf) == 0xf)
+            ssl_session_cache_flush_step(s->session_ctx, (long)time(NULL));
     }
 }
 
@@ -551,6 +551,7 @@ struct ssl_method_st {
  * Look in ssl/ssl_asn1.c for more details
  * I'm using EXPLICIT tags so I can read the damn things using asn1parse :-).
  */
+
 struct ssl_session_st {
     int ssl_version;            /* what ssl version session info is being kept
                                  * in here? */
@@ -805,6 +806,38 @@ int ssl_hmac_update(SSL_HMAC *ctx, const unsigned char *data, size_t len);
 int ssl_hmac_final(SSL_HMAC *ctx, unsigned char *md, size_t *len,
                    size_t max_size);
 size_t ssl_hmac_size(const SSL_HMAC *ctx);
+SSL_HMAC *ssl_hmac_dup(const SSL_HMAC *src);
+
+/*
+ * Contexts keyed with one set of built-in session ticket keys. Protecting or
+ * unprotecting a ticket only copies these and sets the IV, rather than
+ * fetching the algorithms and expanding the keys for every ticket. The
+ * contexts are never changed once set up, and a reference keeps them alive
+ * while they are copied even if the keys are replaced meanwhile. The AEAD
+ * contexts are only set up, under |lock|, once a ticket in the AEAD format
+ * is issued or parsed, which is what |aes_key| is kept for. The structure
+ * lives in the secure heap.
+ */
+typedef struct ssl_ticket_keys_st {
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+    unsigned char key_name[TLSEXT_KEYNAME_LENGTH];
+    unsigned char aes_key[TLSEXT_TICK_KEY_LENGTH];
+    EVP_CIPHER_CTX *enc;        /* AES-256-CBC */
+    EVP_CIPHER_CTX *dec;
+    SSL_HMAC *hmac;             /* HMAC-SHA256 */
+    EVP_CIPHER_CTX *aead_enc;   /* AES-256-GCM */
+    EVP_CIPHER_CTX *aead_dec;
+} SSL_TICKET_KEYS;
+
+/* IV and tag lengths of tickets in the AEAD format */
+# define SSL_TICKET_AEAD_IV_LENGTH  12
+# define SSL_TICKET_AEAD_TAG_LENGTH 16
+
+SSL_TICKET_KEYS *ssl_ticket_keys_new(SSL_CTX *ctx);
+void ssl_ticket_keys_free(SSL_TICKET_KEYS *keys);
+int ssl_ticket_keys_copy(SSL *s, int enc, unsigned char *key_name,
+                         EVP_CIPHER_CTX *ctx, SSL_HMAC **phctx, int *renew);
 
 int ssl_get_EC_curve_nid(const EVP_PKEY *pkey);
 
@@ -831,6 +864,54 @@ typedef struct tls_group_info_st {
 
 # define TLS_GROUP_FFDHE_FOR_TLS1_3 (TLS_GROUP_FFDHE|TLS_GROUP_ONLY_FOR_TLS1_3)
 
+/*
+ * The internal session cache is split into independently locked shards, with
+ * the shard of a session chosen from its session ID. Each shard has its own
+ * hash table and its own list of sessions, most recently added first.
+ */
+# define SSL_SESSION_CACHE_SHARDS   16
+
+typedef struct ssl_session_cache_shard_st {
+    CRYPTO_RWLOCK *lock;
+    LHASH_OF(SSL_SESSION) *sessions;
+    struct ssl_session_st *head;
+    struct ssl_session_st *tail;
+} SSL_SESSION_CACHE_SHARD;
+
+/*
+ * The record buffer pool is split into independently locked shards so that
+ * connections being served by different threads do not all contend on the
+ * same lock. Each shard keeps free lists for a small number of buffer lengths.
+ */
+# define SSL_BUFFER_POOL_SHARDS     8
+# define SSL_BUFFER_POOL_CLASSES    4
+
+typedef struct ssl_buffer_pool_class_st {
+    size_t len;                 /* Length of the buffers, 0 if unused */
+    size_t num;                 /* Number of buffers on the free list */
+    void *head;                 /* Free list, linked through the buffers */
+} SSL_BUFFER_POOL_CLASS;
+
+typedef struct ssl_buffer_pool_shard_st {
+    CRYPTO_RWLOCK *lock;
+    size_t max;                 /* Buffers of each length this shard keeps */
+    SSL_BUFFER_POOL_CLASS classes[SSL_BUFFER_POOL_CLASSES];
+} SSL_BUFFER_POOL_SHARD;
+
+/*
+ * Ephemeral key exchange keys generated ahead of time. The pool holds keys
+ * for a small number of groups, which are claimed on demand by the groups
+ * actually negotiated.
+ */
+# define SSL_KEYSHARE_POOL_GROUPS   4
+
+typedef struct ssl_keyshare_pool_group_st {
+    uint16_t group_id;          /* Group of the keys, 0 if unused */
+    size_t num;                 /* Number of keys in |keys| */
+    size_t alloc;               /* Room in |keys| */
+    EVP_PKEY **keys;
+} SSL_KEYSHARE_POOL_GROUP;
+
 struct ssl_ctx_st {
     OSSL_LIB_CTX *libctx;
 
@@ -841,14 +922,16 @@ struct ssl_ctx_st {
     /* TLSv1.3 specific ciphersuites */
     STACK_OF(SSL_CIPHER) *tls13_ciphersuites;
     struct x509_store_st /* X509_STORE */ *cert_store;
-    LHASH_OF(SSL_SESSION) *sessions;
+    SSL_SESSION_CACHE_SHARD session_cache[SSL_SESSION_CACHE_SHARDS];
+    /* Number of sessions in all the shards of |session_cache| */
+    TSAN_QUALIFIER int session_cache_num;
+    /* Shard to be flushed next by ssl_session_cache_flush_step() */
+    TSAN_QUALIFIER int session_cache_flush_next;
     /*
      * Most session-ids that will be cached, default is
      * SSL_SESSION_CACHE_MAX_SIZE_DEFAULT. 0 is unlimited.
      */
     size_t session_cache_size;
-    struct ssl_session_st *session_cache_head;
-    struct ssl_session_st *session_cache_tail;
     /*
      * This can have one of 2 values, ored together, SSL_SESS_CACHE_CLIENT,
      * SSL_SESS_CACHE_SERVER, Default is SSL_SESSION_CACHE_SERVER, which
@@ -893,6 +976,10 @@ struct ssl_ctx_st {
                                                 * supplying session-id's from
                                                 * other processes - spooky
                                                 * :-) */
+        TSAN_QUALIFIER int buffer_pool_hit;    /* record buffer taken from pool */
+        TSAN_QUALIFIER int buffer_pool_miss;   /* record buffer malloc'ed */
+        TSAN_QUALIFIER int keyshare_pool_hit;  /* key taken from pool */
+        TSAN_QUALIFIER int keyshare_pool_miss; /* key generated in handshake */
     } stats;
 
     CRYPTO_REF_COUNT references;
@@ -1008,9 +1095,32 @@ struct ssl_ctx_st {
     /* Up to how many pipelines should we use? If 0 then 1 is assumed */
     size_t max_pipelines;
 
+    /* Up to how many datagrams should DTLS read at once? 0 means 1 */
+    size_t dtls_read_batch;
+
     /* The default read buffer length to use (0 means not set) */
     size_t default_read_buf_len;
 
+    /*
+     * Idle record layer buffers kept for reuse by SSL objects created from
+     * this SSL_CTX. At most |buffer_pool_size| buffers of each length are
+     * kept in total, split between the shards, 0 disables the pool.
+     */
+    TSAN_QUALIFIER long buffer_pool_size;
+    SSL_BUFFER_POOL_SHARD buffer_pool[SSL_BUFFER_POOL_SHARDS];
+    TSAN_QUALIFIER int buffer_pool_next;
+
+    /*
+     * Single use key exchange keys generated in advance by
+     * SSL_CTX_fill_keyshare_pool(). At most |keyshare_pool_size| keys are
+     * kept for each group, 0 disables the pool. The keys belong to the
+     * process with |keyshare_pool_fork_id|, and are discarded after a fork.
+     */
+    TSAN_QUALIFIER long keyshare_pool_size;
+    SSL_KEYSHARE_POOL_GROUP keyshare_pool[SSL_KEYSHARE_POOL_GROUPS];
+    int keyshare_pool_fork_id;
+    CRYPTO_RWLOCK *keyshare_pool_lock;
+
 # ifndef OPENSSL_NO_ENGINE
     /*
      * Engine to pass requests for client certs to
@@ -1030,6 +1140,14 @@ struct ssl_ctx_st {
         /* RFC 4507 session ticket keys */
         unsigned char tick_key_name[TLSEXT_KEYNAME_LENGTH];
         SSL_CTX_EXT_SECURE *secure;
+        /*
+         * Contexts for the current and the previous built-in ticket keys.
+         * The current ones are set up on first use. |tick_keys_lock|
+         * protects these and the keys above, and is only held to take a
+         * reference, not while copying the contexts.
+         */
+        SSL_TICKET_KEYS *tick_keys[2];
+        CRYPTO_RWLOCK *tick_keys_lock;
 # ifndef OPENSSL_NO_DEPRECATED_3_0
         /* Callback to support customisation of ticket key setting */
         int (*ticket_key_cb) (SSL *ssl,
@@ -1558,6 +1676,10 @@ struct ssl_st {
     size_t max_send_fragment;
     /* Up to how many pipelines should we use? If 0 then 1 is assumed */
     size_t max_pipelines;
+    /* Up to how many datagrams should DTLS read at once? 0 means 1 */
+    size_t dtls_read_batch;
+    /* Which shard of the SSL_CTX buffer pool this connection uses */
+    size_t buffer_pool_shard;
 
     struct {
         /* Built-in extension flags */
@@ -1944,6 +2066,32 @@ struct cert_pkey_st {
     unsigned char *serverinfo;
     size_t serverinfo_length;
 };
+
+/*
+ * The certificate_list of a Certificate message, encoded once and reused by
+ * every handshake presenting the same certificate and chain. |data| holds
+ * each certificate in |certs| preceded by its 24-bit length, which is the
+ * complete list for TLSv1.2 and below. For TLSv1.3 the per certificate
+ * extensions still have to be added after each entry.
+ */
+typedef struct ssl_cert_chain_enc_st {
+    STACK_OF(X509) *certs;
+    unsigned char *data;
+    size_t len;
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+} SSL_CERT_CHAIN_ENC;
+
+/*
+ * Encoded chains for each CERT_PKEY slot. This is shared between a CERT and
+ * all its duplicates, so the encoding made for one connection is used by
+ * all connections created from the same SSL_CTX.
+ */
+typedef struct ssl_cert_enc_cache_st {
+    SSL_CERT_CHAIN_ENC *chains[SSL_PKEY_NUM];
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+} SSL_CERT_ENC_CACHE;
 /* Retrieve Suite B flags */
 # define tls1_suiteb(s)  (s->cert->cert_flags & SSL_CERT_FLAG_SUITEB_128_LOS)
 /* Uses to check strict mode: suite B modes are always strict */
@@ -2055,6 +2203,8 @@ typedef struct cert_st {
     /* If not NULL psk identity hint to use for servers */
     char *psk_identity_hint;
 # endif
+    /* Encoded certificate chains, shared with duplicates of this CERT */
+    SSL_CERT_ENC_CACHE *enc_cache;
     CRYPTO_REF_COUNT references;             /* >1 only if SSL_copy_session_id is used */
     CRYPTO_RWLOCK *lock;
 } CERT;
@@ -2374,12 +2524,18 @@ __owur CERT *ssl_cert_new(void);
 __owur CERT *ssl_cert_dup(CERT *cert);
 void ssl_cert_clear_certs(CERT *c);
 void ssl_cert_free(CERT *c);
+__owur SSL_CERT_CHAIN_ENC *ssl_cert_get1_chain_enc(CERT *c, CERT_PKEY *cpk,
+                                                  STACK_OF(X509) *chain);
+void ssl_cert_chain_enc_free(SSL_CERT_CHAIN_ENC *enc);
 __owur int ssl_generate_session_id(SSL *s, SSL_SESSION *ss);
 __owur int ssl_get_new_session(SSL *s, int session);
 __owur SSL_SESSION *lookup_sess_in_cache(SSL *s, const unsigned char *sess_id,
                                          size_t sess_id_len);
 __owur int ssl_get_prev_session(SSL *s, CLIENTHELLO_MSG *hello);
 __owur SSL_SESSION *ssl_session_dup(const SSL_SESSION *src, int ticket);
+SSL_SESSION_CACHE_SHARD *ssl_session_cache_shard(SSL_CTX *ctx,
+                                                 const SSL_SESSION *s);
+void ssl_session_cache_flush_step(SSL_CTX *s, long t);
 __owur int ssl_cipher_id_cmp(const SSL_CIPHER *a, const SSL_CIPHER *b);
 DECLARE_OBJ_BSEARCH_GLOBAL_CMP_FN(SSL_CIPHER, SSL_CIPHER, ssl_cipher_id);
 __owur int ssl_cipher_ptr_id_cmp(const SSL_CIPHER *const *ap,
@@ -2464,6 +2620,11 @@ __owur int ssl_set_tmp_ecdh_groups(uint16_t **pext, size_t *pextlen,
 __owur unsigned int ssl_get_max_send_fragment(const SSL *ssl);
 __owur unsigned int ssl_get_split_send_fragment(const SSL *ssl);
 
+__owur int ssl_buffer_pool_init(SSL_CTX *ctx);
+void ssl_buffer_pool_cleanup(SSL_CTX *ctx);
+void ssl_buffer_pool_set_size(SSL_CTX *ctx, size_t size);
+size_t ssl_buffer_pool_num(SSL_CTX *ctx);
+
 __owur const SSL_CIPHER *ssl3_get_cipher_by_id(uint32_t id);
 __owur const SSL_CIPHER *ssl3_get_cipher_by_std_name(const char *stdname);
 __owur const SSL_CIPHER *ssl3_get_cipher_by_char(const unsigned char *p);
@@ -2649,6 +2810,12 @@ __owur int tls1_set_groups(uint16_t **pext, size_t *pextlen,
 __owur int tls1_set_groups_list(SSL_CTX *ctx, uint16_t **pext, size_t *pextlen,
                                 const char *str);
 __owur EVP_PKEY *ssl_generate_pkey_group(SSL *s, uint16_t id);
+__owur int ssl_keyshare_pool_init(SSL_CTX *ctx);
+void ssl_keyshare_pool_cleanup(SSL_CTX *ctx);
+void ssl_keyshare_pool_set_size(SSL_CTX *ctx, size_t size);
+size_t ssl_keyshare_pool_num(SSL_CTX *ctx);
+__owur int ssl_keyshare_pool_fill(SSL_CTX *ctx);
+__owur EVP_PKEY *ssl_keyshare_pool_get(SSL_CTX *ctx, uint16_t id);
 __owur int tls_valid_group(SSL *s, uint16_t group_id, int minversion,
                            int maxversion, int isec, int *okfortls13);
 __owur EVP_PKEY *ssl_generate_param_group(SSL *s, uint16_t id);
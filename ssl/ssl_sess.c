@@ -1,5 +1,5 @@
 /*
- * Copyright 1995-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 1995-2021 The OpenSSL Project Authors. All Rights Reserved.
  * Copyright 2005 Nokia. All rights reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
@@ -16,8 +16,10 @@
 #include "ssl_local.h"
 #include "statem/statem_local.h"
 
-static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s);
-static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s);
+static void SSL_SESSION_list_remove(SSL_SESSION_CACHE_SHARD *shard,
+                                    SSL_SESSION *s);
+static void SSL_SESSION_list_add(SSL_SESSION_CACHE_SHARD *shard,
+                                 SSL_SESSION *s);
 static int remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck);
 
 /*
@@ -420,6 +422,7 @@ SSL_SESSION *lookup_sess_in_cache(SSL *s, const unsigned char *sess_id,
     if ((s->session_ctx->session_cache_mode
          & SSL_SESS_CACHE_NO_INTERNAL_LOOKUP) == 0) {
         SSL_SESSION data;
+        SSL_SESSION_CACHE_SHARD *shard;
 
         data.ssl_version = s->version;
         if (!ossl_assert(sess_id_len <= SSL_MAX_SSL_SESSION_ID_LENGTH))
@@ -428,13 +431,14 @@ SSL_SESSION *lookup_sess_in_cache(SSL *s, const unsigned char *sess_id,
         memcpy(data.session_id, sess_id, sess_id_len);
         data.session_id_length = sess_id_len;
 
-        CRYPTO_THREAD_read_lock(s->session_ctx->lock);
-        ret = lh_SSL_SESSION_retrieve(s->session_ctx->sessions, &data);
+        shard = ssl_session_cache_shard(s->session_ctx, &data);
+        CRYPTO_THREAD_read_lock(shard->lock);
+        ret = lh_SSL_SESSION_retrieve(shard->sessions, &data);
         if (ret != NULL) {
             /* don't allow other threads to steal it: */
             SSL_SESSION_up_ref(ret);
         }
-        CRYPTO_THREAD_unlock(s->session_ctx->lock);
+        CRYPTO_THREAD_unlock(shard->lock);
         if (ret == NULL)
             tsan_counter(&s->session_ctx->stats.sess_miss);
     }
@@ -628,10 +632,62 @@ int ssl_get_prev_session(SSL *s, CLIENTHELLO_MSG *hello)
     return 0;
 }
 
+/*
+ * The shard of the session cache of |ctx| that |s| belongs in. The lhash of
+ * each shard picks a bucket from the low bits of the first four bytes of the
+ * session ID, so the shard is chosen from a hash of the whole ID instead to
+ * avoid all the sessions of a shard landing in the same few buckets.
+ */
+SSL_SESSION_CACHE_SHARD *ssl_session_cache_shard(SSL_CTX *ctx,
+                                                 const SSL_SESSION *s)
+{
+    uint32_t h = 0x811c9dc5;
+    size_t i;
+
+    for (i = 0; i < s->session_id_length; i++)
+        h = (h ^ s->session_id[i]) * 0x01000193;
+    return &ctx->session_cache[(h >> 16) % SSL_SESSION_CACHE_SHARDS];
+}
+
+static int session_cache_full(SSL_CTX *ctx)
+{
+    size_t size = (size_t)SSL_CTX_sess_get_cache_size(ctx);
+
+    return size > 0 && (size_t)SSL_CTX_sess_number(ctx) > size;
+}
+
+/*
+ * Remove the least recently added sessions of the shards other than |shard|
+ * while the cache is too large, taking one session from each shard in turn
+ * and only holding the lock of one shard at a time.
+ */
+static void session_cache_trim(SSL_CTX *ctx, SSL_SESSION_CACHE_SHARD *shard)
+{
+    size_t start = shard - ctx->session_cache, i;
+    SSL_SESSION_CACHE_SHARD *other;
+    int removed;
+
+    do {
+        removed = 0;
+        for (i = 1; i < SSL_SESSION_CACHE_SHARDS && session_cache_full(ctx);
+             i++) {
+            other = &ctx->session_cache[(start + i) % SSL_SESSION_CACHE_SHARDS];
+            CRYPTO_THREAD_write_lock(other->lock);
+            if (other->tail != NULL
+                    && remove_session_lock(ctx, other->tail, 0)) {
+                tsan_counter(&ctx->stats.sess_cache_full);
+                removed = 1;
+            }
+            CRYPTO_THREAD_unlock(other->lock);
+        }
+    } while (removed && session_cache_full(ctx));
+}
+
 int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 {
     int ret = 0;
     SSL_SESSION *s;
+    SSL_SESSION_CACHE_SHARD *shard = ssl_session_cache_shard(ctx, c);
 
     /*
      * add just 1 reference count for the SSL_CTX's session cache even though
@@ -643,18 +699,19 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
      * if session c is in already in cache, we take back the increment later
      */
 
-    CRYPTO_THREAD_write_lock(ctx->lock);
-    s = lh_SSL_SESSION_insert(ctx->sessions, c);
+    CRYPTO_THREAD_write_lock(shard->lock);
+    s = lh_SSL_SESSION_insert(shard->sessions, c);
 
     /*
      * s != NULL iff we already had a session with the given PID. In this
      * case, s == c should hold (then we did not really modify
-     * ctx->sessions), or we're in trouble.
+     * shard->sessions), or we're in trouble.
      */
     if (s != NULL && s != c) {
         /* We *are* in trouble ... */
-        SSL_SESSION_list_remove(ctx, s);
+        SSL_SESSION_list_remove(shard, s);
         SSL_SESSION_free(s);
+        tsan_decr(&ctx->session_cache_num);
         /*
          * ... so pretend the other session did not exist in cache (we cannot
          * handle two SSL_SESSION structures with identical session ID in the
@@ -663,7 +720,7 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
          */
         s = NULL;
     } else if (s == NULL &&
-               lh_SSL_SESSION_retrieve(ctx->sessions, c) == NULL) {
+               lh_SSL_SESSION_retrieve(shard->sessions, c) == NULL) {
         /* s == NULL can also mean OOM error in lh_SSL_SESSION_insert ... */
 
         /*
@@ -674,8 +731,10 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
     }
 
     /* Put at the head of the queue unless it is already in the cache */
-    if (s == NULL)
-        SSL_SESSION_list_add(ctx, c);
+    if (s == NULL) {
+        SSL_SESSION_list_add(shard, c);
+        tsan_counter(&ctx->session_cache_num);
+    }
 
     if (s != NULL) {
         /*
@@ -687,21 +746,22 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
         ret = 0;
     } else {
         /*
-         * new cache entry -- remove old ones if cache has become too large
+         * new cache entry -- remove old ones if cache has become too large,
+         * from this shard first and then from the others
          */
 
         ret = 1;
 
-        if (SSL_CTX_sess_get_cache_size(ctx) > 0) {
-            while (SSL_CTX_sess_number(ctx) > SSL_CTX_sess_get_cache_size(ctx)) {
-                if (!remove_session_lock(ctx, ctx->session_cache_tail, 0))
-                    break;
-                else
-                    tsan_counter(&ctx->stats.sess_cache_full);
-            }
+        while (session_cache_full(ctx) && shard->tail != c) {
+            if (!remove_session_lock(ctx, shard->tail, 0))
+                break;
+            else
+                tsan_counter(&ctx->stats.sess_cache_full);
         }
     }
-    CRYPTO_THREAD_unlock(ctx->lock);
+    CRYPTO_THREAD_unlock(shard->lock);
+    if (ret && session_cache_full(ctx))
+        session_cache_trim(ctx, shard);
     return ret;
 }
 
@@ -713,20 +773,23 @@ int SSL_CTX_remove_session(SSL_CTX *ctx, SSL_SESSION *c)
 static int remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck)
 {
     SSL_SESSION *r;
+    SSL_SESSION_CACHE_SHARD *shard;
     int ret = 0;
 
     if ((c != NULL) && (c->session_id_length != 0)) {
+        shard = ssl_session_cache_shard(ctx, c);
         if (lck)
-            CRYPTO_THREAD_write_lock(ctx->lock);
-        if ((r = lh_SSL_SESSION_retrieve(ctx->sessions, c)) != NULL) {
+            CRYPTO_THREAD_write_lock(shard->lock);
+        if ((r = lh_SSL_SESSION_retrieve(shard->sessions, c)) != NULL) {
             ret = 1;
-            r = lh_SSL_SESSION_delete(ctx->sessions, r);
-            SSL_SESSION_list_remove(ctx, r);
+            r = lh_SSL_SESSION_delete(shard->sessions, r);
+            SSL_SESSION_list_remove(shard, r);
+            tsan_decr(&ctx->session_cache_num);
         }
         c->not_resumable = 1;
 
         if (lck)
-            CRYPTO_THREAD_unlock(ctx->lock);
+            CRYPTO_THREAD_unlock(shard->lock);
 
         if (ctx->remove_session_cb != NULL)
             ctx->remove_session_cb(ctx, c);
@@ -1037,7 +1100,7 @@ int SSL_set_session_ticket_ext(SSL *s, void *ext_data, int ext_len)
 typedef struct timeout_param_st {
     SSL_CTX *ctx;
     long time;
-    LHASH_OF(SSL_SESSION) *cache;
+    SSL_SESSION_CACHE_SHARD *shard;
 } TIMEOUT_PARAM;
 
 static void timeout_cb(SSL_SESSION *s, TIMEOUT_PARAM *p)
@@ -1047,8 +1110,9 @@ static void timeout_cb(SSL_SESSION *s, TIMEOUT_PARAM *p)
          * The reason we don't call SSL_CTX_remove_session() is to save on
          * locking overhead
          */
-        (void)lh_SSL_SESSION_delete(p->cache, s);
-        SSL_SESSION_list_remove(p->ctx, s);
+        (void)lh_SSL_SESSION_delete(p->shard->sessions, s);
+        SSL_SESSION_list_remove(p->shard, s);
+        tsan_decr(&p->ctx->session_cache_num);
         s->not_resumable = 1;
         if (p->ctx->remove_session_cb != NULL)
             p->ctx->remove_session_cb(p->ctx, s);
@@ -1058,22 +1122,45 @@ static void timeout_cb(SSL_SESSION *s, TIMEOUT_PARAM *p)
 
 IMPLEMENT_LHASH_DOALL_ARG(SSL_SESSION, TIMEOUT_PARAM);
 
-void SSL_CTX_flush_sessions(SSL_CTX *s, long t)
+static void session_cache_flush_shard(SSL_CTX *s,
+                                      SSL_SESSION_CACHE_SHARD *shard, long t)
 {
     unsigned long i;
     TIMEOUT_PARAM tp;
 
-    tp.ctx = s;
-    tp.cache = s->sessions;
-    if (tp.cache == NULL)
+    if (shard->sessions == NULL)
         return;
+    tp.ctx = s;
+    tp.shard = shard;
     tp.time = t;
-    CRYPTO_THREAD_write_lock(s->lock);
-    i = lh_SSL_SESSION_get_down_load(s->sessions);
-    lh_SSL_SESSION_set_down_load(s->sessions, 0);
-    lh_SSL_SESSION_doall_TIMEOUT_PARAM(tp.cache, timeout_cb, &tp);
-    lh_SSL_SESSION_set_down_load(s->sessions, i);
-    CRYPTO_THREAD_unlock(s->lock);
+    CRYPTO_THREAD_write_lock(shard->lock);
+    i = lh_SSL_SESSION_get_down_load(shard->sessions);
+    lh_SSL_SESSION_set_down_load(shard->sessions, 0);
+    lh_SSL_SESSION_doall_TIMEOUT_PARAM(shard->sessions, timeout_cb, &tp);
+    lh_SSL_SESSION_set_down_load(shard->sessions, i);
+    CRYPTO_THREAD_unlock(shard->lock);
+}
+
+/* Only one shard is locked at a time, so lookups in the others can go on */
+void SSL_CTX_flush_sessions(SSL_CTX *s, long t)
+{
+    size_t i;
+
+    for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++)
+        session_cache_flush_shard(s, &s->session_cache[i], t);
+}
+
+/*
+ * Flush the expired sessions from the next shard of the cache in turn, so
+ * that calling this every few connections spreads the cost of expiring
+ * sessions rather than walking the whole cache at once.
+ */
+void ssl_session_cache_flush_step(SSL_CTX *s, long t)
+{
+    size_t i = (size_t)tsan_counter(&s->session_cache_flush_next)
+               % SSL_SESSION_CACHE_SHARDS;
+
+    session_cache_flush_shard(s, &s->session_cache[i], t);
 }
 
 int ssl_clear_bad_session(SSL *s)
@@ -1087,27 +1174,28 @@ int ssl_clear_bad_session(SSL *s)
         return 0;
 }
 
-/* locked by SSL_CTX in the calling function */
-static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s)
+/* locked by the shard in the calling function */
+static void SSL_SESSION_list_remove(SSL_SESSION_CACHE_SHARD *shard,
+                                    SSL_SESSION *s)
 {
     if ((s->next == NULL) || (s->prev == NULL))
         return;
 
-    if (s->next == (SSL_SESSION *)&(ctx->session_cache_tail)) {
+    if (s->next == (SSL_SESSION *)&(shard->tail)) {
         /* last element in list */
-        if (s->prev == (SSL_SESSION *)&(ctx->session_cache_head)) {
+        if (s->prev == (SSL_SESSION *)&(shard->head)) {
             /* only one element in list */
-            ctx->session_cache_head = NULL;
-            ctx->session_cache_tail = NULL;
+            shard->head = NULL;
+            shard->tail = NULL;
         } else {
-            ctx->session_cache_tail = s->prev;
-            s->prev->next = (SSL_SESSION *)&(ctx->session_cache_tail);
+            shard->tail = s->prev;
+            s->prev->next = (SSL_SESSION *)&(shard->tail);
         }
     } else {
-        if (s->prev == (SSL_SESSION *)&(ctx->session_cache_head)) {
+        if (s->prev == (SSL_SESSION *)&(shard->head)) {
             /* first element in list */
-            ctx->session_cache_head = s->next;
-            s->next->prev = (SSL_SESSION *)&(ctx->session_cache_head);
+            shard->head = s->next;
+            s->next->prev = (SSL_SESSION *)&(shard->head);
         } else {
             /* middle of list */
             s->next->prev = s->prev;
@@ -1117,21 +1205,22 @@ static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s)
     s->prev = s->next = NULL;
 }
 
-static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s)
+static void SSL_SESSION_list_add(SSL_SESSION_CACHE_SHARD *shard,
+                                 SSL_SESSION *s)
 {
     if ((s->next != NULL) && (s->prev != NULL))
-        SSL_SESSION_list_remove(ctx, s);
+        SSL_SESSION_list_remove(shard, s);
 
-    if (ctx->session_cache_head == NULL) {
-        ctx->session_cache_head = s;
-        ctx->session_cache_tail = s;
-        s->prev = (SSL_SESSION *)&(ctx->session_cache_head);
-        s->next = (SSL_SESSION *)&(ctx->session_cache_tail);
+    if (shard->head == NULL) {
+        shard->head = s;
+        shard->tail = s;
+        s->prev = (SSL_SESSION *)&(shard->head);
+        s->next = (SSL_SESSION *)&(shard->tail);
     } else {
-        s->next = ctx->session_cache_head;
+        s->next = shard->head;
         s->next->prev = s;
-        s->prev = (SSL_SESSION *)&(ctx->session_cache_head);
-        ctx->session_cache_head = s;
+        s->prev = (SSL_SESSION *)&(shard->head);
+        shard->head = s;
     }
 }
 
@@ -915,6 +915,44 @@ static int ssl_add_cert_to_wpacket(SSL *s, WPACKET *pkt, X509 *x, int chain)
     return 1;
 }
 
+/*
+ * Add a previously encoded certificate chain to the WPACKET. For TLSv1.3
+ * the extensions for each certificate are put after its encoding.
+ */
+static int ssl_add_cert_chain_enc(SSL *s, WPACKET *pkt,
+                                  const SSL_CERT_CHAIN_ENC *enc)
+{
+    const unsigned char *p = enc->data;
+    unsigned long len;
+    int i;
+
+    if (!SSL_IS_TLS13(s)) {
+        if (!WPACKET_memcpy(pkt, enc->data, enc->len)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            return 0;
+        }
+        return 1;
+    }
+
+    for (i = 0; i < sk_X509_num(enc->certs); i++) {
+        const unsigned char *cert = p;
+
+        n2l3(p, len);
+        p += len;
+        if (!WPACKET_memcpy(pkt, cert, p - cert)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            return 0;
+        }
+        if (!tls_construct_extensions(s, pkt, SSL_EXT_TLS1_3_CERTIFICATE,
+                                      sk_X509_value(enc->certs, i), i)) {
+            /* SSLfatal() already called */
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 /* Add certificate chain to provided WPACKET */
 static int ssl_add_cert_chain(SSL *s, WPACKET *pkt, CERT_PKEY *cpk)
 {
@@ -923,6 +961,7 @@ static int ssl_add_cert_chain(SSL *s, WPACKET *pkt, CERT_PKEY *cpk)
     STACK_OF(X509) *extra_certs;
     STACK_OF(X509) *chain = NULL;
     X509_STORE *chain_store;
+    SSL_CERT_CHAIN_ENC *enc;
 
     if (cpk == NULL || cpk->x509 == NULL)
         return 1;
@@ -996,16 +1035,21 @@ static int ssl_add_cert_chain(SSL *s, WPACKET *pkt, CERT_PKEY *cpk)
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, i);
             return 0;
         }
-        if (!ssl_add_cert_to_wpacket(s, pkt, x, 0)) {
-            /* SSLfatal() already called */
+        /*
+         * An explicitly configured chain normally stays the same for the
+         * lifetime of the SSL_CTX, so its encoding is cached rather than
+         * redone for every handshake.
+         */
+        enc = ssl_cert_get1_chain_enc(s->cert, cpk, extra_certs);
+        if (enc == NULL) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
             return 0;
         }
-        for (i = 0; i < sk_X509_num(extra_certs); i++) {
-            x = sk_X509_value(extra_certs, i);
-            if (!ssl_add_cert_to_wpacket(s, pkt, x, i + 1)) {
-                /* SSLfatal() already called */
-                return 0;
-            }
+        i = ssl_add_cert_chain_enc(s, pkt, enc);
+        ssl_cert_chain_enc_free(enc);
+        if (!i) {
+            /* SSLfatal() already called */
+            return 0;
         }
     }
     return 1;
@@ -3654,7 +3654,7 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
     SSL_CTX *tctx = s->session_ctx;
     unsigned char iv[EVP_MAX_IV_LENGTH];
     unsigned char key_name[TLSEXT_KEYNAME_LENGTH];
-    int iv_len, ok = 0;
+    int iv_len, aead = 0, ok = 0;
     size_t macoffset, macendoffset;
 
     /* get session encoding length */
@@ -3674,8 +3674,7 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
     }
 
     ctx = EVP_CIPHER_CTX_new();
-    hctx = ssl_hmac_new(tctx);
-    if (ctx == NULL || hctx == NULL) {
+    if (ctx == NULL) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_MALLOC_FAILURE);
         goto err;
     }
@@ -3723,6 +3722,11 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
     {
         int ret = 0;
 
+        hctx = ssl_hmac_new(tctx);
+        if (hctx == NULL) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_MALLOC_FAILURE);
+            goto err;
+        }
         if (tctx->ext.ticket_key_evp_cb != NULL)
             ret = tctx->ext.ticket_key_evp_cb(s, key_name, iv, ctx,
                                               ssl_hmac_get0_EVP_MAC_CTX(hctx),
@@ -3753,29 +3757,19 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
         }
         iv_len = EVP_CIPHER_CTX_iv_length(ctx);
     } else {
-        EVP_CIPHER *cipher = EVP_CIPHER_fetch(s->ctx->libctx, "AES-256-CBC",
-                                              s->ctx->propq);
-
-        if (cipher == NULL) {
-            /* Error is already recorded */
-            SSLfatal_alert(s, SSL_AD_INTERNAL_ERROR);
+        /* Built-in keys, with contexts that are already keyed */
+        if (ssl_ticket_keys_copy(s, 1, key_name, ctx, &hctx, NULL) <= 0) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
             goto err;
         }
-
-        iv_len = EVP_CIPHER_iv_length(cipher);
+        iv_len = EVP_CIPHER_CTX_iv_length(ctx);
         if (RAND_bytes_ex(s->ctx->libctx, iv, iv_len) <= 0
-                || !EVP_EncryptInit_ex(ctx, cipher, NULL,
-                                       tctx->ext.secure->tick_aes_key, iv)
-                || !ssl_hmac_init(hctx, tctx->ext.secure->tick_hmac_key,
-                                  sizeof(tctx->ext.secure->tick_hmac_key),
-                                  "SHA256")) {
-            EVP_CIPHER_free(cipher);
+                || !EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, iv)) {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
             goto err;
         }
-        EVP_CIPHER_free(cipher);
-        memcpy(key_name, tctx->ext.tick_key_name,
-               sizeof(tctx->ext.tick_key_name));
+        /* No HMAC context means the tag of the AEAD protects the ticket */
+        aead = hctx == NULL;
     }
 
     if (!create_ticket_prequel(s, pkt, age_add, tick_nonce)) {
@@ -3788,17 +3782,35 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
             || !WPACKET_memcpy(pkt, key_name, sizeof(key_name))
                /* output IV */
             || !WPACKET_memcpy(pkt, iv, iv_len)
+               /* The AEAD authenticates the key name and IV */
+            || (aead
+                && !EVP_EncryptUpdate(ctx, NULL, &len,
+                                      (unsigned char *)s->init_buf->data
+                                      + macoffset,
+                                      (int)sizeof(key_name) + iv_len))
             || !WPACKET_reserve_bytes(pkt, slen + EVP_MAX_BLOCK_LENGTH,
                                       &encdata1)
                /* Encrypt session data */
             || !EVP_EncryptUpdate(ctx, encdata1, &len, senc, slen)
-            || !WPACKET_allocate_bytes(pkt, len, &encdata2)
-            || encdata1 != encdata2
             || !EVP_EncryptFinal(ctx, encdata1 + len, &lenfinal)
-            || !WPACKET_allocate_bytes(pkt, lenfinal, &encdata2)
-            || encdata1 + len != encdata2
             || len + lenfinal > slen + EVP_MAX_BLOCK_LENGTH
-            || !WPACKET_get_total_written(pkt, &macendoffset)
+               /* GCM has no padding, so the final block may be empty */
+            || !WPACKET_allocate_bytes(pkt, len + lenfinal, &encdata2)
+            || encdata1 != encdata2) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+        goto err;
+    }
+
+    if (aead) {
+        if (!WPACKET_allocate_bytes(pkt, SSL_TICKET_AEAD_TAG_LENGTH,
+                                    &macdata1)
+                || !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
+                                        SSL_TICKET_AEAD_TAG_LENGTH,
+                                        macdata1)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            goto err;
+        }
+    } else if (!WPACKET_get_total_written(pkt, &macendoffset)
             || !ssl_hmac_update(hctx,
                                 (unsigned char *)s->init_buf->data + macoffset,
                                 macendoffset - macoffset)
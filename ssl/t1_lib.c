@@ -1762,9 +1762,9 @@ SSL_TICKET_STATUS tls_decrypt_ticket(SSL *s, const unsigned char *etick,
     SSL_SESSION *sess = NULL;
     unsigned char *sdec;
     const unsigned char *p;
-    int slen, renew_ticket = 0, declen;
+    int slen, renew_ticket = 0, declen, aead = 0;
     SSL_TICKET_STATUS ret = SSL_TICKET_FATAL_ERR_OTHER;
-    size_t mlen;
+    size_t mlen, ivlen;
     unsigned char tick_hmac[EVP_MAX_MD_SIZE];
     SSL_HMAC *hctx = NULL;
     EVP_CIPHER_CTX *ctx = NULL;
@@ -1796,11 +1796,6 @@ SSL_TICKET_STATUS tls_decrypt_ticket(SSL *s, const unsigned char *etick,
     }
 
     /* Initialize session ticket encryption and HMAC contexts */
-    hctx = ssl_hmac_new(tctx);
-    if (hctx == NULL) {
-        ret = SSL_TICKET_FATAL_ERR_MALLOC;
-        goto end;
-    }
     ctx = EVP_CIPHER_CTX_new();
     if (ctx == NULL) {
         ret = SSL_TICKET_FATAL_ERR_MALLOC;
@@ -1815,6 +1810,11 @@ SSL_TICKET_STATUS tls_decrypt_ticket(SSL *s, const unsigned char *etick,
         unsigned char *nctick = (unsigned char *)etick;
         int rv = 0;
 
+        hctx = ssl_hmac_new(tctx);
+        if (hctx == NULL) {
+            ret = SSL_TICKET_FATAL_ERR_MALLOC;
+            goto end;
+        }
         if (tctx->ext.ticket_key_evp_cb != NULL)
             rv = tctx->ext.ticket_key_evp_cb(s, nctick,
                                              nctick + TLSEXT_KEYNAME_LENGTH,
@@ -1839,64 +1839,78 @@ SSL_TICKET_STATUS tls_decrypt_ticket(SSL *s, const unsigned char *etick,
         if (rv == 2)
             renew_ticket = 1;
     } else {
-        EVP_CIPHER *aes256cbc = NULL;
+        /* Built-in keys, which also checks that the key name matches */
+        int rv = ssl_ticket_keys_copy(s, 0, (unsigned char *)etick, ctx,
+                                      &hctx, &renew_ticket);
 
-        /* Check key name matches */
-        if (memcmp(etick, tctx->ext.tick_key_name,
-                   TLSEXT_KEYNAME_LENGTH) != 0) {
+        if (rv == 0) {
             ret = SSL_TICKET_NO_DECRYPT;
             goto end;
         }
-
-        aes256cbc = EVP_CIPHER_fetch(s->ctx->libctx, "AES-256-CBC",
-                                     s->ctx->propq);
-        if (aes256cbc == NULL
-            || ssl_hmac_init(hctx, tctx->ext.secure->tick_hmac_key,
-                             sizeof(tctx->ext.secure->tick_hmac_key),
-                             "SHA256") <= 0
-            || EVP_DecryptInit_ex(ctx, aes256cbc, NULL,
-                                  tctx->ext.secure->tick_aes_key,
+        if (rv < 0
+            || EVP_DecryptInit_ex(ctx, NULL, NULL, NULL,
                                   etick + TLSEXT_KEYNAME_LENGTH) <= 0) {
-            EVP_CIPHER_free(aes256cbc);
             ret = SSL_TICKET_FATAL_ERR_OTHER;
             goto end;
         }
-        EVP_CIPHER_free(aes256cbc);
+        aead = hctx == NULL;
         if (SSL_IS_TLS13(s))
             renew_ticket = 1;
     }
-    /*
-     * Attempt to process session ticket, first conduct sanity and integrity
-     * checks on ticket.
-     */
-    mlen = ssl_hmac_size(hctx);
-    if (mlen == 0) {
-        ret = SSL_TICKET_FATAL_ERR_OTHER;
-        goto end;
-    }
+    ivlen = EVP_CIPHER_CTX_iv_length(ctx);
 
-    /* Sanity check ticket length: must exceed keyname + IV + HMAC */
-    if (eticklen <=
-        TLSEXT_KEYNAME_LENGTH + EVP_CIPHER_CTX_iv_length(ctx) + mlen) {
-        ret = SSL_TICKET_NO_DECRYPT;
-        goto end;
-    }
-    eticklen -= mlen;
-    /* Check HMAC of encrypted ticket */
-    if (ssl_hmac_update(hctx, etick, eticklen) <= 0
-        || ssl_hmac_final(hctx, tick_hmac, NULL, sizeof(tick_hmac)) <= 0) {
-        ret = SSL_TICKET_FATAL_ERR_OTHER;
-        goto end;
-    }
+    if (aead) {
+        /*
+         * The key name and IV are authenticated along with the encrypted
+         * session, and the tag is checked when finishing the decryption.
+         */
+        if (eticklen <= TLSEXT_KEYNAME_LENGTH + ivlen
+                        + SSL_TICKET_AEAD_TAG_LENGTH) {
+            ret = SSL_TICKET_NO_DECRYPT;
+            goto end;
+        }
+        eticklen -= SSL_TICKET_AEAD_TAG_LENGTH;
+        if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
+                                SSL_TICKET_AEAD_TAG_LENGTH,
+                                (void *)(etick + eticklen)) <= 0
+            || EVP_DecryptUpdate(ctx, NULL, &slen, etick,
+                                 (int)(TLSEXT_KEYNAME_LENGTH + ivlen)) <= 0) {
+            ret = SSL_TICKET_FATAL_ERR_OTHER;
+            goto end;
+        }
+    } else {
+        /*
+         * Attempt to process session ticket, first conduct sanity and
+         * integrity checks on ticket.
+         */
+        mlen = ssl_hmac_size(hctx);
+        if (mlen == 0) {
+            ret = SSL_TICKET_FATAL_ERR_OTHER;
+            goto end;
+        }
 
-    if (CRYPTO_memcmp(tick_hmac, etick + eticklen, mlen)) {
-        ret = SSL_TICKET_NO_DECRYPT;
-        goto end;
+        /* Sanity check ticket length: must exceed keyname + IV + HMAC */
+        if (eticklen <= TLSEXT_KEYNAME_LENGTH + ivlen + mlen) {
+            ret = SSL_TICKET_NO_DECRYPT;
+            goto end;
+        }
+        eticklen -= mlen;
+        /* Check HMAC of encrypted ticket */
+        if (ssl_hmac_update(hctx, etick, eticklen) <= 0
+            || ssl_hmac_final(hctx, tick_hmac, NULL, sizeof(tick_hmac)) <= 0) {
+            ret = SSL_TICKET_FATAL_ERR_OTHER;
+            goto end;
+        }
+
+        if (CRYPTO_memcmp(tick_hmac, etick + eticklen, mlen)) {
+            ret = SSL_TICKET_NO_DECRYPT;
+            goto end;
+        }
     }
     /* Attempt to decrypt session data */
     /* Move p after IV to start of encrypted ticket, update length */
-    p = etick + TLSEXT_KEYNAME_LENGTH + EVP_CIPHER_CTX_iv_length(ctx);
-    eticklen -= TLSEXT_KEYNAME_LENGTH + EVP_CIPHER_CTX_iv_length(ctx);
+    p = etick + TLSEXT_KEYNAME_LENGTH + ivlen;
+    eticklen -= TLSEXT_KEYNAME_LENGTH + ivlen;
     sdec = OPENSSL_malloc(eticklen);
     if (sdec == NULL || EVP_DecryptUpdate(ctx, sdec, &slen, p,
                                           (int)eticklen) <= 0) {
@@ -3442,6 +3456,206 @@ size_t ssl_hmac_size(const SSL_HMAC *ctx)
     return 0;
 }
 
+/* Duplicate a keyed HMAC context, not supported for the legacy HMAC_CTX */
+SSL_HMAC *ssl_hmac_dup(const SSL_HMAC *src)
+{
+    SSL_HMAC *ret;
+
+    if (src->ctx == NULL)
+        return NULL;
+    if ((ret = OPENSSL_zalloc(sizeof(*ret))) == NULL)
+        return NULL;
+    if ((ret->ctx = EVP_MAC_CTX_dup(src->ctx)) == NULL) {
+        OPENSSL_free(ret);
+        return NULL;
+    }
+    return ret;
+}
+
+void ssl_ticket_keys_free(SSL_TICKET_KEYS *keys)
+{
+    int i;
+
+    if (keys == NULL)
+        return;
+    CRYPTO_DOWN_REF(&keys->references, &i, keys->lock);
+    if (i > 0)
+        return;
+    CRYPTO_THREAD_lock_free(keys->lock);
+    EVP_CIPHER_CTX_free(keys->enc);
+    EVP_CIPHER_CTX_free(keys->dec);
+    ssl_hmac_free(keys->hmac);
+    EVP_CIPHER_CTX_free(keys->aead_enc);
+    EVP_CIPHER_CTX_free(keys->aead_dec);
+    OPENSSL_secure_clear_free(keys, sizeof(*keys));
+}
+
+/*
+ * Set up contexts for the built-in ticket keys currently set in |ctx|.
+ * Called with the ticket keys lock of |ctx| held.
+ */
+SSL_TICKET_KEYS *ssl_ticket_keys_new(SSL_CTX *ctx)
+{
+    SSL_TICKET_KEYS *keys = OPENSSL_secure_zalloc(sizeof(*keys));
+    EVP_CIPHER *cbc = NULL;
+    int ok = 0;
+
+    if (keys == NULL)
+        return NULL;
+    keys->references = 1;
+    if ((keys->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        OPENSSL_secure_free(keys);
+        return NULL;
+    }
+    memcpy(keys->key_name, ctx->ext.tick_key_name, sizeof(keys->key_name));
+    memcpy(keys->aes_key, ctx->ext.secure->tick_aes_key,
+           sizeof(keys->aes_key));
+
+    cbc = EVP_CIPHER_fetch(ctx->libctx, "AES-256-CBC", ctx->propq);
+    if (cbc == NULL
+            || (keys->enc = EVP_CIPHER_CTX_new()) == NULL
+            || (keys->dec = EVP_CIPHER_CTX_new()) == NULL
+            || (keys->hmac = ssl_hmac_new(ctx)) == NULL)
+        goto err;
+    if (!EVP_EncryptInit_ex(keys->enc, cbc, NULL, keys->aes_key, NULL)
+            || !EVP_DecryptInit_ex(keys->dec, cbc, NULL, keys->aes_key, NULL)
+            || !ssl_hmac_init(keys->hmac, ctx->ext.secure->tick_hmac_key,
+                              sizeof(ctx->ext.secure->tick_hmac_key),
+                              "SHA256"))
+        goto err;
+    ok = 1;
+ err:
+    EVP_CIPHER_free(cbc);
+    if (!ok) {
+        ssl_ticket_keys_free(keys);
+        keys = NULL;
+    }
+    return keys;
+}
+
+/*
+ * Take a reference to the contexts for the built-in ticket keys of |tctx|:
+ * the current ones if |key_name| is NULL, otherwise the ones named
+ * |key_name|, which may also be the previous ones, in which case |*renew|
+ * is set. The current contexts are set up if they do not exist yet.
+ */
+static SSL_TICKET_KEYS *ticket_keys_get(SSL_CTX *tctx,
+                                        const unsigned char *key_name,
+                                        int *renew)
+{
+    SSL_TICKET_KEYS *keys = NULL;
+    size_t i;
+    int ref;
+
+    if (!CRYPTO_THREAD_read_lock(tctx->ext.tick_keys_lock))
+        return NULL;
+    if (tctx->ext.tick_keys[0] == NULL) {
+        CRYPTO_THREAD_unlock(tctx->ext.tick_keys_lock);
+        if (!CRYPTO_THREAD_write_lock(tctx->ext.tick_keys_lock))
+            return NULL;
+        if (tctx->ext.tick_keys[0] == NULL)
+            tctx->ext.tick_keys[0] = ssl_ticket_keys_new(tctx);
+    }
+    if (key_name == NULL) {
+        keys = tctx->ext.tick_keys[0];
+    } else {
+        for (i = 0; i < OSSL_NELEM(tctx->ext.tick_keys); i++) {
+            if (tctx->ext.tick_keys[i] != NULL
+                    && memcmp(key_name, tctx->ext.tick_keys[i]->key_name,
+                              TLSEXT_KEYNAME_LENGTH) == 0) {
+                keys = tctx->ext.tick_keys[i];
+                if (i > 0)
+                    *renew = 1;
+                break;
+            }
+        }
+    }
+    if (keys != NULL)
+        CRYPTO_UP_REF(&keys->references, &ref, keys->lock);
+    CRYPTO_THREAD_unlock(tctx->ext.tick_keys_lock);
+    return keys;
+}
+
+/*
+ * Set up the AES-256-GCM contexts of |keys| if that has not been done yet,
+ * fetching the cipher from the library context of |tctx|.
+ */
+static int ticket_keys_init_aead(SSL_CTX *tctx, SSL_TICKET_KEYS *keys)
+{
+    EVP_CIPHER *gcm;
+    int ok;
+
+    if (!CRYPTO_THREAD_read_lock(keys->lock))
+        return 0;
+    ok = keys->aead_dec != NULL;
+    CRYPTO_THREAD_unlock(keys->lock);
+    if (ok)
+        return 1;
+
+    if (!CRYPTO_THREAD_write_lock(keys->lock))
+        return 0;
+    if (keys->aead_dec != NULL) {
+        CRYPTO_THREAD_unlock(keys->lock);
+        return 1;
+    }
+    gcm = EVP_CIPHER_fetch(tctx->libctx, "AES-256-GCM", tctx->propq);
+    if (gcm != NULL
+            && (keys->aead_enc = EVP_CIPHER_CTX_new()) != NULL
+            && (keys->aead_dec = EVP_CIPHER_CTX_new()) != NULL
+            && EVP_EncryptInit_ex(keys->aead_enc, gcm, NULL, keys->aes_key,
+                                  NULL)
+            && EVP_DecryptInit_ex(keys->aead_dec, gcm, NULL, keys->aes_key,
+                                  NULL))
+        ok = 1;
+    if (!ok) {
+        EVP_CIPHER_CTX_free(keys->aead_enc);
+        EVP_CIPHER_CTX_free(keys->aead_dec);
+        keys->aead_enc = keys->aead_dec = NULL;
+    }
+    CRYPTO_THREAD_unlock(keys->lock);
+    EVP_CIPHER_free(gcm);
+    return ok;
+}
+
+/*
+ * Prepare |ctx| and, for the HMAC based format, |*phctx| to protect
+ * (|enc| == 1) or unprotect a ticket with the built-in ticket keys of the
+ * session SSL_CTX. The IV still has to be set in |ctx| by the caller.
+ * Tickets are always protected with the current keys, whose name is written
+ * to |key_name|. Tickets are unprotected with the keys named |key_name|,
+ * which may also be the previous ones, in which case |*renew| is set.
+ * Returns 1 on success, 0 if there are no keys named |key_name| and -1 on
+ * error.
+ */
+int ssl_ticket_keys_copy(SSL *s, int enc, unsigned char *key_name,
+                         EVP_CIPHER_CTX *ctx, SSL_HMAC **phctx, int *renew)
+{
+    SSL_TICKET_KEYS *keys;
+    int aead = (s->options & SSL_OP_TICKET_AEAD) != 0;
+    int ret = -1;
+
+    keys = ticket_keys_get(s->session_ctx, enc ? NULL : key_name, renew);
+    if (keys == NULL)
+        return enc ? -1 : 0;
+    if (enc)
+        memcpy(key_name, keys->key_name, sizeof(keys->key_name));
+
+    if (aead) {
+        if (!ticket_keys_init_aead(s->session_ctx, keys)
+                || !EVP_CIPHER_CTX_copy(ctx, enc ? keys->aead_enc
+                                                 : keys->aead_dec))
+            goto end;
+    } else {
+        if (!EVP_CIPHER_CTX_copy(ctx, enc ? keys->enc : keys->dec)
+                || (*phctx = ssl_hmac_dup(keys->hmac)) == NULL)
+            goto end;
+    }
+    ret = 1;
+ end:
+    ssl_ticket_keys_free(keys);
+    return ret;
+}
+
 int ssl_get_EC_curve_nid(const EVP_PKEY *pkey)
 {
     char gname[OSSL_MAX_NAME_SIZE];
@@ -497,6 +497,7 @@ int tls13_change_cipher_state(SSL *s, int which)
     const EVP_CIPHER *cipher = NULL;
 #if !defined(OPENSSL_NO_KTLS) && defined(OPENSSL_KTLS_TLS13)
     ktls_crypto_info_t crypto_info;
+    void *rl_sequence;
     BIO *bio;
 #endif
 
@@ -751,8 +752,11 @@ int tls13_change_cipher_state(SSL *s, int which)
         s->statem.enc_write_state = ENC_WRITE_STATE_VALID;
 #ifndef OPENSSL_NO_KTLS
 # if defined(OPENSSL_KTLS_TLS13)
-    if (!(which & SSL3_CC_WRITE) || !(which & SSL3_CC_APPLICATION)
-        || ((which & SSL3_CC_WRITE) && (s->mode & SSL_MODE_NO_KTLS_TX)))
+    if (!(which & SSL3_CC_APPLICATION)
+        || ((which & SSL3_CC_WRITE) && (s->mode & SSL_MODE_NO_KTLS_TX))
+        || ((which & SSL3_CC_READ)
+            && ((s->mode & SSL_MODE_NO_KTLS_RX)
+                || !(s->mode & SSL_MODE_KTLS_RX_TLS13))))
         goto skip_ktls;
 
     /* ktls supports only the maximum fragment size */
@@ -767,26 +771,50 @@ int tls13_change_cipher_state(SSL *s, int which)
     if (!ktls_check_supported_cipher(s, cipher, ciph_ctx))
         goto skip_ktls;
 
-    bio = s->wbio;
+    if (which & SSL3_CC_WRITE)
+        bio = s->wbio;
+    else
+        bio = s->rbio;
 
     if (!ossl_assert(bio != NULL)) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
         goto err;
     }
 
-    /* All future data will get encrypted by ktls. Flush the BIO or skip ktls */
-    if (BIO_flush(bio) <= 0)
+    if (which & SSL3_CC_WRITE) {
+        /*
+         * All future data will get encrypted by ktls. Flush the BIO or skip
+         * ktls
+         */
+        if (BIO_flush(bio) <= 0)
+            goto skip_ktls;
+        rl_sequence = RECORD_LAYER_get_write_sequence(&s->rlayer);
+    } else {
+#  ifndef OPENSSL_NO_KTLS_RX
+        /*
+         * Any records already read with the new keys would have to be
+         * decrypted here and accounted for in the kernel's record sequence.
+         * There should not be any, but if there are leave the decryption
+         * to us.
+         */
+        if (SSL3_BUFFER_get_left(RECORD_LAYER_get_rbuf(&s->rlayer)) != 0)
+            goto skip_ktls;
+        rl_sequence = RECORD_LAYER_get_read_sequence(&s->rlayer);
+#  else
         goto skip_ktls;
+#  endif
+    }
 
     /* configure kernel crypto structure */
-    if (!ktls_configure_crypto(s, cipher, ciph_ctx,
-                               RECORD_LAYER_get_write_sequence(&s->rlayer),
+    if (!ktls_configure_crypto(s, cipher, ciph_ctx, rl_sequence,
                                &crypto_info, NULL, iv, key, NULL, 0))
         goto skip_ktls;
 
     /* ktls works with user provided buffers directly */
-    if (BIO_set_ktls(bio, &crypto_info, which & SSL3_CC_WRITE))
-        ssl3_release_write_buffer(s);
+    if (BIO_set_ktls(bio, &crypto_info, which & SSL3_CC_WRITE)) {
+        if (which & SSL3_CC_WRITE)
+            ssl3_release_write_buffer(s);
+    }
 skip_ktls:
 # endif
 #endif
@@ -816,6 +844,19 @@ int tls13_update_key(SSL *s, int sending)
     EVP_CIPHER_CTX *ciph_ctx;
     int ret = 0;
 
+#ifndef OPENSSL_NO_KTLS
+    /*
+     * The kernel cannot be given new keys for a connection that it is already
+     * protecting, so we cannot continue after a key update in a direction
+     * that has been offloaded.
+     */
+    if (sending ? BIO_get_ktls_send(s->wbio) : BIO_get_ktls_recv(s->rbio)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_R_KTLS_KEY_UPDATE_NOT_SUPPORTED);
+        return 0;
+    }
+#endif
+
     if (s->server == sending)
         insecret = s->server_app_traffic_secret;
     else
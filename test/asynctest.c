@@ -1,5 +1,5 @@
 /*
- * Copyright 2015-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2015-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -7,14 +7,12 @@
  * https://www.openssl.org/source/license.html
  */
 
-#ifdef _WIN32
-# include <windows.h>
-#endif
-
 #include <stdio.h>
 #include <string.h>
 #include <openssl/async.h>
 #include <openssl/crypto.h>
+#include <openssl/err.h>
+#include "threadstest.h"
 
 static int ctr = 0;
 static ASYNC_JOB *currjob = NULL;
@@ -120,6 +118,208 @@ static int blockpause(void *args)
     return 1;
 }
 
+static int deep_stack(void *args)
+{
+    volatile unsigned char buf[40000];
+
+    memset((unsigned char *)buf, 1, sizeof(buf));
+    ASYNC_pause_job();
+
+    return buf[0] + buf[sizeof(buf) - 1];
+}
+
+#define MIGRATE_JOBS    16
+#define MIGRATE_PAUSES  100
+
+static ASYNC_JOB *migrate_job[MIGRATE_JOBS];
+static ASYNC_WAIT_CTX *migrate_waitctx;
+static int migrate_ret[MIGRATE_JOBS];
+static int migrate_count[MIGRATE_JOBS];
+static int migrate_failed;
+static int migrate_threads;
+
+static int count_pauses(void *args)
+{
+    int *count = *(int **)args;
+    int i;
+
+    for (i = 0; i < MIGRATE_PAUSES; i++) {
+        (*count)++;
+        ASYNC_pause_job();
+    }
+
+    return 1;
+}
+
+/* Resume every outstanding job once, returning the number still paused */
+static int migrate_resume_all(void)
+{
+    int i, paused = 0;
+
+    for (i = 0; i < MIGRATE_JOBS; i++) {
+        if (migrate_job[i] == NULL)
+            continue;
+        switch (ASYNC_start_job(&migrate_job[i], migrate_waitctx,
+                                &migrate_ret[i], count_pauses, NULL, 0)) {
+        case ASYNC_PAUSE:
+            paused++;
+            break;
+        case ASYNC_FINISH:
+            break;
+        default:
+            migrate_failed = 1;
+            return 0;
+        }
+    }
+    return paused;
+}
+
+static void migrate_thread(void)
+{
+    /* Every other worker has a pool of its own to adopt finished jobs */
+    if ((++migrate_threads & 1) != 0 && !ASYNC_init_thread(MIGRATE_JOBS, 0))
+        migrate_failed = 1;
+    migrate_resume_all();
+    ASYNC_cleanup_thread();
+}
+
+static int test_ASYNC_init_thread_ex(void)
+{
+    ASYNC_JOB *job = NULL;
+    int funcret;
+    ASYNC_WAIT_CTX *waitctx = NULL;
+
+    if (ASYNC_init_thread_ex(1, 0, 1024, 0)
+            || ERR_GET_REASON(ERR_get_error()) != ASYNC_R_INVALID_STACK_SIZE
+            || ASYNC_init_thread_ex(1, 0, 0, 0x80)) {
+        fprintf(stderr, "test_ASYNC_init_thread_ex() failed to reject args\n");
+        return 0;
+    }
+    ERR_clear_error();
+
+    if (       !ASYNC_init_thread_ex(1, 1, 65536,
+                                     ASYNC_STACK_GUARD | ASYNC_STACK_PREFAULT)
+            || (waitctx = ASYNC_WAIT_CTX_new()) == NULL
+            || ASYNC_start_job(&job, waitctx, &funcret, deep_stack, NULL, 0)
+                != ASYNC_PAUSE
+            || ASYNC_start_job(&job, waitctx, &funcret, deep_stack, NULL, 0)
+                != ASYNC_FINISH
+            || funcret != 2) {
+        fprintf(stderr, "test_ASYNC_init_thread_ex() failed\n");
+        ASYNC_WAIT_CTX_free(waitctx);
+        ASYNC_cleanup_thread();
+        return 0;
+    }
+
+    ASYNC_WAIT_CTX_free(waitctx);
+    ASYNC_cleanup_thread();
+    return 1;
+}
+
+/*
+ * Start a set of jobs on this thread, then keep resuming them alternately
+ * from here and from short lived worker threads until they have all finished.
+ * The pool is exactly big enough for the jobs, so starting them all again
+ * afterwards checks that jobs finishing elsewhere were accounted for.
+ */
+static int test_ASYNC_start_job_migrate(void)
+{
+    thread_t t;
+    int i, round, paused, ret = 0;
+
+    memset(migrate_count, 0, sizeof(migrate_count));
+    migrate_failed = 0;
+    if (!ASYNC_init_thread_ex(MIGRATE_JOBS, MIGRATE_JOBS, 0,
+                              ASYNC_STACK_GUARD)
+            || (migrate_waitctx = ASYNC_WAIT_CTX_new()) == NULL)
+        goto err;
+
+    for (round = 0; round < 2; round++) {
+        for (i = 0; i < MIGRATE_JOBS; i++) {
+            int *count = &migrate_count[i];
+
+            *count = 0;
+            if (ASYNC_start_job(&migrate_job[i], migrate_waitctx,
+                                &migrate_ret[i], count_pauses, &count,
+                                sizeof(count)) != ASYNC_PAUSE)
+                goto err;
+        }
+        do {
+            if (!run_thread(&t, migrate_thread) || !wait_for_thread(t))
+                goto err;
+            paused = migrate_resume_all();
+        } while (paused > 0 && !migrate_failed);
+
+        if (migrate_failed)
+            goto err;
+        for (i = 0; i < MIGRATE_JOBS; i++)
+            if (migrate_job[i] != NULL || migrate_ret[i] != 1
+                    || migrate_count[i] != MIGRATE_PAUSES)
+                goto err;
+    }
+
+    ret = 1;
+ err:
+    if (!ret)
+        fprintf(stderr, "test_ASYNC_start_job_migrate() failed\n");
+    ASYNC_WAIT_CTX_free(migrate_waitctx);
+    migrate_waitctx = NULL;
+    ASYNC_cleanup_thread();
+    return ret;
+}
+
+static int orphan_count;
+
+/* Start a job, then let the thread and its pool go while the job is paused */
+static void orphan_thread(void)
+{
+    int *count = &orphan_count;
+
+    if (!ASYNC_init_thread(1, 0)
+            || ASYNC_start_job(&migrate_job[0], migrate_waitctx,
+                               &migrate_ret[0], count_pauses, &count,
+                               sizeof(count)) != ASYNC_PAUSE)
+        migrate_failed = 1;
+    ASYNC_cleanup_thread();
+}
+
+/*
+ * Finish a job on this thread after the thread that created it has exited.
+ * This thread has no pool, so the finished job is freed, and drops the last
+ * reference to the pool of the creating thread.
+ */
+static int test_ASYNC_start_job_orphan(void)
+{
+    thread_t t;
+    int i, ret = 0;
+
+    orphan_count = 0;
+    migrate_failed = 0;
+    migrate_job[0] = NULL;
+    if ((migrate_waitctx = ASYNC_WAIT_CTX_new()) == NULL
+            || !run_thread(&t, orphan_thread) || !wait_for_thread(t)
+            || migrate_failed)
+        goto err;
+
+    for (i = 1; i < MIGRATE_PAUSES; i++)
+        if (ASYNC_start_job(&migrate_job[0], migrate_waitctx, &migrate_ret[0],
+                            count_pauses, NULL, 0) != ASYNC_PAUSE)
+            goto err;
+    if (ASYNC_start_job(&migrate_job[0], migrate_waitctx, &migrate_ret[0],
+                        count_pauses, NULL, 0) != ASYNC_FINISH
+            || migrate_ret[0] != 1 || orphan_count != MIGRATE_PAUSES)
+        goto err;
+
+    ret = 1;
+ err:
+    if (!ret)
+        fprintf(stderr, "test_ASYNC_start_job_orphan() failed\n");
+    ASYNC_WAIT_CTX_free(migrate_waitctx);
+    migrate_waitctx = NULL;
+    ASYNC_cleanup_thread();
+    return ret;
+}
+
 static int test_ASYNC_init_thread(void)
 {
     ASYNC_JOB *job1 = NULL, *job2 = NULL, *job3 = NULL;
@@ -425,7 +625,10 @@ int main(int argc, char **argv)
                 || !test_ASYNC_get_current_job()
                 || !test_ASYNC_WAIT_CTX_get_all_fds()
                 || !test_ASYNC_block_pause()
-                || !test_ASYNC_start_job_ex()) {
+                || !test_ASYNC_start_job_ex()
+                || !test_ASYNC_init_thread_ex()
+                || !test_ASYNC_start_job_migrate()
+                || !test_ASYNC_start_job_orphan()) {
             return 1;
         }
     }
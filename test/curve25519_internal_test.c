@@ -0,0 +1,289 @@
+/*
+ * Copyright 2020-2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+#include <string.h>
+#include <openssl/e_os2.h>
+#include <openssl/rand.h>
+#include "crypto/ecx.h"
+#include "internal/nelem.h"
+#include "testutil.h"
+
+/* More than one internal chunk of ED25519_verify_batch() */
+#define NUM_SIGS 100
+
+static uint8_t msgs[NUM_SIGS][NUM_SIGS];
+static size_t msg_lens[NUM_SIGS];
+static uint8_t sigs[NUM_SIGS][64];
+static uint8_t pubs[NUM_SIGS][32];
+static const uint8_t *msg_ptrs[NUM_SIGS];
+static const uint8_t *sig_ptrs[NUM_SIGS];
+static const uint8_t *pub_ptrs[NUM_SIGS];
+
+static int make_signatures(void)
+{
+    uint8_t priv[32];
+    size_t i;
+
+    for (i = 0; i < NUM_SIGS; i++) {
+        memset(priv, (int)i + 1, sizeof(priv));
+        memset(msgs[i], (int)i, i);
+        msg_lens[i] = i;
+        if (!TEST_true(ED25519_public_from_private(NULL, pubs[i], priv, NULL))
+            || !TEST_true(ED25519_sign(sigs[i], msgs[i], msg_lens[i], pubs[i],
+                                       priv, NULL, NULL)))
+            return 0;
+        msg_ptrs[i] = msgs[i];
+        sig_ptrs[i] = sigs[i];
+        pub_ptrs[i] = pubs[i];
+    }
+    return 1;
+}
+
+static int verify_batch(size_t num)
+{
+    return ED25519_verify_batch(msg_ptrs, msg_lens, sig_ptrs, pub_ptrs, num,
+                                NULL, NULL);
+}
+
+static int test_ed25519_verify_batch(void)
+{
+    size_t i;
+
+    if (!TEST_true(make_signatures()))
+        return 0;
+
+    for (i = 0; i < NUM_SIGS; i++)
+        if (!TEST_true(ED25519_verify(msgs[i], msg_lens[i], sigs[i], pubs[i],
+                                      NULL, NULL)))
+            return 0;
+
+    return TEST_true(verify_batch(0))
+        && TEST_true(verify_batch(1))
+        && TEST_true(verify_batch(2))
+        && TEST_true(verify_batch(NUM_SIGS));
+}
+
+/*
+ * Corrupt one entry, which is placed in the second internal chunk for idx
+ * 70, and check that the batch as a whole is rejected.
+ */
+static int test_ed25519_verify_batch_bad(int idx)
+{
+    uint8_t sig[64], pub[32], msg[NUM_SIGS + 1];
+    const uint8_t *orig_msg, *orig_sig, *orig_pub;
+    size_t orig_len, n = idx == 0 ? 2 : 70, i = n - 1;
+    int ret = 0;
+
+    if (!TEST_true(make_signatures()))
+        return 0;
+
+    orig_msg = msg_ptrs[i];
+    orig_len = msg_lens[i];
+    orig_sig = sig_ptrs[i];
+    orig_pub = pub_ptrs[i];
+    memcpy(sig, sigs[i], sizeof(sig));
+    memcpy(pub, pubs[i], sizeof(pub));
+    memcpy(msg, msgs[i], msg_lens[i]);
+
+    switch (idx) {
+    case 0:
+    case 1:
+        /* Flip a bit in S */
+        sig[40] ^= 0x01;
+        sig_ptrs[i] = sig;
+        break;
+    case 2:
+        /* Flip a bit in R */
+        sig[3] ^= 0x10;
+        sig_ptrs[i] = sig;
+        break;
+    case 3:
+        /* S out of range */
+        sig[63] = 0xff;
+        sig_ptrs[i] = sig;
+        break;
+    case 4:
+        /* Different message */
+        msg[0] ^= 0x01;
+        msg_ptrs[i] = msg;
+        break;
+    case 5:
+        /* Longer message */
+        msg[msg_lens[i]] = 0;
+        msg_lens[i]++;
+        msg_ptrs[i] = msg;
+        break;
+    case 6:
+        /* Different public key */
+        pub_ptrs[i] = pubs[i + 1];
+        break;
+    case 7:
+        /* Swapped signatures */
+        sig_ptrs[i] = sigs[i - 1];
+        sig_ptrs[i - 1] = sigs[i];
+        break;
+    }
+
+    if (!TEST_false(verify_batch(n))
+        || !TEST_false(verify_batch(NUM_SIGS)))
+        goto err;
+    ret = 1;
+err:
+    msg_ptrs[i] = orig_msg;
+    msg_lens[i] = orig_len;
+    sig_ptrs[i] = orig_sig;
+    sig_ptrs[i - 1] = sigs[i - 1];
+    pub_ptrs[i] = orig_pub;
+    return ret;
+}
+
+static int test_ed25519_verify_precomp(void)
+{
+    ED25519_PRECOMP *pre = NULL;
+    uint8_t sig[64];
+    size_t i;
+    int ret = 0;
+
+    if (!TEST_true(make_signatures()))
+        return 0;
+
+    for (i = 0; i < NUM_SIGS; i++) {
+        if (!TEST_ptr(pre = ossl_ed25519_precomp_new(pubs[i]))
+            || !TEST_true(ossl_ed25519_verify_precomp(msgs[i], msg_lens[i],
+                                                      sigs[i], pubs[i], pre,
+                                                      NULL, NULL)))
+            goto err;
+
+        /* Flip a bit of R and of each half of S */
+        memcpy(sig, sigs[i], sizeof(sig));
+        sig[i % 32] ^= 0x01;
+        if (!TEST_false(ossl_ed25519_verify_precomp(msgs[i], msg_lens[i], sig,
+                                                    pubs[i], pre, NULL, NULL)))
+            goto err;
+        memcpy(sig, sigs[i], sizeof(sig));
+        sig[32 + i % 16] ^= 0x01;
+        if (!TEST_false(ossl_ed25519_verify_precomp(msgs[i], msg_lens[i], sig,
+                                                    pubs[i], pre, NULL, NULL)))
+            goto err;
+        memcpy(sig, sigs[i], sizeof(sig));
+        sig[48 + i % 12] ^= 0x01;
+        if (!TEST_false(ossl_ed25519_verify_precomp(msgs[i], msg_lens[i], sig,
+                                                    pubs[i], pre, NULL, NULL)))
+            goto err;
+
+        /* Signature made with a different key */
+        if (i > 0
+            && !TEST_false(ossl_ed25519_verify_precomp(msgs[i - 1],
+                                                       msg_lens[i - 1],
+                                                       sigs[i - 1], pubs[i],
+                                                       pre, NULL, NULL)))
+            goto err;
+        ossl_ed25519_precomp_free(pre);
+        pre = NULL;
+    }
+    ret = 1;
+err:
+    ossl_ed25519_precomp_free(pre);
+    return ret;
+}
+
+/* Peer keys the precomputed X25519 tables cannot be built for */
+static const uint8_t x25519_no_precomp[][32] = {
+    /* u = -1 */
+    {
+        0xec, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f
+    },
+    /* u = 2, which is on the twist */
+    { 0x02 },
+};
+
+/* Points of small order, including non-canonical encodings */
+static const uint8_t x25519_small_order[][32] = {
+    { 0x00 },
+    { 0x01 },
+    {
+        0xe0, 0xeb, 0x7a, 0x7c, 0x3b, 0x41, 0xb8, 0xae,
+        0x16, 0x56, 0xe3, 0xfa, 0xf1, 0x9f, 0xc4, 0x6a,
+        0xda, 0x09, 0x8d, 0xeb, 0x9c, 0x32, 0xb1, 0xfd,
+        0x86, 0x62, 0x05, 0x16, 0x5f, 0x49, 0xb8, 0x00
+    },
+    {
+        0x5f, 0x9c, 0x95, 0xbc, 0xa3, 0x50, 0x8c, 0x24,
+        0xb1, 0xd0, 0xb1, 0x55, 0x9c, 0x83, 0xef, 0x5b,
+        0x04, 0x44, 0x5c, 0xc4, 0x58, 0x1c, 0x8e, 0x86,
+        0xd8, 0x22, 0x4e, 0xdd, 0xd0, 0x9f, 0x11, 0x57
+    },
+    /* u = p */
+    {
+        0xed, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f
+    },
+    /* u = p + 1 with the top bit set */
+    {
+        0xee, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+    },
+};
+
+static int test_x25519_precomp(void)
+{
+    X25519_PRECOMP *pre = NULL;
+    uint8_t priv[32], peer_priv[32], peer[32], out1[32], out2[32];
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; i < 50; i++) {
+        if (!TEST_int_gt(RAND_bytes(priv, sizeof(priv)), 0)
+            || !TEST_int_gt(RAND_bytes(peer_priv, sizeof(peer_priv)), 0))
+            goto err;
+        X25519_public_from_private(peer, peer_priv);
+        /* Exercise the unused top bit too, it must be ignored */
+        peer[31] |= (i & 1) << 7;
+        if (!TEST_ptr(pre = ossl_x25519_precomp_new(peer))
+            || !TEST_true(X25519(out1, priv, peer))
+            || !TEST_true(ossl_x25519_precomp(out2, priv, pre))
+            || !TEST_mem_eq(out1, sizeof(out1), out2, sizeof(out2)))
+            goto err;
+        ossl_x25519_precomp_free(pre);
+        pre = NULL;
+    }
+
+    for (i = 0; i < OSSL_NELEM(x25519_no_precomp); i++)
+        if (!TEST_ptr_null(ossl_x25519_precomp_new(x25519_no_precomp[i])))
+            goto err;
+
+    for (i = 0; i < OSSL_NELEM(x25519_small_order); i++) {
+        if (!TEST_ptr(pre = ossl_x25519_precomp_new(x25519_small_order[i]))
+            || !TEST_false(X25519(out1, priv, x25519_small_order[i]))
+            || !TEST_false(ossl_x25519_precomp(out2, priv, pre))
+            || !TEST_mem_eq(out1, sizeof(out1), out2, sizeof(out2)))
+            goto err;
+        ossl_x25519_precomp_free(pre);
+        pre = NULL;
+    }
+    ret = 1;
+err:
+    ossl_x25519_precomp_free(pre);
+    return ret;
+}
+
+int setup_tests(void)
+{
+    ADD_TEST(test_ed25519_verify_batch);
+    ADD_ALL_TESTS(test_ed25519_verify_batch_bad, 8);
+    ADD_TEST(test_ed25519_verify_precomp);
+    ADD_TEST(test_x25519_precomp);
+    return 1;
+}
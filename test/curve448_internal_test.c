@@ -1,5 +1,5 @@
 /*
- * Copyright 2017-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2017-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -10,8 +10,10 @@
 #include <string.h>
 #include <openssl/e_os2.h>
 #include <openssl/evp.h>
+#include <openssl/bn.h>
 #include "crypto/ecx.h"
 #include "curve448_local.h"
+#include "field.h"
 #include "testutil.h"
 
 static unsigned int max = 1000;
@@ -644,6 +646,156 @@ static int test_ed448(void)
     return 1;
 }
 
+static int test_ed448_verify(void)
+{
+    uint8_t badsig[114];
+    EVP_MD_CTX *hashctx = EVP_MD_CTX_new();
+    int ret = 0;
+
+    memcpy(badsig, sig9, sizeof(badsig));
+    badsig[10] ^= 0x01;
+
+    if (!TEST_ptr(hashctx)
+            || !TEST_true(ED448_verify(NULL, NULL, 0, sig1, pubkey1, NULL, 0,
+                                       NULL))
+            || !TEST_true(ED448_verify(NULL, msg2, sizeof(msg2), sig2, pubkey2,
+                                       NULL, 0, NULL))
+            || !TEST_true(ED448_verify(NULL, msg3, sizeof(msg3), sig3, pubkey3,
+                                       context3, sizeof(context3), NULL))
+            || !TEST_false(ED448_verify(NULL, msg3, sizeof(msg3), sig3,
+                                        pubkey3, NULL, 0, NULL))
+            || !TEST_true(ED448_verify(NULL, msg4, sizeof(msg4), sig4, pubkey4,
+                                       NULL, 0, NULL))
+            || !TEST_true(ED448_verify(NULL, msg5, sizeof(msg5), sig5, pubkey5,
+                                       NULL, 0, NULL))
+            || !TEST_true(ED448_verify(NULL, msg6, sizeof(msg6), sig6, pubkey6,
+                                       NULL, 0, NULL))
+            || !TEST_true(ED448_verify(NULL, msg7, sizeof(msg7), sig7, pubkey7,
+                                       NULL, 0, NULL))
+            || !TEST_true(ED448_verify(NULL, msg8, sizeof(msg8), sig8, pubkey8,
+                                       NULL, 0, NULL))
+            || !TEST_true(ED448_verify(NULL, msg9, sizeof(msg9), sig9, pubkey9,
+                                       NULL, 0, NULL))
+            || !TEST_false(ED448_verify(NULL, msg9, sizeof(msg9), badsig,
+                                        pubkey9, NULL, 0, NULL))
+            || !TEST_false(ED448_verify(NULL, msg9, sizeof(msg9) - 1, sig9,
+                                        pubkey9, NULL, 0, NULL))
+            || !TEST_true(ED448ph_verify(NULL, dohash(hashctx, phmsg1,
+                                         sizeof(phmsg1)), phsig1, phpubkey1,
+                                         NULL, 0, NULL))
+            || !TEST_true(ED448ph_verify(NULL, dohash(hashctx, phmsg2,
+                                         sizeof(phmsg2)), phsig2, phpubkey2,
+                                         phcontext2, sizeof(phcontext2), NULL)))
+        goto err;
+
+    ret = 1;
+ err:
+    EVP_MD_CTX_free(hashctx);
+    return ret;
+}
+
+/*
+ * Check the field arithmetic against BIGNUM.  Results are fed back in as
+ * inputs so that the unreduced outputs of one operation are exercised as
+ * inputs to the next.
+ */
+static int gf_matches_bn(const gf x, const BIGNUM *bn)
+{
+    uint8_t ser[56], exp[56];
+
+    gf_serialize(ser, x, 1);
+    return TEST_int_eq(BN_bn2lebinpad(bn, exp, sizeof(exp)), sizeof(exp))
+           && TEST_mem_eq(ser, sizeof(ser), exp, sizeof(exp));
+}
+
+static int bn_to_gf(gf x, const BIGNUM *bn)
+{
+    uint8_t ser[56];
+
+    return TEST_int_eq(BN_bn2lebinpad(bn, ser, sizeof(ser)), sizeof(ser))
+           && TEST_true(mask_to_bool(gf_deserialize(x, ser, 1, 0)));
+}
+
+static int test_field_448(int idx)
+{
+    BN_CTX *ctx = BN_CTX_new();
+    BIGNUM *p, *a, *b, *t, *r;
+    gf ga, gb, gt, gr;
+    int i, ret = 0;
+
+    if (!TEST_ptr(ctx))
+        return 0;
+    BN_CTX_start(ctx);
+    p = BN_CTX_get(ctx);
+    a = BN_CTX_get(ctx);
+    b = BN_CTX_get(ctx);
+    t = BN_CTX_get(ctx);
+    r = BN_CTX_get(ctx);
+    if (!TEST_ptr(r)
+            /* p = 2^448 - 2^224 - 1 */
+            || !TEST_true(BN_set_bit(p, 448))
+            || !TEST_true(BN_set_bit(t, 224))
+            || !TEST_true(BN_sub(p, p, t))
+            || !TEST_true(BN_sub_word(p, 1)))
+        goto err;
+
+    switch (idx) {
+    case 0:
+        /* p - 1 and a value with every limb at its maximum */
+        if (!TEST_true(BN_sub_word(BN_copy(a, p), 1))
+                || !TEST_true(BN_sub_word(BN_copy(b, p), 2)))
+            goto err;
+        break;
+    case 1:
+        /* 2^224 and 2^224 - 1, straddling the Karatsuba split */
+        if (!TEST_true(BN_lshift(a, BN_value_one(), 224))
+                || !TEST_true(BN_sub_word(BN_copy(b, a), 1)))
+            goto err;
+        break;
+    default:
+        if (!TEST_true(BN_rand_range(a, p))
+                || !TEST_true(BN_rand_range(b, p)))
+            goto err;
+        break;
+    }
+    if (!bn_to_gf(ga, a) || !bn_to_gf(gb, b))
+        goto err;
+
+    for (i = 0; i < 200; i++) {
+        gf_mul(gr, ga, gb);
+        if (!TEST_true(BN_mod_mul(r, a, b, p, ctx))
+                || !gf_matches_bn(gr, r))
+            goto err;
+
+        gf_sqr(gt, gr);
+        if (!TEST_true(BN_mod_sqr(t, r, p, ctx))
+                || !gf_matches_bn(gt, t))
+            goto err;
+
+        gf_sub(ga, gt, gb);
+        if (!TEST_true(BN_mod_sub(a, t, b, p, ctx))
+                || !gf_matches_bn(ga, a))
+            goto err;
+
+        gf_mulw_unsigned(gt, ga, 39081);
+        if (!TEST_true(BN_mul_word(BN_copy(t, a), 39081))
+                || !TEST_true(BN_mod(t, t, p, ctx))
+                || !gf_matches_bn(gt, t))
+            goto err;
+
+        gf_add(gb, gt, gr);
+        if (!TEST_true(BN_mod_add(b, t, r, p, ctx))
+                || !gf_matches_bn(gb, b))
+            goto err;
+    }
+
+    ret = 1;
+ err:
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    return ret;
+}
+
 static int test_x448(void)
 {
     uint8_t u[56], k[56], out[56];
@@ -729,5 +881,7 @@ int setup_tests(void)
 
     ADD_TEST(test_x448);
     ADD_TEST(test_ed448);
+    ADD_TEST(test_ed448_verify);
+    ADD_ALL_TESTS(test_field_448, 10);
     return 1;
 }
@@ -536,8 +536,102 @@ static int test_rand_fork_safety(int i)
 
     return success;
 }
+
+/*
+ * Test that short RAND_bytes() requests, which are served from a per-thread
+ * buffer, don't return the same output in a parent and its forked child.
+ */
+static int test_rand_bytes_cache_fork(void)
+{
+    unsigned char parent_buf[RANDOM_SIZE], child_buf[RANDOM_SIZE];
+    int fd[2], status, rv = 0;
+    pid_t pid;
+
+    /* Fill this thread's buffer */
+    if (!TEST_true(RAND_bytes(parent_buf, RANDOM_SIZE))
+            || !TEST_int_ge(pipe(fd), 0))
+        return 0;
+
+    if (!TEST_int_ge(pid = fork(), 0)) {
+        close(fd[0]);
+        close(fd[1]);
+        return 0;
+    } else if (pid == 0) {
+        close(fd[0]);
+        rv = RAND_bytes(child_buf, RANDOM_SIZE) == 1
+             && write(fd[1], child_buf, RANDOM_SIZE) == RANDOM_SIZE;
+        close(fd[1]);
+        exit(rv == 0);
+    }
+
+    close(fd[1]);
+    if (TEST_true(RAND_bytes(parent_buf, RANDOM_SIZE))
+            && TEST_int_eq(waitpid(pid, &status, 0), pid)
+            && TEST_int_eq(status, 0)
+            && TEST_true(read(fd[0], child_buf, RANDOM_SIZE) == RANDOM_SIZE)
+            && TEST_mem_ne(parent_buf, RANDOM_SIZE, child_buf, RANDOM_SIZE))
+        rv = 1;
+    close(fd[0]);
+    return rv;
+}
+#endif
+
+/*
+ * Test that RAND_add() takes effect for the very next short RAND_bytes()
+ * request, rather than after the per-thread buffer has been used up.
+ */
+static int test_rand_bytes_cache_add(void)
+{
+    EVP_RAND_CTX *public;
+    unsigned char buf[1], rand_add_buf[256];
+    unsigned int before_add;
+
+    if (crngt_skip())
+        return TEST_skip("CRNGT cannot be disabled");
+
+#ifndef OPENSSL_NO_DEPRECATED_3_0
+    if (RAND_get_rand_method() != RAND_OpenSSL())
+        return TEST_skip("RAND_OpenSSL() is not the default method");
+#endif
+
+    if (!TEST_ptr(public = RAND_get0_public(NULL))
+            || !TEST_true(RAND_bytes(buf, 1)))
+        return 0;
+    before_add = reseed_counter(public);
+
+    memset(rand_add_buf, 'r', sizeof(rand_add_buf));
+    RAND_add(rand_add_buf, sizeof(rand_add_buf), sizeof(rand_add_buf));
+
+    return TEST_true(RAND_bytes(buf, 1))
+           && TEST_uint_gt(reseed_counter(public), before_add);
+}
+
+/*
+ * Test that reseeding the thread's public DRBG directly also discards the
+ * bytes it buffered for short RAND_bytes() requests.
+ */
+static int test_rand_bytes_cache_reseed(void)
+{
+    EVP_RAND_CTX *public;
+    unsigned char buf[1];
+    unsigned int generated;
+
+#ifndef OPENSSL_NO_DEPRECATED_3_0
+    if (RAND_get_rand_method() != RAND_OpenSSL())
+        return TEST_skip("RAND_OpenSSL() is not the default method");
 #endif
 
+    if (!TEST_ptr(public = RAND_get0_public(NULL))
+            || !TEST_true(RAND_bytes(buf, 1))
+            || !TEST_true(EVP_RAND_reseed(public, 0, NULL, 0, NULL, 0)))
+        return 0;
+    generated = prov_rand(public)->generate_counter;
+
+    /* The next short request must come from a fresh generate call */
+    return TEST_true(RAND_bytes(buf, 1))
+           && TEST_uint_gt(prov_rand(public)->generate_counter, generated);
+}
+
 /*
  * Test whether the default rand_method (RAND_OpenSSL()) is
  * setup correctly, in particular whether reseeding  works
@@ -717,13 +811,16 @@ static void run_multi_thread_test(void)
     while (time(NULL) - start < 5);
 }
 
+/* What the threads started with run_thread() run */
+static void (*thread_routine)(void) = run_multi_thread_test;
+
 # if defined(OPENSSL_SYS_WINDOWS)
 
 typedef HANDLE thread_t;
 
 static DWORD WINAPI thread_run(LPVOID arg)
 {
-    run_multi_thread_test();
+    thread_routine();
     /*
      * Because we're linking with a static library, we must stop each
      * thread explicitly, or so says OPENSSL_thread_stop(3)
@@ -749,7 +846,7 @@ typedef pthread_t thread_t;
 
 static void *thread_run(void *arg)
 {
-    run_multi_thread_test();
+    thread_routine();
     /*
      * Because we're linking with a static library, we must stop each
      * thread explicitly, or so says OPENSSL_thread_stop(3)
@@ -781,6 +878,7 @@ static int test_multi_thread(void)
     thread_t t[THREADS];
     int i;
 
+    thread_routine = run_multi_thread_test;
     for (i = 0; i < THREADS; i++)
         run_thread(&t[i]);
     run_multi_thread_test();
@@ -794,6 +892,48 @@ static int test_multi_thread(void)
 
     return 1;
 }
+
+static void rand_add_thread(void)
+{
+    unsigned char rand_add_buf[256];
+
+    memset(rand_add_buf, 'r', sizeof(rand_add_buf));
+    RAND_add(rand_add_buf, sizeof(rand_add_buf), sizeof(rand_add_buf));
+}
+
+/*
+ * Test that a RAND_add() on another thread also discards the bytes this
+ * thread buffered for short RAND_bytes() requests.
+ */
+static int test_rand_bytes_cache_add_other_thread(void)
+{
+    EVP_RAND_CTX *public;
+    unsigned char buf[1];
+    unsigned int before_add;
+    thread_t t;
+
+    if (crngt_skip())
+        return TEST_skip("CRNGT cannot be disabled");
+
+#ifndef OPENSSL_NO_DEPRECATED_3_0
+    if (RAND_get_rand_method() != RAND_OpenSSL())
+        return TEST_skip("RAND_OpenSSL() is not the default method");
+#endif
+
+    if (!TEST_ptr(public = RAND_get0_public(NULL))
+            || !TEST_true(RAND_bytes(buf, 1)))
+        return 0;
+    before_add = reseed_counter(public);
+
+    thread_routine = rand_add_thread;
+    if (!TEST_true(run_thread(&t))
+            || !TEST_true(wait_for_thread(t)))
+        return 0;
+
+    /* The next short request must come from a freshly reseeded generate */
+    return TEST_true(RAND_bytes(buf, 1))
+           && TEST_uint_gt(reseed_counter(public), before_add);
+}
 #endif
 
 static EVP_RAND_CTX *new_drbg(EVP_RAND_CTX *parent)
@@ -908,10 +1048,14 @@ int setup_tests(void)
     ADD_TEST(test_rand_reseed);
 #if defined(OPENSSL_SYS_UNIX)
     ADD_ALL_TESTS(test_rand_fork_safety, RANDOM_SIZE);
+    ADD_TEST(test_rand_bytes_cache_fork);
 #endif
+    ADD_TEST(test_rand_bytes_cache_add);
+    ADD_TEST(test_rand_bytes_cache_reseed);
     ADD_TEST(test_rand_prediction_resistance);
 #if defined(OPENSSL_THREADS)
     ADD_TEST(test_multi_thread);
+    ADD_TEST(test_rand_bytes_cache_add_other_thread);
 #endif
     return 1;
 }
@@ -13,6 +13,7 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 
+#include "internal/sockets.h"
 #include "helpers/ssltestlib.h"
 #include "testutil.h"
 
@@ -337,6 +338,188 @@ static int test_dtls_duplicate_records(void)
     return testresult;
 }
 
+#if !defined(OPENSSL_NO_SOCK) && !defined(OPENSSL_NO_DGRAM)
+/*
+ * Create two non-blocking UDP sockets on the loopback interface that are
+ * connected to each other, and datagram BIOs for them
+ */
+static int create_udp_pair(BIO **sbio, BIO **cbio)
+{
+    BIO_ADDRINFO *res = NULL;
+    BIO_ADDR *saddr = NULL, *caddr = NULL;
+    union BIO_sock_info_u info;
+    int sfd = -1, cfd = -1, ret = 0;
+
+    *sbio = *cbio = NULL;
+    if (!TEST_true(BIO_lookup_ex("127.0.0.1", "0", BIO_LOOKUP_SERVER, AF_INET,
+                                 SOCK_DGRAM, IPPROTO_UDP, &res))
+            || !TEST_ptr(saddr = BIO_ADDR_new())
+            || !TEST_ptr(caddr = BIO_ADDR_new())
+            || !TEST_int_ge(sfd = BIO_socket(AF_INET, SOCK_DGRAM,
+                                             IPPROTO_UDP, 0), 0)
+            || !TEST_int_ge(cfd = BIO_socket(AF_INET, SOCK_DGRAM,
+                                             IPPROTO_UDP, 0), 0)
+            || !TEST_true(BIO_bind(sfd, BIO_ADDRINFO_address(res), 0))
+            || !TEST_true(BIO_bind(cfd, BIO_ADDRINFO_address(res), 0)))
+        goto end;
+    info.addr = saddr;
+    if (!TEST_true(BIO_sock_info(sfd, BIO_SOCK_INFO_ADDRESS, &info)))
+        goto end;
+    info.addr = caddr;
+    if (!TEST_true(BIO_sock_info(cfd, BIO_SOCK_INFO_ADDRESS, &info))
+            || !TEST_true(BIO_connect(sfd, caddr, 0))
+            || !TEST_true(BIO_connect(cfd, saddr, 0))
+            || !TEST_true(BIO_socket_nbio(sfd, 1))
+            || !TEST_true(BIO_socket_nbio(cfd, 1))
+            || !TEST_ptr(*sbio = BIO_new_dgram(sfd, BIO_CLOSE)))
+        goto end;
+    sfd = -1;
+    if (!TEST_ptr(*cbio = BIO_new_dgram(cfd, BIO_CLOSE)))
+        goto end;
+    cfd = -1;
+    (void)BIO_ctrl_set_connected(*sbio, caddr);
+    (void)BIO_ctrl_set_connected(*cbio, saddr);
+    ret = 1;
+ end:
+    if (!ret) {
+        BIO_free(*sbio);
+        BIO_free(*cbio);
+        *sbio = *cbio = NULL;
+    }
+    if (sfd != -1)
+        BIO_closesocket(sfd);
+    if (cfd != -1)
+        BIO_closesocket(cfd);
+    BIO_ADDR_free(saddr);
+    BIO_ADDR_free(caddr);
+    BIO_ADDRINFO_free(res);
+    return ret;
+}
+
+#define MMSG_NUM 5
+
+/* Send several datagrams in one go and receive them the same way */
+static int test_bio_mmsg(void)
+{
+    BIO *sbio = NULL, *cbio = NULL;
+    BIO_DGRAM_MSG msg[MMSG_NUM + 1];
+    BIO_ADDR *peer = NULL;
+    unsigned char out[MMSG_NUM][64], in[MMSG_NUM + 1][64];
+    size_t i, got, num = 0, tries;
+    int testresult = 0;
+
+    if (!TEST_true(create_udp_pair(&sbio, &cbio))
+            || !TEST_ptr(peer = BIO_ADDR_new()))
+        goto end;
+
+    for (i = 0; i < MMSG_NUM; i++) {
+        memset(out[i], 'a' + (int)i, sizeof(out[i]));
+        msg[i].data = out[i];
+        msg[i].data_len = 10 * i + 1;
+        msg[i].peer = NULL;
+    }
+    for (i = 0; i < MMSG_NUM; i += got)
+        if (!TEST_true(BIO_dgram_sendmmsg(cbio, msg + i, MMSG_NUM - i, &got)))
+            goto end;
+
+    /* Ask for one more than was sent */
+    for (tries = 0; num < MMSG_NUM && tries < 1000; tries++) {
+        for (i = 0; i <= MMSG_NUM - num; i++) {
+            msg[i].data = in[num + i];
+            msg[i].data_len = sizeof(in[0]);
+            msg[i].peer = i == 0 ? peer : NULL;
+        }
+        if (!BIO_dgram_recvmmsg(sbio, msg, MMSG_NUM + 1 - num, &got)) {
+            if (!TEST_true(BIO_should_retry(sbio)))
+                goto end;
+            continue;
+        }
+        for (i = 0; i < got; i++)
+            if (!TEST_mem_eq(msg[i].data, msg[i].data_len,
+                             out[num + i], 10 * (num + i) + 1))
+                goto end;
+        if (!TEST_int_eq(BIO_ADDR_family(peer), AF_INET))
+            goto end;
+        num += got;
+    }
+    if (!TEST_size_t_eq(num, MMSG_NUM))
+        goto end;
+
+    testresult = 1;
+ end:
+    BIO_ADDR_free(peer);
+    BIO_free(sbio);
+    BIO_free(cbio);
+    return testresult;
+}
+
+/*
+ * Let DTLS read several datagrams from a UDP socket at once. The datagrams
+ * are larger than the MTU of the reading side, which must not truncate them.
+ */
+static int test_dtls_read_batch(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    BIO *sbio = NULL, *cbio = NULL;
+    unsigned char msg[2000], buf[sizeof(msg)];
+    size_t i, written, readbytes;
+    int testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(NULL, DTLS_server_method(),
+                                       DTLS_client_method(),
+                                       DTLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey)))
+        return 0;
+
+    if (!TEST_false(SSL_CTX_set_dtls_read_batch(sctx, 0))
+            || !TEST_false(SSL_CTX_set_dtls_read_batch(sctx,
+                                                   SSL_MAX_DTLS_READ_BATCH + 1))
+            || !TEST_true(SSL_CTX_set_dtls_read_batch(sctx, 8))
+            || !TEST_ptr(serverssl = SSL_new(sctx))
+            || !TEST_ptr(clientssl = SSL_new(cctx))
+            || !TEST_true(create_udp_pair(&sbio, &cbio)))
+        goto end;
+    SSL_set_bio(serverssl, sbio, sbio);
+    SSL_set_bio(clientssl, cbio, cbio);
+
+    SSL_set_options(serverssl, SSL_OP_NO_QUERY_MTU);
+    if (!TEST_true(SSL_set_mtu(serverssl, 1400)))
+        goto end;
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE)))
+        goto end;
+
+    /* Each write is a datagram of its own */
+    memset(msg, 'x', sizeof(msg));
+    for (i = 0; i < MMSG_NUM; i++) {
+        msg[0] = (unsigned char)i;
+        if (!TEST_true(SSL_write_ex(clientssl, msg, sizeof(msg), &written)))
+            goto end;
+    }
+    for (i = 0; i < MMSG_NUM; i++) {
+        msg[0] = (unsigned char)i;
+        if (!TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf), &readbytes))
+                || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg)))
+            goto end;
+# ifdef __linux__
+        /* The first read has taken all the datagrams off the socket */
+        if (!TEST_int_eq(SSL_has_pending(serverssl), i < MMSG_NUM - 1))
+            goto end;
+# endif
+    }
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+#endif
+
 OPT_TEST_DECLARE_USAGE("certfile privkeyfile\n")
 
 int setup_tests(void)
@@ -356,6 +539,10 @@ int setup_tests(void)
 #endif
     ADD_TEST(test_cookie);
     ADD_TEST(test_dtls_duplicate_records);
+#if !defined(OPENSSL_NO_SOCK) && !defined(OPENSSL_NO_DGRAM)
+    ADD_TEST(test_bio_mmsg);
+    ADD_TEST(test_dtls_read_batch);
+#endif
 
     return 1;
 }
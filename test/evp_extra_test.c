@@ -954,6 +954,77 @@ static int test_EVP_DigestVerifyInit(void)
     return ret;
 }
 
+#ifndef OPENSSL_NO_EC
+/*
+ * The last two Ed25519 signatures are passed to the provider together, the
+ * others on their own. Test |idx| == 1 allows the cofactored batch equation.
+ */
+static int test_EVP_DigestVerify_batch(int idx)
+{
+    static const char *keytypes[] = { "ED25519", "ED448", "ED25519", "ED25519" };
+    EVP_PKEY *pkeys[OSSL_NELEM(keytypes)] = { NULL };
+    EVP_PKEY_CTX *pctx = NULL;
+    EVP_MD_CTX *md_ctx = NULL;
+    unsigned char sigbufs[OSSL_NELEM(keytypes)][114];
+    const unsigned char *sigs[OSSL_NELEM(keytypes)];
+    const unsigned char *tbs[OSSL_NELEM(keytypes)];
+    size_t siglens[OSSL_NELEM(keytypes)], tbslens[OSSL_NELEM(keytypes)];
+    size_t i;
+    int ret = 0, cofactored = idx;
+    OSSL_PARAM params[2];
+
+    params[0] = OSSL_PARAM_construct_int(OSSL_SIGNATURE_PARAM_COFACTORED,
+                                         &cofactored);
+    params[1] = OSSL_PARAM_construct_end();
+
+    for (i = 0; i < OSSL_NELEM(keytypes); i++) {
+        siglens[i] = sizeof(sigbufs[i]);
+        sigs[i] = sigbufs[i];
+        tbs[i] = kMsg;
+        tbslens[i] = sizeof(kMsg) - i;
+        if (!TEST_ptr(pctx = EVP_PKEY_CTX_new_from_name(testctx, keytypes[i],
+                                                        NULL))
+                || !TEST_int_gt(EVP_PKEY_keygen_init(pctx), 0)
+                || !TEST_int_gt(EVP_PKEY_keygen(pctx, &pkeys[i]), 0)
+                || !TEST_ptr(md_ctx = EVP_MD_CTX_new())
+                || !TEST_true(EVP_DigestSignInit_ex(md_ctx, NULL, NULL, testctx,
+                                                    NULL, pkeys[i]))
+                || !TEST_true(EVP_DigestSign(md_ctx, sigbufs[i], &siglens[i],
+                                             tbs[i], tbslens[i])))
+            goto out;
+        EVP_PKEY_CTX_free(pctx);
+        pctx = NULL;
+        EVP_MD_CTX_free(md_ctx);
+        md_ctx = NULL;
+    }
+
+    if (!TEST_true(EVP_DigestVerify_batch(pkeys, sigs, siglens, tbs, tbslens,
+                                          0, testctx, NULL, params))
+            || !TEST_true(EVP_DigestVerify_batch(pkeys, sigs, siglens, tbs,
+                                                 tbslens, OSSL_NELEM(pkeys),
+                                                 testctx, NULL, params)))
+        goto out;
+
+    /* A bad signature anywhere in the batch fails it */
+    for (i = 0; i < OSSL_NELEM(keytypes); i++) {
+        sigbufs[i][0] ^= 1;
+        if (!TEST_false(EVP_DigestVerify_batch(pkeys, sigs, siglens, tbs,
+                                               tbslens, OSSL_NELEM(pkeys),
+                                               testctx, NULL, params)))
+            goto out;
+        sigbufs[i][0] ^= 1;
+    }
+    ret = 1;
+
+ out:
+    EVP_PKEY_CTX_free(pctx);
+    EVP_MD_CTX_free(md_ctx);
+    for (i = 0; i < OSSL_NELEM(pkeys); i++)
+        EVP_PKEY_free(pkeys[i]);
+    return ret;
+}
+#endif
+
 /*
  * Test corner cases of EVP_DigestInit/Update/Final API call behavior.
  */
@@ -999,6 +1070,80 @@ static int test_EVP_Digest(void)
     return ret;
 }
 
+/*
+ * Hash messages of lengths around the block and padding boundaries with
+ * EVP_Digest_many() and compare against EVP_Digest(). There are more
+ * messages than lanes in a multi-block implementation and they are not
+ * sorted by length.
+ */
+static const size_t digest_many_lens[] = {
+    0, 1, 55, 56, 57, 63, 64, 65, 119, 120, 3, 128, 1000, 0, 200, 55, 64,
+    4096, 111, 112, 17
+};
+
+static int test_EVP_Digest_many(int tst)
+{
+    static const char *names[] = {
+        "SHA1", "SHA256", "SHA512", "SHA3-256", "SHAKE256", "KECCAK-KMAC-128",
+        NULL
+    };
+    const void *data[OSSL_NELEM(digest_many_lens)];
+    unsigned char *buf = NULL, *md = NULL;
+    unsigned char expected[EVP_MAX_MD_SIZE];
+    EVP_MD *fetched = NULL;
+    const EVP_MD *type;
+    unsigned int size = 0, exp_size;
+    size_t i, num = OSSL_NELEM(digest_many_lens);
+    int ret = 0;
+
+    /* The last one uses an implicitly fetched digest */
+    if (names[tst] == NULL)
+        type = EVP_sha256();
+    else if (!TEST_ptr(type = fetched = EVP_MD_fetch(testctx, names[tst],
+                                                     NULL)))
+        goto err;
+
+    if (!TEST_ptr(buf = OPENSSL_malloc(4096))
+            || !TEST_ptr(md = OPENSSL_malloc(num * EVP_MAX_MD_SIZE)))
+        goto err;
+    for (i = 0; i < 4096; i++)
+        buf[i] = (unsigned char)(i * 7 + 3);
+    for (i = 0; i < num; i++)
+        data[i] = buf + i;
+    data[0] = NULL;
+
+    if (!TEST_true(EVP_Digest_many(data, digest_many_lens, num, md, &size,
+                                   type, NULL))
+            || !TEST_int_eq(size, EVP_MD_size(type)))
+        goto err;
+    for (i = 0; i < num; i++) {
+        if (!TEST_true(EVP_Digest(i == 0 ? "" : data[i], digest_many_lens[i],
+                                  expected, &exp_size, type, NULL))
+                || !TEST_mem_eq(md + i * size, size, expected, exp_size)) {
+            TEST_note("message %zu", i);
+            goto err;
+        }
+    }
+
+    /* Fewer messages than lanes */
+    if (!TEST_true(EVP_Digest_many(data + 4, digest_many_lens + 4, 3, md,
+                                   NULL, type, NULL)))
+        goto err;
+    for (i = 0; i < 3; i++) {
+        if (!TEST_true(EVP_Digest(data[i + 4], digest_many_lens[i + 4],
+                                  expected, &exp_size, type, NULL))
+                || !TEST_mem_eq(md + i * size, size, expected, exp_size))
+            goto err;
+    }
+
+    ret = TEST_true(EVP_Digest_many(NULL, NULL, 0, md, NULL, type, NULL));
+ err:
+    OPENSSL_free(buf);
+    OPENSSL_free(md);
+    EVP_MD_free(fetched);
+    return ret;
+}
+
 static int test_d2i_AutoPrivateKey(int i)
 {
     int ret = 0;
@@ -2413,6 +2558,77 @@ err:
     return ret;
 }
 
+static const char *multirec_ciphers[] = {
+    "AES-128-GCM",
+    "AES-256-GCM",
+#if !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+    "ChaCha20-Poly1305",
+#endif
+};
+
+/*
+ * Test that encrypting several records in one call with the "aead-multirec-enc"
+ * parameter gives the same result as encrypting each of them on its own.
+ */
+static int test_evp_aead_multirec(int idx)
+{
+    int ret = 0, outl, finl;
+    EVP_CIPHER *cipher = NULL;
+    EVP_CIPHER_CTX *ctx = NULL;
+    EVP_AEAD_MULTIREC_PARAM mr[3];
+    OSSL_PARAM params[2];
+    static const size_t lens[OSSL_NELEM(mr)] = { 1, 100, 257 };
+    unsigned char key[32], iv[OSSL_NELEM(mr)][12], aad[OSSL_NELEM(mr)][5];
+    unsigned char msg[257], out[OSSL_NELEM(mr)][257 + 16], ref[257 + 16];
+    size_t i;
+
+    memset(key, 0x42, sizeof(key));
+    for (i = 0; i < sizeof(msg); i++)
+        msg[i] = (unsigned char)i;
+
+    if (!TEST_ptr(cipher = EVP_CIPHER_fetch(testctx, multirec_ciphers[idx],
+                                            NULL))
+            || !TEST_true(EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_MULTIREC)
+            || !TEST_ptr(ctx = EVP_CIPHER_CTX_new())
+            || !TEST_true(EVP_EncryptInit_ex(ctx, cipher, NULL, key, NULL)))
+        goto err;
+
+    for (i = 0; i < OSSL_NELEM(mr); i++) {
+        memset(iv[i], (int)i, sizeof(iv[i]));
+        memset(aad[i], 0x17 + (int)i, sizeof(aad[i]));
+        mr[i].out = out[i];
+        mr[i].inp = msg;
+        mr[i].len = lens[i];
+        mr[i].iv = iv[i];
+        mr[i].aad = aad[i];
+        mr[i].aadlen = sizeof(aad[i]);
+        mr[i].taglen = 16;
+    }
+    params[0] = OSSL_PARAM_construct_octet_string(
+                    OSSL_CIPHER_PARAM_AEAD_MULTIREC_ENC, mr, sizeof(mr));
+    params[1] = OSSL_PARAM_construct_end();
+    if (!TEST_true(EVP_CIPHER_CTX_set_params(ctx, params)))
+        goto err;
+
+    for (i = 0; i < OSSL_NELEM(mr); i++) {
+        if (!TEST_true(EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, iv[i]))
+                || !TEST_true(EVP_EncryptUpdate(ctx, NULL, &outl, aad[i],
+                                                sizeof(aad[i])))
+                || !TEST_true(EVP_EncryptUpdate(ctx, ref, &outl, msg,
+                                                (int)lens[i]))
+                || !TEST_true(EVP_EncryptFinal_ex(ctx, ref + outl, &finl))
+                || !TEST_true(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
+                                                  16, ref + lens[i]))
+                || !TEST_mem_eq(out[i], lens[i] + 16, ref, lens[i] + 16))
+            goto err;
+    }
+    ret = 1;
+err:
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(cipher);
+    return ret;
+}
+
 #ifndef OPENSSL_NO_EC
 static int ecpub_nids[] = { NID_brainpoolP256r1, NID_X9_62_prime256v1,
     NID_secp384r1, NID_secp521r1, NID_sect233k1, NID_sect233r1, NID_sect283r1,
@@ -2560,7 +2776,11 @@ int setup_tests(void)
     ADD_TEST(test_EVP_set_default_properties);
     ADD_ALL_TESTS(test_EVP_DigestSignInit, 9);
     ADD_TEST(test_EVP_DigestVerifyInit);
+#ifndef OPENSSL_NO_EC
+    ADD_ALL_TESTS(test_EVP_DigestVerify_batch, 2);
+#endif
     ADD_TEST(test_EVP_Digest);
+    ADD_ALL_TESTS(test_EVP_Digest_many, 7);
     ADD_TEST(test_EVP_Enveloped);
     ADD_ALL_TESTS(test_d2i_AutoPrivateKey, OSSL_NELEM(keydata));
     ADD_TEST(test_privatekey_to_pkcs8);
@@ -2621,6 +2841,7 @@ int setup_tests(void)
 
     ADD_TEST(test_rand_agglomeration);
     ADD_ALL_TESTS(test_evp_iv, 10);
+    ADD_ALL_TESTS(test_evp_aead_multirec, OSSL_NELEM(multirec_ciphers));
     ADD_TEST(test_EVP_rsa_pss_with_keygen_bits);
 #ifndef OPENSSL_NO_EC
     ADD_ALL_TESTS(test_ecpub, OSSL_NELEM(ecpub_nids));
@@ -1242,7 +1242,7 @@ static int mac_test_run_pkey(EVP_TEST *t)
 static int mac_test_run_mac(EVP_TEST *t)
 {
     MAC_DATA *expected = t->data;
-    EVP_MAC_CTX *ctx = NULL;
+    EVP_MAC_CTX *ctx = NULL, *dupctx = NULL;
     unsigned char *got = NULL;
     size_t got_len;
     int i;
@@ -1357,11 +1357,39 @@ static int mac_test_run_mac(EVP_TEST *t)
         t->err = "TEST_MAC_ERR";
         goto err;
     }
+    /*
+     * HMAC keeps the prepared key, so it can be restarted without one, and
+     * duplicates share it: check both give the same result.
+     */
+    if (EVP_MAC_is_a(expected->mac, "HMAC")) {
+        size_t half = expected->input_len / 2;
+
+        if (!EVP_MAC_init(ctx, NULL, 0, NULL)
+            || !EVP_MAC_update(ctx, expected->input, half)
+            || !TEST_ptr(dupctx = EVP_MAC_CTX_dup(ctx))) {
+            t->err = "MAC_DUP_ERROR";
+            goto err;
+        }
+        for (i = 0; i < 2; i++) {
+            EVP_MAC_CTX *c = i == 0 ? ctx : dupctx;
+
+            if (!EVP_MAC_update(c, expected->input + half,
+                                expected->input_len - half)
+                || !EVP_MAC_final(c, got, &got_len, got_len)
+                || !memory_err_compare(t, "TEST_MAC_ERR",
+                                       expected->output, expected->output_len,
+                                       got, got_len)) {
+                t->err = "TEST_MAC_ERR";
+                goto err;
+            }
+        }
+    }
     t->err = NULL;
  err:
     while (params_n-- > params_n_allocstart) {
         OPENSSL_free(params[params_n].data);
     }
+    EVP_MAC_CTX_free(dupctx);
     EVP_MAC_CTX_free(ctx);
     OPENSSL_free(got);
     return 1;
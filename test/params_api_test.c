@@ -608,6 +608,42 @@ err:
     return ret;
 }
 
+static int test_param_locate(void)
+{
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_int("iv", NULL),
+        OSSL_PARAM_int("ivlen", NULL),
+        OSSL_PARAM_int("keylen", NULL),
+        OSSL_PARAM_int("", NULL),
+        OSSL_PARAM_END
+    };
+    char key[8];
+
+    /* The same literal, which is usually merged and found by pointer */
+    if (!TEST_ptr_eq(OSSL_PARAM_locate(params, "ivlen"), params + 1)
+            || !TEST_ptr_eq(OSSL_PARAM_locate_const(params, "keylen"),
+                            params + 2))
+        return 0;
+
+    /* A copy of the name, which has to be compared */
+    strcpy(key, "ivlen");
+    if (!TEST_ptr_eq(OSSL_PARAM_locate(params, key), params + 1))
+        return 0;
+    key[2] = '\0';
+    if (!TEST_ptr_eq(OSSL_PARAM_locate(params, key), params))
+        return 0;
+    key[0] = '\0';
+    if (!TEST_ptr_eq(OSSL_PARAM_locate(params, key), params + 3))
+        return 0;
+    strcpy(key, "ivlex");
+    if (!TEST_ptr_null(OSSL_PARAM_locate(params, key))
+            || !TEST_ptr_null(OSSL_PARAM_locate(params, "i"))
+            || !TEST_ptr_null(OSSL_PARAM_locate(NULL, "iv"))
+            || !TEST_ptr_null(OSSL_PARAM_locate(params, NULL)))
+        return 0;
+    return 1;
+}
+
 static int test_param_modified(void)
 {
     OSSL_PARAM param[3] = { OSSL_PARAM_int("a", NULL),
@@ -650,6 +686,7 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_param_bignum, OSSL_NELEM(raw_values));
     ADD_TEST(test_param_real);
     ADD_TEST(test_param_construct);
+    ADD_TEST(test_param_locate);
     ADD_TEST(test_param_modified);
     return 1;
 }
@@ -14,6 +14,8 @@
 #include "internal/nelem.h"
 #include "internal/property.h"
 #include "../crypto/property/property_local.h"
+#include "internal/cryptlib.h"
+#include "threadstest.h"
 
 static int add_property_names(const char *n, ...)
 {
@@ -384,6 +386,225 @@ err:
     return res;
 }
 
+/*
+ * Repeated cache lookups are served from a per thread cache.  Check that
+ * this doesn't hand out stale results once the store has been changed.
+ */
+static int test_query_cache_invalidation(void)
+{
+    OSSL_METHOD_STORE *store;
+    void *result;
+    int i, res = 0;
+
+    if (!TEST_ptr(store = ossl_method_store_new(NULL))
+        || !add_property_names("n", NULL)
+        || !TEST_true(ossl_method_store_add(store, NULL, 7, "n=1", "a",
+                                            &up_ref, &down_ref))
+        || !TEST_true(ossl_method_store_cache_set(store, 7, "n=1", "a",
+                                                  &up_ref, &down_ref)))
+        goto err;
+
+    for (i = 0; i < 3; i++)
+        if (!TEST_true(ossl_method_store_cache_get(store, 7, "n=1", &result))
+            || !TEST_str_eq((char *)result, "a"))
+            goto err;
+
+    /* Replacing the cached result must be seen immediately */
+    if (!TEST_true(ossl_method_store_cache_set(store, 7, "n=1", "b",
+                                               &up_ref, &down_ref))
+        || !TEST_true(ossl_method_store_cache_get(store, 7, "n=1", &result))
+        || !TEST_str_eq((char *)result, "b"))
+        goto err;
+
+    /* As must removal of the result or of the method itself */
+    if (!TEST_true(ossl_method_store_cache_set(store, 7, "n=1", NULL,
+                                               &up_ref, &down_ref))
+        || !TEST_false(ossl_method_store_cache_get(store, 7, "n=1", &result))
+        || !TEST_true(ossl_method_store_cache_set(store, 7, "n=1", "a",
+                                                  &up_ref, &down_ref))
+        || !TEST_true(ossl_method_store_cache_get(store, 7, "n=1", &result))
+        || !TEST_true(ossl_method_store_remove(store, 7, "a"))
+        || !TEST_false(ossl_method_store_cache_get(store, 7, "n=1", &result)))
+        goto err;
+
+    /* And so must flushing the entire cache */
+    if (!TEST_true(ossl_method_store_add(store, NULL, 7, "n=1", "a",
+                                         &up_ref, &down_ref))
+        || !TEST_true(ossl_method_store_cache_set(store, 7, "n=1", "a",
+                                                  &up_ref, &down_ref))
+        || !TEST_true(ossl_method_store_cache_get(store, 7, "n=1", &result)))
+        goto err;
+    ossl_method_store_flush_cache(store, 0);
+    if (!TEST_false(ossl_method_store_cache_get(store, 7, "n=1", &result)))
+        goto err;
+    res = 1;
+
+err:
+    ossl_method_store_free(store);
+    return res;
+}
+
+static int counted_refs = 0;
+
+static int counted_up_ref(void *p)
+{
+    counted_refs++;
+    return 1;
+}
+
+static void counted_down_ref(void *p)
+{
+    counted_refs--;
+}
+
+/*
+ * A change to the store must release the references held by a thread's cache
+ * straight away, and freeing the store must release them all.
+ */
+static int test_query_cache_release(void)
+{
+    OSSL_METHOD_STORE *store;
+    void *result;
+    int base, res = 0;
+
+    if (!TEST_ptr(store = ossl_method_store_new(NULL))
+        || !add_property_names("n", NULL)
+        || !TEST_true(ossl_method_store_add(store, NULL, 7, "n=1", "a",
+                                            &counted_up_ref,
+                                            &counted_down_ref)))
+        goto err;
+    base = counted_refs;
+
+    /* The shared cache and this thread's cache both take a reference */
+    if (!TEST_true(ossl_method_store_cache_set(store, 7, "n=1", "a",
+                                               &counted_up_ref,
+                                               &counted_down_ref))
+        || !TEST_true(ossl_method_store_cache_get(store, 7, "n=1", &result)))
+        goto err;
+    counted_down_ref(result);
+    if (!TEST_int_eq(counted_refs, base + 2))
+        goto err;
+
+    ossl_method_store_flush_cache(store, 0);
+    if (!TEST_int_eq(counted_refs, base)
+        || !TEST_false(ossl_method_store_cache_get(store, 7, "n=1", &result)))
+        goto err;
+
+    /* Cache it again and let freeing the store release it */
+    if (!TEST_true(ossl_method_store_cache_set(store, 7, "n=1", "a",
+                                               &counted_up_ref,
+                                               &counted_down_ref))
+        || !TEST_int_eq(counted_refs, base + 2))
+        goto err;
+    res = 1;
+
+ err:
+    ossl_method_store_free(store);
+    return res && TEST_int_eq(counted_refs, 0);
+}
+
+#if defined(OPENSSL_THREADS) && !defined(CRYPTO_TDEBUG)
+static OSSL_METHOD_STORE *idle_store;
+static CRYPTO_RWLOCK *idle_lock;
+static int idle_ready, idle_ok;
+
+/* Fill this thread's cache, then sit idle until the main thread is done */
+static void idle_thread(void)
+{
+    void *result;
+    int ready;
+
+    idle_ok = ossl_method_store_cache_get(idle_store, 7, "n=1", &result);
+    if (idle_ok)
+        counted_down_ref(result);
+    CRYPTO_atomic_add(&idle_ready, 1, &ready, NULL);
+    if (CRYPTO_THREAD_write_lock(idle_lock))
+        CRYPTO_THREAD_unlock(idle_lock);
+}
+
+/*
+ * Unloading a provider flushes the store.  The methods cached by a thread
+ * that doesn't fetch anything afterwards must be released all the same, or
+ * the provider isn't torn down until that thread wakes up.
+ */
+static int test_query_cache_idle_thread(void)
+{
+    thread_t thread;
+    int base, ready = 0, locked = 0, started = 0, res = 0;
+
+    if (!TEST_ptr(idle_store = ossl_method_store_new(NULL))
+        || !TEST_ptr(idle_lock = CRYPTO_THREAD_lock_new())
+        || !add_property_names("n", NULL)
+        || !TEST_true(ossl_method_store_add(idle_store, NULL, 7, "n=1", "a",
+                                            &counted_up_ref,
+                                            &counted_down_ref)))
+        goto err;
+    base = counted_refs;
+    if (!TEST_true(ossl_method_store_cache_set(idle_store, 7, "n=1", "a",
+                                               &counted_up_ref,
+                                               &counted_down_ref))
+        || !TEST_true(locked = CRYPTO_THREAD_write_lock(idle_lock))
+        || !TEST_true(started = run_thread(&thread, idle_thread)))
+        goto err;
+    while (CRYPTO_atomic_add(&idle_ready, 0, &ready, NULL) && ready == 0)
+        ossl_sleep(1);
+
+    /* The shared cache and both threads' caches hold a reference */
+    if (!TEST_true(idle_ok)
+        || !TEST_int_eq(counted_refs, base + 3))
+        goto err;
+    /* Dropping all methods, as when a provider goes away, leaves none held */
+    ossl_method_store_flush_cache(idle_store, 1);
+    if (!TEST_int_eq(counted_refs, 0))
+        goto err;
+    res = 1;
+
+ err:
+    if (locked)
+        CRYPTO_THREAD_unlock(idle_lock);
+    if (started && !TEST_true(wait_for_thread(thread)))
+        res = 0;
+    ossl_method_store_free(idle_store);
+    CRYPTO_THREAD_lock_free(idle_lock);
+    return res && TEST_int_eq(counted_refs, 0);
+}
+#endif
+
+/*
+ * The per thread caches must not use up a thread local key per store, or
+ * applications with many library contexts would run out of them.
+ */
+static int test_query_cache_many_stores(void)
+{
+    OSSL_METHOD_STORE *stores[1500];
+    void *result;
+    size_t i, n = 0;
+    int res = 0;
+
+    if (!add_property_names("n", NULL))
+        return 0;
+    for (n = 0; n < OSSL_NELEM(stores); n++) {
+        if (!TEST_ptr(stores[n] = ossl_method_store_new(NULL))
+            || !TEST_true(ossl_method_store_add(stores[n], NULL, 7, "n=1",
+                                                "a", &counted_up_ref,
+                                                &counted_down_ref))
+            || !TEST_true(ossl_method_store_cache_set(stores[n], 7, "n=1",
+                                                      "a", &counted_up_ref,
+                                                      &counted_down_ref))
+            || !TEST_true(ossl_method_store_cache_get(stores[n], 7, "n=1",
+                                                      &result)))
+            goto err;
+        counted_down_ref(result);
+    }
+    res = 1;
+
+ err:
+    /* On error, stores[n] is the store that failed, if any */
+    for (i = 0; i <= n && i < OSSL_NELEM(stores); i++)
+        ossl_method_store_free(stores[i]);
+    return res && TEST_int_eq(counted_refs, 0);
+}
+
 static int test_fips_mode(void)
 {
     int ret = 0;
@@ -423,6 +644,12 @@ int setup_tests(void)
     ADD_TEST(test_register_deregister);
     ADD_TEST(test_property);
     ADD_TEST(test_query_cache_stochastic);
+    ADD_TEST(test_query_cache_invalidation);
+    ADD_TEST(test_query_cache_release);
+#if defined(OPENSSL_THREADS) && !defined(CRYPTO_TDEBUG)
+    ADD_TEST(test_query_cache_idle_thread);
+#endif
+    ADD_TEST(test_query_cache_many_stores);
     ADD_TEST(test_fips_mode);
     return 1;
 }
@@ -456,6 +456,25 @@ static int test_sp80056b_keygen(int id)
     return ret;
 }
 
+/* As above, with q searched for on a worker thread while p is found */
+static int test_sp80056b_keygen_threads(void)
+{
+    RSA *key = NULL;
+    int ret;
+
+    if (!OSSL_set_max_threads(NULL, 1))
+        return TEST_skip("no thread support");
+
+    ret = TEST_ptr(key = RSA_new())
+          && TEST_true(ossl_rsa_sp800_56b_generate_key(key, 2048, NULL, NULL))
+          && TEST_true(ossl_rsa_sp800_56b_check_public(key))
+          && TEST_true(ossl_rsa_sp800_56b_check_private(key))
+          && TEST_true(ossl_rsa_sp800_56b_check_keypair(key, NULL, -1, 2048));
+
+    RSA_free(key);
+    return TEST_true(OSSL_set_max_threads(NULL, 0)) && ret;
+}
+
 static int test_check_private_key(void)
 {
     int ret = 0;
@@ -541,5 +560,6 @@ int setup_tests(void)
     ADD_TEST(test_invalid_keypair);
     ADD_TEST(test_pq_diff);
     ADD_ALL_TESTS(test_sp80056b_keygen, (int)OSSL_NELEM(keygen_size));
+    ADD_TEST(test_sp80056b_keygen_threads);
     return 1;
 }
@@ -696,6 +696,107 @@ end:
     return ret;
 }
 
+/*
+ * Connect and check that the server sent |num| certificates, the last one of
+ * which is |last|
+ */
+static int check_sent_chain(SSL_CTX *sctx, SSL_CTX *cctx, int num, X509 *last)
+{
+    SSL *clientssl = NULL, *serverssl = NULL;
+    STACK_OF(X509) *chain;
+    int ret = 0;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(chain = SSL_get_peer_cert_chain(clientssl))
+            || !TEST_int_eq(sk_X509_num(chain), num)
+            || !TEST_int_eq(X509_cmp(sk_X509_value(chain, num - 1), last), 0))
+        goto end;
+    ret = 1;
+ end:
+    shutdown_ssl_connection(serverssl, clientssl);
+    return ret;
+}
+
+/*
+ * The encoding of a configured server chain is cached between handshakes.
+ * Test that changes to the chain are still picked up.
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.3
+ */
+static int test_cert_chain_cache(int tst)
+{
+    char *skey = test_mk_file_path(certsdir, "leaf.key");
+    char *leaf = test_mk_file_path(certsdir, "leaf.pem");
+    char *int2 = test_mk_file_path(certsdir, "subinterCA.pem");
+    char *int1 = test_mk_file_path(certsdir, "interCA.pem");
+    X509 *leafcrt = NULL, *crt1 = NULL, *crt2 = NULL;
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    int version = tst == 0 ? TLS1_2_VERSION : TLS1_3_VERSION;
+    int testresult = 0;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (tst == 0) {
+        TEST_skip("TLSv1.2 is disabled");
+        testresult = 1;
+        goto end;
+    }
+#endif
+#ifdef OSSL_NO_USABLE_TLS1_3
+    if (tst == 1) {
+        TEST_skip("No usable TLSv1.3");
+        testresult = 1;
+        goto end;
+    }
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), version, version,
+                                       &sctx, &cctx, NULL, NULL))
+            || !TEST_int_eq(SSL_CTX_use_certificate_file(sctx, leaf,
+                                                         SSL_FILETYPE_PEM), 1)
+            || !TEST_int_eq(SSL_CTX_use_PrivateKey_file(sctx, skey,
+                                                        SSL_FILETYPE_PEM), 1)
+            || !TEST_ptr(leafcrt = load_cert_pem(leaf, libctx))
+            || !TEST_ptr(crt1 = load_cert_pem(int1, libctx))
+            || !TEST_ptr(crt2 = load_cert_pem(int2, libctx)))
+        goto end;
+
+    /* Twice with the same chain, the second time from the cache */
+    if (!TEST_true(SSL_CTX_add1_chain_cert(sctx, crt2))
+            || !TEST_true(check_sent_chain(sctx, cctx, 2, crt2))
+            || !TEST_true(check_sent_chain(sctx, cctx, 2, crt2)))
+        goto end;
+
+    /* A certificate added to the chain must be sent */
+    if (!TEST_true(SSL_CTX_add1_chain_cert(sctx, crt1))
+            || !TEST_true(check_sent_chain(sctx, cctx, 3, crt1)))
+        goto end;
+
+    /* And no longer be sent once the chain is cleared */
+    if (!TEST_true(SSL_CTX_clear_chain_certs(sctx))
+            || !TEST_true(SSL_CTX_set_mode(sctx, SSL_MODE_NO_AUTO_CHAIN))
+            || !TEST_true(check_sent_chain(sctx, cctx, 1, leafcrt)))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    X509_free(leafcrt);
+    X509_free(crt1);
+    X509_free(crt2);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(skey);
+    OPENSSL_free(leaf);
+    OPENSSL_free(int2);
+    OPENSSL_free(int1);
+
+    return testresult;
+}
+
 #ifndef OPENSSL_NO_TLS1_2
 static int full_client_hello_callback(SSL *s, int *al, void *arg)
 {
@@ -1171,6 +1272,12 @@ static int execute_test_ktls(int cis_ktls_tx, int cis_ktls_rx,
             goto end;
     }
 
+    if (tls_version == TLS1_3_VERSION) {
+        if (!TEST_true(SSL_set_mode(clientssl, SSL_MODE_KTLS_RX_TLS13))
+                || !TEST_true(SSL_set_mode(serverssl, SSL_MODE_KTLS_RX_TLS13)))
+            goto end;
+    }
+
     if (!TEST_true(create_ssl_connection(serverssl, clientssl,
                                                 SSL_ERROR_NONE)))
         goto end;
@@ -1364,10 +1471,6 @@ static int test_ktls(int test)
     if (cis_ktls_rx || sis_ktls_rx)
         return 1;
 #endif
-#if !defined(OSSL_NO_USABLE_TLS1_3)
-    if (tlsver == TLS1_3_VERSION && (cis_ktls_rx || sis_ktls_rx))
-        return 1;
-#endif
 
     testresult = 1;
 #ifdef OPENSSL_KTLS_AES_GCM_128
@@ -2112,6 +2215,87 @@ static int test_session_wo_ca_names(void)
 #endif
 }
 
+/*
+ * Test the internal session cache, which is split into shards: the cache size
+ * applies to all the shards together, a session that has just been added is
+ * never the one dropped to make room, and flushing visits every shard.
+ */
+static int test_session_cache_shards(void)
+{
+    SSL_CTX *ctx = NULL;
+    SSL_SESSION *sess[64];
+    unsigned char id;
+    size_t i;
+    int cached = 0, testresult = 0;
+
+    memset(sess, 0, sizeof(sess));
+    if (!TEST_ptr(ctx = SSL_CTX_new_ex(libctx, NULL, TLS_server_method())))
+        goto end;
+    SSL_CTX_sess_set_cache_size(ctx, 40);
+
+    for (i = 0; i < OSSL_NELEM(sess); i++) {
+        id = (unsigned char)(i + 1);
+        if (!TEST_ptr(sess[i] = SSL_SESSION_new())
+                || !TEST_true(SSL_SESSION_set1_id(sess[i], &id, sizeof(id)))
+                || !TEST_true(SSL_SESSION_set_time(sess[i], 100))
+                || !TEST_true(SSL_SESSION_set_timeout(sess[i],
+                                                      i % 2 == 0 ? 10 : 50))
+                || !TEST_true(SSL_CTX_add_session(ctx, sess[i]))
+                || !TEST_long_le(SSL_CTX_sess_number(ctx), 40))
+            goto end;
+        /* Adding a session that is already cached changes nothing */
+        if (!TEST_false(SSL_CTX_add_session(ctx, sess[i])))
+            goto end;
+    }
+    if (!TEST_long_eq(SSL_CTX_sess_number(ctx), 40)
+            || !TEST_long_eq(SSL_CTX_sess_cache_full(ctx), 24))
+        goto end;
+
+    /* The cache holds the sessions it counts, including the newest one */
+    if (!TEST_true(SSL_CTX_remove_session(ctx, sess[63])))
+        goto end;
+    cached = 1;
+    for (i = 0; i < OSSL_NELEM(sess) - 1; i++)
+        if (SSL_CTX_remove_session(ctx, sess[i]))
+            cached++;
+    if (!TEST_int_eq(cached, 40)
+            || !TEST_long_eq(SSL_CTX_sess_number(ctx), 0))
+        goto end;
+
+    /* Expired sessions are flushed from all the shards */
+    SSL_CTX_sess_set_cache_size(ctx, 0);
+    for (i = 0; i < OSSL_NELEM(sess); i++)
+        if (!TEST_true(SSL_CTX_add_session(ctx, sess[i])))
+            goto end;
+    SSL_CTX_flush_sessions(ctx, 120);
+    if (!TEST_long_eq(SSL_CTX_sess_number(ctx), 32))
+        goto end;
+    for (i = 0; i < OSSL_NELEM(sess); i++)
+        if (!TEST_int_eq(SSL_CTX_remove_session(ctx, sess[i]), i % 2 == 1))
+            goto end;
+    if (!TEST_long_eq(SSL_CTX_sess_number(ctx), 0))
+        goto end;
+
+    /* Sessions that were cached outlive the SSL_CTX */
+    for (i = 0; i < OSSL_NELEM(sess); i++)
+        if (!TEST_true(SSL_CTX_add_session(ctx, sess[i])))
+            goto end;
+    SSL_CTX_free(ctx);
+    ctx = NULL;
+    if (!TEST_long_eq(SSL_SESSION_set_time(sess[0], 300), 300)
+            || !TEST_true(SSL_SESSION_set_timeout(sess[0], 10))
+            || !TEST_long_eq(SSL_SESSION_get_timeout(sess[0]), 10))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    for (i = 0; i < OSSL_NELEM(sess); i++)
+        SSL_SESSION_free(sess[i]);
+    SSL_CTX_free(ctx);
+
+    return testresult;
+}
 
 #ifndef OSSL_NO_USABLE_TLS1_3
 static SSL_SESSION *sesscache[6];
@@ -5941,6 +6125,174 @@ static int test_ssl_clear(int idx)
     return testresult;
 }
 
+/*
+ * Test that SSL objects reuse record buffers from the SSL_CTX buffer pool
+ * when they release and reacquire them.
+ */
+static int test_buffer_pool(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+    const char msg[] = "Hello";
+    char buf[sizeof(msg)];
+    size_t written, readbytes;
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), TLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    SSL_CTX_set_mode(sctx, SSL_MODE_RELEASE_BUFFERS);
+    if (!TEST_long_eq(SSL_CTX_get_buffer_pool_size(sctx), 0)
+            || !TEST_long_eq(SSL_CTX_set_buffer_pool_size(sctx, 16), 0)
+            || !TEST_long_eq(SSL_CTX_set_buffer_pool_size(sctx, -1), 0)
+            || !TEST_long_eq(SSL_CTX_get_buffer_pool_size(sctx), 16))
+        goto end;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_true(SSL_write_ex(clientssl, msg, sizeof(msg), &written))
+            || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf), &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg))
+            || !TEST_true(SSL_write_ex(serverssl, msg, sizeof(msg), &written))
+            || !TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf), &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg)))
+        goto end;
+
+    /* The server released its buffers while idle and got them back */
+    if (!TEST_long_gt(SSL_CTX_buffer_pool_hits(sctx), 0)
+            || !TEST_long_gt(SSL_CTX_buffer_pool_misses(sctx), 0)
+            || !TEST_long_gt(SSL_CTX_buffer_pool_number(sctx), 0)
+            || !TEST_long_eq(SSL_CTX_buffer_pool_hits(cctx), 0)
+            || !TEST_long_eq(SSL_CTX_buffer_pool_number(cctx), 0))
+        goto end;
+
+    SSL_shutdown(clientssl);
+    SSL_shutdown(serverssl);
+    SSL_free(serverssl);
+    serverssl = NULL;
+
+    if (!TEST_long_gt(SSL_CTX_buffer_pool_number(sctx), 0)
+            || !TEST_long_le(SSL_CTX_buffer_pool_number(sctx), 16)
+            /* At most one read and one write buffer may remain */
+            || !TEST_long_eq(SSL_CTX_set_buffer_pool_size(sctx, 1), 16)
+            || !TEST_long_le(SSL_CTX_buffer_pool_number(sctx), 2)
+            || !TEST_long_eq(SSL_CTX_set_buffer_pool_size(sctx, 0), 1)
+            || !TEST_long_eq(SSL_CTX_buffer_pool_number(sctx), 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+/* Connect and return the ephemeral key the server used */
+static EVP_PKEY *keyshare_pool_connect(SSL_CTX *sctx, SSL_CTX *cctx)
+{
+    SSL *clientssl = NULL, *serverssl = NULL;
+    EVP_PKEY *key = NULL;
+
+    if (TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                     NULL, NULL))
+            && TEST_true(create_ssl_connection(serverssl, clientssl,
+                                               SSL_ERROR_NONE)))
+        TEST_true(SSL_get_peer_tmp_key(clientssl, &key));
+    shutdown_ssl_connection(serverssl, clientssl);
+    return key;
+}
+
+/*
+ * Test that handshakes take their ephemeral keys from the pool once it has
+ * been filled, and that each key is only used once.
+ * Test 0: TLSv1.2 ECDHE, where only the server generates a key from a group
+ * Test 1: TLSv1.3, where both sides do
+ */
+static int test_keyshare_pool(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    EVP_PKEY *key1 = NULL, *key2 = NULL;
+    int version = tst == 0 ? TLS1_2_VERSION : TLS1_3_VERSION;
+    int testresult = 0;
+
+#if defined(OPENSSL_NO_TLS1_2) || defined(OPENSSL_NO_EC)
+    if (tst == 0) {
+        TEST_skip("No TLSv1.2 ECDHE");
+        return 1;
+    }
+#endif
+#ifdef OSSL_NO_USABLE_TLS1_3
+    if (tst == 1) {
+        TEST_skip("No usable TLSv1.3");
+        return 1;
+    }
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), version, version,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+    if (tst == 0 && !TEST_true(SSL_CTX_set_cipher_list(cctx, "ECDHE")))
+        goto end;
+
+    if (!TEST_long_eq(SSL_CTX_get_keyshare_pool_size(sctx), 0)
+            || !TEST_long_eq(SSL_CTX_set_keyshare_pool_size(sctx, 2), 0)
+            || !TEST_long_eq(SSL_CTX_set_keyshare_pool_size(sctx, -1), 0)
+            || !TEST_long_eq(SSL_CTX_get_keyshare_pool_size(sctx), 2)
+            || !TEST_long_eq(SSL_CTX_set_keyshare_pool_size(cctx, 2), 0))
+        goto end;
+
+    /* Nothing has been generated yet */
+    if (!TEST_ptr(key1 = keyshare_pool_connect(sctx, cctx))
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_hits(sctx), 0)
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_misses(sctx), 1))
+        goto end;
+    EVP_PKEY_free(key1);
+    key1 = NULL;
+
+    if (!TEST_true(SSL_CTX_fill_keyshare_pool(sctx))
+            || !TEST_true(SSL_CTX_fill_keyshare_pool(cctx))
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_number(sctx), 2)
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_number(cctx),
+                             tst == 0 ? 0 : 2))
+        goto end;
+
+    if (!TEST_ptr(key1 = keyshare_pool_connect(sctx, cctx))
+            || !TEST_ptr(key2 = keyshare_pool_connect(sctx, cctx))
+            || !TEST_int_ne(EVP_PKEY_eq(key1, key2), 1)
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_hits(sctx), 2)
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_misses(sctx), 1)
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_number(sctx), 0)
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_hits(cctx),
+                             tst == 0 ? 0 : 2))
+        goto end;
+
+    /* The pool is refilled on request and emptied when disabled */
+    if (!TEST_true(SSL_CTX_fill_keyshare_pool(sctx))
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_number(sctx), 2)
+            || !TEST_long_eq(SSL_CTX_set_keyshare_pool_size(sctx, 0), 2)
+            || !TEST_long_eq(SSL_CTX_keyshare_pool_number(sctx), 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    EVP_PKEY_free(key1);
+    EVP_PKEY_free(key2);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
 /* Parse CH and retrieve any MFL extension value if present */
 static int get_MFL_from_client_hello(BIO *bio, int *mfl_codemfl_code)
 {
@@ -7101,6 +7453,139 @@ static int test_ticket_callbacks(int tst)
     return testresult;
 }
 
+/*
+ * Resume |*sess| and check whether the session was reused as |reused| says.
+ * On success |*sess| is replaced by the session the client ends up with.
+ */
+static int resume_with_ticket(SSL_CTX *sctx, SSL_CTX *cctx, SSL_SESSION **sess,
+                              int reused)
+{
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl, NULL,
+                                      NULL))
+            || !TEST_true(SSL_set_session(clientssl, *sess))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_int_eq(SSL_session_reused(clientssl), reused))
+        goto end;
+
+    SSL_SESSION_free(*sess);
+    *sess = SSL_get1_session(clientssl);
+    if (!TEST_ptr(*sess))
+        goto end;
+    SSL_shutdown(clientssl);
+    SSL_shutdown(serverssl);
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    return testresult;
+}
+
+/*
+ * Test replacing the built-in ticket keys
+ * Test 0: TLSv1.2, AES-256-CBC and HMAC tickets
+ * Test 1: TLSv1.3, AES-256-CBC and HMAC tickets
+ * Test 2: TLSv1.2, AES-256-GCM tickets
+ * Test 3: TLSv1.3, AES-256-GCM tickets
+ */
+static int test_ticket_keys(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    SSL_SESSION *sess = NULL, *oldsess = NULL;
+    unsigned char keys[80];
+    int testresult = 0;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (tst % 2 == 0)
+        return 1;
+#endif
+#ifdef OSSL_NO_USABLE_TLS1_3
+    if (tst % 2 == 1)
+        return 1;
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION,
+                                       ((tst % 2) == 0) ? TLS1_2_VERSION
+                                                        : TLS1_3_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_long_eq(SSL_CTX_set_tlsext_ticket_keys(sctx, NULL, 0),
+                             sizeof(keys)))
+        goto end;
+
+    /* Only resume from tickets */
+    SSL_CTX_set_session_cache_mode(sctx, SSL_SESS_CACHE_OFF);
+    if (tst >= 2)
+        SSL_CTX_set_options(sctx, SSL_OP_TICKET_AEAD);
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(sess = SSL_get1_session(clientssl)))
+        goto end;
+    SSL_shutdown(clientssl);
+    SSL_shutdown(serverssl);
+
+    if (!TEST_true(resume_with_ticket(sctx, cctx, &sess, 1))
+            || !TEST_ptr(oldsess = SSL_SESSION_dup(sess)))
+        goto end;
+
+    /* A ticket issued under the previous keys is accepted and renewed */
+    memset(keys, 1, sizeof(keys));
+    if (!TEST_true(SSL_CTX_set_tlsext_ticket_keys(sctx, keys, sizeof(keys)))
+            || !TEST_true(resume_with_ticket(sctx, cctx, &sess, 1))
+            || !TEST_true(resume_with_ticket(sctx, cctx, &sess, 1)))
+        goto end;
+
+    /* One that was issued two sets of keys ago is not */
+    memset(keys, 2, sizeof(keys));
+    if (!TEST_true(SSL_CTX_set_tlsext_ticket_keys(sctx, keys, sizeof(keys)))
+            || !TEST_true(resume_with_ticket(sctx, cctx, &oldsess, 0))
+            || !TEST_true(resume_with_ticket(sctx, cctx, &sess, 1)))
+        goto end;
+
+    /* Nor once two sets of keys were set, even if one was never used */
+    SSL_SESSION_free(oldsess);
+    if (!TEST_ptr(oldsess = SSL_SESSION_dup(sess)))
+        goto end;
+    memset(keys, 3, sizeof(keys));
+    if (!TEST_true(SSL_CTX_set_tlsext_ticket_keys(sctx, keys, sizeof(keys))))
+        goto end;
+    memset(keys, 4, sizeof(keys));
+    if (!TEST_true(SSL_CTX_set_tlsext_ticket_keys(sctx, keys, sizeof(keys)))
+            || !TEST_true(resume_with_ticket(sctx, cctx, &oldsess, 0))
+            || !TEST_true(resume_with_ticket(sctx, cctx, &sess, 0))
+            || !TEST_true(resume_with_ticket(sctx, cctx, &sess, 1)))
+        goto end;
+
+    /* Neither is a ticket in the other format */
+    SSL_CTX_clear_options(sctx, SSL_OP_TICKET_AEAD);
+    if (tst < 2)
+        SSL_CTX_set_options(sctx, SSL_OP_TICKET_AEAD);
+    if (!TEST_true(resume_with_ticket(sctx, cctx, &sess, 0))
+            || !TEST_true(resume_with_ticket(sctx, cctx, &sess, 1)))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_SESSION_free(sess);
+    SSL_SESSION_free(oldsess);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
 /*
  * Test incorrect shutdown.
  * Test 0: client does not shutdown properly,
@@ -7763,18 +8248,21 @@ static int test_multiblock_write(int test_index)
     /*
      * Choose a buffer large enough to perform a multi-block operation
      * i.e: write_len >= 4 * frag_size
-     * 9 * is chosen so that multiple multiblocks are used + some leftover.
+     * 13 * is chosen so that both an 8 and a 4 record interleaved multiblock
+     * are used + some leftover.
      */
-    unsigned char msg[MULTIBLOCK_FRAGSIZE * 9];
+    unsigned char msg[MULTIBLOCK_FRAGSIZE * 13];
     unsigned char buf[sizeof(msg)], *p = buf;
     size_t readbytes, written, len;
     EVP_CIPHER *ciph = NULL;
 
     /*
      * Check if the cipher exists before attempting to use it since it only has
-     * a hardware specific implementation.
+     * a hardware specific implementation.  This must be fetched from the same
+     * library context as the SSL_CTX, since the default one doesn't have any
+     * ciphers available.
      */
-    ciph = EVP_CIPHER_fetch(NULL, fetchable_ciphers[test_index], "");
+    ciph = EVP_CIPHER_fetch(libctx, fetchable_ciphers[test_index], "");
     if (ciph == NULL) {
         TEST_skip("Multiblock cipher is not available for %s", cipherlist);
         return 1;
@@ -7829,6 +8317,96 @@ end:
 }
 #endif /* OPENSSL_NO_TLS1_2 */
 
+#ifndef OSSL_NO_USABLE_TLS1_3
+static int pipeline_records;
+
+static void pipeline_msg_cb(int write_p, int version, int content_type,
+                            const void *buf, size_t len, SSL *ssl, void *arg)
+{
+    if (write_p && content_type == SSL3_RT_HEADER)
+        pipeline_records++;
+}
+
+/*
+ * Test that TLSv1.3 application data writes are split across pipelines with
+ * the built-in ciphers that can encrypt several records in one call, and
+ * written as a single record with the others.
+ * Test 0: TLS_AES_128_GCM_SHA256
+ * Test 1: TLS_CHACHA20_POLY1305_SHA256
+ * Test 2: TLS_AES_128_CCM_SHA256
+ */
+static int test_tls13_write_pipelining(int idx)
+{
+    static const char *ciphersuites[] = {
+        "TLS_AES_128_GCM_SHA256",
+        "TLS_CHACHA20_POLY1305_SHA256",
+        "TLS_AES_128_CCM_SHA256"
+    };
+    static const int records[] = { 4, 4, 1 };
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    unsigned char msg[1024 * 4], buf[sizeof(msg)], *p = buf;
+    size_t written, readbytes, len;
+    int testresult = 0;
+
+# ifdef OPENSSL_NO_CHACHA
+    if (idx == 1) {
+        TEST_skip("ChaCha20-Poly1305 is disabled");
+        return 1;
+    }
+# endif
+    if (is_fips && idx == 1) {
+        TEST_skip("No ChaCha20-Poly1305 in FIPS");
+        return 1;
+    }
+
+    RAND_bytes(msg, sizeof(msg));
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), TLS1_3_VERSION,
+                                       TLS1_3_VERSION, &sctx, &cctx, cert,
+                                       privkey))
+            || !TEST_true(SSL_CTX_set_ciphersuites(sctx, ciphersuites[idx]))
+            || !TEST_true(SSL_CTX_set_ciphersuites(cctx, ciphersuites[idx]))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    /* One record per 1024 bytes, all four of which are encrypted in one go */
+    if (!TEST_true(SSL_set_max_pipelines(serverssl, 4))
+            || !TEST_true(SSL_set_split_send_fragment(serverssl, 1024)))
+        goto end;
+    SSL_set_msg_callback(serverssl, pipeline_msg_cb);
+    pipeline_records = 0;
+
+    if (!TEST_true(SSL_write_ex(serverssl, msg, sizeof(msg), &written))
+            || !TEST_size_t_eq(written, sizeof(msg))
+            || !TEST_int_eq(pipeline_records, records[idx]))
+        goto end;
+
+    len = written;
+    while (len > 0) {
+        if (!TEST_true(SSL_read_ex(clientssl, p, len, &readbytes)))
+            goto end;
+        p += readbytes;
+        len -= readbytes;
+    }
+    if (!TEST_mem_eq(msg, sizeof(msg), buf, sizeof(buf)))
+        goto end;
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+#endif /* OSSL_NO_USABLE_TLS1_3 */
+
 /*
  * Test 0: Client sets servername and server acknowledges it (TLSv1.2)
  * Test 1: Client sets servername and server does not acknowledge it (TLSv1.2)
@@ -8746,6 +9324,7 @@ int setup_tests(void)
     ADD_TEST(test_session_with_only_ext_cache);
     ADD_TEST(test_session_with_both_cache);
     ADD_TEST(test_session_wo_ca_names);
+    ADD_TEST(test_session_cache_shards);
 #ifndef OSSL_NO_USABLE_TLS1_3
     ADD_ALL_TESTS(test_stateful_tickets, 3);
     ADD_ALL_TESTS(test_stateless_tickets, 3);
@@ -8767,6 +9346,7 @@ int setup_tests(void)
     ADD_TEST(test_client_cert_verify_cb);
     ADD_TEST(test_ssl_build_cert_chain);
     ADD_TEST(test_ssl_ctx_build_cert_chain);
+    ADD_ALL_TESTS(test_cert_chain_cache, 2);
 #ifndef OPENSSL_NO_TLS1_2
     ADD_TEST(test_client_hello_cb);
     ADD_TEST(test_no_ems);
@@ -8821,6 +9401,8 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_key_update_in_write, 2);
 #endif
     ADD_ALL_TESTS(test_ssl_clear, 2);
+    ADD_TEST(test_buffer_pool);
+    ADD_ALL_TESTS(test_keyshare_pool, 2);
     ADD_ALL_TESTS(test_max_fragment_len_ext, OSSL_NELEM(max_fragment_len_test));
 #if !defined(OPENSSL_NO_SRP) && !defined(OPENSSL_NO_TLS1_2)
     ADD_ALL_TESTS(test_srp, 6);
@@ -8829,6 +9411,7 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_ssl_pending, 2);
     ADD_ALL_TESTS(test_ssl_get_shared_ciphers, OSSL_NELEM(shared_ciphers_data));
     ADD_ALL_TESTS(test_ticket_callbacks, 16);
+    ADD_ALL_TESTS(test_ticket_keys, 4);
     ADD_ALL_TESTS(test_shutdown, 7);
     ADD_ALL_TESTS(test_incorrect_shutdown, 2);
     ADD_ALL_TESTS(test_cert_cb, 6);
@@ -8836,6 +9419,9 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_ca_names, 3);
 #ifndef OPENSSL_NO_TLS1_2
     ADD_ALL_TESTS(test_multiblock_write, OSSL_NELEM(multiblock_cipherlist_data));
+#endif
+#ifndef OSSL_NO_USABLE_TLS1_3
+    ADD_ALL_TESTS(test_tls13_write_pipelining, 3);
 #endif
     ADD_ALL_TESTS(test_servername, 10);
 #if !defined(OPENSSL_NO_EC) \
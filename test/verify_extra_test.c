@@ -220,6 +220,246 @@ static int test_store_ctx(void)
     return test_self_signed(bad_f, 0, 0);
 }
 
+/*
+ * Both subinterCA certificates share a subject name, lookups must find them
+ * whatever the case and spacing of the name being looked up.
+ */
+static int test_store_lookup_by_name(void)
+{
+    X509_STORE *store = X509_STORE_new();
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    STACK_OF(X509) *roots = load_certs_pem(roots_f);
+    STACK_OF(X509) *untrusted = load_certs_pem(untrusted_f);
+    STACK_OF(X509) *found = NULL;
+    X509_NAME *nm = X509_NAME_new();
+    X509 *issuer = NULL;
+    int i, ret = 0;
+
+    if (!TEST_ptr(store) || !TEST_ptr(ctx) || !TEST_ptr(nm)
+            || !TEST_int_eq(sk_X509_num(roots), 2)
+            || !TEST_int_eq(sk_X509_num(untrusted), 2))
+        goto err;
+    /* Adding the same certificates twice must not create duplicates */
+    for (i = 0; i < 2; i++)
+        if (!TEST_true(X509_STORE_add_cert(store, sk_X509_value(roots, 0)))
+                || !TEST_true(X509_STORE_add_cert(store,
+                                                  sk_X509_value(roots, 1)))
+                || !TEST_true(X509_STORE_add_cert(store,
+                                                  sk_X509_value(untrusted,
+                                                                0))))
+            goto err;
+    if (!TEST_int_eq(sk_X509_OBJECT_num(X509_STORE_get0_objects(store)), 3)
+            || !TEST_true(X509_STORE_CTX_init(ctx, store, NULL, NULL)))
+        goto err;
+
+    if (!TEST_true(X509_NAME_add_entry_by_txt(nm, "C", MBSTRING_ASC,
+                                              (unsigned char *)"au", -1, -1,
+                                              0))
+            || !TEST_true(X509_NAME_add_entry_by_txt(nm, "ST", MBSTRING_ASC,
+                                                     (unsigned char *)"SOME-State",
+                                                     -1, -1, 0))
+            || !TEST_true(X509_NAME_add_entry_by_txt(nm, "O", MBSTRING_UTF8,
+                                                     (unsigned char *)"Internet  Widgits Pty Ltd",
+                                                     -1, -1, 0))
+            || !TEST_true(X509_NAME_add_entry_by_txt(nm, "CN", MBSTRING_ASC,
+                                                     (unsigned char *)" subinterca ",
+                                                     -1, -1, 0))
+            || !TEST_ptr(found = X509_STORE_CTX_get1_certs(ctx, nm))
+            || !TEST_int_eq(sk_X509_num(found), 2))
+        goto err;
+
+    /* Either subinterCA will do as the issuer of leaf, they share a key */
+    if (!TEST_int_eq(X509_STORE_CTX_get1_issuer(&issuer, ctx,
+                                                sk_X509_value(untrusted, 1)),
+                     1)
+            || !TEST_int_eq(X509_NAME_cmp(X509_get_subject_name(issuer), nm),
+                            0))
+        goto err;
+
+    /* Nothing is known under the issuer name of the interCA */
+    if (!TEST_ptr_null(X509_STORE_CTX_get1_certs(ctx,
+                                                 X509_get_issuer_name(sk_X509_value(roots, 0)))))
+        goto err;
+
+    ret = 1;
+ err:
+    X509_free(issuer);
+    sk_X509_pop_free(found, X509_free);
+    X509_NAME_free(nm);
+    sk_X509_pop_free(roots, X509_free);
+    sk_X509_pop_free(untrusted, X509_free);
+    X509_STORE_CTX_free(ctx);
+    X509_STORE_free(store);
+    return ret;
+}
+
+static int store_has_cert(X509_STORE_CTX *ctx, X509 *x)
+{
+    STACK_OF(X509) *found = X509_STORE_CTX_get1_certs(ctx,
+                                                      X509_get_subject_name(x));
+    int ret = found != NULL && X509_cmp(sk_X509_value(found, 0), x) == 0;
+
+    sk_X509_pop_free(found, X509_free);
+    return ret;
+}
+
+/*
+ * Lookups must see objects that were added to, replaced in or removed from
+ * the stack returned by X509_STORE_get0_objects().
+ */
+static int test_store_objects_changed(void)
+{
+    X509_STORE *store = X509_STORE_new();
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    STACK_OF(X509) *roots = load_certs_pem(roots_f);
+    STACK_OF(X509_OBJECT) *objs;
+    X509_OBJECT *obj = NULL;
+    X509 *inter, *subinter;
+    int ret = 0;
+
+    if (!TEST_ptr(store) || !TEST_ptr(ctx)
+            || !TEST_int_eq(sk_X509_num(roots), 2)
+            || !TEST_true(X509_STORE_CTX_init(ctx, store, NULL, NULL)))
+        goto err;
+    inter = sk_X509_value(roots, 0);
+    subinter = sk_X509_value(roots, 1);
+    objs = X509_STORE_get0_objects(store);
+
+    /* Added directly */
+    if (!TEST_ptr(obj = X509_OBJECT_new())
+            || !TEST_true(X509_OBJECT_set1_X509(obj, inter))
+            || !TEST_true(sk_X509_OBJECT_push(objs, obj)))
+        goto err;
+    obj = NULL;
+    if (!TEST_true(store_has_cert(ctx, inter))
+            || !TEST_false(store_has_cert(ctx, subinter)))
+        goto err;
+
+    /* Replaced in place */
+    if (!TEST_ptr(obj = X509_OBJECT_new())
+            || !TEST_true(X509_OBJECT_set1_X509(obj, subinter)))
+        goto err;
+    X509_OBJECT_free(sk_X509_OBJECT_value(objs, 0));
+    (void)sk_X509_OBJECT_set(objs, 0, obj);
+    obj = NULL;
+    if (!TEST_false(store_has_cert(ctx, inter))
+            || !TEST_true(store_has_cert(ctx, subinter)))
+        goto err;
+
+    /* Removed */
+    X509_OBJECT_free(sk_X509_OBJECT_delete(objs, 0));
+    if (!TEST_false(store_has_cert(ctx, subinter))
+            || !TEST_true(X509_STORE_add_cert(store, subinter))
+            || !TEST_true(store_has_cert(ctx, subinter)))
+        goto err;
+
+    /* Removed and another one added, then sorted again, keeping the size */
+    X509_OBJECT_free(sk_X509_OBJECT_delete(objs, 0));
+    if (!TEST_ptr(obj = X509_OBJECT_new())
+            || !TEST_true(X509_OBJECT_set1_X509(obj, inter))
+            || !TEST_true(sk_X509_OBJECT_push(objs, obj)))
+        goto err;
+    obj = NULL;
+    sk_X509_OBJECT_sort(objs);
+    if (!TEST_int_eq(sk_X509_OBJECT_num(objs), 1)
+            || !TEST_false(store_has_cert(ctx, subinter))
+            || !TEST_true(store_has_cert(ctx, inter)))
+        goto err;
+
+    ret = 1;
+ err:
+    X509_OBJECT_free(obj);
+    sk_X509_pop_free(roots, X509_free);
+    X509_STORE_CTX_free(ctx);
+    X509_STORE_free(store);
+    return ret;
+}
+
+static int verify_at(X509_STORE *store, STACK_OF(X509) *untrusted, X509 *x,
+                     time_t t, int *err)
+{
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    int ret = -1;
+
+    if (ctx != NULL && X509_STORE_CTX_init(ctx, store, x, untrusted)) {
+        X509_VERIFY_PARAM_set_time(X509_STORE_CTX_get0_param(ctx), t);
+        ret = X509_verify_cert(ctx);
+        *err = X509_STORE_CTX_get_error(ctx);
+    }
+    X509_STORE_CTX_free(ctx);
+    return ret;
+}
+
+/*
+ * A cached signature must not make an expired or tampered with certificate
+ * pass verification.
+ */
+static int test_sig_cache(void)
+{
+    X509_STORE *store = X509_STORE_new();
+    STACK_OF(X509) *roots = load_certs_pem(roots_f);
+    STACK_OF(X509) *untrusted = load_certs_pem(untrusted_f);
+    X509 *leaf, *bad_leaf = NULL;
+    const ASN1_BIT_STRING *sig;
+    const X509_ALGOR *alg;
+    time_t valid = 1577836800;      /* 2020-01-01 */
+    time_t expired = 2082758400;    /* 2036-01-01 */
+    int i, err, ret = 0;
+
+    if (!TEST_ptr(store)
+            || !TEST_int_eq(sk_X509_num(roots), 2)
+            || !TEST_int_eq(sk_X509_num(untrusted), 2)
+            || !TEST_false(X509_STORE_set_sig_cache(store, 16, -1))
+            || !TEST_true(X509_STORE_set_sig_cache(store, 16, 0)))
+        goto err;
+    for (i = 0; i < sk_X509_num(roots); i++)
+        if (!TEST_true(X509_STORE_add_cert(store, sk_X509_value(roots, i))))
+            goto err;
+    leaf = sk_X509_value(untrusted, 1);
+
+    for (i = 0; i < 2; i++)
+        if (!TEST_int_eq(verify_at(store, untrusted, leaf, valid, &err), 1))
+            goto err;
+    if (!TEST_int_eq(verify_at(store, untrusted, leaf, expired, &err), 0)
+            || !TEST_int_eq(err, X509_V_ERR_CERT_HAS_EXPIRED))
+        goto err;
+
+    if (!TEST_ptr(bad_leaf = X509_dup(leaf)))
+        goto err;
+    X509_get0_signature(&sig, NULL, bad_leaf);
+    sig->data[sig->length - 1] ^= 1;
+    if (!TEST_int_eq(verify_at(store, untrusted, bad_leaf, valid, &err), 0)
+            || !TEST_int_eq(err, X509_V_ERR_CERT_SIGNATURE_FAILURE))
+        goto err;
+
+    /* The outer signature algorithm must match the one that was signed */
+    X509_free(bad_leaf);
+    if (!TEST_ptr(bad_leaf = X509_dup(leaf)))
+        goto err;
+    X509_get0_signature(NULL, &alg, bad_leaf);
+    if (!TEST_true(X509_ALGOR_set0((X509_ALGOR *)alg,
+                                   OBJ_nid2obj(NID_sha512WithRSAEncryption),
+                                   V_ASN1_NULL, NULL))
+            || !TEST_int_eq(verify_at(store, untrusted, bad_leaf, valid, &err),
+                            0)
+            || !TEST_int_eq(err, X509_V_ERR_CERT_SIGNATURE_FAILURE))
+        goto err;
+
+    /* Still fine after all that, and with the cache disabled again */
+    if (!TEST_int_eq(verify_at(store, untrusted, leaf, valid, &err), 1)
+            || !TEST_true(X509_STORE_set_sig_cache(store, 0, 0))
+            || !TEST_int_eq(verify_at(store, untrusted, leaf, valid, &err), 1))
+        goto err;
+
+    ret = 1;
+ err:
+    X509_free(bad_leaf);
+    sk_X509_pop_free(roots, X509_free);
+    sk_X509_pop_free(untrusted, X509_free);
+    X509_STORE_free(store);
+    return ret;
+}
+
 int setup_tests(void)
 {
     if (!test_skip_common_options()) {
@@ -236,6 +476,9 @@ int setup_tests(void)
 
     ADD_TEST(test_alt_chains_cert_forgery);
     ADD_TEST(test_store_ctx);
+    ADD_TEST(test_store_lookup_by_name);
+    ADD_TEST(test_store_objects_changed);
+    ADD_TEST(test_sig_cache);
     ADD_TEST(test_distinguishing_id);
     ADD_TEST(test_req_distinguishing_id);
     ADD_TEST(test_self_signed_good);
@@ -48,8 +48,100 @@ static int test_standard_exts(void)
     return good;
 }
 
+/**********************************************************************
+ *
+ * Test of the X509_NAME canonical encoding
+ *
+ ***/
+
+typedef struct {
+    const char *field;
+    int type;
+    const char *value;
+    int set;
+} NAME_ENTRY;
+
+static X509_NAME *make_name(const NAME_ENTRY *ents, size_t num)
+{
+    X509_NAME *nm = X509_NAME_new();
+    size_t i;
+
+    for (i = 0; nm != NULL && i < num; i++) {
+        if (!X509_NAME_add_entry_by_txt(nm, ents[i].field, ents[i].type,
+                                        (const unsigned char *)ents[i].value,
+                                        -1, -1, ents[i].set)) {
+            X509_NAME_free(nm);
+            return NULL;
+        }
+    }
+    return nm;
+}
+
+static const NAME_ENTRY canon_name[] = {
+    { "C", MBSTRING_ASC, "gb", 0 },
+    { "O", MBSTRING_UTF8, "acme ltd", 0 },
+    { "CN", MBSTRING_UTF8, "foo bar", -1 },
+    { "OU", MBSTRING_ASC, "test unit", 0 },
+};
+
+/* The same name with spacing, case, string types and RDN order changed */
+static const NAME_ENTRY messy_name[] = {
+    { "C", MBSTRING_ASC, "GB", 0 },
+    { "CN", MBSTRING_ASC, "  Foo    BAR ", 0 },
+    { "O", MBSTRING_ASC, "ACME  Ltd", -1 },
+    { "OU", MBSTRING_UTF8, "Test\tUnit", 0 },
+};
+
+/* As canon_name but with the multi-valued RDN split in two */
+static const NAME_ENTRY split_name[] = {
+    { "C", MBSTRING_ASC, "gb", 0 },
+    { "O", MBSTRING_UTF8, "acme ltd", 0 },
+    { "CN", MBSTRING_UTF8, "foo bar", 0 },
+    { "OU", MBSTRING_ASC, "test unit", 0 },
+};
+
+static int test_name_canon(void)
+{
+    X509_NAME *canon = make_name(canon_name, OSSL_NELEM(canon_name));
+    X509_NAME *messy = make_name(messy_name, OSSL_NELEM(messy_name));
+    X509_NAME *split = make_name(split_name, OSSL_NELEM(split_name));
+    X509_NAME *decoded = NULL;
+    unsigned char *der = NULL;
+    const unsigned char *p;
+    int len, ret = 0;
+
+    if (!TEST_ptr(canon) || !TEST_ptr(messy)
+            || !TEST_int_eq(X509_NAME_cmp(canon, messy), 0)
+            || !TEST_ulong_eq(X509_NAME_hash(canon), X509_NAME_hash(messy)))
+        goto err;
+
+    /* A decoded name must compare equal without being re-encoded */
+    if (!TEST_int_gt(len = i2d_X509_NAME(messy, &der), 0))
+        goto err;
+    p = der;
+    if (!TEST_ptr(decoded = d2i_X509_NAME(NULL, &p, len))
+            || !TEST_int_eq(X509_NAME_entry_count(decoded), 4)
+            || !TEST_int_eq(X509_NAME_cmp(decoded, canon), 0)
+            || !TEST_ulong_eq(X509_NAME_hash(decoded), X509_NAME_hash(canon)))
+        goto err;
+
+    if (!TEST_ptr(split)
+            || !TEST_int_ne(X509_NAME_cmp(split, canon), 0))
+        goto err;
+
+    ret = 1;
+ err:
+    OPENSSL_free(der);
+    X509_NAME_free(canon);
+    X509_NAME_free(messy);
+    X509_NAME_free(decoded);
+    X509_NAME_free(split);
+    return ret;
+}
+
 int setup_tests(void)
 {
     ADD_TEST(test_standard_exts);
+    ADD_TEST(test_name_canon);
     return 1;
 }